@@ -31,6 +31,10 @@ struct dataset_settings : public conf::configuration,
           "Remove footpaths if they do not fit an assumed average speed");
     param(expand_footpaths_, "expand_footpaths",
           "Calculate expanded footpaths");
+    param(route_edge_index_, "route_edge_index",
+          "Build dense departure time indices for route edges");
+    param(reorder_graph_, "reorder_graph",
+          "Place route nodes of nearby stations next to each other in memory");
     param(schedule_begin_, "begin",
           "schedule interval begin (TODAY or YYYYMMDD)");
     param(num_days_, "num_days", "number of days");
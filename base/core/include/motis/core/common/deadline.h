@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace motis {
+
+// Cooperative time budget for long running searches.
+// reached() is meant to be called in the inner loop of a search: the clock is
+// only read every CHECK_INTERVAL calls. Once reached, it stays reached.
+struct deadline {
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto const CHECK_INTERVAL = 1024U;
+
+  // unlimited
+  deadline() = default;
+
+  // timeout == 0: unlimited
+  explicit deadline(std::chrono::milliseconds const timeout)
+      : limited_{timeout.count() != 0}, end_{clock::now() + timeout} {}
+
+  static deadline from_timeout_ms(uint32_t const request_timeout,
+                                  uint32_t const default_timeout) {
+    return deadline{std::chrono::milliseconds{
+        request_timeout != 0U ? request_timeout : default_timeout}};
+  }
+
+  inline bool reached() {
+    if (!limited_ || reached_) {
+      return reached_;
+    }
+    if (++calls_ % CHECK_INTERVAL != 0U) {
+      return false;
+    }
+    return check();
+  }
+
+  // Reads the clock immediately (for checks outside of inner loops).
+  inline bool check() {
+    if (!limited_ || reached_) {
+      return reached_;
+    }
+    reached_ = clock::now() >= end_;
+    return reached_;
+  }
+
+  bool is_limited() const { return limited_; }
+
+private:
+  bool limited_{false};
+  bool reached_{false};
+  uint32_t calls_{0U};
+  clock::time_point end_{};
+};
+
+}  // namespace motis
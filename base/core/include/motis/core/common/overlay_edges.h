@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cinttypes>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace motis {
+
+// A few additional edges attached to a graph with dense node indices
+// (e.g. query specific edges). Checking whether a node has additional edges
+// is a single bit test. The edges of all nodes are stored in one array,
+// grouped by node (in insertion order).
+template <typename Edge>
+struct overlay_edges {
+  using node_idx_t = uint32_t;
+
+  static constexpr auto const BITS = 64U;
+
+  overlay_edges() = default;
+
+  explicit overlay_edges(std::vector<std::pair<node_idx_t, Edge>> edges) {
+    if (edges.empty()) {
+      return;
+    }
+
+    std::stable_sort(begin(edges), end(edges),
+                     [](auto const& a, auto const& b) {
+                       return a.first < b.first;
+                     });
+
+    has_edges_.resize(edges.back().first / BITS + 1U);
+    edges_.reserve(edges.size());
+    for (auto& [n, e] : edges) {
+      if (nodes_.empty() || nodes_.back() != n) {
+        nodes_.push_back(n);
+        offsets_.push_back(static_cast<uint32_t>(edges_.size()));
+        has_edges_[n / BITS] |= uint64_t{1U} << (n % BITS);
+      }
+      edges_.emplace_back(std::move(e));
+    }
+    offsets_.push_back(static_cast<uint32_t>(edges_.size()));
+  }
+
+  bool empty() const { return edges_.empty(); }
+
+  inline bool has_edges(node_idx_t const n) const {
+    auto const word = n / BITS;
+    return word < has_edges_.size() &&
+           ((has_edges_[word] >> (n % BITS)) & 1U) != 0U;
+  }
+
+  template <typename Fn>
+  inline void for_each_edge(node_idx_t const n, Fn&& fn) const {
+    if (!has_edges(n)) {
+      return;
+    }
+
+    auto const idx = static_cast<std::size_t>(
+        std::lower_bound(begin(nodes_), end(nodes_), n) - begin(nodes_));
+    for (auto i = offsets_[idx]; i != offsets_[idx + 1]; ++i) {
+      fn(edges_[i]);
+    }
+  }
+
+  std::vector<uint64_t> has_edges_;
+  std::vector<node_idx_t> nodes_;
+  std::vector<uint32_t> offsets_;
+  std::vector<Edge> edges_;
+};
+
+}  // namespace motis
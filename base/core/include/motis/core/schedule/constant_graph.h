@@ -7,6 +7,7 @@
 #include "motis/vector.h"
 
 #include "motis/core/common/dial.h"
+#include "motis/core/common/overlay_edges.h"
 #include "motis/core/schedule/nodes.h"
 
 namespace motis {
@@ -166,10 +167,10 @@ public:
 
   enum : dist_t { UNREACHABLE = std::numeric_limits<dist_t>::max() };
 
-  constant_graph_dijkstra(
-      constant_graph const& g, std::vector<int> const& goals,
-      mcd::hash_map<unsigned, std::vector<simple_edge>> const& additional_edges,
-      MapNodeFn map_node = MapNodeFn())
+  constant_graph_dijkstra(constant_graph const& g,
+                          std::vector<int> const& goals,
+                          overlay_edges<simple_edge> const& additional_edges,
+                          MapNodeFn map_node = MapNodeFn())
       : graph_(g),
         additional_edges_(additional_edges),
         map_node_(std::forward<MapNodeFn>(map_node)) {
@@ -195,12 +196,9 @@ public:
         expand_edge(label.dist_, edge);
       }
 
-      auto additional_edges_it = additional_edges_.find(label.node_);
-      if (additional_edges_it != std::end(additional_edges_)) {
-        for (auto const& edge : additional_edges_it->second) {
-          expand_edge(label.dist_, edge);
-        }
-      }
+      additional_edges_.for_each_edge(
+          label.node_,
+          [&](simple_edge const& edge) { expand_edge(label.dist_, edge); });
     }
   }
 
@@ -217,7 +215,7 @@ public:
   constant_graph const& graph_;
   dial<label, MaxValue, get_bucket> pq_;
   mcd::vector<dist_t> dists_;
-  mcd::hash_map<unsigned, std::vector<simple_edge>> const& additional_edges_;
+  overlay_edges<simple_edge> const& additional_edges_;
   MapNodeFn map_node_;
 };
 
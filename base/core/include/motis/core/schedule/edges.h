@@ -49,6 +49,14 @@ const edge_cost NO_EDGE = edge_cost();
 
 enum class search_dir { FWD, BWD };
 
+// Dense search indices of route edges (see edge::build_route_edge_index).
+// Stored next to the graph (schedule::route_edge_indices_) instead of inside
+// the edge union, which would grow all edges. Layout for n connections:
+//   [0, n)                  d_time_ of conns_[i]
+//   [n, 2n)                 a_time_ of conns_[i]
+//   [2n, 2n + ceil(n / 16)) valid_ of conns_[i] as bitmap
+using route_edge_indices = mcd::vector<mcd::vector<uint16_t>>;
+
 class edge {
 public:
   enum type {
@@ -111,10 +119,10 @@ public:
   }
 
   template <search_dir Dir = search_dir::FWD>
-  edge_cost get_edge_cost(time start_time,
-                          light_connection const* last_con) const {
+  edge_cost get_edge_cost(time start_time, light_connection const* last_con,
+                          route_edge_indices const* indices = nullptr) const {
     switch (m_.type_) {
-      case ROUTE_EDGE: return get_route_edge_cost<Dir>(start_time);
+      case ROUTE_EDGE: return get_route_edge_cost<Dir>(start_time, indices);
 
       case ENTER_EDGE:
         if (Dir == search_dir::FWD) {
@@ -257,14 +265,22 @@ public:
     return nullptr;
   }
 
+  // Uses the dense index of the edge if it has one in indices.
   template <search_dir Dir = search_dir::FWD>
-  light_connection const* get_connection(time const start_time) const {
+  light_connection const* get_connection(
+      time const start_time,
+      route_edge_indices const* indices = nullptr) const {
     assert(type() == ROUTE_EDGE);
 
     if (m_.route_edge_.conns_.empty()) {
       return nullptr;
     }
 
+    if (indices != nullptr && has_route_edge_index()) {
+      return get_indexed_connection<Dir>(
+          start_time, (*indices)[m_.route_edge_.index_id_ - 1U]);
+    }
+
     if (Dir == search_dir::FWD) {
       auto it = std::lower_bound(std::begin(m_.route_edge_.conns_),
                                  std::end(m_.route_edge_.conns_),
@@ -291,11 +307,53 @@ public:
     }
   }
 
+  /** writes the dense departure index of conns_ (see route_edge_indices). */
+  void write_route_edge_index(mcd::vector<uint16_t>& index) const {
+    assert(type() == ROUTE_EDGE);
+
+    auto const& re = m_.route_edge_;
+    auto const n = static_cast<unsigned>(re.conns_.size());
+    index.resize(2U * n + (n + INDEX_VALID_BITS - 1U) / INDEX_VALID_BITS);
+
+    auto const times = index.begin();
+    auto const valid = times + 2U * n;
+    std::fill(valid, index.end(), uint16_t{0U});
+    for (auto i = 0U; i < n; ++i) {
+      auto const& lcon = re.conns_[i];
+      times[i] = lcon.d_time_;
+      times[n + i] = lcon.a_time_;
+      if (lcon.valid_ != 0U) {
+        valid[i / INDEX_VALID_BITS] |= 1U << (i % INDEX_VALID_BITS);
+      }
+    }
+  }
+
+  /** adds a new dense departure index for this edge to indices. */
+  void build_route_edge_index(route_edge_indices& indices) {
+    assert(type() == ROUTE_EDGE);
+    indices.emplace_back();
+    m_.route_edge_.index_id_ = static_cast<uint32_t>(indices.size());
+    write_route_edge_index(indices.back());
+  }
+
+  /** has to be called after modifying conns_ (times or validity). */
+  void update_route_edge_index(route_edge_indices& indices) const {
+    if (has_route_edge_index()) {
+      write_route_edge_index(indices[m_.route_edge_.index_id_ - 1U]);
+    }
+  }
+
+  inline bool has_route_edge_index() const {
+    return type() == ROUTE_EDGE && m_.route_edge_.index_id_ != 0U;
+  }
+
   template <search_dir Dir = search_dir::FWD>
-  edge_cost get_route_edge_cost(time const start_time) const {
+  edge_cost get_route_edge_cost(
+      time const start_time,
+      route_edge_indices const* indices = nullptr) const {
     assert(type() == ROUTE_EDGE);
 
-    light_connection const* c = get_connection<Dir>(start_time);
+    light_connection const* c = get_connection<Dir>(start_time, indices);
     return (c == nullptr)
                ? NO_EDGE
                : edge_cost((Dir == search_dir::FWD) ? c->a_time_ - start_time
@@ -460,9 +518,17 @@ public:
     // TYPE = ROUTE_EDGE
     struct re {
       uint8_t type_padding_;
+
+      // 1 + position of the dense search index in route_edge_indices
+      // (0: none). Fits into the padding before conns_.
+      uint32_t index_id_;
+
       mcd::vector<light_connection> conns_;
 
-      void init_empty() { new (&conns_) mcd::vector<light_connection>(); }
+      void init_empty() {
+        index_id_ = 0U;
+        new (&conns_) mcd::vector<light_connection>();
+      }
     } route_edge_;
 
     // TYPE = FOOT_EDGE & CO
@@ -503,6 +569,85 @@ public:
   } m_;
 
 private:
+  static constexpr auto const INDEX_VALID_BITS = 16U;
+
+  // Route edges up to this size are searched with a branchless linear scan
+  // (vectorizable, 64 byte = one cache line of departure times).
+  static constexpr auto const INDEX_LINEAR_SCAN_SIZE = 32U;
+
+  // Number of entries of the sorted range [times, times + n) less than t
+  // (Inclusive: less than or equal to t).
+  template <bool Inclusive>
+  static unsigned count_before(uint16_t const* times, unsigned const n,
+                               time const t) {
+    if (n <= INDEX_LINEAR_SCAN_SIZE) {
+      auto count = 0U;
+      for (auto i = 0U; i < n; ++i) {
+        count +=
+            static_cast<unsigned>(Inclusive ? times[i] <= t : times[i] < t);
+      }
+      return count;
+    } else {
+      return static_cast<unsigned>(
+          (Inclusive ? std::upper_bound(times, times + n, t)
+                     : std::lower_bound(times, times + n, t)) -
+          times);
+    }
+  }
+
+  // First valid connection index >= i (n if there is none).
+  unsigned next_valid_index(mcd::vector<uint16_t> const& index,
+                            unsigned i) const {
+    auto const n = static_cast<unsigned>(m_.route_edge_.conns_.size());
+    auto const valid = index.begin() + 2U * n;
+    while (i < n) {
+      auto const word =
+          static_cast<unsigned>(valid[i / INDEX_VALID_BITS]) >>
+          (i % INDEX_VALID_BITS);
+      if (word == 0U) {
+        i = (i / INDEX_VALID_BITS + 1U) * INDEX_VALID_BITS;
+      } else if ((word & 1U) != 0U) {
+        return i;
+      } else {
+        ++i;
+      }
+    }
+    return n;
+  }
+
+  // Last valid connection index < i (n if there is none).
+  unsigned prev_valid_index(mcd::vector<uint16_t> const& index,
+                            unsigned i) const {
+    auto const n = static_cast<unsigned>(m_.route_edge_.conns_.size());
+    auto const valid = index.begin() + 2U * n;
+    while (i != 0U) {
+      --i;
+      auto const word = static_cast<unsigned>(valid[i / INDEX_VALID_BITS]);
+      if (word == 0U) {
+        i = (i / INDEX_VALID_BITS) * INDEX_VALID_BITS;
+      } else if (((word >> (i % INDEX_VALID_BITS)) & 1U) != 0U) {
+        return i;
+      }
+    }
+    return n;
+  }
+
+  template <search_dir Dir>
+  light_connection const* get_indexed_connection(
+      time const start_time, mcd::vector<uint16_t> const& index) const {
+    auto const& re = m_.route_edge_;
+    auto const n = static_cast<unsigned>(re.conns_.size());
+    auto const times = index.begin();
+
+    auto const idx =
+        Dir == search_dir::FWD
+            ? next_valid_index(index,
+                               count_before<false>(times, n, start_time))
+            : prev_valid_index(
+                  index, count_before<true>(times + n, n, start_time));
+    return idx == n ? nullptr : &re.conns_[idx];
+  }
+
   edge_cost calc_cost_time_dependent_edge(time const start_time) const {
     if (start_time > m_.foot_edge_.interval_end_) {
       return NO_EDGE;
@@ -50,10 +50,12 @@ struct schedule {
   constant_graph travel_time_lower_bounds_bwd_;
   constant_graph transfers_lower_bounds_fwd_;
   constant_graph transfers_lower_bounds_bwd_;
+  uint32_t constant_graph_version_{0U};
   node_id_t node_count_{0U};
   uint32_t route_count_{0U};
   mcd::vector<station_node_ptr> station_nodes_;
   mcd::vector<ptr<node>> route_index_to_first_route_node_;
+  route_edge_indices route_edge_indices_;  // see edge::get_connection
   mcd::hash_map<uint32_t, mcd::vector<int32_t>> train_nr_to_routes_;
   waiting_time_rules waiting_time_rules_;
 
@@ -0,0 +1,40 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+
+#include "motis/core/common/deadline.h"
+
+using namespace motis;
+
+TEST(core_deadline, unlimited) {
+  deadline d;
+  EXPECT_FALSE(d.is_limited());
+  for (auto i = 0U; i < 4 * deadline::CHECK_INTERVAL; ++i) {
+    EXPECT_FALSE(d.reached());
+  }
+  EXPECT_FALSE(d.check());
+
+  auto const zero = deadline::from_timeout_ms(0U, 0U);
+  EXPECT_FALSE(zero.is_limited());
+}
+
+TEST(core_deadline, request_timeout_overrides_default) {
+  auto d = deadline::from_timeout_ms(1U, 60U * 60U * 1000U);
+  EXPECT_TRUE(d.is_limited());
+  std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  EXPECT_TRUE(d.check());
+  EXPECT_TRUE(d.reached());
+}
+
+TEST(core_deadline, reached_checks_clock_periodically) {
+  auto d = deadline{std::chrono::milliseconds{1}};
+  std::this_thread::sleep_for(std::chrono::milliseconds{5});
+
+  auto calls = 0U;
+  while (!d.reached()) {
+    ++calls;
+  }
+  EXPECT_EQ(deadline::CHECK_INTERVAL - 1, calls);
+  EXPECT_TRUE(d.reached());
+}
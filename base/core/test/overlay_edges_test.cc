@@ -0,0 +1,36 @@
+#include "gtest/gtest.h"
+
+#include <utility>
+#include <vector>
+
+#include "motis/core/common/overlay_edges.h"
+
+using namespace motis;
+
+std::vector<int> edges_of(overlay_edges<int> const& o, uint32_t const n) {
+  std::vector<int> edges;
+  o.for_each_edge(n, [&](int const e) { edges.push_back(e); });
+  return edges;
+}
+
+TEST(core_overlay_edges, empty) {
+  overlay_edges<int> const o;
+  EXPECT_TRUE(o.empty());
+  EXPECT_FALSE(o.has_edges(0U));
+  EXPECT_FALSE(o.has_edges(1000U));
+  EXPECT_TRUE(edges_of(o, 0U).empty());
+}
+
+TEST(core_overlay_edges, grouped_by_node) {
+  overlay_edges<int> const o{std::vector<std::pair<uint32_t, int>>{
+      {130U, 1}, {7U, 2}, {130U, 3}, {64U, 4}, {7U, 5}}};
+  EXPECT_FALSE(o.empty());
+
+  for (auto n = 0U; n < 200U; ++n) {
+    EXPECT_EQ(n == 7U || n == 64U || n == 130U, o.has_edges(n));
+  }
+  EXPECT_EQ((std::vector<int>{2, 5}), edges_of(o, 7U));
+  EXPECT_EQ((std::vector<int>{4}), edges_of(o, 64U));
+  EXPECT_EQ((std::vector<int>{1, 3}), edges_of(o, 130U));
+  EXPECT_TRUE(edges_of(o, 8U).empty());
+}
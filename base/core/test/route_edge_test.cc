@@ -91,3 +91,59 @@ TEST(core_route_edge, get_connection_reverse_end_test) {
 
   EXPECT_FALSE(e1.get_connection<search_dir::BWD>(11));
 }
+
+TEST(core_route_edge, indexed_get_connection_matches_test) {
+  mcd::vector<light_connection> lcons;
+  for (auto i = 0U; i < 100U; ++i) {
+    lcons.emplace_back(static_cast<motis::time>(10U + 3U * i),
+                       static_cast<motis::time>(20U + 3U * i));
+  }
+  auto e1 = make_route_edge(nullptr, nullptr, lcons);
+  for (auto i = 0U; i < 100U; ++i) {
+    e1.m_.route_edge_.conns_[i].valid_ = (i % 7U == 0U || i > 40U) ? 1U : 0U;
+  }
+
+  route_edge_indices indices;
+  auto e2 = e1;
+  e2.build_route_edge_index(indices);
+  ASSERT_TRUE(e2.has_route_edge_index());
+  ASSERT_FALSE(e1.has_route_edge_index());
+  ASSERT_EQ(1U, indices.size());
+
+  auto const idx = [](edge const& e, light_connection const* c) {
+    return c == nullptr ? -1 : c - &e.m_.route_edge_.conns_[0];
+  };
+  for (auto t = motis::time{0U}; t < 350U; ++t) {
+    EXPECT_EQ(idx(e1, e1.get_connection(t)),
+              idx(e2, e2.get_connection(t, &indices)));
+    EXPECT_EQ(idx(e1, e1.get_connection<search_dir::BWD>(t)),
+              idx(e2, e2.get_connection<search_dir::BWD>(t, &indices)));
+  }
+}
+
+TEST(core_route_edge, indexed_get_connection_update_test) {
+  route_edge_indices indices;
+  auto e1 = e;
+  e1.build_route_edge_index(indices);
+
+  e1.m_.route_edge_.conns_[1].valid_ = 0U;
+  e1.update_route_edge_index(indices);
+
+  auto c = e1.get_connection(1, &indices);
+  ASSERT_TRUE(c);
+  EXPECT_EQ(2, c->d_time_);
+
+  c = e1.get_connection<search_dir::BWD>(11, &indices);
+  ASSERT_TRUE(c);
+  EXPECT_EQ(0, c->d_time_);
+
+  e1.m_.route_edge_.conns_[0].valid_ = 0U;
+  e1.update_route_edge_index(indices);
+  EXPECT_FALSE(e1.get_connection<search_dir::BWD>(11, &indices));
+}
+
+TEST(core_route_edge, index_does_not_grow_edges) {
+  // index id in the padding between the edge type and the connections
+  EXPECT_EQ(sizeof(uint64_t) + sizeof(mcd::vector<light_connection>),
+            sizeof(edge::edge_details));
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "motis/core/schedule/schedule.h"
+
+namespace motis::loader {
+
+// Renumbers and reallocates route nodes and foot nodes such that nodes of
+// nearby stations (Hilbert curve order of the station coordinates) are
+// adjacent in memory and in id space. Station nodes keep their ids.
+// Has to be called before anything stores ev_keys (waits for, delays).
+void reorder_graph(schedule&);
+
+}  // namespace motis::loader
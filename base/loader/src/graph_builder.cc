@@ -28,6 +28,7 @@
 #include "motis/loader/build_stations.h"
 #include "motis/loader/classes.h"
 #include "motis/loader/interval_util.h"
+#include "motis/loader/reorder_graph.h"
 #include "motis/loader/rule_route_builder.h"
 #include "motis/loader/rule_service_graph_builder.h"
 #include "motis/loader/util.h"
@@ -792,6 +793,24 @@ schedule_ptr build_graph(std::vector<Schedule const*> const& fbs_schedules,
   progress_tracker->status("Sort Trips").out_bounds(93, 95);
   builder.sort_trips();
 
+  if (opt.reorder_graph_) {
+    progress_tracker->status("Reorder Graph").out_bounds(95, 96);
+    reorder_graph(*sched);
+  }
+
+  if (opt.route_edge_index_) {
+    scoped_timer timer("route edge indices");
+    for (auto const& station : sched->station_nodes_) {
+      for (auto const& route_node : station->route_nodes_) {
+        for (auto& e : route_node->edges_) {
+          if (e.type() == edge::ROUTE_EDGE) {
+            e.build_route_edge_index(sched->route_edge_indices_);
+          }
+        }
+      }
+    }
+  }
+
   auto hash = cista::BASE_HASH;
   for (auto const* fbs_schedule : fbs_schedules) {
     hash = cista::hash_combine(hash, fbs_schedule->hash());
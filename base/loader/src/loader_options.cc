@@ -31,7 +31,8 @@ std::string loader_options::graph_path() const {
     std::stringstream ss;
     ss << "graph_" << from << "-" << to << "af" << adjust_footpaths_ << "ar"
        << apply_rules_ << "et" << expand_trips_ << "ef" << expand_footpaths_
-       << "ptd" << planned_transfer_delta_ << ".raw";
+       << "ptd" << planned_transfer_delta_ << "ri" << route_edge_index_
+       << "rg" << reorder_graph_ << ".raw";
     return ss.str();
   } else {
     return graph_path_;
@@ -0,0 +1,125 @@
+#include "motis/loader/reorder_graph.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utl/to_vec.h"
+#include "utl/verify.h"
+
+#include "motis/core/common/logging.h"
+
+using namespace motis::logging;
+
+namespace motis::loader {
+
+constexpr auto const kHilbertOrder = 16U;
+
+// Position of (x, y) on the Hilbert curve filling a 2^16 x 2^16 grid.
+uint64_t hilbert_index(uint32_t x, uint32_t y) {
+  constexpr auto const n = 1U << kHilbertOrder;
+
+  auto d = uint64_t{0U};
+  for (auto s = n / 2U; s > 0U; s /= 2U) {
+    auto const rx = (x & s) != 0U ? 1U : 0U;
+    auto const ry = (y & s) != 0U ? 1U : 0U;
+    d += uint64_t{s} * s * ((3U * rx) ^ ry);
+    if (ry == 0U) {
+      if (rx == 1U) {
+        x = n - 1U - x;
+        y = n - 1U - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+uint64_t hilbert_index(station const& s) {
+  constexpr auto const max = (1U << kHilbertOrder) - 1U;
+  auto const to_grid = [](double const val, double const range) {
+    auto const normalized = (val + range) / (2.0 * range);
+    return static_cast<uint32_t>(std::clamp(normalized, 0.0, 1.0) * max);
+  };
+  return hilbert_index(to_grid(s.lng(), 180.0), to_grid(s.lat(), 90.0));
+}
+
+void reorder_graph(schedule& sched) {
+  scoped_timer timer("reorder graph");
+
+  auto const curve_pos = utl::to_vec(
+      sched.stations_, [](station_ptr const& s) { return hilbert_index(*s); });
+  std::vector<uint32_t> station_order(sched.station_nodes_.size());
+  std::iota(begin(station_order), end(station_order), 0U);
+  std::stable_sort(begin(station_order), end(station_order),
+                   [&](uint32_t const a, uint32_t const b) {
+                     return curve_pos[a] < curve_pos[b];
+                   });
+
+  // Old nodes are kept alive until all pointers are updated: this way, no new
+  // node can reuse the address of an old node (keys of the mapping).
+  std::unordered_map<node const*, node*> moved;
+  std::vector<mcd::unique_ptr<node>> old_nodes;
+  auto next_id = static_cast<node_id_t>(sched.station_nodes_.size());
+  auto const relocate = [&](mcd::unique_ptr<node>& n) {
+    auto relocated = mcd::make_unique<node>(std::move(*n));
+    relocated->id_ = next_id++;
+    moved[n.get()] = relocated.get();
+    old_nodes.emplace_back(std::move(n));
+    n = std::move(relocated);
+  };
+
+  for (auto const station_idx : station_order) {
+    auto& station_node = sched.station_nodes_[station_idx];
+    std::stable_sort(begin(station_node->route_nodes_),
+                     end(station_node->route_nodes_),
+                     [](mcd::unique_ptr<node> const& a,
+                        mcd::unique_ptr<node> const& b) {
+                       return a->route_ < b->route_;
+                     });
+    for (auto& route_node : station_node->route_nodes_) {
+      relocate(route_node);
+    }
+    if (station_node->foot_node_ != nullptr) {
+      relocate(station_node->foot_node_);
+    }
+  }
+  utl::verify(next_id == sched.node_count_,
+              "reorder_graph: {} nodes renumbered, {} expected", next_id,
+              sched.node_count_);
+
+  auto const update = [&](ptr<node>& n) {
+    if (auto const it = moved.find(n); it != end(moved)) {
+      n = it->second;
+    }
+  };
+  auto const update_edges = [&](node& n) {
+    for (auto& e : n.edges_) {
+      update(e.from_);
+      update(e.to_);
+    }
+  };
+  for (auto& station_node : sched.station_nodes_) {
+    update_edges(*station_node);
+    for (auto& route_node : station_node->route_nodes_) {
+      update_edges(*route_node);
+    }
+    if (station_node->foot_node_ != nullptr) {
+      update_edges(*station_node->foot_node_);
+    }
+  }
+  for (auto& route_node : sched.route_index_to_first_route_node_) {
+    update(route_node);
+  }
+  for (auto& trip_edges : sched.trip_edges_) {
+    for (auto& e : *trip_edges) {
+      update(e.route_node_);
+    }
+  }
+
+  LOG(info) << "reordered " << moved.size() << " nodes";
+}
+
+}  // namespace motis::loader
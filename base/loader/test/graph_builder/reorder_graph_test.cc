@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "utl/enumerate.h"
+
+#include "motis/core/access/trip_iterator.h"
+#include "motis/loader/loader.h"
+
+#include "../hrd/paths.h"
+
+using namespace motis::access;
+
+namespace motis::loader {
+
+schedule_ptr load_mss_ts(bool const reorder) {
+  auto opt = loader_options{
+      {(hrd::SCHEDULES / "mss-ts").string()}, "20150325", 3};
+  opt.reorder_graph_ = reorder;
+  return load_schedule(opt);
+}
+
+std::vector<std::tuple<uint32_t, uint32_t, time, time>> trip_sections(
+    schedule const& sched) {
+  std::vector<std::tuple<uint32_t, uint32_t, time, time>> sections_vec;
+  for (auto const& t : sched.trips_) {
+    for (auto const& sec : sections(t.second)) {
+      sections_vec.emplace_back(sec.from_station_id(), sec.to_station_id(),
+                                sec.lcon().d_time_, sec.lcon().a_time_);
+    }
+  }
+  return sections_vec;
+}
+
+TEST(loader_reorder_graph, same_graph) {
+  auto const sched = load_mss_ts(false);
+  auto const reordered = load_mss_ts(true);
+
+  ASSERT_EQ(sched->node_count_, reordered->node_count_);
+  EXPECT_EQ(trip_sections(*sched), trip_sections(*reordered));
+
+  std::vector<node const*> nodes(reordered->node_count_, nullptr);
+  auto const add_node = [&](node const* n) {
+    ASSERT_LT(n->id_, nodes.size());
+    ASSERT_EQ(nullptr, nodes[n->id_]);
+    nodes[n->id_] = n;
+
+    for (auto const& e : n->edges_) {
+      EXPECT_EQ(n, e.from_);
+      auto const& in = e.to_->incoming_edges_;
+      EXPECT_NE(end(in), std::find(begin(in), end(in), &e));
+    }
+  };
+  for (auto const& [i, sn] : utl::enumerate(reordered->station_nodes_)) {
+    EXPECT_EQ(i, sn->id_);
+    add_node(sn.get());
+    for (auto const& rn : sn->route_nodes_) {
+      EXPECT_EQ(sn.get(), rn->station_node_);
+      add_node(rn.get());
+    }
+    if (sn->foot_node_ != nullptr) {
+      add_node(sn->foot_node_.get());
+    }
+  }
+  EXPECT_TRUE(std::all_of(begin(nodes), end(nodes),
+                          [](node const* n) { return n != nullptr; }));
+
+  for (auto const& trip_edges : reordered->trip_edges_) {
+    for (auto const& e : *trip_edges) {
+      EXPECT_EQ(e.route_node_, e->from_);
+    }
+  }
+}
+
+}  // namespace motis::loader
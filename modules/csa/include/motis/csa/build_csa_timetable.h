@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "motis/core/schedule/schedule.h"
 
 #include "motis/csa/csa_timetable.h"
@@ -8,6 +11,24 @@ namespace motis::csa {
 
 std::unique_ptr<csa_timetable> build_csa_timetable(
     schedule const&, bool bridge_zero_duration_connections,
-    bool add_footpath_connections);
+    bool add_footpath_connections, bool connection_arrays);
+
+// Deep copy (the copy does not point into the timetable or a mapped file).
+// Without the GPU timetable.
+std::unique_ptr<csa_timetable> copy_csa_timetable(csa_timetable const&);
+
+// Creates the stations (incl. footpaths) of the timetable.
+void init_stations(schedule const&, csa_timetable&);
+
+// Creates everything that is derived from the sorted connections: trip and
+// station connection lists, connection arrays (if enabled), GPU timetable.
+void finish_csa_timetable(csa_timetable&, bool connection_arrays);
+
+// Bucket start indices (relative to it_begin, incl. the end index) of
+// connections sorted for the search direction.
+std::vector<uint32_t> get_bucket_starts(
+    std::vector<csa_connection>::const_iterator it_begin,
+    std::vector<csa_connection>::const_iterator it_end, search_dir,
+    bool bridged);
 
 }  // namespace motis::csa
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "motis/core/schedule/time.h"
+
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_timetable.h"
+
+// Labels of the price-aware searches (csa_search_price.h,
+// csa_search_price_buckets.h), separate from the searches for the pooled
+// search state (csa_search_state.h).
+namespace motis::csa::price {
+
+using price_t = uint16_t;
+
+constexpr price_t MINUTE_PRICE = 8;
+constexpr price_t INVALID_PRICE = std::numeric_limits<price_t>::max();
+constexpr trip_id INVALID_TRIP = std::numeric_limits<trip_id>::max();
+
+template <typename T>
+inline price_t add_price(price_t base, T additional) {
+  return static_cast<price_t>(std::min(
+      static_cast<uint32_t>(std::numeric_limits<price_t>::max()),
+      static_cast<uint32_t>(base) + static_cast<uint32_t>(additional)));
+}
+
+struct station_arrival_info {
+  station_arrival_info() = default;
+  station_arrival_info(time arrival_time, price_t price)
+      : time_(arrival_time), price_(price) {}
+
+  time time_{0};
+  price_t price_{INVALID_PRICE};
+
+  template <search_dir Dir>
+  inline bool dominates(station_arrival_info const& other) const {
+    return (Dir == search_dir::FWD ? time_ <= other.time_
+                                   : time_ >= other.time_) &&
+           dominates_price<Dir>(other);
+  }
+
+  template <search_dir Dir>
+  inline bool dominates_price(station_arrival_info const& other) const {
+    uint32_t const min_wage_diff = time_ > other.time_
+                                       ? (time_ - other.time_) * MINUTE_PRICE
+                                       : (other.time_ - time_) * MINUTE_PRICE;
+    auto const fwd = Dir == search_dir::FWD;
+
+    uint32_t const this_price =
+        (time_ > other.time_) == fwd ? price_ : price_ + min_wage_diff;
+    uint32_t const other_price = (time_ > other.time_) == fwd
+                                     ? other.price_ + min_wage_diff
+                                     : other.price_;
+
+    return this_price <= other_price;
+  }
+};
+
+}  // namespace motis::csa::price
+
+namespace motis::csa::price_buckets {
+
+constexpr auto const MAX_PRICE_BUCKETS = 8U;
+
+// Labels of a station for one transfer count (unused buckets: time = the
+// invalid time of the search direction, fare = INVALID_PRICE).
+struct bucket_labels {
+  static bucket_labels make(time const invalid) {
+    return {array_maker<time, MAX_PRICE_BUCKETS>::make_array(invalid),
+            array_maker<price::price_t, MAX_PRICE_BUCKETS>::make_array(
+                price::INVALID_PRICE)};
+  }
+
+  std::array<time, MAX_PRICE_BUCKETS> time_;
+  std::array<price::price_t, MAX_PRICE_BUCKETS> fare_;
+};
+
+using station_labels = std::array<bucket_labels, MAX_TRANSFERS + 1>;
+using fares = std::array<price::price_t, MAX_TRANSFERS + 1>;
+
+}  // namespace motis::csa::price_buckets
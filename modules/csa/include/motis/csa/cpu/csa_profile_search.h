@@ -0,0 +1,467 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "utl/verify.h"
+
+#include "motis/core/common/timing.h"
+#include "motis/core/schedule/interval.h"
+#include "motis/core/schedule/schedule.h"
+
+#include "motis/csa/collect_start_times.h"
+#include "motis/csa/csa_journey.h"
+#include "motis/csa/csa_query.h"
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_statistics.h"
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa::cpu {
+
+// Profile connection scan for pretrip queries (strategy for pretrip<>).
+//
+// Instead of one ontrip scan per start time, the connections are scanned
+// once in reverse (descending departure times for forward searches) while
+// maintaining
+//  - per trip and trip budget: the best arrival at the destination when
+//    sitting in the trip and the connection to exit the trip, and
+//  - per station and trip budget: the pareto profile of
+//    (departure, arrival at the destination) pairs.
+// The budget r is the maximum number of trips used from there on.
+//
+// Afterwards, the profiles of the start stations are evaluated for the same
+// start times as the iterated ontrip search. The profile for the budget r
+// yields the earliest arrival with at most r trips; the journeys with
+// exactly k trips found by the iterated search that are not dominated are
+// contained. Transfer and footpath semantics match the ontrip scan: a
+// footpath (incl. the transfer time footpath) is expanded after each trip,
+// at the start, and to reach the destination.
+template <search_dir Dir>
+struct csa_profile_search {
+  static constexpr auto INVALID = Dir == search_dir::FWD
+                                      ? std::numeric_limits<time>::max()
+                                      : std::numeric_limits<time>::min();
+
+  // Entry of a station profile: boarding at the station at time_ with the
+  // connection enter_con_ reaches the destination at target_time_ (forward:
+  // arrival, backward: departure) when exiting the trip at exit_con_.
+  struct profile_entry {
+    time time_;
+    time target_time_;
+    csa_connection const* enter_con_;
+    csa_connection const* exit_con_;
+  };
+
+  struct trip_entry {
+    time target_time_{INVALID};
+    csa_connection const* exit_con_{nullptr};
+  };
+
+  // Index r - 1 for the trip budget r = 1 .. MAX_TRANSFERS.
+  using profile = std::array<std::vector<profile_entry>, MAX_TRANSFERS>;
+  using trip_profile = std::array<trip_entry, MAX_TRANSFERS>;
+
+  csa_profile_search(schedule const& sched, csa_timetable const& tt,
+                     csa_query const& q, csa_statistics& stats)
+      : sched_{sched}, tt_{tt}, q_{q}, stats_{stats} {}
+
+  template <typename Results>
+  void search_in_interval(Results& results, interval const& search_interval,
+                          bool const ontrip_at_interval_end) {
+    auto const start_times =
+        collect_start_times(tt_, q_, search_interval, ontrip_at_interval_end);
+    if (start_times.empty()) {
+      return;
+    }
+
+    MOTIS_START_TIMING(search_timing);
+    init_target_offsets();
+    auto const scanned_until =
+        scan(*start_times.begin(), *start_times.rbegin());
+    MOTIS_STOP_TIMING(search_timing);
+
+    MOTIS_START_TIMING(reconstruction_timing);
+    for (auto const start_time : start_times) {
+      if (better(start_time, scanned_until)) {
+        continue;  // timeout: connections after start_time not scanned
+      }
+      collect_results(start_time, results);
+    }
+    MOTIS_STOP_TIMING(reconstruction_timing);
+
+    stats_.search_duration_ += MOTIS_TIMING_MS(search_timing);
+    stats_.search_duration_us_ += MOTIS_TIMING_US(search_timing);
+    stats_.reconstruction_duration_ += MOTIS_TIMING_MS(reconstruction_timing);
+  }
+
+  // Scan order helpers (forward: descending departures, backward: ascending
+  // arrivals). "Board" and "exit" refer to the search direction.
+  static inline bool better(time const a, time const b) {
+    return Dir == search_dir::FWD ? a < b : a > b;
+  }
+
+  static inline time add(time const t, time const d) {
+    return Dir == search_dir::FWD ? t + d : t - d;
+  }
+
+  static inline time board_time(csa_connection const& c) {
+    return Dir == search_dir::FWD ? c.departure_ : c.arrival_;
+  }
+
+  static inline time exit_time(csa_connection const& c) {
+    return Dir == search_dir::FWD ? c.arrival_ : c.departure_;
+  }
+
+  static inline station_id board_station(csa_connection const& c) {
+    return Dir == search_dir::FWD ? c.from_station_ : c.to_station_;
+  }
+
+  static inline station_id exit_station(csa_connection const& c) {
+    return Dir == search_dir::FWD ? c.to_station_ : c.from_station_;
+  }
+
+  static inline bool board_allowed(csa_connection const& c) {
+    return Dir == search_dir::FWD ? c.from_in_allowed_ : c.to_out_allowed_;
+  }
+
+  static inline bool exit_allowed(csa_connection const& c) {
+    return Dir == search_dir::FWD ? c.to_out_allowed_ : c.from_in_allowed_;
+  }
+
+  inline std::vector<footpath> const& footpaths(station_id const s) const {
+    return Dir == search_dir::FWD ? tt_.stations_[s].footpaths_
+                                  : tt_.stations_[s].incoming_footpaths_;
+  }
+
+  static inline station_id fp_target(footpath const& fp) {
+    return Dir == search_dir::FWD ? fp.to_station_ : fp.from_station_;
+  }
+
+  // Best profile entry boarding at or after t (in search direction).
+  static inline profile_entry const* query(
+      std::vector<profile_entry> const& p, time const t) {
+    auto const it = std::partition_point(
+        begin(p), end(p),
+        [&](profile_entry const& e) { return !better(e.time_, t); });
+    return it == begin(p) ? nullptr : &*std::prev(it);
+  }
+
+  void init_target_offsets() {
+    target_offset_.assign(tt_.stations_.size(), INVALID_TIME);
+    for (auto const& dest : q_.meta_dests_) {
+      target_offset_[dest] = 0U;
+    }
+    for (auto const& dest : q_.meta_dests_) {
+      auto const& fps = Dir == search_dir::FWD
+                            ? tt_.stations_[dest].incoming_footpaths_
+                            : tt_.stations_[dest].footpaths_;
+      for (auto const& fp : fps) {
+        auto const from =
+            Dir == search_dir::FWD ? fp.from_station_ : fp.to_station_;
+        if (fp.from_station_ != fp.to_station_ &&
+            fp.duration_ < target_offset_[from]) {
+          target_offset_[from] = fp.duration_;
+        }
+      }
+    }
+  }
+
+  // Returns the board time of the last scanned connection.
+  time scan(time const first_start, time const last_start) {
+    auto const& connections =
+        Dir == search_dir::FWD ? tt_.fwd_connections_ : tt_.bwd_connections_;
+
+    // forward: departures in [first_start, last_start + MAX_TRAVEL_TIME]
+    // (scanned from last_start + MAX_TRAVEL_TIME to first_start)
+    // backward: arrivals in [first_start - MAX_TRAVEL_TIME, last_start]
+    // (scanned from first_start - MAX_TRAVEL_TIME to last_start)
+    auto const scan_begin =
+        Dir == search_dir::FWD
+            ? static_cast<time>(std::min(
+                  static_cast<int>(last_start) + MAX_TRAVEL_TIME,
+                  static_cast<int>(std::numeric_limits<time>::max() - 1)))
+            : static_cast<time>(std::max(
+                  static_cast<int>(first_start) - MAX_TRAVEL_TIME, 0));
+    auto const scan_end = Dir == search_dir::FWD ? first_start : last_start;
+
+    profiles_.assign(tt_.stations_.size(), profile{});
+    trips_.assign(tt_.trip_count_, trip_profile{});
+
+    // connections are sorted by board time in reverse scan order
+    auto const first = std::make_reverse_iterator(std::upper_bound(
+        begin(connections), end(connections), scan_begin,
+        [](time const t, csa_connection const& c) {
+          return better(t, board_time(c));
+        }));
+
+    auto scanned_until = scan_end;
+    for (auto it = first; it != connections.rend(); ++it) {
+      auto const& con = *it;
+      if (better(board_time(con), scan_end)) {
+        break;
+      }
+      if (q_.deadline_ != nullptr && q_.deadline_->reached()) {
+        stats_.timeout_quit_ = true;
+        scanned_until = add(board_time(con), 1);
+        break;
+      }
+
+      if (con.light_con_ == nullptr && !is_trip_segment(con)) {
+        continue;  // footpath connection: footpaths are expanded below
+      }
+
+      stats_.connections_scanned_++;
+      auto& trip = trips_[con.trip_];
+
+      if (exit_allowed(con)) {
+        auto const exit_station_id = exit_station(con);
+        auto const offset = target_offset_[exit_station_id];
+        if (offset != INVALID_TIME) {
+          auto const target_time = add(exit_time(con), offset);
+          for (auto& t : trip) {
+            if (better(target_time, t.target_time_)) {
+              t = {target_time, &con};
+            }
+          }
+        }
+
+        for (auto const& fp : footpaths(exit_station_id)) {
+          auto const& p = profiles_[fp_target(fp)];
+          auto const t = add(exit_time(con), fp.duration_);
+          for (auto r = 1U; r < MAX_TRANSFERS; ++r) {
+            auto const e = query(p[r - 1], t);
+            if (e != nullptr && better(e->target_time_, trip[r].target_time_)) {
+              trip[r] = {e->target_time_, &con};
+            }
+          }
+        }
+      }
+
+      if (board_allowed(con)) {
+        auto& p = profiles_[board_station(con)];
+        for (auto r = 0U; r < MAX_TRANSFERS; ++r) {
+          if (trip[r].target_time_ != INVALID) {
+            add_entry(p[r], {board_time(con), trip[r].target_time_, &con,
+                             trip[r].exit_con_});
+          }
+        }
+      }
+    }
+    return scanned_until;
+  }
+
+  // Bridged connections span trip connections, footpath connections end at
+  // a station not served by the trip.
+  bool is_trip_segment(csa_connection const& con) const {
+    auto const& trip_cons = tt_.trip_to_connections_[con.trip_];
+    for (auto idx = std::size_t{con.trip_con_idx_}; idx < trip_cons.size();
+         ++idx) {
+      if (trip_cons[idx]->arrival_ == con.arrival_ &&
+          trip_cons[idx]->to_station_ == con.to_station_) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void add_entry(std::vector<profile_entry>& p, profile_entry const& e) {
+    if (!p.empty() && !better(e.target_time_, p.back().target_time_)) {
+      return;
+    }
+    if (!p.empty() && p.back().time_ == e.time_) {
+      p.back() = e;
+    } else {
+      p.emplace_back(e);
+      stats_.labels_created_++;
+    }
+  }
+
+  template <typename Results>
+  void collect_results(time const start_time, Results& results) {
+    // walking only (footpath from a start station to a destination)
+    auto walk_target_time = INVALID;
+    footpath const* walk = nullptr;
+    station_id walk_start = 0U;
+    for (auto const& start : q_.meta_starts_) {
+      for (auto const& fp : footpaths(start)) {
+        auto const target = fp_target(fp);
+        if (fp.from_station_ != fp.to_station_ &&
+            target_offset_[target] == 0U &&
+            better(add(start_time, fp.duration_), walk_target_time)) {
+          walk_target_time = add(start_time, fp.duration_);
+          walk = &fp;
+          walk_start = start;
+        }
+      }
+    }
+    if (walk != nullptr) {
+      auto j = csa_journey{Dir, start_time, walk_target_time, 0U,
+                           &tt_.stations_[fp_target(*walk)]};
+      j.start_station_ = &tt_.stations_[walk_start];
+      add_walk(j, *walk, start_time);
+      add_result(j, results);
+    }
+
+    auto last_target_time = walk_target_time;
+    for (auto r = 1U; r <= MAX_TRANSFERS; ++r) {
+      profile_entry const* best = nullptr;
+      footpath const* best_fp = nullptr;
+      station_id best_start = 0U;
+      for (auto const& start : q_.meta_starts_) {
+        for (auto const& fp : footpaths(start)) {
+          auto const offset =
+              fp.from_station_ == fp.to_station_ ? 0U : fp.duration_;
+          auto const e = query(profiles_[fp_target(fp)][r - 1],
+                               add(start_time, offset));
+          if (e != nullptr && (best == nullptr ||
+                               better(e->target_time_, best->target_time_))) {
+            best = e;
+            best_fp = &fp;
+            best_start = start;
+          }
+        }
+      }
+
+      if (best == nullptr || !better(best->target_time_, last_target_time)) {
+        continue;
+      }
+      last_target_time = best->target_time_;
+
+      auto j = csa_journey{Dir, start_time, best->target_time_, r, nullptr};
+      j.start_station_ = &tt_.stations_[best_start];
+      if (best_fp->from_station_ != best_fp->to_station_) {
+        add_walk(j, *best_fp, start_time);
+      }
+      reconstruct(j, *best, r);
+      add_result(j, results);
+    }
+  }
+
+  template <typename Results>
+  void add_result(csa_journey& j, Results& results) {
+    stats_.reconstruction_count_++;
+    if (Dir == search_dir::BWD) {
+      std::reverse(begin(j.edges_), end(j.edges_));
+    }
+    if (j.duration() <= MAX_TRAVEL_TIME) {
+      results.push_back(j);
+    }
+  }
+
+  // Adds the footpath walked at time t (in search direction).
+  void add_walk(csa_journey& j, footpath const& fp, time const t) {
+    auto const& from = tt_.stations_[fp.from_station_];
+    auto const& to = tt_.stations_[fp.to_station_];
+    if (Dir == search_dir::FWD) {
+      j.edges_.emplace_back(&from, &to, t, t + fp.duration_, -1);
+    } else {
+      j.edges_.emplace_back(&from, &to, t - fp.duration_, t, -1);
+    }
+  }
+
+  void reconstruct(csa_journey& j, profile_entry const& first,
+                   unsigned const budget) {
+    auto const target_time = first.target_time_;
+    auto e = &first;
+    auto trips = 0U;
+    for (auto r = budget; r != 0U; --r) {
+      auto const& exit_con = *e->exit_con_;
+      add_trip(j, *e->enter_con_, exit_con);
+      ++trips;
+
+      auto const exit_station_id = exit_station(exit_con);
+      auto const offset = target_offset_[exit_station_id];
+      if (offset != INVALID_TIME &&
+          !better(target_time, add(exit_time(exit_con), offset))) {
+        j.transfers_ = trips;
+        j.destination_station_ = &tt_.stations_[exit_station_id];
+        if (offset != 0U) {
+          add_destination_walk(j, exit_con);
+        }
+        j.arrival_time_ = add(exit_time(exit_con), offset);
+        return;
+      }
+
+      profile_entry const* next = nullptr;
+      for (auto const& fp : footpaths(exit_station_id)) {
+        auto const t = add(exit_time(exit_con), fp.duration_);
+        auto const candidate = r > 1U
+                                   ? query(profiles_[fp_target(fp)][r - 2], t)
+                                   : nullptr;
+        if (candidate != nullptr &&
+            !better(target_time, candidate->target_time_)) {
+          if (fp.from_station_ != fp.to_station_) {
+            add_walk(j, fp, exit_time(exit_con));
+          }
+          next = candidate;
+          break;
+        }
+      }
+      utl::verify(next != nullptr, "csa profile: journey reconstruction");
+      e = next;
+    }
+    utl::verify(false, "csa profile: trip budget exceeded");
+  }
+
+  void add_destination_walk(csa_journey& j, csa_connection const& exit_con) {
+    auto const exit_station_id = exit_station(exit_con);
+    for (auto const& fp : footpaths(exit_station_id)) {
+      auto const target = fp_target(fp);
+      if (fp.from_station_ != fp.to_station_ && target_offset_[target] == 0U &&
+          fp.duration_ == target_offset_[exit_station_id]) {
+        add_walk(j, fp, exit_time(exit_con));
+        j.destination_station_ = &tt_.stations_[target];
+        return;
+      }
+    }
+  }
+
+  // Adds the trip edges from board_con to exit_con (in search direction).
+  void add_trip(csa_journey& j, csa_connection const& board_con,
+                csa_connection const& exit_con) {
+    auto const& enter = Dir == search_dir::FWD ? board_con : exit_con;
+    auto const& exit = Dir == search_dir::FWD ? exit_con : board_con;
+    auto const& trip_cons = tt_.trip_to_connections_[enter.trip_];
+
+    // bridged connections span multiple trip connections
+    auto const enter_idx = static_cast<int>(enter.trip_con_idx_);
+    auto exit_idx = enter_idx;
+    while (exit_idx < static_cast<int>(trip_cons.size()) &&
+           (trip_cons[exit_idx]->arrival_ != exit.arrival_ ||
+            trip_cons[exit_idx]->to_station_ != exit.to_station_)) {
+      ++exit_idx;
+    }
+    utl::verify(exit_idx < static_cast<int>(trip_cons.size()),
+                "csa profile: exit connection not found");
+
+    auto const add_trip_edge = [&](int const idx) {
+      auto const con = trip_cons[idx];
+      j.edges_.emplace_back(con->light_con_, &tt_.stations_[con->from_station_],
+                            &tt_.stations_[con->to_station_], idx == enter_idx,
+                            idx == exit_idx, con->departure_, con->arrival_);
+    };
+    if (Dir == search_dir::FWD) {
+      for (auto idx = enter_idx; idx <= exit_idx; ++idx) {
+        add_trip_edge(idx);
+      }
+    } else {
+      for (auto idx = exit_idx; idx >= enter_idx; --idx) {
+        add_trip_edge(idx);
+      }
+    }
+  }
+
+  schedule const& sched_;
+  csa_timetable const& tt_;
+  csa_query const& q_;
+  csa_statistics& stats_;
+
+  std::vector<time> target_offset_;
+  std::vector<profile> profiles_;
+  std::vector<trip_profile> trips_;
+};
+
+}  // namespace motis::csa::cpu
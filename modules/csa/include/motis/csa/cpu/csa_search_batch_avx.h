@@ -0,0 +1,421 @@
+#pragma once
+
+static_assert(__AVX2__, "AVX2 not enabled!");
+
+#include <immintrin.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "boost/align/aligned_allocator.hpp"
+
+#include "utl/verify.h"
+
+#include "motis/core/common/deadline.h"
+
+#include "motis/csa/csa_journey.h"
+#include "motis/csa/csa_reconstruction.h"
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_statistics.h"
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa::cpu::batch {
+
+// One query = MAX_TRANSFERS + 1 = 8 lanes of 16 bit = one 128 bit lane of
+// the register. Shifts by one transfer therefore stay within a query.
+static_assert(MAX_TRANSFERS == 7);
+static_assert(sizeof(time) == 2);
+
+#ifdef __AVX512BW__
+struct lanes {
+  using reg = __m512i;
+  using mask = uint32_t;  // 8 bits per query
+  static constexpr auto QUERIES = 4U;
+
+  static reg load(time const* p) { return _mm512_load_si512(p); }
+  static void store(time* p, reg const r) { _mm512_store_si512(p, r); }
+  static reg set1(time const t) {
+    return _mm512_set1_epi16(static_cast<int16_t>(t));
+  }
+  static reg ones() { return _mm512_set1_epi16(-1); }
+  static reg and_(reg const a, reg const b) { return _mm512_and_si512(a, b); }
+  static reg or_(reg const a, reg const b) { return _mm512_or_si512(a, b); }
+  static reg andnot(reg const a, reg const b) {
+    return _mm512_andnot_si512(a, b);
+  }
+  static reg min(reg const a, reg const b) { return _mm512_min_epu16(a, b); }
+  static reg max(reg const a, reg const b) { return _mm512_max_epu16(a, b); }
+
+  // unsigned a <= b / a < b
+  static reg le(reg const a, reg const b) {
+    return _mm512_movm_epi16(_mm512_cmple_epu16_mask(a, b));
+  }
+  static reg lt(reg const a, reg const b) {
+    return _mm512_movm_epi16(_mm512_cmplt_epu16_mask(a, b));
+  }
+
+  // lane[t] = lane[t + 1] / lane[t] = lane[t - 1] (per query)
+  static reg next_transfer(reg const r) { return _mm512_bsrli_epi128(r, 2); }
+  static reg prev_transfer(reg const r) { return _mm512_bslli_epi128(r, 2); }
+
+  static bool any(reg const r) { return _mm512_test_epi16_mask(r, r) != 0U; }
+  static reg from_bits(mask const m) { return _mm512_movm_epi16(m); }
+  static mask to_bits(reg const r) { return _mm512_movepi16_mask(r); }
+};
+#else
+struct lanes {
+  using reg = __m256i;
+  using mask = uint16_t;  // 8 bits per query
+  static constexpr auto QUERIES = 2U;
+
+  static reg load(time const* p) {
+    return _mm256_load_si256(reinterpret_cast<__m256i const*>(p));
+  }
+  static void store(time* p, reg const r) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(p), r);
+  }
+  static reg set1(time const t) {
+    return _mm256_set1_epi16(static_cast<int16_t>(t));
+  }
+  static reg ones() { return _mm256_set1_epi16(-1); }
+  static reg and_(reg const a, reg const b) { return _mm256_and_si256(a, b); }
+  static reg or_(reg const a, reg const b) { return _mm256_or_si256(a, b); }
+  static reg andnot(reg const a, reg const b) {
+    return _mm256_andnot_si256(a, b);
+  }
+  static reg min(reg const a, reg const b) { return _mm256_min_epu16(a, b); }
+  static reg max(reg const a, reg const b) { return _mm256_max_epu16(a, b); }
+
+  // unsigned a <= b / a < b
+  static reg le(reg const a, reg const b) {
+    return _mm256_cmpeq_epi16(_mm256_subs_epu16(a, b),
+                              _mm256_setzero_si256());
+  }
+  static reg lt(reg const a, reg const b) {
+    auto const sign = _mm256_set1_epi16(static_cast<int16_t>(0x8000));
+    return _mm256_cmpgt_epi16(_mm256_xor_si256(b, sign),
+                              _mm256_xor_si256(a, sign));
+  }
+
+  // lane[t] = lane[t + 1] / lane[t] = lane[t - 1] (per query)
+  static reg next_transfer(reg const r) { return _mm256_srli_si256(r, 2); }
+  static reg prev_transfer(reg const r) { return _mm256_slli_si256(r, 2); }
+
+  static bool any(reg const r) { return _mm256_testz_si256(r, r) == 0; }
+  static reg from_bits(mask const m) {
+    auto const bits = _mm256_setr_epi16(
+        0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80, 0x100, 0x200, 0x400, 0x800,
+        0x1000, 0x2000, 0x4000, static_cast<int16_t>(0x8000));
+    return _mm256_cmpeq_epi16(
+        _mm256_and_si256(_mm256_set1_epi16(static_cast<int16_t>(m)), bits),
+        bits);
+  }
+  static mask to_bits(reg const r) {
+    // packs: bytes 0-7 = lanes 0-7, bytes 16-23 = lanes 8-15
+    auto const m = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_packs_epi16(r, _mm256_setzero_si256())));
+    return static_cast<mask>((m & 0xFFU) | ((m >> 8U) & 0xFF00U));
+  }
+};
+#endif
+
+template <typename T>
+using aligned_vector =
+    std::vector<T, boost::alignment::aligned_allocator<T, 64>>;
+
+// Ontrip station searches for up to BATCH_SIZE queries (same direction,
+// arbitrary start stations and times) in one pass over the connections.
+template <search_dir Dir>
+struct csa_search {
+  static constexpr auto BATCH_SIZE = 16U;
+  static constexpr auto QUERY_LANES = MAX_TRANSFERS + 1U;
+  static constexpr auto REG_LANES = lanes::QUERIES * QUERY_LANES;
+  static constexpr auto REGS = BATCH_SIZE / lanes::QUERIES;
+  static constexpr time INVALID = Dir == search_dir::FWD
+                                      ? std::numeric_limits<time>::max()
+                                      : std::numeric_limits<time>::min();
+  static constexpr time INACTIVE_LIMIT =
+      Dir == search_dir::FWD ? time{0U} : INVALID_TIME;
+  static_assert(BATCH_SIZE % lanes::QUERIES == 0U);
+
+  using arrival_row = std::array<time, BATCH_SIZE * QUERY_LANES>;
+  using reachable_row = std::array<uint8_t, BATCH_SIZE>;  // bit = transfers
+
+  // Per query views for the csa_reconstruction.
+  struct query_arrival_times {
+    time const* operator[](station_id const s) const {
+      return rows_[s].data() + query_ * QUERY_LANES;
+    }
+    aligned_vector<arrival_row> const& rows_;
+    unsigned query_;
+  };
+
+  struct query_trip_reachable {
+    struct transfer_bits {
+      bool operator[](int const transfers) const {
+        return ((bits_ >> static_cast<unsigned>(transfers)) & 1U) != 0U;
+      }
+      uint8_t bits_;
+    };
+    transfer_bits operator[](trip_id const t) const {
+      return {rows_[t][query_]};
+    }
+    std::vector<reachable_row> const& rows_;
+    unsigned query_;
+  };
+
+  csa_search(csa_timetable const& tt, std::vector<time> start_times,
+             csa_statistics& stats)
+      : tt_(tt),
+        start_time_(std::move(start_times)),
+        start_times_(start_time_.size()),
+        arrival_time_(tt.stations_.size(),
+                      array_maker<time, BATCH_SIZE * QUERY_LANES>::make_array(
+                          INVALID)),
+        trip_reachable_(tt.trip_count_, reachable_row{}),
+        stats_(stats) {
+    utl::verify(!start_time_.empty() && start_time_.size() <= BATCH_SIZE,
+                "csa batch: invalid batch size {}", start_time_.size());
+  }
+
+  void add_start(unsigned const query, csa_station const& station,
+                 time const initial_duration) {
+    auto const station_arrival = Dir == search_dir::FWD
+                                     ? start_time_[query] + initial_duration
+                                     : start_time_[query] - initial_duration;
+    start_times_[query][station.id_] = station_arrival;
+    arrival_time_[station.id_][query * QUERY_LANES] = station_arrival;
+    stats_.start_count_++;
+
+    auto const reg = query / lanes::QUERIES;
+    auto const lane0 = static_cast<lanes::mask>(
+        1U << ((query % lanes::QUERIES) * QUERY_LANES));
+    expand_footpaths(station, station_arrival, reg * REG_LANES,
+                     lanes::from_bits(lane0));
+  }
+
+  // Deactivates the query once the deadline is reached (results found so
+  // far).
+  void set_deadline(unsigned const query, deadline* d) {
+    deadlines_[query] = d;
+    has_deadlines_ = has_deadlines_ || d != nullptr;
+  }
+
+  bool timed_out(unsigned const query) const { return timed_out_[query]; }
+
+  void search() {
+    auto const& arrays =
+        Dir == search_dir::FWD ? tt_.fwd_arrays_ : tt_.bwd_arrays_;
+    if (arrays.empty()) {
+      scan(csa_connection_view{Dir == search_dir::FWD ? tt_.fwd_connections_
+                                                      : tt_.bwd_connections_});
+    } else {
+      scan(arrays);
+    }
+  }
+
+  template <typename Connections>
+  void scan(Connections const& connections) {
+    // Connections before the start time of a query can not reach any of its
+    // stations: scanning from the earliest start is exact for all queries.
+    // A query only stops updating at its own time limit.
+    auto const [min_start, max_start] =
+        std::minmax_element(begin(start_time_), end(start_time_));
+    auto const first_start = Dir == search_dir::FWD ? *min_start : *max_start;
+    auto const time_limit =
+        get_time_limit(Dir == search_dir::FWD ? *max_start : *min_start);
+
+    alignas(64) arrival_row query_limits{};
+    for (auto q = 0U; q != BATCH_SIZE; ++q) {
+      // unused queries: never active
+      auto const limit = q >= start_time_.size()
+                             ? INACTIVE_LIMIT
+                             : get_time_limit(start_time_[q]);
+      std::fill_n(begin(query_limits) + q * QUERY_LANES, QUERY_LANES, limit);
+    }
+
+    auto const first_connection =
+        get_first_connection<Dir>(connections, first_start);
+    for (auto i = first_connection; i != connections.size(); ++i) {
+      auto const departure = connections.departure(i);
+      auto const arrival = connections.arrival(i);
+
+      auto const time_limit_reached = Dir == search_dir::FWD
+                                          ? departure > time_limit
+                                          : arrival < time_limit;
+      if (time_limit_reached) {
+        break;
+      }
+
+      if (has_deadlines_ && check_deadlines(query_limits)) {
+        break;
+      }
+
+      stats_.connections_scanned_++;
+
+      auto const from_in_allowed = connections.from_in_allowed(i);
+      auto const to_out_allowed = connections.to_out_allowed(i);
+      auto& trip_reachable = trip_reachable_[connections.trip(i)];
+      auto const& from_station = tt_.stations_[connections.from_station(i)];
+      auto const& to_station = tt_.stations_[connections.to_station(i)];
+      auto const from_arrival_time = arrival_time_[from_station.id_].data();
+      auto const to_arrival_time = arrival_time_[to_station.id_].data();
+      auto const m_departure = lanes::set1(departure);
+      auto const m_arrival = lanes::set1(arrival);
+
+      for (auto r = 0U; r != REGS; ++r) {
+        auto const offset = r * REG_LANES;
+        auto const m_limit = lanes::load(query_limits.data() + offset);
+        auto const m_active = Dir == search_dir::FWD
+                                  ? lanes::le(m_departure, m_limit)
+                                  : lanes::le(m_limit, m_arrival);
+
+        lanes::mask via_trip{};
+        std::memcpy(&via_trip, trip_reachable.data() + r * lanes::QUERIES,
+                    sizeof(via_trip));
+        auto m_reachable = lanes::from_bits(via_trip);
+        if (Dir == search_dir::FWD && from_in_allowed) {
+          // from_arrival_time <= con.departure
+          auto const m_via_station = lanes::le(
+              lanes::load(from_arrival_time + offset), m_departure);
+          m_reachable = lanes::or_(m_reachable,
+                                   lanes::and_(m_via_station, m_active));
+        } else if (Dir == search_dir::BWD && to_out_allowed) {
+          // con.arrival <= to_arrival_time
+          auto const m_via_station =
+              lanes::le(m_arrival, lanes::load(to_arrival_time + offset));
+          m_reachable = lanes::or_(m_reachable,
+                                   lanes::and_(m_via_station, m_active));
+        }
+        auto const reachable_bits = lanes::to_bits(m_reachable);
+        if (reachable_bits == via_trip) {
+          if (reachable_bits == 0U) {
+            continue;
+          }
+        } else {
+          std::memcpy(trip_reachable.data() + r * lanes::QUERIES,
+                      &reachable_bits, sizeof(reachable_bits));
+        }
+
+        if ((Dir == search_dir::FWD && !to_out_allowed) ||
+            (Dir == search_dir::BWD && !from_in_allowed)) {
+          continue;
+        }
+
+        // trips stay reachable after the time limit of a query,
+        // but must not improve its arrival times any more
+        m_reachable = lanes::and_(m_reachable, m_active);
+
+        lanes::reg m_improved_arrival;
+        if (Dir == search_dir::FWD) {
+          // con.arrival < to_arrival[transfers + 1]
+          m_improved_arrival = lanes::lt(
+              m_arrival,
+              lanes::next_transfer(lanes::load(to_arrival_time + offset)));
+        } else {
+          // con.departure > from_arrival[transfers + 1]
+          m_improved_arrival = lanes::lt(
+              lanes::next_transfer(lanes::load(from_arrival_time + offset)),
+              m_departure);
+        }
+        auto const m_update = lanes::prev_transfer(
+            lanes::and_(m_reachable, m_improved_arrival));
+
+        if (lanes::any(m_update)) {
+          if (Dir == search_dir::FWD) {
+            expand_footpaths(to_station, arrival, offset, m_update);
+          } else {
+            expand_footpaths(from_station, departure, offset, m_update);
+          }
+        }
+      }
+    }
+  }
+
+  // Deactivates the queries whose deadline is reached. Returns true if all
+  // queries timed out.
+  bool check_deadlines(arrival_row& query_limits) {
+    auto all_timed_out = true;
+    for (auto q = 0U; q != start_time_.size(); ++q) {
+      if (!timed_out_[q] && deadlines_[q] != nullptr &&
+          deadlines_[q]->reached()) {
+        timed_out_[q] = true;
+        std::fill_n(begin(query_limits) + q * QUERY_LANES, QUERY_LANES,
+                    INACTIVE_LIMIT);
+      }
+      all_timed_out = all_timed_out && timed_out_[q];
+    }
+    return all_timed_out;
+  }
+
+  // clamped to the time range (limits are compared lane wise)
+  static time get_time_limit(time const start_time) {
+    return Dir == search_dir::FWD
+               ? static_cast<time>(std::min(
+                     static_cast<int>(start_time) + MAX_TRAVEL_TIME,
+                     static_cast<int>(std::numeric_limits<time>::max())))
+               : static_cast<time>(std::max(
+                     static_cast<int>(start_time) - MAX_TRAVEL_TIME, 0));
+  }
+
+  void expand_footpaths(csa_station const& station, time const station_arrival,
+                        unsigned const offset,
+                        lanes::reg const m_update) {
+    stats_.footpaths_expanded_++;
+
+    if (Dir == search_dir::FWD) {
+      auto const m_no_update = lanes::andnot(m_update, lanes::ones());
+      for (auto const& fp : station.footpaths_) {
+        auto const arrival = arrival_time_[fp.to_station_].data() + offset;
+        auto const fp_arrival = lanes::or_(
+            lanes::and_(
+                lanes::set1(static_cast<time>(station_arrival + fp.duration_)),
+                m_update),
+            m_no_update);
+        lanes::store(arrival, lanes::min(lanes::load(arrival), fp_arrival));
+      }
+    } else {
+      for (auto const& fp : station.incoming_footpaths_) {
+        auto const arrival = arrival_time_[fp.from_station_].data() + offset;
+        auto const fp_arrival = lanes::and_(
+            lanes::set1(static_cast<time>(station_arrival - fp.duration_)),
+            m_update);
+        lanes::store(arrival, lanes::max(lanes::load(arrival), fp_arrival));
+      }
+    }
+  }
+
+  std::vector<csa_journey> get_results(unsigned const query,
+                                       csa_station const& station) {
+    std::vector<csa_journey> journeys;
+    auto const arrival_times = query_arrival_times{arrival_time_, query};
+    auto const trip_reachable = query_trip_reachable{trip_reachable_, query};
+    auto const station_arrival = arrival_times[station.id_];
+    for (auto i = 0; i <= MAX_TRANSFERS; ++i) {
+      auto const arrival_time = station_arrival[i];  // NOLINT
+      if (arrival_time != INVALID) {
+        csa_reconstruction<Dir, query_arrival_times, query_trip_reachable>{
+            tt_, start_times_[query], arrival_times, trip_reachable}
+            .extract_journey(journeys.emplace_back(Dir, start_time_[query],
+                                                   arrival_time, i, &station));
+      }
+    }
+    return journeys;
+  }
+
+  csa_timetable const& tt_;
+  std::vector<time> start_time_;
+  std::vector<std::map<station_id, time>> start_times_;
+  aligned_vector<arrival_row> arrival_time_;
+  std::vector<reachable_row> trip_reachable_;
+  std::array<deadline*, BATCH_SIZE> deadlines_{};
+  std::array<bool, BATCH_SIZE> timed_out_{};
+  bool has_deadlines_{false};
+  csa_statistics& stats_;
+};
+
+}  // namespace motis::csa::cpu::batch
@@ -7,11 +7,13 @@
 
 #include "utl/erase_if.h"
 
+#include "motis/core/common/deadline.h"
 #include "motis/core/common/logging.h"
 
 #include "motis/csa/csa_journey.h"
 #include "motis/csa/csa_reconstruction.h"
 #include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 
@@ -23,85 +25,124 @@ struct csa_search {
                                       ? std::numeric_limits<time>::max()
                                       : std::numeric_limits<time>::min();
 
-  csa_search(csa_timetable const& tt, time start_time, csa_statistics& stats)
+  csa_search(csa_timetable const& tt, time start_time, csa_statistics& stats,
+             csa_search_state& state)
       : tt_(tt),
         start_time_(start_time),
-        arrival_time_(
-            tt.stations_.size(),
-            array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID)),
-        trip_reachable_(tt.trip_count_),
-        stats_(stats) {}
+        state_(state),
+        arrival_time_(state.arrival_time_),
+        trip_reachable_(state.trip_reachable_),
+        stats_(stats) {
+    state_.prepare(tt_.stations_.size(), tt_.trip_count_, INVALID, stats_);
+  }
 
   void add_start(csa_station const& station, time initial_duration) {
     auto const station_arrival = Dir == search_dir::FWD
                                      ? start_time_ + initial_duration
                                      : start_time_ - initial_duration;
     start_times_[station.id_] = station_arrival;
+    state_.touch_station(station.id_);
     arrival_time_[station.id_][0] = station_arrival;
     stats_.start_count_++;
     expand_footpaths(station, station_arrival, 0);
   }
 
+  // Enables target pruning (see target_bounds).
+  void add_destination(csa_station const& station) {
+    target_bounds_.add_destination(station.id_, tt_.stations_.size());
+  }
+
+  // Stops the scan once the deadline is reached (results found so far).
+  void set_deadline(deadline* d) { deadline_ = d; }
+
   void search() {
-    auto const& connections =
-        Dir == search_dir::FWD ? tt_.fwd_connections_ : tt_.bwd_connections_;
-
-    csa_connection const start_at{start_time_};
-    auto const first_connection = std::lower_bound(
-        begin(connections), end(connections), start_at,
-        [&](csa_connection const& a, csa_connection const& b) {
-          return Dir == search_dir::FWD ? a.departure_ < b.departure_
-                                        : a.arrival_ > b.arrival_;
-        });
-    if (first_connection == end(connections)) {
+    auto const& arrays =
+        Dir == search_dir::FWD ? tt_.fwd_arrays_ : tt_.bwd_arrays_;
+    if (arrays.empty()) {
+      scan(csa_connection_view{Dir == search_dir::FWD ? tt_.fwd_connections_
+                                                      : tt_.bwd_connections_});
+    } else {
+      scan(arrays);
+    }
+  }
+
+  template <typename Connections>
+  void scan(Connections const& connections) {
+    auto const first_connection =
+        get_first_connection<Dir>(connections, start_time_);
+    if (first_connection == connections.size()) {
       return;
     }
 
     auto const time_limit = Dir == search_dir::FWD
-                                ? start_time_ + MAX_TRAVEL_TIME
-                                : start_time_ - MAX_TRAVEL_TIME;
+                                ? start_time_ + max_travel_time_
+                                : start_time_ - max_travel_time_;
+
+    for (auto i = first_connection; i != connections.size(); ++i) {
+      if (deadline_ != nullptr && deadline_->reached()) {
+        stats_.timeout_quit_ = true;
+        break;
+      }
 
-    for (auto it = first_connection; it != end(connections); ++it) {
-      auto const& con = *it;
+      auto const departure = connections.departure(i);
+      auto const arrival = connections.arrival(i);
 
-      auto& trip_reachable = trip_reachable_[con.trip_];
-      auto const& from_arrival_time = arrival_time_[con.from_station_];
-      auto const& to_arrival_time = arrival_time_[con.to_station_];
+      auto& trip_reachable = trip_reachable_[connections.trip(i)];
+      auto const& from_arrival_time =
+          arrival_time_[connections.from_station(i)];
+      auto const& to_arrival_time = arrival_time_[connections.to_station(i)];
 
       auto const time_limit_reached = Dir == search_dir::FWD
-                                          ? con.departure_ > time_limit
-                                          : con.arrival_ < time_limit;
+                                          ? departure > time_limit
+                                          : arrival < time_limit;
       if (time_limit_reached) {
         break;
       }
 
+      auto const con_time = Dir == search_dir::FWD ? departure : arrival;
+      if (target_bounds_.prunes(con_time, 1)) {
+        // all following connections would be pruned as well
+        stats_.connections_skipped_ +=
+            get_last_connection<Dir>(connections, time_limit) - i;
+        break;
+      }
+
       stats_.connections_scanned_++;
 
+      auto const from_in_allowed = connections.from_in_allowed(i);
+      auto const to_out_allowed = connections.to_out_allowed(i);
       for (auto transfers = 0; transfers < MAX_TRANSFERS; ++transfers) {
+        if (target_bounds_.prunes(con_time, transfers + 1)) {
+          stats_.connections_pruned_++;
+          break;
+        }
         auto const via_trip = trip_reachable[transfers];  // NOLINT
         auto const via_station =
             Dir == search_dir::FWD
-                ? (from_arrival_time[transfers] <= con.departure_  // NOLINT
-                   && con.from_in_allowed_)
-                : (to_arrival_time[transfers] >= con.arrival_ &&  // NOLINT
-                   con.to_out_allowed_);
+                ? (from_arrival_time[transfers] <= departure  // NOLINT
+                   && from_in_allowed)
+                : (to_arrival_time[transfers] >= arrival &&  // NOLINT
+                   to_out_allowed);
         if (via_trip || via_station) {
+          if (!via_trip) {
+            state_.touch_trip(connections.trip(i));
+          }
           trip_reachable[transfers] = true;  // NOLINT
           auto const update =
               Dir == search_dir::FWD
-                  ? con.arrival_ < to_arrival_time[transfers + 1] &&  // NOLINT
-                        con.to_out_allowed_
-                  : (con.departure_ >=
+                  ? arrival < to_arrival_time[transfers + 1] &&  // NOLINT
+                        to_out_allowed
+                  : (departure >=
                      from_arrival_time[transfers + 1]) &&  // NOLINT
-                        con.from_in_allowed_;
+                        from_in_allowed;
           if (update) {
             stats_.footpaths_expanded_++;
             if (Dir == search_dir::FWD) {
-              expand_footpaths(tt_.stations_[con.to_station_], con.arrival_,
-                               transfers + 1);
+              expand_footpaths(tt_.stations_[connections.to_station(i)],
+                               arrival, transfers + 1);
             } else {
-              expand_footpaths(tt_.stations_[con.from_station_], con.departure_,
-                               transfers + 1);
+              expand_footpaths(tt_.stations_[connections.from_station(i)],
+                               departure, transfers + 1);
             }
           }
         }
@@ -115,14 +156,22 @@ struct csa_search {
       for (auto const& fp : station.footpaths_) {
         auto const fp_arrival = station_arrival + fp.duration_;
         if (arrival_time_[fp.to_station_][transfers] > fp_arrival) {
+          state_.touch_station(fp.to_station_);
           arrival_time_[fp.to_station_][transfers] = fp_arrival;
+          if (target_bounds_.is_destination(fp.to_station_)) {
+            target_bounds_.update(transfers, fp_arrival);
+          }
         }
       }
     } else {
       for (auto const& fp : station.incoming_footpaths_) {
         auto const fp_arrival = station_arrival - fp.duration_;
         if (arrival_time_[fp.from_station_][transfers] < fp_arrival) {
+          state_.touch_station(fp.from_station_);
           arrival_time_[fp.from_station_][transfers] = fp_arrival;
+          if (target_bounds_.is_destination(fp.from_station_)) {
+            target_bounds_.update(transfers, fp_arrival);
+          }
         }
       }
     }
@@ -134,8 +183,8 @@ struct csa_search {
     for (auto i = 0; i <= MAX_TRANSFERS; ++i) {
       auto const arrival_time = station_arrival[i];  // NOLINT
       if (arrival_time != INVALID) {
-        csa_reconstruction<Dir, decltype(arrival_time_),
-                           decltype(trip_reachable_)>{
+        csa_reconstruction<Dir, csa_search_state::arrival_times,
+                           csa_search_state::trip_reachability>{
             tt_, start_times_, arrival_time_, trip_reachable_}
             .extract_journey(journeys.emplace_back(Dir, start_time_,
                                                    arrival_time, i, &station));
@@ -146,9 +195,13 @@ struct csa_search {
 
   csa_timetable const& tt_;
   time start_time_;
+  duration max_travel_time_{MAX_TRAVEL_TIME};
   std::map<station_id, time> start_times_;
-  std::vector<std::array<time, MAX_TRANSFERS + 1>> arrival_time_;
-  std::vector<std::array<bool, MAX_TRANSFERS + 1>> trip_reachable_;
+  csa_search_state& state_;
+  csa_search_state::arrival_times& arrival_time_;
+  csa_search_state::trip_reachability& trip_reachable_;
+  target_bounds<Dir> target_bounds_;
+  deadline* deadline_{nullptr};
   csa_statistics& stats_;
 };
 
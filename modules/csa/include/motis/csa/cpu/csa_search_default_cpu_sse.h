@@ -10,24 +10,20 @@ static_assert(__AVX__, "AVX not enabled!");
 #include <limits>
 #include <map>
 
-#include "boost/align/aligned_allocator.hpp"
-
 #include "utl/erase_if.h"
 
+#include "motis/core/common/deadline.h"
 #include "motis/core/common/logging.h"
 
 #include "motis/csa/csa_journey.h"
 #include "motis/csa/csa_reconstruction.h"
 #include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 
 namespace motis::csa::cpu::sse {
 
-template <typename T>
-using aligned_vector =
-    std::vector<T, boost::alignment::aligned_allocator<T, 16>>;
-
 // 128 bit
 static_assert(MAX_TRANSFERS == 7);
 static_assert(sizeof(time) == 2);
@@ -38,21 +34,24 @@ struct csa_search {
                                       ? std::numeric_limits<time>::max()
                                       : std::numeric_limits<time>::min();
 
-  csa_search(csa_timetable const& tt, time start_time, csa_statistics& stats)
+  csa_search(csa_timetable const& tt, time start_time, csa_statistics& stats,
+             csa_search_state& state)
       : tt_(tt),
         start_time_(start_time),
         stop_time_(INVALID),
-        arrival_time_(
-            tt.stations_.size(),
-            array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID)),
-        trip_reachable_(tt.trip_count_),
-        stats_(stats) {}
+        state_(state),
+        arrival_time_(state.arrival_time_),
+        trip_reachable_(state.trip_reachable_),
+        stats_(stats) {
+    state_.prepare(tt_.stations_.size(), tt_.trip_count_, INVALID, stats_);
+  }
 
   void add_start(csa_station const& station, time initial_duration) {
     auto const station_arrival = Dir == search_dir::FWD
                                      ? start_time_ + initial_duration
                                      : start_time_ - initial_duration;
     start_times_[station.id_] = station_arrival;
+    state_.touch_station(station.id_);
     arrival_time_[station.id_][0] = station_arrival;
     stats_.start_count_++;
     expand_footpaths(station, station_arrival,
@@ -61,74 +60,126 @@ struct csa_search {
                                     0, 0, 0, 0, 0, 0, 0));
   }
 
+  // Enables target pruning (see target_bounds).
+  void add_destination(csa_station const& station) {
+    target_bounds_.add_destination(station.id_, tt_.stations_.size());
+  }
+
+  // Stops the scan once the deadline is reached (results found so far).
+  void set_deadline(deadline* d) { deadline_ = d; }
+
   void search() {
-    auto const& connections =
-        Dir == search_dir::FWD ? tt_.fwd_connections_ : tt_.bwd_connections_;
-
-    csa_connection const start_at{start_time_};
-    auto const first_connection = std::lower_bound(
-        begin(connections), end(connections), start_at,
-        [&](csa_connection const& a, csa_connection const& b) {
-          return Dir == search_dir::FWD ? a.departure_ < b.departure_
-                                        : a.arrival_ > b.arrival_;
-        });
-    if (first_connection == end(connections)) {
+    auto const& arrays =
+        Dir == search_dir::FWD ? tt_.fwd_arrays_ : tt_.bwd_arrays_;
+    if (arrays.empty()) {
+      scan(csa_connection_view{Dir == search_dir::FWD ? tt_.fwd_connections_
+                                                      : tt_.bwd_connections_});
+    } else {
+      scan(arrays);
+    }
+  }
+
+  template <typename Connections>
+  void scan(Connections const& connections) {
+    auto const first_connection =
+        get_first_connection<Dir>(connections, start_time_);
+    if (first_connection == connections.size()) {
       return;
     }
 
     auto const time_limit =
         Dir == search_dir::FWD
-            ? std::min(static_cast<time>(start_time_ + MAX_TRAVEL_TIME),
+            ? std::min(static_cast<time>(start_time_ + max_travel_time_),
                        stop_time_)
-            : std::max(static_cast<time>(start_time_ - MAX_TRAVEL_TIME),
+            : std::max(static_cast<time>(start_time_ - max_travel_time_),
                        stop_time_);
 
     auto const m_signed_offset = _mm_set1_epi16(static_cast<int16_t>(0x8000));
 
-    for (auto it = first_connection; it != end(connections); ++it) {
-      auto const& con = *it;
+    for (auto i = first_connection; i != connections.size(); ++i) {
+      if (deadline_ != nullptr && deadline_->reached()) {
+        stats_.timeout_quit_ = true;
+        break;
+      }
+
+      auto const departure = connections.departure(i);
+      auto const arrival = connections.arrival(i);
+      auto const from_in_allowed = connections.from_in_allowed(i);
+      auto const to_out_allowed = connections.to_out_allowed(i);
 
-      auto& trip_reachable = trip_reachable_[con.trip_];
-      auto& from_arrival_time = arrival_time_[con.from_station_];
-      auto& to_arrival_time = arrival_time_[con.to_station_];
+      auto& trip_reachable = trip_reachable_[connections.trip(i)];
+      auto& from_arrival_time = arrival_time_[connections.from_station(i)];
+      auto& to_arrival_time = arrival_time_[connections.to_station(i)];
 
       auto const time_limit_reached = Dir == search_dir::FWD
-                                          ? con.departure_ > time_limit
-                                          : con.arrival_ < time_limit;
+                                          ? departure > time_limit
+                                          : arrival < time_limit;
       if (time_limit_reached) {
         break;
       }
 
+      auto const con_time = Dir == search_dir::FWD ? departure : arrival;
+      if (target_bounds_.prunes(con_time, 1)) {
+        // all following connections would be pruned as well
+        stats_.connections_skipped_ +=
+            get_last_connection<Dir>(connections, time_limit) - i;
+        break;
+      }
+
       stats_.connections_scanned_++;
 
       auto const m_via_trip =
           _mm_load_si128(reinterpret_cast<__m128i*>(trip_reachable.data()));
       auto m_reachable = m_via_trip;
 
-      if (Dir == search_dir::FWD && con.from_in_allowed_) {
+      if (Dir == search_dir::FWD && from_in_allowed) {
         // from_arrival_time <= con.departure
         auto const m_from_arrival_time = _mm_load_si128(
             reinterpret_cast<__m128i*>(from_arrival_time.data()));
-        auto const m_con_departure_time = _mm_set1_epi16(con.departure_);
+        auto const m_con_departure_time = _mm_set1_epi16(departure);
         auto const m_via_station = _mm_cmpeq_epi16(
             _mm_subs_epu16(m_from_arrival_time, m_con_departure_time),
             _mm_setzero_si128());
         m_reachable = _mm_or_si128(m_via_trip, m_via_station);
-      } else if (Dir == search_dir::BWD && con.to_out_allowed_) {
+      } else if (Dir == search_dir::BWD && to_out_allowed) {
         // to_arrival_time >= con.arrival == con.arrival <= to_arrival_time
         auto const m_to_arrival_time =
             _mm_load_si128(reinterpret_cast<__m128i*>(to_arrival_time.data()));
-        auto const m_con_arrival_time = _mm_set1_epi16(con.arrival_);
+        auto const m_con_arrival_time = _mm_set1_epi16(arrival);
         auto const m_via_station = _mm_cmpeq_epi16(
             _mm_subs_epu16(m_con_arrival_time, m_to_arrival_time),
             _mm_setzero_si128());
         m_reachable = _mm_or_si128(m_via_trip, m_via_station);
       }
-      _mm_store_si128(reinterpret_cast<__m128i*>(trip_reachable.data()),
-                      m_reachable);
 
-      if ((Dir == search_dir::FWD && !con.to_out_allowed_) ||
-          (Dir == search_dir::BWD && !con.from_in_allowed_)) {
+      if (target_bounds_.prunes(con_time, MAX_TRANSFERS)) {
+        // prune = con.departure > bound[transfers + 1] (FWD)
+        //         con.arrival < bound[transfers + 1] (BWD)
+        stats_.connections_pruned_++;
+        auto const m_bounds_shifted = _mm_srli_si128(  // NOLINT
+            _mm_sub_epi16(
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(
+                    target_bounds_.bounds_.data())),
+                m_signed_offset),
+            2);
+        auto const m_con_time_s = _mm_set1_epi16(
+            static_cast<int16_t>(static_cast<int>(con_time) - 0x8000));
+        auto const m_prune =
+            Dir == search_dir::FWD
+                ? _mm_cmpgt_epi16(m_con_time_s, m_bounds_shifted)
+                : _mm_cmpgt_epi16(m_bounds_shifted, m_con_time_s);
+        m_reachable = _mm_or_si128(m_via_trip,
+                                   _mm_andnot_si128(m_prune, m_reachable));
+        store_trip_reachable(connections.trip(i), trip_reachable, m_via_trip,
+                             m_reachable);
+        m_reachable = _mm_andnot_si128(m_prune, m_reachable);
+      } else {
+        store_trip_reachable(connections.trip(i), trip_reachable, m_via_trip,
+                             m_reachable);
+      }
+
+      if ((Dir == search_dir::FWD && !to_out_allowed) ||
+          (Dir == search_dir::BWD && !from_in_allowed)) {
         continue;
       }
 
@@ -140,7 +191,7 @@ struct csa_search {
         auto const m_to_arrival_time_shifted =
             _mm_srli_si128(m_to_arrival_time, 2);  // NOLINT
         auto const m_con_arrival_time_s = _mm_set1_epi16(
-            static_cast<int16_t>(static_cast<int>(con.arrival_) - 0x8000));
+            static_cast<int16_t>(static_cast<int>(arrival) - 0x8000));
         m_improved_arrival = _mm_cmpgt_epi16(
             _mm_sub_epi16(m_to_arrival_time_shifted, m_signed_offset),
             m_con_arrival_time_s);
@@ -151,7 +202,7 @@ struct csa_search {
         auto const m_from_arrival_time_shifted =
             _mm_srli_si128(m_from_arrival_time, 2);  // NOLINT
         auto const m_con_departure_time_s = _mm_set1_epi16(
-            static_cast<int16_t>(static_cast<int>(con.departure_) - 0x8000));
+            static_cast<int16_t>(static_cast<int>(departure) - 0x8000));
         m_improved_arrival = _mm_cmpgt_epi16(
             m_con_departure_time_s,
             _mm_sub_epi16(m_from_arrival_time_shifted, m_signed_offset));
@@ -162,16 +213,30 @@ struct csa_search {
 
       if (any_updates) {
         if (Dir == search_dir::FWD) {
-          expand_footpaths(tt_.stations_[con.to_station_], con.arrival_,
+          expand_footpaths(tt_.stations_[connections.to_station(i)], arrival,
                            m_update);
         } else {
-          expand_footpaths(tt_.stations_[con.from_station_], con.departure_,
-                           m_update);
+          expand_footpaths(tt_.stations_[connections.from_station(i)],
+                           departure, m_update);
         }
       }
     }
   }
 
+  // m_reachable contains m_via_trip: the trip is written for the first time
+  // in this search iff m_via_trip is empty and m_reachable is not.
+  inline void store_trip_reachable(
+      trip_id const trip, std::array<uint16_t, MAX_TRANSFERS + 1>& reachable,
+      __m128i const& m_via_trip, __m128i const& m_reachable) {
+    if (_mm_testz_si128(m_reachable, m_reachable) != 0) {
+      return;
+    }
+    if (_mm_testz_si128(m_via_trip, m_via_trip) != 0) {
+      state_.touch_trip(trip);
+    }
+    _mm_store_si128(reinterpret_cast<__m128i*>(reachable.data()), m_reachable);
+  }
+
   void expand_footpaths(csa_station const& station, time const station_arrival,
                         __m128i const& m_update) {
     stats_.footpaths_expanded_++;
@@ -182,6 +247,7 @@ struct csa_search {
       for (auto const& fp : station.footpaths_) {
         // fp_arrival = (~m_update & ~0) | (fp.arrival & update)
         // arrival = min(arrival, fp_arrival)
+        state_.touch_station(fp.to_station_);
         auto& arrival = arrival_time_[fp.to_station_];
         auto const no_update = _mm_andnot_si128(m_update, all_ones);
         auto const fp_arrival = _mm_or_si128(
@@ -193,10 +259,14 @@ struct csa_search {
         auto const new_arrival = _mm_min_epu16(old_arrival, fp_arrival);
         _mm_store_si128(reinterpret_cast<__m128i*>(arrival.data()),
                         new_arrival);
+        if (target_bounds_.is_destination(fp.to_station_)) {
+          target_bounds_.update(arrival);
+        }
       }
     } else {
       for (auto const& fp : station.incoming_footpaths_) {
         // arrival = max(arrival, (fp.arrival & update))
+        state_.touch_station(fp.from_station_);
         auto& arrival = arrival_time_[fp.from_station_];
         auto const fp_arrival = _mm_and_si128(
             _mm_set1_epi16(station_arrival - fp.duration_), m_update);
@@ -205,6 +275,9 @@ struct csa_search {
         auto const new_arrival = _mm_max_epu16(old_arrival, fp_arrival);
         _mm_store_si128(reinterpret_cast<__m128i*>(arrival.data()),
                         new_arrival);
+        if (target_bounds_.is_destination(fp.from_station_)) {
+          target_bounds_.update(arrival);
+        }
       }
     }
   }
@@ -215,8 +288,8 @@ struct csa_search {
     for (auto i = 0; i <= MAX_TRANSFERS; ++i) {
       auto const arrival_time = station_arrival[i];  // NOLINT
       if (arrival_time != INVALID) {
-        csa_reconstruction<Dir, decltype(arrival_time_),
-                           decltype(trip_reachable_)>{
+        csa_reconstruction<Dir, csa_search_state::arrival_times,
+                           csa_search_state::trip_reachability>{
             tt_, start_times_, arrival_time_, trip_reachable_}
             .extract_journey(journeys.emplace_back(Dir, start_time_,
                                                    arrival_time, i, &station));
@@ -228,9 +301,13 @@ struct csa_search {
   csa_timetable const& tt_;
   time start_time_;
   time stop_time_;
+  duration max_travel_time_{MAX_TRAVEL_TIME};
   std::map<station_id, time> start_times_;
-  aligned_vector<std::array<time, MAX_TRANSFERS + 1>> arrival_time_;
-  aligned_vector<std::array<uint16_t, MAX_TRANSFERS + 1>> trip_reachable_;
+  csa_search_state& state_;
+  csa_search_state::arrival_times& arrival_time_;
+  csa_search_state::trip_reachability& trip_reachable_;
+  target_bounds<Dir> target_bounds_;
+  deadline* deadline_{nullptr};
   csa_statistics& stats_;
 };
 
@@ -2,34 +2,25 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <iostream>
 #include <map>
 
 #include "utl/erase_if.h"
 #include "utl/verify.h"
 
+#include "motis/core/common/deadline.h"
 #include "motis/core/common/logging.h"
 
+#include "motis/csa/cpu/csa_price_labels.h"
 #include "motis/csa/csa_journey.h"
 #include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 
 namespace motis::csa::price {
 
-using price_t = uint16_t;
-
-constexpr price_t MINUTE_PRICE = 8;
-constexpr price_t INVALID_PRICE = std::numeric_limits<price_t>::max();
-constexpr trip_id INVALID_TRIP = std::numeric_limits<trip_id>::max();
-
-template <typename T>
-inline price_t add_price(price_t base, T additional) {
-  return static_cast<price_t>(std::min(
-      static_cast<uint32_t>(std::numeric_limits<price_t>::max()),
-      static_cast<uint32_t>(base) + static_cast<uint32_t>(additional)));
-}
-
 struct journey_pointer {
   journey_pointer() = default;
   journey_pointer(csa_connection const* enter_con,
@@ -53,53 +44,24 @@ struct journey_pointer {
   price_t new_price_{};
 };
 
-struct station_arrival_info {
-  station_arrival_info() = default;
-  station_arrival_info(time arrival_time, price_t price)
-      : time_(arrival_time), price_(price) {}
-
-  time time_{0};
-  price_t price_{INVALID_PRICE};
-
-  template <search_dir Dir>
-  inline bool dominates(station_arrival_info const& other) const {
-    return (Dir == search_dir::FWD ? time_ <= other.time_
-                                   : time_ >= other.time_) &&
-           dominates_price<Dir>(other);
-  }
-
-  template <search_dir Dir>
-  inline bool dominates_price(station_arrival_info const& other) const {
-    uint32_t const min_wage_diff = time_ > other.time_
-                                       ? (time_ - other.time_) * MINUTE_PRICE
-                                       : (other.time_ - time_) * MINUTE_PRICE;
-    auto const fwd = Dir == search_dir::FWD;
-
-    uint32_t const this_price =
-        (time_ > other.time_) == fwd ? price_ : price_ + min_wage_diff;
-    uint32_t const other_price = (time_ > other.time_) == fwd
-                                     ? other.price_ + min_wage_diff
-                                     : other.price_;
-
-    return this_price <= other_price;
-  }
-};
-
 template <search_dir Dir>
 struct csa_search {
   static constexpr time INVALID = Dir == search_dir::FWD
                                       ? std::numeric_limits<time>::max()
                                       : std::numeric_limits<time>::min();
 
-  csa_search(csa_timetable const& tt, time start_time, csa_statistics& stats)
+  csa_search(csa_timetable const& tt, time start_time, csa_statistics& stats,
+             csa_search_state& state)
       : tt_(tt),
         start_time_(start_time),
         stop_time_(INVALID),
-        arrival_(tt.stations_.size(),
-                 array_maker<std::vector<station_arrival_info>,
-                             MAX_TRANSFERS + 1>::make_array({})),
-        trip_reachable_(tt.trip_count_),
-        stats_(stats) {}
+        state_(state),
+        arrival_(state.price_arrival_),
+        trip_reachable_(state.price_trip_reachable_),
+        stats_(stats) {
+    state_.prepare_price(tt_.stations_.size(), tt_.trip_count_, INVALID,
+                         stats_);
+  }
 
   void add_start(csa_station const& station, time initial_duration,
                  price_t initial_price = 0) {
@@ -115,6 +77,9 @@ struct csa_search {
     expand_footpaths(station, station_arrival, arrival_prices);
   }
 
+  // Stops the scan once the deadline is reached (results found so far).
+  void set_deadline(deadline* d) { deadline_ = d; }
+
   void search() {
     auto const& connections =
         Dir == search_dir::FWD ? tt_.fwd_connections_ : tt_.bwd_connections_;
@@ -138,6 +103,11 @@ struct csa_search {
                        stop_time_);
 
     for (auto it = first_connection; it != end(connections); ++it) {
+      if (deadline_ != nullptr && deadline_->reached()) {
+        stats_.timeout_quit_ = true;
+        break;
+      }
+
       auto const& con = *it;
 
       auto const time_limit_reached = Dir == search_dir::FWD
@@ -212,6 +182,7 @@ struct csa_search {
       csa_connection const& con) {
     auto& tr = trip_reachable_[con.trip_];
     if (tr.empty()) {
+      state_.touch_trip(con.trip_);
       tr.resize(
           tt_.trip_to_connections_[con.trip_].size(),
           array_maker<price_t, MAX_TRANSFERS + 1>::make_array(INVALID_PRICE));
@@ -315,6 +286,7 @@ struct csa_search {
       for (auto const& fp : station.footpaths_) {
         auto const fp_arrival_time = arrival_time + fp.duration_;
         auto const fp_price = fp.duration_ * MINUTE_PRICE;
+        state_.touch_station(fp.to_station_);
         auto& arrival = arrival_[fp.to_station_];
         for (auto transfers = 0; transfers <= MAX_TRANSFERS; ++transfers) {
           if (arrival_prices[transfers] == INVALID_PRICE) {  // NOLINT
@@ -330,6 +302,7 @@ struct csa_search {
       for (auto const& fp : station.incoming_footpaths_) {
         auto const fp_arrival_time = arrival_time - fp.duration_;
         auto const fp_price = fp.duration_ * MINUTE_PRICE;
+        state_.touch_station(fp.from_station_);
         auto& arrival = arrival_[fp.from_station_];
         for (auto transfers = 0; transfers <= MAX_TRANSFERS; ++transfers) {
           if (arrival_prices[transfers] == INVALID_PRICE) {  // NOLINT
@@ -402,9 +375,10 @@ struct csa_search {
     return journeys;
   }
 
-  void extract_journey(csa_journey& j) {
+  // Same interface as price_buckets::csa_search (always reconstructed).
+  bool extract_journey(csa_journey& j) {
     if (j.is_reconstructed()) {
-      return;
+      return true;
     }
     auto stop = j.destination_station_;
     auto transfers = j.transfers_;
@@ -491,6 +465,7 @@ struct csa_search {
       std::reverse(begin(j.edges_), end(j.edges_));
     }
     utl::verify(!j.edges_.empty(), "csa price journey reconstruction failed");
+    return true;
   }
 
   void add_final_footpath(csa_journey& j, csa_station const* stop,
@@ -701,11 +676,11 @@ struct csa_search {
   time start_time_;
   time stop_time_;
   std::map<station_id, time> start_times_;
-  std::vector<std::array<std::vector<station_arrival_info>, MAX_TRANSFERS + 1>>
-      arrival_;
-  std::vector<std::vector<std::array<price_t, MAX_TRANSFERS + 1>>>
-      trip_reachable_;
+  csa_search_state& state_;
+  csa_search_state::price_arrivals& arrival_;
+  csa_search_state::price_trip_reachability& trip_reachable_;
   std::vector<station_id> starts_;
+  deadline* deadline_{nullptr};
   csa_statistics& stats_;
 };
 
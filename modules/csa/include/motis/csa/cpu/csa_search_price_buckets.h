@@ -0,0 +1,472 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "utl/verify.h"
+
+#include "motis/core/common/deadline.h"
+#include "motis/core/common/logging.h"
+
+#include "motis/csa/cpu/csa_price_labels.h"
+#include "motis/csa/cpu/csa_search_price.h"
+#include "motis/csa/csa_journey.h"
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
+#include "motis/csa/csa_statistics.h"
+#include "motis/csa/csa_timetable.h"
+
+// Price-aware CSA with a fixed number of labels per station and transfer
+// count: one label per price bucket instead of the full pareto set of
+// price::csa_search.
+//
+// Same criteria as price::csa_search (arrival time, transfers and price =
+// fare + MINUTE_PRICE * travel time). The labels store the fare, the bucket
+// of a label is its fare class. Each bucket keeps the earliest (FWD) /
+// latest (BWD) label, i.e. a journey is only lost if another journey of the
+// same fare class arrives earlier. The earliest arrival per transfer count
+// is always found.
+namespace motis::csa::price_buckets {
+
+using price::add_price;
+using price::INVALID_PRICE;
+using price::MINUTE_PRICE;
+using price::price_t;
+
+// Fare classes: bucket i holds the fares in [bounds_[i - 1], bounds_[i]).
+// The bounds grow geometrically (first_bound, 2 * first_bound, ...), the
+// last used bucket has no upper bound.
+struct price_bucket_bounds {
+  price_bucket_bounds(unsigned const count, price_t const first_bound) {
+    utl::verify(count > 0U && count <= MAX_PRICE_BUCKETS,
+                "invalid price bucket count: {}", count);
+    auto bound = static_cast<uint32_t>(first_bound);
+    for (auto i = 0U; i + 1U < count; ++i) {
+      bounds_[i] = std::min(bound, UNBOUNDED);
+      bound *= 2U;
+    }
+  }
+
+  inline unsigned get_bucket(price_t const fare) const {
+    auto bucket = 0U;
+    for (auto const bound : bounds_) {
+      bucket += fare >= bound ? 1U : 0U;
+    }
+    return bucket;
+  }
+
+  static constexpr auto const UNBOUNDED =
+      static_cast<uint32_t>(std::numeric_limits<price_t>::max()) + 1U;
+  std::array<uint32_t, MAX_PRICE_BUCKETS - 1> bounds_{
+      array_maker<uint32_t, MAX_PRICE_BUCKETS - 1>::make_array(UNBOUNDED)};
+};
+
+template <search_dir Dir>
+struct csa_search {
+  static constexpr time INVALID = Dir == search_dir::FWD
+                                      ? std::numeric_limits<time>::max()
+                                      : std::numeric_limits<time>::min();
+
+  struct journey_pointer {
+    bool valid() const { return enter_con_ != nullptr; }
+
+    csa_connection const* enter_con_{nullptr};
+    csa_connection const* exit_con_{nullptr};
+    footpath const* footpath_{nullptr};
+    time new_time_{};
+    price_t new_fare_{};
+  };
+
+  csa_search(csa_timetable const& tt, time start_time, csa_statistics& stats,
+             csa_search_state& state, price_bucket_bounds const& buckets)
+      : tt_(tt),
+        start_time_(start_time),
+        buckets_(buckets),
+        state_(state),
+        labels_(state.bucket_labels_),
+        trip_fare_(state.bucket_trip_fare_),
+        stats_(stats) {
+    state_.prepare_price_buckets(tt_.stations_.size(), tt_.trip_count_,
+                                 INVALID, stats_);
+  }
+
+  void add_start(csa_station const& station, time initial_duration,
+                 price_t initial_price = 0) {
+    auto const station_arrival = Dir == search_dir::FWD
+                                     ? start_time_ + initial_duration
+                                     : start_time_ - initial_duration;
+    starts_.push_back(station.id_);
+    start_times_[station.id_] = station_arrival;
+    stats_.start_count_++;
+    auto start_fares =
+        array_maker<price_t, MAX_TRANSFERS + 1>::make_array(INVALID_PRICE);
+    start_fares[0] = initial_price;
+    expand_footpaths(station, station_arrival, start_fares);
+  }
+
+  // Stops the scan once the deadline is reached (results found so far).
+  void set_deadline(deadline* d) { deadline_ = d; }
+
+  void search() {
+    auto const& connections =
+        Dir == search_dir::FWD ? tt_.fwd_connections_ : tt_.bwd_connections_;
+
+    csa_connection const start_at{start_time_};
+    auto const first_connection = std::lower_bound(
+        begin(connections), end(connections), start_at,
+        [&](csa_connection const& a, csa_connection const& b) {
+          return Dir == search_dir::FWD ? a.departure_ < b.departure_
+                                        : a.arrival_ > b.arrival_;
+        });
+
+    auto const time_limit = Dir == search_dir::FWD
+                                ? start_time_ + MAX_TRAVEL_TIME
+                                : start_time_ - MAX_TRAVEL_TIME;
+
+    for (auto it = first_connection; it != end(connections); ++it) {
+      if (deadline_ != nullptr && deadline_->reached()) {
+        stats_.timeout_quit_ = true;
+        break;
+      }
+
+      auto const& con = *it;
+
+      auto const time_limit_reached = Dir == search_dir::FWD
+                                          ? con.departure_ > time_limit
+                                          : con.arrival_ < time_limit;
+      if (time_limit_reached) {
+        break;
+      }
+
+      stats_.connections_scanned_++;
+
+      auto const in_allowed =
+          Dir == search_dir::FWD ? con.from_in_allowed_ : con.to_out_allowed_;
+      auto const out_allowed =
+          Dir == search_dir::FWD ? con.to_out_allowed_ : con.from_in_allowed_;
+      auto const& station_labels =
+          labels_[Dir == search_dir::FWD ? con.from_station_
+                                         : con.to_station_];
+      auto const board_time =
+          Dir == search_dir::FWD ? con.departure_ : con.arrival_;
+
+      auto& trip_fare = trip_fare_[con.trip_];
+      auto arrival_fares =
+          array_maker<price_t, MAX_TRANSFERS + 1>::make_array(INVALID_PRICE);
+      auto reachable = false;
+      for (auto transfers = 0; transfers < MAX_TRANSFERS; ++transfers) {
+        auto const via_station =
+            in_allowed ? board_fare(station_labels[transfers], board_time)
+                       : INVALID_PRICE;
+        auto const via_trip = trip_fare[transfers];
+        auto const fare = std::min(via_trip, via_station);
+        if (fare == INVALID_PRICE) {
+          continue;
+        }
+        if (via_station < via_trip) {
+          stats_.trip_reachable_updates_++;
+        }
+        trip_fare[transfers] = add_price(fare, con.price_);
+        arrival_fares[transfers + 1] = trip_fare[transfers];
+        reachable = true;
+      }
+
+      if (reachable) {
+        state_.touch_trip(con.trip_);
+      }
+
+      if (reachable && out_allowed) {
+        stats_.footpaths_expanded_++;
+        if (Dir == search_dir::FWD) {
+          expand_footpaths(tt_.stations_[con.to_station_], con.arrival_,
+                           arrival_fares);
+        } else {
+          expand_footpaths(tt_.stations_[con.from_station_], con.departure_,
+                           arrival_fares);
+        }
+      }
+    }
+  }
+
+  // Lowest fare of the labels reaching the connection in time.
+  inline price_t board_fare(bucket_labels const& l, time const t) const {
+    auto fare = INVALID_PRICE;
+    for (auto b = 0U; b != MAX_PRICE_BUCKETS; ++b) {
+      auto const reachable =
+          Dir == search_dir::FWD ? l.time_[b] <= t : l.time_[b] >= t;
+      fare = std::min(fare, reachable ? l.fare_[b] : INVALID_PRICE);
+    }
+    return fare;
+  }
+
+  void expand_footpaths(csa_station const& station, time arrival_time,
+                        fares const& arrival_fares) {
+    std::array<unsigned, MAX_TRANSFERS + 1> bucket{};
+    for (auto transfers = 0; transfers <= MAX_TRANSFERS; ++transfers) {
+      bucket[transfers] = buckets_.get_bucket(arrival_fares[transfers]);
+    }
+    auto const& footpaths = Dir == search_dir::FWD
+                                ? station.footpaths_
+                                : station.incoming_footpaths_;
+    for (auto const& fp : footpaths) {
+      auto const fp_time = Dir == search_dir::FWD
+                               ? arrival_time + fp.duration_
+                               : arrival_time - fp.duration_;
+      auto const to =
+          Dir == search_dir::FWD ? fp.to_station_ : fp.from_station_;
+      state_.touch_station(to);
+      auto& l = labels_[to];
+      for (auto transfers = 0; transfers <= MAX_TRANSFERS; ++transfers) {
+        if (arrival_fares[transfers] != INVALID_PRICE) {
+          update_label(l[transfers], bucket[transfers], fp_time,
+                       arrival_fares[transfers]);
+        }
+      }
+    }
+  }
+
+  inline void update_label(bucket_labels& l, unsigned const bucket,
+                           time const t, price_t const fare) {
+    for (auto b = 0U; b != bucket; ++b) {
+      // lower fare class: cheaper, not later -> dominated
+      if (Dir == search_dir::FWD ? l.time_[b] <= t : l.time_[b] >= t) {
+        stats_.new_labels_dominated_++;
+        return;
+      }
+    }
+    auto const better = Dir == search_dir::FWD ? t < l.time_[bucket]
+                                               : t > l.time_[bucket];
+    if (better || (t == l.time_[bucket] && fare < l.fare_[bucket])) {
+      if (l.time_[bucket] != INVALID) {
+        stats_.existing_labels_dominated_++;
+      }
+      l.time_[bucket] = t;
+      l.fare_[bucket] = fare;
+      stats_.labels_created_++;
+    } else {
+      stats_.new_labels_dominated_++;
+    }
+  }
+
+  inline bool is_start(station_id station) const {
+    return std::find(begin(starts_), end(starts_), station) != end(starts_);
+  }
+
+  // Not reconstructed yet (see extract_journey), price = generalized price.
+  std::vector<csa_journey> get_results(csa_station const& station) {
+    std::vector<csa_journey> journeys;
+
+    auto const dominated = [&](duration dur, unsigned price) {
+      return std::any_of(begin(journeys), end(journeys),
+                         [&](csa_journey const& j) {
+                           return j.duration_ <= dur && j.price_ <= price;
+                         });
+    };
+
+    for (auto transfers = 0; transfers <= MAX_TRANSFERS; ++transfers) {
+      auto const& l = labels_[station.id_][transfers];
+      for (auto b = 0U; b != MAX_PRICE_BUCKETS; ++b) {
+        if (l.time_[b] == INVALID) {
+          continue;
+        }
+        auto const dur = l.time_[b] > start_time_ ? l.time_[b] - start_time_
+                                                  : start_time_ - l.time_[b];
+        auto const price = add_price(l.fare_[b], dur * MINUTE_PRICE);
+        if (!dominated(dur, price)) {
+          journeys.emplace_back(Dir, start_time_, l.time_[b], transfers,
+                                &station, price);
+        }
+      }
+    }
+    return journeys;
+  }
+
+  // Returns false if the journey can not be reconstructed (it has to be
+  // dropped, the edges are incomplete).
+  bool extract_journey(csa_journey& j) {
+    if (j.is_reconstructed()) {
+      return true;
+    }
+    auto stop = j.destination_station_;
+    auto transfers = j.transfers_;
+    auto t = j.arrival_time_;
+    auto fare = static_cast<price_t>(j.price_ - j.duration_ * MINUTE_PRICE);
+    for (; transfers > 0; --transfers) {
+      auto const jp = get_journey_pointer(*stop, t, transfers, fare);
+      if (!jp.valid()) {
+        LOG(motis::logging::warn)
+            << "csa price bucket journey reconstruction: no journey pointer "
+               "with transfers="
+            << transfers << ", journey dropped";
+        return false;
+      }
+      if (jp.footpath_->from_station_ != jp.footpath_->to_station_) {
+        if (Dir == search_dir::FWD) {
+          j.edges_.emplace_back(
+              &tt_.stations_[jp.footpath_->from_station_],
+              &tt_.stations_[jp.footpath_->to_station_],
+              jp.exit_con_->arrival_,
+              jp.exit_con_->arrival_ + jp.footpath_->duration_, -1);
+        } else {
+          j.edges_.emplace_back(
+              &tt_.stations_[jp.footpath_->from_station_],
+              &tt_.stations_[jp.footpath_->to_station_],
+              jp.enter_con_->departure_ - jp.footpath_->duration_,
+              jp.enter_con_->departure_, -1);
+        }
+      }
+      auto const& trip_cons = tt_.trip_to_connections_[jp.exit_con_->trip_];
+      auto const add_trip_edge = [&](csa_connection const* con) {
+        j.edges_.emplace_back(con->light_con_,
+                              &tt_.stations_[con->from_station_],
+                              &tt_.stations_[con->to_station_],
+                              con == jp.enter_con_, con == jp.exit_con_,
+                              con->departure_, con->arrival_);
+      };
+      if (Dir == search_dir::FWD) {
+        for (auto i = jp.exit_con_->trip_con_idx_ + 1;
+             i > jp.enter_con_->trip_con_idx_; --i) {
+          add_trip_edge(trip_cons[i - 1]);
+        }
+        stop = &tt_.stations_[jp.enter_con_->from_station_];
+      } else {
+        for (auto i = jp.enter_con_->trip_con_idx_;
+             i <= jp.exit_con_->trip_con_idx_; ++i) {
+          add_trip_edge(trip_cons[i]);
+        }
+        stop = &tt_.stations_[jp.exit_con_->to_station_];
+      }
+      j.start_station_ = stop;
+      t = jp.new_time_;
+      fare = jp.new_fare_;
+    }
+    if (!is_start(stop->id_)) {
+      add_final_footpath(j, stop, t);
+    }
+    if (Dir == search_dir::FWD) {
+      std::reverse(begin(j.edges_), end(j.edges_));
+    }
+    utl::verify(!j.edges_.empty(),
+                "csa price bucket journey reconstruction failed");
+    return true;
+  }
+
+  void add_final_footpath(csa_journey& j, csa_station const* stop,
+                          time arrival_time) {
+    if (Dir == search_dir::FWD) {
+      for (auto const& fp : stop->incoming_footpaths_) {
+        if (fp.from_station_ == fp.to_station_ || !is_start(fp.from_station_)) {
+          continue;
+        }
+        auto const fp_departure = arrival_time - fp.duration_;
+        if (fp_departure >= start_times_[fp.from_station_]) {
+          j.edges_.emplace_back(&tt_.stations_[fp.from_station_],
+                                &tt_.stations_[fp.to_station_], fp_departure,
+                                arrival_time, -1);
+          j.start_station_ = &tt_.stations_[fp.from_station_];
+          break;
+        }
+      }
+    } else {
+      for (auto const& fp : stop->footpaths_) {
+        if (fp.from_station_ == fp.to_station_ || !is_start(fp.to_station_)) {
+          continue;
+        }
+        auto const fp_departure = arrival_time + fp.duration_;
+        if (fp_departure <= start_times_[fp.to_station_]) {
+          j.edges_.emplace_back(&tt_.stations_[fp.from_station_],
+                                &tt_.stations_[fp.to_station_], arrival_time,
+                                fp_departure, -1);
+          j.start_station_ = &tt_.stations_[fp.to_station_];
+          break;
+        }
+      }
+    }
+  }
+
+  // Trip segment and label (one transfer less) the label at the station was
+  // created from. Labels are only replaced by labels with the same time and
+  // a lower fare once they have been used, i.e. a label with a time and fare
+  // not worse than the original one is always found.
+  journey_pointer get_journey_pointer(csa_station const& station, time t,
+                                      int transfers, price_t fare) const {
+    if (Dir == search_dir::FWD) {
+      for (auto const& fp : station.incoming_footpaths_) {
+        auto const con_arrival = static_cast<time>(t - fp.duration_);
+        for (auto const exit_con :
+             tt_.stations_[fp.from_station_].incoming_connections_) {
+          if (exit_con->arrival_ != con_arrival || !exit_con->to_out_allowed_) {
+            continue;
+          }
+          auto const& trip_cons = tt_.trip_to_connections_[exit_con->trip_];
+          auto trip_fare = 0U;
+          for (auto i = exit_con->trip_con_idx_ + 1; i != 0; --i) {
+            auto const con = trip_cons[i - 1];
+            trip_fare += con->price_;
+            if (trip_fare > fare) {
+              break;
+            }
+            if (!con->from_in_allowed_) {
+              continue;
+            }
+            auto const& l = labels_[con->from_station_][transfers - 1];
+            for (auto b = 0U; b != MAX_PRICE_BUCKETS; ++b) {
+              if (l.time_[b] <= con->departure_ &&
+                  l.fare_[b] <= fare - trip_fare) {
+                return {con, exit_con, &fp, l.time_[b], l.fare_[b]};
+              }
+            }
+          }
+        }
+      }
+    } else {
+      for (auto const& fp : station.footpaths_) {
+        auto const con_departure = static_cast<time>(t + fp.duration_);
+        for (auto const enter_con :
+             tt_.stations_[fp.to_station_].outgoing_connections_) {
+          if (enter_con->departure_ != con_departure ||
+              !enter_con->from_in_allowed_) {
+            continue;
+          }
+          auto const& trip_cons = tt_.trip_to_connections_[enter_con->trip_];
+          auto trip_fare = 0U;
+          for (auto i = enter_con->trip_con_idx_; i != trip_cons.size(); ++i) {
+            auto const con = trip_cons[i];
+            trip_fare += con->price_;
+            if (trip_fare > fare) {
+              break;
+            }
+            if (!con->to_out_allowed_) {
+              continue;
+            }
+            auto const& l = labels_[con->to_station_][transfers - 1];
+            for (auto b = 0U; b != MAX_PRICE_BUCKETS; ++b) {
+              if (l.time_[b] != INVALID && l.time_[b] >= con->arrival_ &&
+                  l.fare_[b] <= fare - trip_fare) {
+                return {enter_con, con, &fp, l.time_[b], l.fare_[b]};
+              }
+            }
+          }
+        }
+      }
+    }
+    return {};
+  }
+
+  csa_timetable const& tt_;
+  time start_time_;
+  price_bucket_bounds buckets_;
+  std::map<station_id, time> start_times_;
+  csa_search_state& state_;
+  std::vector<station_labels>& labels_;
+  std::vector<fares>& trip_fare_;
+  std::vector<station_id> starts_;
+  deadline* deadline_{nullptr};
+  csa_statistics& stats_;
+};
+
+}  // namespace motis::csa::price_buckets
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
 #include "motis/module/module.h"
 
 #include "motis/csa/csa_implementation_type.h"
+#include "motis/csa/update_csa_timetable.h"
 
 #ifdef MOTIS_CUDA
 #include "motis/csa/gpu/gpu_timetable.h"
@@ -11,6 +18,7 @@
 namespace motis::csa {
 
 struct csa_timetable;
+struct csa_search_state_pool;
 
 struct csa : public motis::module::module {
   csa();
@@ -22,12 +30,24 @@ struct csa : public motis::module::module {
   csa(csa&&) = delete;
   csa& operator=(csa&&) = delete;
 
+  void import(motis::module::registry&) override;
   void init(motis::module::registry&) override;
 
-  csa_timetable const* get_timetable() const;
+  bool import_successful() const override;
+
+  // Snapshot for a search: realtime updates never modify a timetable that
+  // is in use, they replace it (see update).
+  std::shared_ptr<csa_timetable const> get_timetable() const;
 
   motis::module::msg_ptr route(motis::module::msg_ptr const&,
                                implementation_type) const;
+  motis::module::msg_ptr route_batch(motis::module::msg_ptr const&) const;
+  motis::module::msg_ptr one_to_all(motis::module::msg_ptr const&) const;
+
+  void update(motis::module::msg_ptr const&);
+
+  // Blocks until a background rebuild of the timetable (if any) is done.
+  void wait_for_rebuild();
 
 #ifdef MOTIS_CUDA
   bool bridge_zero_duration_connections_{true};
@@ -36,7 +56,30 @@ struct csa : public motis::module::module {
   bool bridge_zero_duration_connections_{false};
   bool add_footpath_connections_{false};
 #endif
-  std::unique_ptr<csa_timetable> timetable_;
+  bool connection_arrays_{false};
+  bool use_data_file_{true};
+  unsigned timeout_{0U};
+  unsigned pretrip_jobs_{0U};
+  unsigned state_pool_size_{0U};
+  unsigned price_buckets_{8U};
+  unsigned price_bucket_base_{500U};
+  bool import_successful_{false};
+  std::shared_ptr<csa_timetable> timetable_;
+  std::unique_ptr<csa_search_state_pool> state_pool_;
+
+  // Guards timetable_ and update_stats_ (searches: copy, realtime updates:
+  // replace or patch in place if no search uses the timetable).
+  mutable std::shared_mutex timetable_mutex_;
+  std::mutex update_mutex_;
+  csa_update_statistics update_stats_;
+
+private:
+  void start_rebuild(schedule const&);
+  void finish_rebuild(schedule const&);
+
+  // Background rebuild (see start_rebuild), guarded by update_mutex_.
+  std::shared_future<void> rebuild_;
+  std::vector<motis::module::msg_ptr> deferred_updates_;
 };
 
 }  // namespace motis::csa
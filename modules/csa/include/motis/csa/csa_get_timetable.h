@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "motis/module/context/get_module.h"
 
 #include "utl/verify.h"
@@ -9,10 +11,10 @@
 
 namespace motis::csa {
 
-inline csa_timetable const& csa_get_timetable() {
-  auto const tt = motis::module::get_module<csa>("csa").get_timetable();
+inline std::shared_ptr<csa_timetable const> csa_get_timetable() {
+  auto tt = motis::module::get_module<csa>("csa").get_timetable();
   utl::verify(tt != nullptr, "csa timetable not initialized!");
-  return *tt;
+  return tt;
 }
 
 }  // namespace motis::csa
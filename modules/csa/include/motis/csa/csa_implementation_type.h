@@ -2,6 +2,13 @@
 
 namespace motis::csa {
 
-enum class implementation_type { CPU, CPU_SSE, GPU };
+enum class implementation_type {
+  CPU,
+  CPU_SSE,
+  CPU_PROFILE,
+  CPU_PRICE,
+  CPU_PRICE_BUCKETS,
+  GPU
+};
 
 }  // namespace motis::csa
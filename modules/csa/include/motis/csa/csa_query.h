@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <vector>
 
+#include "motis/core/common/deadline.h"
 #include "motis/core/schedule/interval.h"
 #include "motis/core/schedule/schedule.h"
 #include "motis/csa/csa_timetable.h"
@@ -10,6 +13,17 @@
 
 namespace motis::csa {
 
+struct csa_search_state_pool;
+
+// Station (guessed from the name if no id is given) and its meta stations.
+std::vector<station_id> get_metas(schedule const&,
+                                  motis::routing::InputStation const*,
+                                  bool use_metas);
+
+// Runs independent jobs concurrently and returns when all are done.
+using csa_job = std::function<void()>;
+using run_jobs_fn = std::function<void(std::vector<csa_job> const&)>;
+
 struct csa_query {
   csa_query(schedule const&, motis::routing::RoutingRequest const*);
 
@@ -19,7 +33,22 @@ struct csa_query {
   interval search_interval_;
   unsigned min_connection_count_{0U};
   bool extend_interval_earlier_{false}, extend_interval_later_{false};
+  bool target_pruning_{false};
   search_dir dir_{search_dir::FWD};
+  deadline* deadline_{nullptr};
+
+  // Fare classes of the price bucket search (count <= 8, geometric bounds
+  // starting at price_bucket_base_).
+  unsigned price_buckets_{8U};
+  uint16_t price_bucket_base_{500U};
+
+  // Reused search buffers (nullptr: allocated per search).
+  csa_search_state_pool* state_pool_{nullptr};
+
+  // Number of concurrent ontrip scans of pretrip queries (requires
+  // run_parallel_, <= 1: sequential).
+  unsigned parallel_jobs_{1U};
+  run_jobs_fn run_parallel_;
 };
 
 }  // namespace motis::csa
\ No newline at end of file
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <limits>
+#include <vector>
 
+#include "motis/core/schedule/edges.h"
 #include "motis/core/schedule/time.h"
 
+#include "motis/csa/csa_timetable.h"
+
 namespace motis {
 namespace csa {
 
@@ -27,5 +34,84 @@ struct array_maker<T, N, 1> {
   }
 };
 
+// Index of the first connection departing (FWD) / arriving (BWD) at or after
+// (FWD) / before (BWD) the given time. Works for csa_connection_view and
+// csa_connection_arrays.
+template <search_dir Dir, typename Connections>
+std::size_t get_first_connection(Connections const& cons, time const t) {
+  auto lo = std::size_t{0U};
+  auto hi = cons.size();
+  while (lo < hi) {
+    auto const mid = lo + (hi - lo) / 2;
+    auto const before = Dir == search_dir::FWD ? cons.departure(mid) < t
+                                               : cons.arrival(mid) > t;
+    if (before) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// Index of the first connection departing after (FWD) / arriving before (BWD)
+// the time limit.
+template <search_dir Dir, typename Connections>
+std::size_t get_last_connection(Connections const& cons, int const time_limit) {
+  auto const t = Dir == search_dir::FWD ? time_limit + 1 : time_limit - 1;
+  return t < 0 || t > std::numeric_limits<time>::max()
+             ? cons.size()
+             : get_first_connection<Dir>(cons, static_cast<time>(t));
+}
+
+// Target pruning: best arrival time (FWD) / departure time (BWD) at any
+// destination station using at most k trips. Connections departing later
+// (FWD) / arriving earlier (BWD) can only lead to journeys with more than k
+// trips or journeys dominated by the known ones. Without destinations,
+// nothing gets pruned.
+template <search_dir Dir>
+struct target_bounds {
+  static constexpr time INVALID = Dir == search_dir::FWD
+                                      ? std::numeric_limits<time>::max()
+                                      : std::numeric_limits<time>::min();
+
+  void add_destination(station_id const id, std::size_t const station_count) {
+    is_destination_.resize(station_count);
+    is_destination_[id] = true;
+  }
+
+  inline bool is_destination(station_id const id) const {
+    return !is_destination_.empty() && is_destination_[id];
+  }
+
+  inline void update(int const trips, time const t) {
+    for (auto k = trips; k <= MAX_TRANSFERS; ++k) {
+      auto& bound = bounds_[k];  // NOLINT
+      bound = Dir == search_dir::FWD ? std::min(bound, t) : std::max(bound, t);
+    }
+  }
+
+  inline void update(std::array<time, MAX_TRANSFERS + 1> const& times) {
+    auto best = INVALID;
+    for (auto k = 0; k <= MAX_TRANSFERS; ++k) {
+      auto& bound = bounds_[k];  // NOLINT
+      best = Dir == search_dir::FWD ? std::min(best, times[k])  // NOLINT
+                                    : std::max(best, times[k]);  // NOLINT
+      bound = Dir == search_dir::FWD ? std::min(bound, best)
+                                     : std::max(bound, best);
+    }
+  }
+
+  // t = departure (FWD) / arrival (BWD) of the connection
+  inline bool prunes(time const t, int const trips) const {
+    return Dir == search_dir::FWD ? t > bounds_[trips]  // NOLINT
+                                  : t < bounds_[trips];  // NOLINT
+  }
+
+  std::vector<bool> is_destination_;
+  std::array<time, MAX_TRANSFERS + 1> bounds_{
+      array_maker<time, MAX_TRANSFERS + 1>::make_array(INVALID)};
+};
+
 }  // namespace csa
 }  // namespace motis
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "boost/align/aligned_allocator.hpp"
+
+#include "motis/core/schedule/time.h"
+
+#include "motis/csa/cpu/csa_price_labels.h"
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_statistics.h"
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa {
+
+// Buffers of the ontrip searches (cpu / sse, price and price buckets),
+// reused by the following searches.
+//
+// The search marks the stations and trips it writes (touch_*): a station /
+// trip is recorded once per search (epoch_ instead of clearing the marks).
+// The next search resets only the recorded entries of the buffers of the
+// previous search kind instead of refilling the buffers sized to all
+// stations and trips. The scan loop itself reads the buffers without any
+// checks. The buffers of a kind are allocated by its first search.
+struct csa_search_state {
+  enum class search_kind : uint8_t { NONE, DEFAULT, PRICE, PRICE_BUCKETS };
+
+  template <typename T>
+  using aligned_vector =
+      std::vector<T, boost::alignment::aligned_allocator<T, 16>>;
+  using arrival_times = aligned_vector<std::array<time, MAX_TRANSFERS + 1>>;
+  using trip_reachability =
+      aligned_vector<std::array<uint16_t, MAX_TRANSFERS + 1>>;
+
+  // price::csa_search
+  using price_arrivals = std::vector<std::array<
+      std::vector<price::station_arrival_info>, MAX_TRANSFERS + 1>>;
+  using price_trip_reachability = std::vector<
+      std::vector<std::array<price::price_t, MAX_TRANSFERS + 1>>>;
+
+  // Valid cpu / sse buffers for the given timetable size, all entries
+  // unreached (invalid = unreached arrival time, depends on the search
+  // direction).
+  void prepare(std::size_t const station_count, std::size_t const trip_count,
+               time const invalid, csa_statistics& stats) {
+    begin_search(search_kind::DEFAULT, station_count, trip_count, invalid,
+                 stats);
+    if (arrival_time_.size() != station_count ||
+        trip_reachable_.size() != trip_count) {
+      // first search or changed timetable (realtime updates)
+      ++stats.state_allocations_;
+      arrival_time_.assign(
+          station_count,
+          array_maker<time, MAX_TRANSFERS + 1>::make_array(invalid));
+      trip_reachable_.assign(trip_count, {});
+    } else {
+      ++stats.state_reuses_;
+      if (invalid != arrival_invalid_) {
+        // previous search in the other direction
+        stats.state_entries_reset_ += station_count + trip_count;
+        std::fill(begin(arrival_time_), end(arrival_time_),
+                  array_maker<time, MAX_TRANSFERS + 1>::make_array(invalid));
+        std::fill(begin(trip_reachable_), end(trip_reachable_),
+                  std::array<uint16_t, MAX_TRANSFERS + 1>{});
+      }
+    }
+    arrival_invalid_ = invalid;
+  }
+
+  // price::csa_search buffers: no arrivals, no reachable trips (both
+  // directions).
+  void prepare_price(std::size_t const station_count,
+                     std::size_t const trip_count, time const invalid,
+                     csa_statistics& stats) {
+    begin_search(search_kind::PRICE, station_count, trip_count, invalid,
+                 stats);
+    if (price_arrival_.size() != station_count ||
+        price_trip_reachable_.size() != trip_count) {
+      ++stats.state_allocations_;
+      price_arrival_.clear();
+      price_arrival_.resize(station_count);
+      price_trip_reachable_.clear();
+      price_trip_reachable_.resize(trip_count);
+    } else {
+      ++stats.state_reuses_;
+    }
+  }
+
+  // price_buckets::csa_search buffers, all labels unused (invalid = unused
+  // label time, depends on the search direction).
+  void prepare_price_buckets(std::size_t const station_count,
+                             std::size_t const trip_count, time const invalid,
+                             csa_statistics& stats) {
+    begin_search(search_kind::PRICE_BUCKETS, station_count, trip_count,
+                 invalid, stats);
+    auto const empty_labels =
+        array_maker<price_buckets::bucket_labels, MAX_TRANSFERS + 1>::
+            make_array(price_buckets::bucket_labels::make(invalid));
+    auto const no_fares = array_maker<price::price_t, MAX_TRANSFERS + 1>::
+        make_array(price::INVALID_PRICE);
+    if (bucket_labels_.size() != station_count ||
+        bucket_trip_fare_.size() != trip_count) {
+      ++stats.state_allocations_;
+      bucket_labels_.assign(station_count, empty_labels);
+      bucket_trip_fare_.assign(trip_count, no_fares);
+    } else {
+      ++stats.state_reuses_;
+      if (invalid != bucket_invalid_) {
+        stats.state_entries_reset_ += station_count;
+        std::fill(begin(bucket_labels_), end(bucket_labels_), empty_labels);
+      }
+    }
+    bucket_invalid_ = invalid;
+  }
+
+  inline void touch_station(station_id const id) {
+    if (station_epoch_[id] != epoch_) {
+      station_epoch_[id] = epoch_;
+      touched_stations_.emplace_back(id);
+    }
+  }
+
+  inline void touch_trip(trip_id const id) {
+    if (trip_epoch_[id] != epoch_) {
+      trip_epoch_[id] = epoch_;
+      touched_trips_.emplace_back(id);
+    }
+  }
+
+  // Kind and invalid time (direction) of the last search.
+  search_kind kind_{search_kind::NONE};
+  time invalid_{0U};
+
+  arrival_times arrival_time_;
+  trip_reachability trip_reachable_;
+
+  price_arrivals price_arrival_;
+  price_trip_reachability price_trip_reachable_;
+
+  std::vector<price_buckets::station_labels> bucket_labels_;
+  std::vector<price_buckets::fares> bucket_trip_fare_;
+
+private:
+  // Resets the entries written by the previous search and starts recording
+  // the entries written by the next one.
+  void begin_search(search_kind const kind, std::size_t const station_count,
+                    std::size_t const trip_count, time const invalid,
+                    csa_statistics& stats) {
+    stats.state_entries_reset_ +=
+        touched_stations_.size() + touched_trips_.size();
+    switch (kind_) {
+      case search_kind::DEFAULT:
+        for (auto const id : touched_stations_) {
+          arrival_time_[id] =
+              array_maker<time, MAX_TRANSFERS + 1>::make_array(
+                  arrival_invalid_);
+        }
+        for (auto const id : touched_trips_) {
+          trip_reachable_[id] = {};
+        }
+        break;
+      case search_kind::PRICE:
+        for (auto const id : touched_stations_) {
+          for (auto& arrivals : price_arrival_[id]) {
+            arrivals.clear();
+          }
+        }
+        for (auto const id : touched_trips_) {
+          price_trip_reachable_[id].clear();
+        }
+        break;
+      case search_kind::PRICE_BUCKETS:
+        for (auto const id : touched_stations_) {
+          bucket_labels_[id] =
+              array_maker<price_buckets::bucket_labels, MAX_TRANSFERS + 1>::
+                  make_array(price_buckets::bucket_labels::make(
+                      bucket_invalid_));
+        }
+        for (auto const id : touched_trips_) {
+          bucket_trip_fare_[id] =
+              array_maker<price::price_t, MAX_TRANSFERS + 1>::make_array(
+                  price::INVALID_PRICE);
+        }
+        break;
+      case search_kind::NONE: break;
+    }
+    touched_stations_.clear();
+    touched_trips_.clear();
+
+    if (station_epoch_.size() != station_count ||
+        trip_epoch_.size() != trip_count) {
+      station_epoch_.assign(station_count, 0U);
+      trip_epoch_.assign(trip_count, 0U);
+    }
+    next_epoch();
+    kind_ = kind;
+    invalid_ = invalid;
+  }
+
+  void next_epoch() {
+    if (++epoch_ == 0U) {
+      std::fill(begin(station_epoch_), end(station_epoch_), 0U);
+      std::fill(begin(trip_epoch_), end(trip_epoch_), 0U);
+      epoch_ = 1U;
+    }
+  }
+
+  time arrival_invalid_{0U}, bucket_invalid_{0U};
+  uint32_t epoch_{0U};
+  std::vector<uint32_t> station_epoch_, trip_epoch_;
+  std::vector<station_id> touched_stations_;
+  std::vector<trip_id> touched_trips_;
+};
+
+// Search states of the running searches (i.e. at most one per worker thread)
+// and idle search states for the next searches. Surplus idle states are
+// released.
+struct csa_search_state_pool {
+  explicit csa_search_state_pool(std::size_t const max_idle)
+      : max_idle_{max_idle} {}
+
+  // Prefers an idle state of a previous search of the same kind in the same
+  // direction.
+  csa_search_state* acquire(csa_search_state::search_kind const kind,
+                            time const invalid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto best = end(states_);
+    for (auto it = begin(states_); it != end(states_); ++it) {
+      if (!it->in_use_ &&
+          (best == end(states_) ||
+           (it->state_->kind_ == kind && it->state_->invalid_ == invalid))) {
+        best = it;
+      }
+    }
+    if (best == end(states_)) {
+      best = states_.insert(
+          end(states_), entry{std::make_unique<csa_search_state>(), false});
+    }
+    best->in_use_ = true;
+    return best->state_.get();
+  }
+
+  void release(csa_search_state* s) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto const it =
+        std::find_if(begin(states_), end(states_),
+                     [&](entry const& e) { return e.state_.get() == s; });
+    it->in_use_ = false;
+    auto const idle = std::count_if(begin(states_), end(states_),
+                                    [](entry const& e) { return !e.in_use_; });
+    if (max_idle_ != 0U && static_cast<std::size_t>(idle) > max_idle_) {
+      states_.erase(it);
+    }
+  }
+
+private:
+  struct entry {
+    std::unique_ptr<csa_search_state> state_;
+    bool in_use_;
+  };
+
+  std::size_t max_idle_;
+  std::mutex mutex_;
+  std::vector<entry> states_;
+};
+
+// Search state from the pool (if any) for the lifetime of a search.
+struct csa_search_state_retriever {
+  csa_search_state_retriever(csa_search_state_pool* pool, search_dir const dir,
+                             csa_search_state::search_kind const kind =
+                                 csa_search_state::search_kind::DEFAULT)
+      : pool_{pool},
+        state_{pool == nullptr
+                   ? &own_state_
+                   : pool->acquire(kind,
+                                   dir == search_dir::FWD
+                                       ? std::numeric_limits<time>::max()
+                                       : std::numeric_limits<time>::min())} {}
+
+  csa_search_state_retriever(csa_search_state_retriever const&) = delete;
+  csa_search_state_retriever& operator=(csa_search_state_retriever const&) =
+      delete;
+
+  csa_search_state_retriever(csa_search_state_retriever&&) = delete;
+  csa_search_state_retriever& operator=(csa_search_state_retriever&&) = delete;
+
+  ~csa_search_state_retriever() {
+    if (pool_ != nullptr) {
+      pool_->release(state_);
+    }
+  }
+
+  csa_search_state& get() { return *state_; }
+
+private:
+  csa_search_state_pool* pool_;
+  csa_search_state own_state_;
+  csa_search_state* state_;
+};
+
+}  // namespace motis::csa
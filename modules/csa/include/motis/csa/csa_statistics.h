@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 
 #include "motis/core/statistics/statistics.h"
@@ -10,6 +11,8 @@ struct csa_statistics {
   uint64_t start_count_{};
   uint64_t destination_count_{};
   uint64_t connections_scanned_{};
+  uint64_t connections_pruned_{};
+  uint64_t connections_skipped_{};
   uint64_t footpaths_expanded_{};
   uint64_t reconstruction_count_{};
   uint64_t reachable_via_station_{};
@@ -23,16 +26,56 @@ struct csa_statistics {
   uint64_t price_bounds_updated_{};
   uint64_t price_bounds_filtered_{};
   uint64_t search_duration_{};
+  uint64_t search_duration_us_{};
   uint64_t reconstruction_duration_{};
   uint64_t total_duration_{};
+  uint64_t parallel_jobs_{};
+  uint64_t state_allocations_{};
+  uint64_t state_reuses_{};
+  uint64_t state_entries_reset_{};
+  bool timeout_quit_{};
 };
 
+// Adds the statistics of a concurrently running sub search (durations are
+// summed up, i.e. they are CPU time).
+inline void add_stats(csa_statistics& to, csa_statistics const& from) {
+  to.start_count_ += from.start_count_;
+  to.destination_count_ += from.destination_count_;
+  to.connections_scanned_ += from.connections_scanned_;
+  to.connections_pruned_ += from.connections_pruned_;
+  to.connections_skipped_ += from.connections_skipped_;
+  to.footpaths_expanded_ += from.footpaths_expanded_;
+  to.reconstruction_count_ += from.reconstruction_count_;
+  to.reachable_via_station_ += from.reachable_via_station_;
+  to.reachable_via_trip_ += from.reachable_via_trip_;
+  to.trip_reachable_updates_ += from.trip_reachable_updates_;
+  to.labels_created_ += from.labels_created_;
+  to.existing_labels_dominated_ += from.existing_labels_dominated_;
+  to.new_labels_dominated_ += from.new_labels_dominated_;
+  to.max_labels_per_station_ =
+      std::max(to.max_labels_per_station_, from.max_labels_per_station_);
+  to.trip_price_init_ += from.trip_price_init_;
+  to.price_bounds_updated_ += from.price_bounds_updated_;
+  to.price_bounds_filtered_ += from.price_bounds_filtered_;
+  to.search_duration_ += from.search_duration_;
+  to.search_duration_us_ += from.search_duration_us_;
+  to.reconstruction_duration_ += from.reconstruction_duration_;
+  to.total_duration_ += from.total_duration_;
+  to.parallel_jobs_ += from.parallel_jobs_;
+  to.state_allocations_ += from.state_allocations_;
+  to.state_reuses_ += from.state_reuses_;
+  to.state_entries_reset_ += from.state_entries_reset_;
+  to.timeout_quit_ = to.timeout_quit_ || from.timeout_quit_;
+}
+
 inline stats_category to_stats_category(char const* name,
                                         csa_statistics const& s) {
   return {name,
           {{"start_count", s.start_count_},
            {"destination_count", s.destination_count_},
            {"connections_scanned", s.connections_scanned_},
+           {"connections_pruned", s.connections_pruned_},
+           {"connections_skipped", s.connections_skipped_},
            {"footpaths_expanded", s.footpaths_expanded_},
            {"reconstruction_count", s.reconstruction_count_},
            {"reachable_via_station", s.reachable_via_station_},
@@ -46,8 +89,14 @@ inline stats_category to_stats_category(char const* name,
            {"price_bounds_updated", s.price_bounds_updated_},
            {"price_bounds_filtered", s.price_bounds_filtered_},
            {"search_duration", s.search_duration_},
+           {"search_duration_us", s.search_duration_us_},
            {"reconstruction_duration", s.reconstruction_duration_},
-           {"total_duration", s.total_duration_}}};
+           {"total_duration", s.total_duration_},
+           {"parallel_jobs", s.parallel_jobs_},
+           {"state_allocations", s.state_allocations_},
+           {"state_reuses", s.state_reuses_},
+           {"state_entries_reset", s.state_entries_reset_},
+           {"timeout_quit", s.timeout_quit_ ? 1U : 0U}}};
 }
 
 }  // namespace motis::csa
@@ -5,9 +5,12 @@
 #include <tuple>
 #include <vector>
 
+#include "cista/memory_holder.h"
+
 #include "motis/core/schedule/connection.h"
 #include "motis/core/schedule/footpath.h"
 #include "motis/core/schedule/time.h"
+#include "motis/hash_map.h"
 
 #ifdef MOTIS_CUDA
 #include "motis/csa/gpu/gpu_timetable.h"
@@ -17,6 +20,7 @@ namespace motis {
 
 struct light_connection;
 struct station;
+struct trip;
 
 namespace csa {
 
@@ -59,6 +63,99 @@ struct csa_connection {
   light_connection const* light_con_{nullptr};
 };
 
+// Fields of the connections read by the scan loop as parallel arrays
+// (index i = connections[i]). Everything else (price, class, light
+// connection) is only needed for the reconstruction and stays in the
+// csa_connection.
+//
+// The accessors read through the *_data_ pointers: either into the vectors
+// below (init) or into memory owned by someone else, i.e. the memory mapped
+// timetable file (map, see read_timetable). update() copies mapped arrays
+// into the vectors first.
+struct csa_connection_arrays {
+  enum flags : uint8_t { FROM_IN_ALLOWED = 1U, TO_OUT_ALLOWED = 2U };
+
+  csa_connection_arrays() = default;
+  ~csa_connection_arrays() = default;
+  csa_connection_arrays(csa_connection_arrays const&) = delete;
+  csa_connection_arrays& operator=(csa_connection_arrays const&) = delete;
+  csa_connection_arrays(csa_connection_arrays&&) = default;
+  csa_connection_arrays& operator=(csa_connection_arrays&&) = default;
+
+  void init(std::vector<csa_connection> const&);
+  void map(time const* departure, time const* arrival,
+           station_id const* from_station, station_id const* to_station,
+           trip_id const* trip, uint8_t const* flags, std::size_t size);
+  void update(std::vector<csa_connection> const&, std::size_t from,
+              std::size_t to);
+  void read_vectors();
+
+  inline bool empty() const { return size_ == 0U; }
+  inline std::size_t size() const { return size_; }
+  inline bool mapped() const { return size_ != departure_.size(); }
+
+  inline time departure(std::size_t const i) const {
+    return departure_data_[i];
+  }
+  inline time arrival(std::size_t const i) const { return arrival_data_[i]; }
+  inline station_id from_station(std::size_t const i) const {
+    return from_station_data_[i];
+  }
+  inline station_id to_station(std::size_t const i) const {
+    return to_station_data_[i];
+  }
+  inline trip_id trip(std::size_t const i) const { return trip_data_[i]; }
+  inline bool from_in_allowed(std::size_t const i) const {
+    return (flags_data_[i] & FROM_IN_ALLOWED) != 0U;
+  }
+  inline bool to_out_allowed(std::size_t const i) const {
+    return (flags_data_[i] & TO_OUT_ALLOWED) != 0U;
+  }
+
+  time const* departure_data_{nullptr};
+  time const* arrival_data_{nullptr};
+  station_id const* from_station_data_{nullptr};
+  station_id const* to_station_data_{nullptr};
+  trip_id const* trip_data_{nullptr};
+  uint8_t const* flags_data_{nullptr};
+  std::size_t size_{0U};
+
+  // empty if mapped
+  std::vector<time> departure_, arrival_;
+  std::vector<station_id> from_station_, to_station_;
+  std::vector<trip_id> trip_;
+  std::vector<uint8_t> flags_;
+};
+
+// Same interface as csa_connection_arrays for the array of structs.
+struct csa_connection_view {
+  inline std::size_t size() const { return connections_.size(); }
+
+  inline time departure(std::size_t const i) const {
+    return connections_[i].departure_;
+  }
+  inline time arrival(std::size_t const i) const {
+    return connections_[i].arrival_;
+  }
+  inline station_id from_station(std::size_t const i) const {
+    return connections_[i].from_station_;
+  }
+  inline station_id to_station(std::size_t const i) const {
+    return connections_[i].to_station_;
+  }
+  inline trip_id trip(std::size_t const i) const {
+    return connections_[i].trip_;
+  }
+  inline bool from_in_allowed(std::size_t const i) const {
+    return connections_[i].from_in_allowed_;
+  }
+  inline bool to_out_allowed(std::size_t const i) const {
+    return connections_[i].to_out_allowed_;
+  }
+
+  std::vector<csa_connection> const& connections_;
+};
+
 struct csa_station {
   csa_station() = delete;
   explicit csa_station(station const* station_ptr);
@@ -77,13 +174,20 @@ struct csa_timetable {
   std::vector<csa_connection> fwd_connections_, bwd_connections_;
   std::vector<uint32_t> fwd_bucket_starts_, bwd_bucket_starts_;
 
+  // only filled if enabled (see build_csa_timetable)
+  csa_connection_arrays fwd_arrays_, bwd_arrays_;
+
   std::vector<std::vector<csa_connection const*>> trip_to_connections_;
+  mcd::hash_map<trip const*, trip_id> trip_ids_;
 
 #ifdef MOTIS_CUDA
   gpu_timetable gpu_timetable_;
 #endif
 
   uint32_t trip_count_{0};
+
+  // Timetable file the mapped connection arrays point into (read_timetable).
+  cista::memory_holder file_;
 };
 
 }  // namespace csa
@@ -17,7 +17,8 @@ enum error_code_t {
   via_not_supported = 7,
   additional_edges_not_supported = 8,
   trip_not_found = 9,
-  start_footpaths_no_disable = 10
+  start_footpaths_no_disable = 10,
+  no_start = 11
 };
 }  // namespace error
 
@@ -44,6 +45,7 @@ public:
       case error::trip_not_found: return "csa: trip not found";
       case error::start_footpaths_no_disable:
         return "csa: start footpaths cannot be disabled";
+      case error::no_start: return "csa: no start station or start edges";
       default: return "csa: unknown error";
     }
   }
@@ -173,6 +173,7 @@ struct gpu_search {
     MOTIS_STOP_TIMING(reconstruction_timing);
 
     stats_.search_duration_ += MOTIS_TIMING_MS(search_timing);
+    stats_.search_duration_us_ += MOTIS_TIMING_US(search_timing);
     stats_.reconstruction_duration_ += MOTIS_TIMING_MS(reconstruction_timing);
   }
 
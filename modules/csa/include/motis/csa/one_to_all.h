@@ -0,0 +1,30 @@
+#pragma once
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "motis/core/schedule/time.h"
+
+#include "motis/csa/csa_search_shared.h"
+#include "motis/csa/csa_search_state.h"
+#include "motis/csa/csa_statistics.h"
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa {
+
+struct one_to_all_result {
+  // arrival_times_[station][trips] (INVALID_TIME / 0 if not reachable)
+  std::vector<std::array<time, MAX_TRANSFERS + 1>> arrival_times_;
+  csa_statistics stats_;
+};
+
+// One connection scan from all starts (station, initial duration) without
+// destination. Returns the arrival (FWD) / departure (BWD) times at all
+// stations within max_travel_time.
+one_to_all_result run_one_to_all(
+    csa_timetable const&, std::vector<std::pair<station_id, duration>> const&,
+    time start_time, search_dir, duration max_travel_time,
+    csa_search_state_pool* = nullptr);
+
+}  // namespace motis::csa
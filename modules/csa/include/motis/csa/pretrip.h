@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <vector>
 
 #include "motis/core/common/timing.h"
 #include "motis/core/schedule/interval.h"
@@ -8,6 +9,7 @@
 
 #include "motis/csa/collect_start_times.h"
 #include "motis/csa/csa_query.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 #include "motis/csa/pareto_set.h"
@@ -29,7 +31,8 @@ struct pretrip : public SearchStrategy {
 
     static_cast<SearchStrategy*>(this)->search_in_interval(
         results_, search_interval_, true);
-    while (!min_connection_count_reached() && !max_interval_reached()) {
+    while (!min_connection_count_reached() && !max_interval_reached() &&
+           !stats().timeout_quit_) {
       auto const extended_search_interval =
           interval{query().extend_interval_earlier_
                        ? map_to_interval(search_interval_.begin_ - 60)
@@ -117,12 +120,23 @@ struct pretrip_iterated_ontrip_search {
                           bool const ontrip_at_interval_end) {
     auto const start_times =
         collect_start_times(tt_, q_, search_interval, ontrip_at_interval_end);
+    if (q_.parallel_jobs_ > 1U && q_.run_parallel_ && start_times.size() > 1U) {
+      search_parallel(results, std::vector<motis::time>(begin(start_times),
+                                                        end(start_times)));
+      return;
+    }
+
+    csa_search_state_retriever state{q_.state_pool_, q_.dir_};
     for (auto const& start_time : start_times) {
-      CSASearch csa{tt_, start_time, stats_};
-      for (auto const& start_idx : q_.meta_starts_) {
-        csa.add_start(tt_.stations_.at(start_idx), 0);
+      if (q_.deadline_ != nullptr && q_.deadline_->check()) {
+        stats_.timeout_quit_ = true;
+        break;
       }
 
+      CSASearch csa{tt_, start_time, stats_, state.get()};
+      csa.set_deadline(q_.deadline_);
+      add_starts_and_destinations(csa);
+
       MOTIS_START_TIMING(search_timing);
       csa.search();
       MOTIS_STOP_TIMING(search_timing);
@@ -132,10 +146,82 @@ struct pretrip_iterated_ontrip_search {
       MOTIS_STOP_TIMING(reconstruction_timing);
 
       stats_.search_duration_ += MOTIS_TIMING_MS(search_timing);
+      stats_.search_duration_us_ += MOTIS_TIMING_US(search_timing);
       stats_.reconstruction_duration_ += MOTIS_TIMING_MS(reconstruction_timing);
     }
   }
 
+  // The start times are distributed round robin over q_.parallel_jobs_ jobs.
+  // Each job uses one search state for all its start times and keeps the
+  // journeys per start time. The journeys are added to the results
+  // in start time order afterwards, i.e. in the same order as in the
+  // sequential search: the result set does not depend on the scheduling.
+  template <typename Results>
+  void search_parallel(Results& results,
+                       std::vector<motis::time> const& start_times) {
+    auto const job_count = std::min(static_cast<std::size_t>(q_.parallel_jobs_),
+                                    start_times.size());
+    std::vector<std::vector<csa_journey>> journeys(start_times.size());
+    std::vector<csa_statistics> job_stats(job_count);
+
+    std::vector<csa_job> jobs;
+    for (auto job = std::size_t{0U}; job != job_count; ++job) {
+      jobs.emplace_back([&, job]() {
+        auto& stats = job_stats[job];
+        // deadline::check() is not thread safe: one copy per job
+        auto job_deadline =
+            q_.deadline_ == nullptr ? deadline{} : *q_.deadline_;
+        csa_search_state_retriever state{q_.state_pool_, q_.dir_};
+        for (auto i = job; i < start_times.size(); i += job_count) {
+          if (job_deadline.check()) {
+            stats.timeout_quit_ = true;
+            break;
+          }
+
+          CSASearch csa{tt_, start_times[i], stats, state.get()};
+          csa.set_deadline(&job_deadline);
+          add_starts_and_destinations(csa);
+
+          MOTIS_START_TIMING(search_timing);
+          csa.search();
+          MOTIS_STOP_TIMING(search_timing);
+
+          MOTIS_START_TIMING(reconstruction_timing);
+          collect_results(csa, journeys[i]);
+          MOTIS_STOP_TIMING(reconstruction_timing);
+
+          stats.search_duration_ += MOTIS_TIMING_MS(search_timing);
+          stats.search_duration_us_ += MOTIS_TIMING_US(search_timing);
+          stats.reconstruction_duration_ +=
+              MOTIS_TIMING_MS(reconstruction_timing);
+        }
+      });
+    }
+    q_.run_parallel_(jobs);
+
+    for (auto const& s : job_stats) {
+      add_stats(stats_, s);
+    }
+    stats_.parallel_jobs_ += job_count;
+
+    for (auto& start_time_journeys : journeys) {
+      for (auto& j : start_time_journeys) {
+        results.push_back(j);
+      }
+    }
+  }
+
+  void add_starts_and_destinations(CSASearch& csa) {
+    if (q_.target_pruning_) {
+      for (auto const& dest_idx : q_.meta_dests_) {
+        csa.add_destination(tt_.stations_.at(dest_idx));
+      }
+    }
+    for (auto const& start_idx : q_.meta_starts_) {
+      csa.add_start(tt_.stations_.at(start_idx), 0);
+    }
+  }
+
   template <typename Results>
   void collect_results(CSASearch& csa, Results& results) {
     for (auto const& dest_idx : q_.meta_dests_) {
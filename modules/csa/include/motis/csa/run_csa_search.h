@@ -17,4 +17,13 @@ namespace motis::csa {
 response run_csa_search(schedule const&, csa_timetable const&, csa_query const&,
                         motis::routing::SearchType, implementation_type);
 
+// Answers the queries in order. With AVX2 (MOTIS_AVX2/MOTIS_AVX512, off by
+// default), ontrip queries (default search type) are answered in batches
+// that scan the connections once for up to 16 queries; a query whose
+// deadline is reached stops updating (timeout_quit). All other queries are
+// answered one by one.
+std::vector<response> run_csa_batch_search(
+    schedule const&, csa_timetable const&, std::vector<csa_query> const&,
+    std::vector<motis::routing::SearchType> const&);
+
 }  // namespace motis::csa
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "motis/core/schedule/schedule.h"
+
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa {
+
+// Writes the sorted connections, buckets and connection arrays of the
+// timetable to a file. Everything that points into the schedule is stored as
+// an index.
+void write_timetable(std::string const& path, schedule const&,
+                     csa_timetable const&, bool bridged, bool footpaths);
+
+// Memory maps a file written by write_timetable and creates the timetable
+// from it without sorting. The connection arrays (connection_arrays=true)
+// are used in place from the mapping, which the timetable keeps open. The
+// connections are copied (their light connection pointers are restored from
+// the schedule); stations, trip_to_connections and the per station
+// connections point into them and are rebuilt in a linear pass. Returns
+// nullptr if the file was written for a different schedule or with
+// different options.
+std::unique_ptr<csa_timetable> read_timetable(std::string const& path,
+                                              schedule const&, bool bridged,
+                                              bool footpaths,
+                                              bool connection_arrays);
+
+}  // namespace motis::csa
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "motis/core/schedule/schedule.h"
+#include "motis/core/statistics/statistics.h"
+
+#include "motis/csa/csa_timetable.h"
+
+#include "motis/protocol/RtUpdate_generated.h"
+
+namespace motis::csa {
+
+struct csa_update_statistics {
+  uint64_t update_count_{};
+  uint64_t updated_trips_{};
+  uint64_t updated_connections_{};
+  uint64_t resorted_connections_{};
+  uint64_t full_rebuilds_{};
+  uint64_t pending_rebuilds_{};
+  uint64_t deferred_updates_{};
+  uint64_t last_update_duration_us_{};
+  uint64_t max_update_duration_us_{};
+  uint64_t total_update_duration_us_{};
+};
+
+inline stats_category to_stats_category(char const* name,
+                                        csa_update_statistics const& s) {
+  return {name,
+          {{"update_count", s.update_count_},
+           {"updated_trips", s.updated_trips_},
+           {"updated_connections", s.updated_connections_},
+           {"resorted_connections", s.resorted_connections_},
+           {"full_rebuilds", s.full_rebuilds_},
+           {"pending_rebuilds", s.pending_rebuilds_},
+           {"deferred_updates", s.deferred_updates_},
+           {"last_update_duration_us", s.last_update_duration_us_},
+           {"max_update_duration_us", s.max_update_duration_us_},
+           {"total_update_duration_us", s.total_update_duration_us_}}};
+}
+
+// Applies delays to the timetable: only the slices of the (fwd and bwd)
+// connection arrays spanned by the old and new times of the updated
+// connections are re-sorted. Returns false if the update can not be applied
+// incrementally (reroutes, changed trip structure, changed bridges) and the
+// timetable has to be rebuilt. In this case, the timetable is not modified.
+bool update_csa_timetable(schedule const&, csa_timetable&,
+                          motis::rt::RtUpdates const*, bool bridged,
+                          bool footpaths, csa_update_statistics&);
+
+// Same for a timetable that is in use by searches: tt is not modified, the
+// update is applied to a copy of it (updated; stays empty if the update does
+// not change anything).
+bool update_csa_timetable_copy(schedule const&, csa_timetable const& tt,
+                               std::unique_ptr<csa_timetable>& updated,
+                               motis::rt::RtUpdates const*, bool bridged,
+                               bool footpaths, csa_update_statistics&);
+
+}  // namespace motis::csa
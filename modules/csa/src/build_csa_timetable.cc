@@ -74,6 +74,8 @@ bool is_out_allowed(node const* route_node) {
   return false;
 }
 
+}  // namespace
+
 std::vector<uint32_t> get_bucket_starts(
     std::vector<csa_connection>::const_iterator const it_begin,
     std::vector<csa_connection>::const_iterator const it_end,
@@ -139,11 +141,11 @@ std::vector<uint32_t> get_bucket_starts(
   bucket_starts.emplace_back(
       static_cast<uint32_t>(std::distance(it_begin, it_end)));
 
-  LOG(info) << "CSA bucket count: " << bucket_starts.size() - 1;
-
   return bucket_starts;
 }
 
+namespace {
+
 trip_id get_connections_from_expanded_trips(
     csa_timetable& tt, schedule const& sched,
     bool bridge_zero_duration_connections, bool add_footpath_connections) {
@@ -167,6 +169,7 @@ trip_id get_connections_from_expanded_trips(
           });
 
       for (auto const& trp : route_trips) {
+        tt.trip_ids_[trp] = trip_idx;
         auto const trp_sections = sections{trp};
         for (auto sec_it = trp_sections.begin(); sec_it != trp_sections.end();
              ++sec_it) {
@@ -267,6 +270,10 @@ trip_id get_connections_from_expanded_trips(
     tt.bwd_bucket_starts_ =
         get_bucket_starts(begin(tt.bwd_connections_), end(tt.bwd_connections_),
                           search_dir::BWD, bridge_zero_duration_connections);
+    LOG(info) << "CSA bucket count: "
+              << (tt.fwd_bucket_starts_.empty()
+                      ? 0U
+                      : tt.fwd_bucket_starts_.size() - 1);
   }
 
   assert(trip_idx == sched.expanded_trips_.data_size());
@@ -286,36 +293,74 @@ void add_footpaths(schedule const& sched, csa_timetable& tt) {
 
 }  // namespace
 
-std::unique_ptr<csa_timetable> build_csa_timetable(
-    schedule const& sched, bool const bridge_zero_duration_connections,
-    bool const add_footpath_connections) {
-  scoped_timer timer("building csa timetable");
-
-  auto tt = std::make_unique<csa_timetable>();
-
-  // Create stations
-  tt->stations_ = utl::to_vec(
+void init_stations(schedule const& sched, csa_timetable& tt) {
+  tt.stations_ = utl::to_vec(
       sched.stations_, [](auto const& st) { return csa_station(st.get()); });
-  add_footpaths(sched, *tt);
+  add_footpaths(sched, tt);
+}
 
-  LOG(info) << "Creating CSA Connections";
-  tt->trip_count_ = get_connections_from_expanded_trips(
-      *tt, sched, bridge_zero_duration_connections, add_footpath_connections);
+void finish_csa_timetable(csa_timetable& tt, bool const connection_arrays) {
+  init_trip_to_connections(tt);
+  init_stop_to_connections(tt);
 
-  init_trip_to_connections(*tt);
-  init_stop_to_connections(*tt);
+  if (connection_arrays) {
+    scoped_timer arrays_timer("csa: connection arrays");
+    tt.fwd_arrays_.init(tt.fwd_connections_);
+    tt.bwd_arrays_.init(tt.bwd_connections_);
+  }
 
 #ifdef MOTIS_CUDA
   {
     scoped_timer gpu_timer("building csa gpu timetable");
-    tt->gpu_timetable_ = gpu_timetable(*tt);
+    tt.gpu_timetable_ = gpu_timetable(tt);
   }
 #endif
 
-  LOG(info) << "CSA Stations: " << tt->stations_.size();
-  LOG(info) << "CSA Connections: " << tt->fwd_connections_.size();
+  LOG(info) << "CSA Stations: " << tt.stations_.size();
+  LOG(info) << "CSA Connections: " << tt.fwd_connections_.size();
+}
+
+std::unique_ptr<csa_timetable> build_csa_timetable(
+    schedule const& sched, bool const bridge_zero_duration_connections,
+    bool const add_footpath_connections, bool const connection_arrays) {
+  scoped_timer timer("building csa timetable");
+
+  auto tt = std::make_unique<csa_timetable>();
+  init_stations(sched, *tt);
 
+  LOG(info) << "Creating CSA Connections";
+  tt->trip_count_ = get_connections_from_expanded_trips(
+      *tt, sched, bridge_zero_duration_connections, add_footpath_connections);
+
+  finish_csa_timetable(*tt, connection_arrays);
   return tt;
 }
 
+std::unique_ptr<csa_timetable> copy_csa_timetable(csa_timetable const& tt) {
+  scoped_timer timer("csa: copy timetable");
+
+  auto copy = std::make_unique<csa_timetable>();
+  copy->stations_ = utl::to_vec(tt.stations_, [](csa_station const& s) {
+    auto station = s;
+    station.outgoing_connections_.clear();
+    station.incoming_connections_.clear();
+    return station;
+  });
+  copy->fwd_connections_ = tt.fwd_connections_;
+  copy->bwd_connections_ = tt.bwd_connections_;
+  copy->fwd_bucket_starts_ = tt.fwd_bucket_starts_;
+  copy->bwd_bucket_starts_ = tt.bwd_bucket_starts_;
+  copy->trip_ids_ = tt.trip_ids_;
+  copy->trip_count_ = tt.trip_count_;
+
+  // the pointers into the connections and the connection arrays
+  init_trip_to_connections(*copy);
+  init_stop_to_connections(*copy);
+  if (!tt.fwd_arrays_.empty()) {
+    copy->fwd_arrays_.init(copy->fwd_connections_);
+    copy->bwd_arrays_.init(copy->bwd_connections_);
+  }
+  return copy;
+}
+
 }  // namespace motis::csa
@@ -1,35 +1,152 @@
 #include "motis/csa/csa.h"
 
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "boost/filesystem.hpp"
+
+#include "cista/hash.h"
+
+#include "utl/enumerate.h"
+#include "utl/to_vec.h"
+#include "utl/verify.h"
+
+#include "motis/core/common/deadline.h"
+#include "motis/core/common/logging.h"
+#include "motis/core/common/timing.h"
+#include "motis/core/access/station_access.h"
 #include "motis/core/access/time_access.h"
 #include "motis/core/journey/journeys_to_message.h"
 #include "motis/module/context/get_schedule.h"
+#include "motis/module/context/motis_spawn.h"
+#include "motis/module/event_collector.h"
+#include "motis/module/ini_io.h"
 
 #include "motis/csa/build_csa_timetable.h"
 #include "motis/csa/csa_query.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/csa_statistics.h"
 #include "motis/csa/csa_timetable.h"
 #include "motis/csa/csa_to_journey.h"
 #include "motis/csa/error.h"
+#include "motis/csa/one_to_all.h"
 #include "motis/csa/run_csa_search.h"
+#include "motis/csa/serialization.h"
 
+using namespace motis::logging;
 using namespace motis::module;
 using namespace motis::routing;
 
 namespace motis::csa {
 
+struct import_state {
+  CISTA_COMPARABLE()
+  named<cista::hash_t, MOTIS_NAME("schedule_hash")> schedule_hash_;
+  named<bool, MOTIS_NAME("bridge")> bridge_;
+  named<bool, MOTIS_NAME("expand_footpaths")> expand_footpaths_;
+};
+
 csa::csa() : module("CSA", "csa") {
   param(bridge_zero_duration_connections_, "bridge",
         "Bridge zero duration connections (required for GPU CSA)");
   param(add_footpath_connections_, "expand_footpaths",
         "Add CSA connections representing connection and footpath");
+  param(connection_arrays_, "connection_arrays",
+        "Scan connection times/stations/trips stored in parallel arrays");
+  param(use_data_file_, "use_data_file",
+        "write the timetable to a data file during import and map it at "
+        "startup");
+  param(timeout_, "timeout",
+        "default search time budget in milliseconds (0 = unlimited)");
+  param(pretrip_jobs_, "pretrip_jobs",
+        "number of concurrent ontrip scans of pretrip queries "
+        "(0/1 = sequential)");
+  param(state_pool_size_, "state_pool_size",
+        "maximum number of idle search states kept for the next searches "
+        "(0 = number of threads)");
+  param(price_buckets_, "price_buckets",
+        "number of fare classes of /csa/cpu/price_buckets (1-8)");
+  param(price_bucket_base_, "price_bucket_base",
+        "upper fare bound of the first fare class (doubled for each "
+        "following class)");
 }
 
-csa::~csa() = default;
+csa::~csa() {
+  if (rebuild_.valid()) {
+    rebuild_.wait();
+  }
+}
 
-void csa::init(motis::module::registry& reg) {
-  timetable_ =
-      build_csa_timetable(get_sched(), bridge_zero_duration_connections_,
+void csa::import(motis::module::registry& reg) {
+  std::make_shared<event_collector>(
+      get_data_directory().generic_string(), "csa", reg,
+      [this](std::map<std::string, msg_ptr> const& dependencies) {
+        using import::ScheduleEvent;
+        auto const schedule =
+            motis_content(ScheduleEvent, dependencies.at("SCHEDULE"));
+
+        if (!use_data_file_) {
+          import_successful_ = true;
+          return;
+        }
+
+        auto const dir = get_data_directory() / "csa";
+        auto const filename = dir / "csa.bin";
+        auto const state =
+            import_state{schedule->hash(), bridge_zero_duration_connections_,
+                         add_footpath_connections_};
+
+        if (read_ini<import_state>(dir / "import.ini") != state ||
+            !boost::filesystem::exists(filename)) {
+          boost::filesystem::create_directories(dir);
+          auto const& sched = get_schedule();
+          auto const tt =
+              build_csa_timetable(sched, bridge_zero_duration_connections_,
+                                  add_footpath_connections_, false);
+          write_timetable(filename.generic_string(), sched, *tt,
+                          bridge_zero_duration_connections_,
                           add_footpath_connections_);
+          write_ini(dir / "import.ini", state);
+        }
+
+        import_successful_ = true;
+      })
+      ->require("SCHEDULE", [](msg_ptr const& msg) {
+        return msg->get()->content_type() == MsgContent_ScheduleEvent;
+      });
+}
+
+void csa::init(motis::module::registry& reg) {
+  auto const& sched = get_sched();
+  if (use_data_file_) {
+    auto const filename = get_data_directory() / "csa" / "csa.bin";
+    try {
+      timetable_ = read_timetable(filename.generic_string(), sched,
+                                  bridge_zero_duration_connections_,
+                                  add_footpath_connections_,
+                                  connection_arrays_);
+      if (!timetable_) {
+        LOG(info) << "csa: data file outdated";
+      }
+    } catch (std::exception const& e) {
+      LOG(warn) << "csa: unable to read data file: " << e.what();
+    }
+  }
+  if (!timetable_) {
+    timetable_ = build_csa_timetable(sched, bridge_zero_duration_connections_,
+                                     add_footpath_connections_,
+                                     connection_arrays_);
+  }
+
+  state_pool_ = std::make_unique<csa_search_state_pool>(
+      state_pool_size_ != 0U
+          ? state_pool_size_
+          : std::max(1U, std::thread::hardware_concurrency()));
+
   reg.register_op("/csa", [&](msg_ptr const& msg) {
 #ifdef MOTIS_AVX
     return route(msg, implementation_type::CPU_SSE);
@@ -40,6 +157,19 @@ void csa::init(motis::module::registry& reg) {
   reg.register_op("/csa/cpu", [&](msg_ptr const& msg) {
     return route(msg, implementation_type::CPU);
   });
+  reg.register_op("/csa/cpu/profile", [&](msg_ptr const& msg) {
+    return route(msg, implementation_type::CPU_PROFILE);
+  });
+  reg.register_op("/csa/cpu/price", [&](msg_ptr const& msg) {
+    return route(msg, implementation_type::CPU_PRICE);
+  });
+  reg.register_op("/csa/cpu/price_buckets", [&](msg_ptr const& msg) {
+    return route(msg, implementation_type::CPU_PRICE_BUCKETS);
+  });
+  reg.register_op("/csa/batch",
+                  [&](msg_ptr const& msg) { return route_batch(msg); });
+  reg.register_op("/csa/one_to_all",
+                  [&](msg_ptr const& msg) { return one_to_all(msg); });
 
 #ifdef MOTIS_AVX
   reg.register_op("/csa/cpu/sse", [&](msg_ptr const& msg) {
@@ -52,31 +182,335 @@ void csa::init(motis::module::registry& reg) {
     return route(msg, implementation_type::GPU);
   });
 #endif
+
+  reg.subscribe("/rt/update", [&](msg_ptr const& msg) {
+    update(msg);
+    return nullptr;
+  });
+}
+
+void csa::update(msg_ptr const& msg) {
+  using motis::rt::RtUpdates;
+  std::lock_guard update_lock{update_mutex_};
+  MOTIS_START_TIMING(update_timing);
+  auto const& sched = get_schedule();
+  auto const updates = motis_content(RtUpdates, msg);
+  auto stats = update_stats_;
+  auto incremental = false, in_place = false;
+  {
+    std::unique_lock lock{timetable_mutex_};
+    if (timetable_.use_count() == 1) {
+      // no search uses the timetable
+      in_place = true;
+      incremental = update_csa_timetable(
+          sched, *timetable_, updates, bridge_zero_duration_connections_,
+          add_footpath_connections_, stats);
+#ifdef MOTIS_CUDA
+      if (incremental) {
+        timetable_->gpu_timetable_ = gpu_timetable(*timetable_);
+      }
+#endif
+    }
+  }
+
+  // Searches keep their snapshot: the update is applied to a copy that
+  // replaces the timetable. Only updates modify (when not shared) or replace
+  // timetable_ and they are serialized by update_mutex_.
+  std::unique_ptr<csa_timetable> updated;
+  if (!in_place) {
+    incremental = update_csa_timetable_copy(
+        sched, *timetable_, updated, updates,
+        bridge_zero_duration_connections_, add_footpath_connections_, stats);
+#ifdef MOTIS_CUDA
+    if (updated) {
+      updated->gpu_timetable_ = gpu_timetable(*updated);
+    }
+#endif
+  }
+
+  if (stats.pending_rebuilds_ != 0U) {
+    // applied to the rebuilt timetable before it replaces the current one
+    deferred_updates_.emplace_back(msg);
+    ++stats.deferred_updates_;
+  } else if (!incremental) {
+    LOG(info) << "csa: rebuilding timetable in the background (realtime "
+                 "update not applicable)";
+    start_rebuild(sched);
+    stats.pending_rebuilds_ = 1U;
+  }
+  MOTIS_STOP_TIMING(update_timing);
+
+  auto const duration =
+      static_cast<uint64_t>(MOTIS_TIMING_US(update_timing));
+  ++stats.update_count_;
+  stats.last_update_duration_us_ = duration;
+  stats.max_update_duration_us_ =
+      std::max(stats.max_update_duration_us_, duration);
+  stats.total_update_duration_us_ += duration;
+
+  std::unique_lock lock{timetable_mutex_};
+  if (updated) {
+    timetable_ = std::move(updated);
+  }
+  update_stats_ = stats;
 }
 
-csa_timetable const* csa::get_timetable() const { return timetable_.get(); }
+// Builds the new timetable without blocking searches or further updates.
+// Searches use the current timetable (with the incremental updates that are
+// still applicable) until it is replaced. Caller holds update_mutex_.
+void csa::start_rebuild(schedule const& sched) {
+  rebuild_ = std::async(std::launch::async,
+                        [this, &sched]() { finish_rebuild(sched); })
+                 .share();
+}
+
+void csa::finish_rebuild(schedule const& sched) {
+  using motis::rt::RtUpdates;
+  while (true) {
+    std::unique_ptr<csa_timetable> tt;
+    try {
+      tt = build_csa_timetable(sched, bridge_zero_duration_connections_,
+                               add_footpath_connections_, connection_arrays_);
+    } catch (std::exception const& e) {
+      LOG(logging::error) << "csa: rebuild failed: " << e.what();
+    }
+
+    std::lock_guard update_lock{update_mutex_};
+    auto stats = update_stats_;
+    auto rebuild_again = false;
+    if (tt) {
+      // updates received during the build: the timetable may already
+      // contain them (then they do not change anything) or not
+      for (auto const& msg : deferred_updates_) {
+        if (!update_csa_timetable(sched, *tt, motis_content(RtUpdates, msg),
+                                  bridge_zero_duration_connections_,
+                                  add_footpath_connections_, stats)) {
+          rebuild_again = true;
+          break;
+        }
+      }
+#ifdef MOTIS_CUDA
+      if (!rebuild_again && !deferred_updates_.empty()) {
+        tt->gpu_timetable_ = gpu_timetable(*tt);
+      }
+#endif
+    }
+    deferred_updates_.clear();
+
+    std::unique_lock lock{timetable_mutex_};
+    if (rebuild_again) {
+      LOG(info) << "csa: rebuilding timetable again (realtime update not "
+                   "applicable during the rebuild)";
+      update_stats_ = stats;
+      continue;
+    }
+    if (tt) {
+      timetable_ = std::move(tt);
+      ++stats.full_rebuilds_;
+    }
+    stats.pending_rebuilds_ = 0U;
+    update_stats_ = stats;
+    return;
+  }
+}
+
+void csa::wait_for_rebuild() {
+  std::shared_future<void> rebuild;
+  {
+    std::lock_guard update_lock{update_mutex_};
+    rebuild = rebuild_;
+  }
+  if (rebuild.valid()) {
+    rebuild.wait();
+  }
+}
+
+bool csa::import_successful() const { return import_successful_; }
+
+std::shared_ptr<csa_timetable const> csa::get_timetable() const {
+  std::shared_lock lock{timetable_mutex_};
+  return timetable_;
+}
+
+namespace {
+
+flatbuffers::Offset<RoutingResponse> write_response(
+    message_creator& mc, schedule const& sched, response const& r,
+    csa_update_statistics const& update_stats) {
+  std::vector<flatbuffers::Offset<Statistics>> stats{
+      to_fbs(mc, to_stats_category("csa", r.stats_))};
+  if (update_stats.update_count_ != 0U) {
+    stats.emplace_back(to_fbs(mc, to_stats_category("csa_rt", update_stats)));
+  }
+  return CreateRoutingResponse(
+      mc, mc.CreateVector(stats),
+      mc.CreateVector(utl::to_vec(r.journeys_,
+                                  [&](auto const& cj) {
+                                    return to_connection(
+                                        mc, csa_to_journey(sched, cj));
+                                  })),
+      motis_to_unixtime(sched, r.searched_interval_.begin_),
+      motis_to_unixtime(sched, r.searched_interval_.end_),
+      mc.CreateVector(std::vector<flatbuffers::Offset<DirectConnection>>()));
+}
+
+}  // namespace
 
 motis::module::msg_ptr csa::route(motis::module::msg_ptr const& msg,
                                   implementation_type impl_type) const {
+  std::shared_ptr<csa_timetable const> tt;
+  csa_update_statistics update_stats;
+  {
+    std::shared_lock lock{timetable_mutex_};
+    tt = timetable_;
+    update_stats = update_stats_;
+  }
+
   auto const req = motis_content(RoutingRequest, msg);
+  auto search_deadline = deadline::from_timeout_ms(req->timeout(), timeout_);
   auto const& sched = get_schedule();
-  auto const response = run_csa_search(
-      sched, *timetable_, csa_query(sched, req), req->search_type(), impl_type);
+  auto q = csa_query(sched, req);
+  q.deadline_ = &search_deadline;
+  q.state_pool_ = state_pool_.get();
+  q.price_buckets_ = price_buckets_;
+  q.price_bucket_base_ = static_cast<uint16_t>(
+      std::min(price_bucket_base_,
+               static_cast<unsigned>(std::numeric_limits<uint16_t>::max())));
+  if (pretrip_jobs_ > 1U) {
+    q.parallel_jobs_ = pretrip_jobs_;
+    q.run_parallel_ = [](std::vector<csa_job> const& jobs) {
+      std::vector<ctx::future_ptr<ctx_data, void>> futures;
+      for (auto const& job : jobs) {
+        futures.emplace_back(spawn_job_void([&job]() { job(); }));
+      }
+      ctx::await_all(futures);
+    };
+  }
+  auto const response =
+      run_csa_search(sched, *tt, q, req->search_type(), impl_type);
   message_creator mc;
   mc.create_and_finish(
       MsgContent_RoutingResponse,
-      CreateRoutingResponse(
+      write_response(mc, sched, response, update_stats).Union());
+  return make_msg(mc);
+}
+
+motis::module::msg_ptr csa::route_batch(
+    motis::module::msg_ptr const& msg) const {
+  std::shared_ptr<csa_timetable const> tt;
+  csa_update_statistics update_stats;
+  {
+    std::shared_lock lock{timetable_mutex_};
+    tt = timetable_;
+    update_stats = update_stats_;
+  }
+
+  auto const requests = motis_content(RoutingBatchRequest, msg)->requests();
+  auto const& sched = get_schedule();
+  auto deadlines = utl::to_vec(*requests, [&](RoutingRequest const* req) {
+    return deadline::from_timeout_ms(req->timeout(), timeout_);
+  });
+  auto queries = utl::to_vec(*requests, [&](RoutingRequest const* req) {
+    return csa_query(sched, req);
+  });
+  for (auto i = 0U; i != queries.size(); ++i) {
+    queries[i].deadline_ = &deadlines[i];
+    queries[i].state_pool_ = state_pool_.get();
+  }
+  auto const search_types = utl::to_vec(
+      *requests, [](RoutingRequest const* req) { return req->search_type(); });
+  auto const responses =
+      run_csa_batch_search(sched, *tt, queries, search_types);
+
+  message_creator mc;
+  mc.create_and_finish(
+      MsgContent_RoutingBatchResponse,
+      CreateRoutingBatchResponse(
+          mc, mc.CreateVector(utl::to_vec(responses,
+                                          [&](response const& r) {
+                                            return write_response(
+                                                mc, sched, r, update_stats);
+                                          })))
+          .Union());
+  return make_msg(mc);
+}
+
+motis::module::msg_ptr csa::one_to_all(
+    motis::module::msg_ptr const& msg) const {
+  auto const tt = get_timetable();
+  auto const req = motis_content(CsaOneToAllRequest, msg);
+  auto const& sched = get_schedule();
+  auto const dir = req->search_dir() == SearchDir_Forward ? search_dir::FWD
+                                                          : search_dir::BWD;
+
+  std::map<station_id, duration> start_durations;
+  auto const add_start = [&](station_id const id, duration const d) {
+    auto const it = start_durations.emplace(id, d).first;
+    it->second = std::min(it->second, d);
+  };
+  if (req->start() != nullptr) {
+    auto const metas = get_metas(sched, req->start(), req->use_start_metas());
+    for (auto const id : metas) {
+      add_start(id, 0U);
+    }
+  }
+  if (req->start_edges() != nullptr) {
+    for (auto const& e : *req->start_edges()) {
+      auto const eva =
+          dir == search_dir::FWD ? e->to_station_id() : e->from_station_id();
+      add_start(get_station(sched, eva->str())->index_, e->duration());
+    }
+  }
+  utl::verify_ex(!start_durations.empty(),
+                 std::system_error{error::no_start});
+
+  verify_external_timestamp(sched, req->start_time());
+  auto const start_time = unix_to_motistime(sched, req->start_time());
+  auto const max_travel_time =
+      req->max_travel_time() == 0U
+          ? MAX_TRAVEL_TIME
+          : std::min(MAX_TRAVEL_TIME, req->max_travel_time());
+  auto const result = run_one_to_all(
+      *tt,
+      std::vector<std::pair<station_id, duration>>(begin(start_durations),
+                                                   end(start_durations)),
+      start_time, dir, max_travel_time, state_pool_.get());
+
+  // Labels created by connections departing (FWD) / arriving (BWD) within
+  // the time limit can lie beyond it.
+  constexpr auto const UNREACHABLE = std::numeric_limits<uint16_t>::max();
+  auto const invalid =
+      dir == search_dir::FWD ? std::numeric_limits<time>::max() : time{0U};
+  auto const get_travel_time = [&](time const t) -> uint16_t {
+    if (t == invalid) {
+      return UNREACHABLE;
+    }
+    auto const d = dir == search_dir::FWD ? t - start_time : start_time - t;
+    return d > max_travel_time ? UNREACHABLE : static_cast<uint16_t>(d);
+  };
+
+  std::vector<flatbuffers::Offset<flatbuffers::String>> stations;
+  std::vector<uint16_t> travel_times;
+  message_creator mc;
+  for (auto const& [id, times] : utl::enumerate(result.arrival_times_)) {
+    auto const row = utl::to_vec(times, get_travel_time);
+    if (std::all_of(begin(row), end(row),
+                    [](uint16_t const d) { return d == UNREACHABLE; })) {
+      continue;
+    }
+    stations.emplace_back(mc.CreateString(sched.stations_[id]->eva_nr_));
+    travel_times.insert(end(travel_times), begin(row), end(row));
+  }
+
+  mc.create_and_finish(
+      MsgContent_CsaOneToAllResponse,
+      CreateCsaOneToAllResponse(
           mc,
           mc.CreateVector(std::vector<flatbuffers::Offset<Statistics>>{
-              to_fbs(mc, to_stats_category("csa", response.stats_))}),
-          mc.CreateVector(utl::to_vec(response.journeys_,
-                                      [&](auto const& cj) {
-                                        return to_connection(
-                                            mc, csa_to_journey(sched, cj));
-                                      })),
-          motis_to_unixtime(sched, response.searched_interval_.begin_),
-          motis_to_unixtime(sched, response.searched_interval_.end_),
-          mc.CreateVector(std::vector<flatbuffers::Offset<DirectConnection>>()))
+              to_fbs(mc, to_stats_category("csa", result.stats_))}),
+          mc.CreateVector(stations),
+          static_cast<uint8_t>(MAX_TRANSFERS + 1),
+          mc.CreateVector(travel_times))
           .Union());
   return make_msg(mc);
 }
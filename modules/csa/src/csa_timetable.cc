@@ -11,4 +11,71 @@ csa_station::csa_station(station const* station_ptr)
       incoming_footpaths_({{id_, id_, transfer_time_}}),
       station_ptr_(station_ptr) {}
 
+void csa_connection_arrays::init(std::vector<csa_connection> const& cons) {
+  departure_.resize(cons.size());
+  arrival_.resize(cons.size());
+  from_station_.resize(cons.size());
+  to_station_.resize(cons.size());
+  trip_.resize(cons.size());
+  flags_.resize(cons.size());
+  size_ = cons.size();
+  read_vectors();
+  update(cons, 0U, cons.size());
+}
+
+void csa_connection_arrays::read_vectors() {
+  departure_data_ = departure_.data();
+  arrival_data_ = arrival_.data();
+  from_station_data_ = from_station_.data();
+  to_station_data_ = to_station_.data();
+  trip_data_ = trip_.data();
+  flags_data_ = flags_.data();
+}
+
+void csa_connection_arrays::map(time const* departure, time const* arrival,
+                                station_id const* from_station,
+                                station_id const* to_station,
+                                trip_id const* trip, uint8_t const* flags,
+                                std::size_t const size) {
+  departure_ = {};
+  arrival_ = {};
+  from_station_ = {};
+  to_station_ = {};
+  trip_ = {};
+  flags_ = {};
+  departure_data_ = departure;
+  arrival_data_ = arrival;
+  from_station_data_ = from_station;
+  to_station_data_ = to_station;
+  trip_data_ = trip;
+  flags_data_ = flags;
+  size_ = size;
+}
+
+void csa_connection_arrays::update(std::vector<csa_connection> const& cons,
+                                   std::size_t const from,
+                                   std::size_t const to) {
+  if (mapped()) {
+    // first realtime update: the mapped file is read only
+    departure_.assign(departure_data_, departure_data_ + size_);
+    arrival_.assign(arrival_data_, arrival_data_ + size_);
+    from_station_.assign(from_station_data_, from_station_data_ + size_);
+    to_station_.assign(to_station_data_, to_station_data_ + size_);
+    trip_.assign(trip_data_, trip_data_ + size_);
+    flags_.assign(flags_data_, flags_data_ + size_);
+    read_vectors();
+  }
+  for (auto i = from; i != to; ++i) {
+    auto const& c = cons[i];
+    departure_[i] = c.departure_;
+    arrival_[i] = c.arrival_;
+    from_station_[i] = c.from_station_;
+    to_station_[i] = c.to_station_;
+    trip_[i] = c.trip_;
+    flags_[i] =
+        static_cast<uint8_t>((c.from_in_allowed_ ? FROM_IN_ALLOWED : 0U) |
+                             (c.to_out_allowed_ ? TO_OUT_ALLOWED : 0U));
+  }
+}
+
 }  // namespace motis::csa
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "motis/csa/one_to_all.h"
+
+#include "motis/core/common/timing.h"
+
+#ifdef MOTIS_AVX
+#include "motis/csa/cpu/csa_search_default_cpu_sse.h"
+#endif
+#include "motis/csa/cpu/csa_search_default_cpu.h"
+
+namespace motis::csa {
+
+template <typename CSASearch>
+one_to_all_result one_to_all(
+    csa_timetable const& tt,
+    std::vector<std::pair<station_id, duration>> const& starts,
+    time const start_time, search_dir const dir,
+    duration const max_travel_time, csa_search_state_pool* pool) {
+  one_to_all_result result;
+  auto& stats = result.stats_;
+
+  MOTIS_START_TIMING(total_timing);
+  csa_search_state_retriever state{pool, dir};
+  CSASearch csa(tt, start_time, stats, state.get());
+  csa.max_travel_time_ = max_travel_time;
+  for (auto const& [station, initial_duration] : starts) {
+    csa.add_start(tt.stations_.at(station), initial_duration);
+  }
+
+  MOTIS_START_TIMING(search_timing);
+  csa.search();
+  MOTIS_STOP_TIMING(search_timing);
+
+  result.arrival_times_.assign(begin(csa.arrival_time_),
+                               end(csa.arrival_time_));
+  MOTIS_STOP_TIMING(total_timing);
+
+  stats.search_duration_ = MOTIS_TIMING_MS(search_timing);
+  stats.search_duration_us_ = MOTIS_TIMING_US(search_timing);
+  stats.total_duration_ = MOTIS_TIMING_MS(total_timing);
+  return result;
+}
+
+one_to_all_result run_one_to_all(
+    csa_timetable const& tt,
+    std::vector<std::pair<station_id, duration>> const& starts,
+    time const start_time, search_dir const dir,
+    duration const max_travel_time, csa_search_state_pool* pool) {
+#ifdef MOTIS_AVX
+  return dir == search_dir::FWD
+             ? one_to_all<cpu::sse::csa_search<search_dir::FWD>>(
+                   tt, starts, start_time, dir, max_travel_time, pool)
+             : one_to_all<cpu::sse::csa_search<search_dir::BWD>>(
+                   tt, starts, start_time, dir, max_travel_time, pool);
+#else
+  return dir == search_dir::FWD
+             ? one_to_all<cpu::csa_search<search_dir::FWD>>(
+                   tt, starts, start_time, dir, max_travel_time, pool)
+             : one_to_all<cpu::csa_search<search_dir::BWD>>(
+                   tt, starts, start_time, dir, max_travel_time, pool);
+#endif
+}
+
+}  // namespace motis::csa
@@ -1,15 +1,27 @@
 #include "motis/csa/run_csa_search.h"
 
+#include <algorithm>
+#include <utility>
+
+#include "utl/to_vec.h"
+
 #include "motis/core/common/timing.h"
 
 #ifdef MOTIS_AVX
 #include "motis/csa/cpu/csa_search_default_cpu_sse.h"
 #endif
+#ifdef MOTIS_AVX2
+#include "motis/csa/cpu/csa_search_batch_avx.h"
+#endif
 #ifdef MOTIS_CUDA
 #include "motis/csa/gpu/gpu_search.h"
 #endif
+#include "motis/csa/cpu/csa_profile_search.h"
 #include "motis/csa/cpu/csa_search_default_cpu.h"
+#include "motis/csa/cpu/csa_search_price.h"
+#include "motis/csa/cpu/csa_search_price_buckets.h"
 #include "motis/csa/error.h"
+#include "motis/csa/csa_search_state.h"
 #include "motis/csa/pareto_set.h"
 #include "motis/csa/pretrip.h"
 
@@ -32,7 +44,14 @@ response run_search(schedule const& sched, csa_timetable const& tt,
 
   if (q.is_ontrip()) {
     MOTIS_START_TIMING(total_timing);
-    CSASearch csa(tt, q.search_interval_.begin_, stats);
+    csa_search_state_retriever state{q.state_pool_, q.dir_};
+    CSASearch csa(tt, q.search_interval_.begin_, stats, state.get());
+    csa.set_deadline(q.deadline_);
+    if (q.target_pruning_) {
+      for (auto const& dest_idx : q.meta_dests_) {
+        csa.add_destination(tt.stations_.at(dest_idx));
+      }
+    }
     for (auto const& start_idx : q.meta_starts_) {
       csa.add_start(tt.stations_.at(start_idx), 0);
     }
@@ -52,6 +71,7 @@ response run_search(schedule const& sched, csa_timetable const& tt,
     MOTIS_STOP_TIMING(total_timing);
 
     stats.search_duration_ = MOTIS_TIMING_MS(search_timing);
+    stats.search_duration_us_ = MOTIS_TIMING_US(search_timing);
     stats.reconstruction_duration_ = MOTIS_TIMING_MS(reconstruction_timing);
     stats.total_duration_ = MOTIS_TIMING_MS(total_timing);
 
@@ -63,6 +83,49 @@ response run_search(schedule const& sched, csa_timetable const& tt,
   }
 }
 
+// Price searches: ontrip only, the results are reconstructed separately.
+template <typename CSASearch, typename... Args>
+response run_price_search(csa_timetable const& tt, csa_query const& q,
+                          csa_search_state::search_kind const kind,
+                          Args&&... args) {
+  if (!q.is_ontrip()) {
+    throw std::system_error(error::search_type_not_supported);
+  }
+
+  csa_statistics stats;
+  MOTIS_START_TIMING(total_timing);
+  csa_search_state_retriever state{q.state_pool_, q.dir_, kind};
+  CSASearch csa(tt, q.search_interval_.begin_, stats, state.get(),
+                std::forward<Args>(args)...);
+  csa.set_deadline(q.deadline_);
+  for (auto const& start_idx : q.meta_starts_) {
+    csa.add_start(tt.stations_.at(start_idx), 0);
+  }
+
+  MOTIS_START_TIMING(search_timing);
+  csa.search();
+  MOTIS_STOP_TIMING(search_timing);
+
+  MOTIS_START_TIMING(reconstruction_timing);
+  auto results = make_ontrip_pareto_set();
+  for (auto const& dest_idx : q.meta_dests_) {
+    for (auto j : csa.get_results(tt.stations_.at(dest_idx))) {
+      if (csa.extract_journey(j)) {
+        results.push_back(j);
+      }
+    }
+  }
+  MOTIS_STOP_TIMING(reconstruction_timing);
+  MOTIS_STOP_TIMING(total_timing);
+
+  stats.search_duration_ = MOTIS_TIMING_MS(search_timing);
+  stats.search_duration_us_ = MOTIS_TIMING_US(search_timing);
+  stats.reconstruction_duration_ = MOTIS_TIMING_MS(reconstruction_timing);
+  stats.total_duration_ = MOTIS_TIMING_MS(total_timing);
+
+  return {stats, std::move(results.set_), q.search_interval_};
+}
+
 template <search_dir Dir>
 response dispatch_search_type(schedule const& sched, csa_timetable const& tt,
                               csa_query const& q, SearchType const search_type,
@@ -76,6 +139,38 @@ response dispatch_search_type(schedule const& sched, csa_timetable const& tt,
         default: throw std::system_error(error::search_type_not_supported);
       }
 
+    case implementation_type::CPU_PROFILE:
+      switch (search_type) {
+        case SearchType_Default:
+        case SearchType_Accessibility:
+          if (q.is_ontrip()) {
+            return run_search<cpu::csa_search<Dir>>(sched, tt, q);
+          } else {
+            csa_statistics stats;
+            return pretrip<cpu::csa_profile_search<Dir>>(sched, tt, q, stats)
+                .search();
+          }
+        default: throw std::system_error(error::search_type_not_supported);
+      }
+
+    case implementation_type::CPU_PRICE:
+      switch (search_type) {
+        case SearchType_Default:
+          return run_price_search<price::csa_search<Dir>>(
+              tt, q, csa_search_state::search_kind::PRICE);
+        default: throw std::system_error(error::search_type_not_supported);
+      }
+
+    case implementation_type::CPU_PRICE_BUCKETS:
+      switch (search_type) {
+        case SearchType_Default:
+          return run_price_search<price_buckets::csa_search<Dir>>(
+              tt, q, csa_search_state::search_kind::PRICE_BUCKETS,
+              price_buckets::price_bucket_bounds{q.price_buckets_,
+                                                 q.price_bucket_base_});
+        default: throw std::system_error(error::search_type_not_supported);
+      }
+
 #ifdef MOTIS_AVX
     case implementation_type::CPU_SSE:
       switch (search_type) {
@@ -129,4 +224,100 @@ response run_csa_search(schedule const& sched, csa_timetable const& tt,
                                          sched, tt, q, search_type, impl_type);
 }
 
+#ifdef MOTIS_AVX2
+template <search_dir Dir>
+void run_batches(csa_timetable const& tt, std::vector<csa_query> const& queries,
+                 std::vector<std::size_t> const& indices,
+                 std::vector<response>& responses) {
+  using batch_search = cpu::batch::csa_search<Dir>;
+  for (auto offset = std::size_t{0U}; offset < indices.size();
+       offset += batch_search::BATCH_SIZE) {
+    auto const batch = std::vector<std::size_t>(
+        begin(indices) + offset,
+        begin(indices) + std::min(offset + batch_search::BATCH_SIZE,
+                                  indices.size()));
+
+    csa_statistics stats;
+    MOTIS_START_TIMING(total_timing);
+    batch_search csa(tt, utl::to_vec(batch, [&](std::size_t const i) {
+                       return queries[i].search_interval_.begin_;
+                     }),
+                     stats);
+    for (auto q = 0U; q != batch.size(); ++q) {
+      for (auto const& start_idx : queries[batch[q]].meta_starts_) {
+        csa.add_start(q, tt.stations_.at(start_idx), 0);
+      }
+      csa.set_deadline(q, queries[batch[q]].deadline_);
+    }
+
+    MOTIS_START_TIMING(search_timing);
+    csa.search();
+    MOTIS_STOP_TIMING(search_timing);
+
+    MOTIS_START_TIMING(reconstruction_timing);
+    std::vector<std::vector<csa_journey>> journeys;
+    for (auto q = 0U; q != batch.size(); ++q) {
+      auto results = make_ontrip_pareto_set();
+      for (auto const& dest_idx : queries[batch[q]].meta_dests_) {
+        for (auto j : csa.get_results(q, tt.stations_.at(dest_idx))) {
+          results.push_back(j);
+        }
+      }
+      journeys.emplace_back(std::move(results.set_));
+    }
+    MOTIS_STOP_TIMING(reconstruction_timing);
+    MOTIS_STOP_TIMING(total_timing);
+
+    // statistics of the whole batch
+    stats.search_duration_ = MOTIS_TIMING_MS(search_timing);
+    stats.search_duration_us_ = MOTIS_TIMING_US(search_timing);
+    stats.reconstruction_duration_ = MOTIS_TIMING_MS(reconstruction_timing);
+    stats.total_duration_ = MOTIS_TIMING_MS(total_timing);
+    for (auto q = 0U; q != batch.size(); ++q) {
+      auto query_stats = stats;
+      query_stats.timeout_quit_ = csa.timed_out(q);
+      responses[batch[q]] = {query_stats, std::move(journeys[q]),
+                             queries[batch[q]].search_interval_};
+    }
+  }
+}
+#endif
+
+std::vector<response> run_csa_batch_search(
+    schedule const& sched, csa_timetable const& tt,
+    std::vector<csa_query> const& queries,
+    std::vector<SearchType> const& search_types) {
+#ifdef MOTIS_AVX
+  auto const impl_type = implementation_type::CPU_SSE;
+#else
+  auto const impl_type = implementation_type::CPU;
+#endif
+
+  std::vector<response> responses(queries.size());
+#ifdef MOTIS_AVX2
+  std::vector<std::size_t> fwd_batch, bwd_batch;
+#endif
+  for (auto i = 0U; i != queries.size(); ++i) {
+    auto const& q = queries[i];
+#ifdef MOTIS_AVX2
+    auto const& connections = q.dir_ == search_dir::FWD ? tt.fwd_connections_
+                                                        : tt.bwd_connections_;
+    if (q.is_ontrip() && !connections.empty() &&
+        (search_types[i] == SearchType_Default ||
+         search_types[i] == SearchType_Accessibility)) {
+      (q.dir_ == search_dir::FWD ? fwd_batch : bwd_batch).emplace_back(i);
+      continue;
+    }
+#endif
+    responses[i] = run_csa_search(sched, tt, q, search_types[i], impl_type);
+  }
+
+#ifdef MOTIS_AVX2
+  run_batches<search_dir::FWD>(tt, queries, fwd_batch, responses);
+  run_batches<search_dir::BWD>(tt, queries, bwd_batch, responses);
+#endif
+
+  return responses;
+}
+
 }  // namespace motis::csa
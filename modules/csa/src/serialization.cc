@@ -0,0 +1,200 @@
+#include "motis/csa/serialization.h"
+
+#include <utility>
+#include <vector>
+
+#include "cista/hash.h"
+#include "cista/memory_holder.h"
+#include "cista/serialization.h"
+
+#include "utl/to_vec.h"
+#include "utl/verify.h"
+
+#include "motis/vector.h"
+
+#include "motis/core/common/logging.h"
+#include "motis/core/access/trip_section.h"
+
+#include "motis/csa/build_csa_timetable.h"
+
+using namespace motis::logging;
+
+namespace motis::csa {
+
+constexpr auto const MODE =
+    cista::mode::WITH_INTEGRITY | cista::mode::WITH_VERSION;
+
+namespace {
+
+// csa_connection without the light connection pointer: regular connections
+// get it back from their trip section (trip_, trip_con_idx_).
+struct connection_data {
+  station_id from_station_{0U};
+  station_id to_station_{0U};
+  trip_id trip_{0U};
+  time departure_{0U};
+  time arrival_{0U};
+  uint16_t price_{0U};
+  con_idx_t trip_con_idx_{0U};
+  bool from_in_allowed_{false};
+  bool to_out_allowed_{false};
+  bool regular_{false};
+  service_class clasz_{service_class::OTHER};
+};
+
+// csa_connection_arrays, used in place from the mapped file.
+struct arrays_data {
+  mcd::vector<time> departure_, arrival_;
+  mcd::vector<station_id> from_station_, to_station_;
+  mcd::vector<trip_id> trip_;
+  mcd::vector<uint8_t> flags_;
+};
+
+struct timetable_data {
+  cista::hash_t schedule_hash_{0U};
+  bool bridged_{false};
+  bool footpaths_{false};
+  uint32_t trip_count_{0U};
+  mcd::vector<connection_data> fwd_connections_, bwd_connections_;
+  mcd::vector<uint32_t> fwd_bucket_starts_, bwd_bucket_starts_;
+  arrays_data fwd_arrays_, bwd_arrays_;
+};
+
+mcd::vector<connection_data> to_data(std::vector<csa_connection> const& v) {
+  return mcd::to_vec(v, [](csa_connection const& c) {
+    return connection_data{c.from_station_,   c.to_station_,
+                           c.trip_,           c.departure_,
+                           c.arrival_,        c.price_,
+                           c.trip_con_idx_,   c.from_in_allowed_,
+                           c.to_out_allowed_, c.light_con_ != nullptr,
+                           c.clasz_};
+  });
+}
+
+std::vector<csa_connection> from_data(mcd::vector<connection_data> const& v,
+                                      std::vector<trip const*> const& trips) {
+  return utl::to_vec(v, [&](connection_data const& c) {
+    return csa_connection{
+        c.from_station_,
+        c.to_station_,
+        c.departure_,
+        c.arrival_,
+        c.price_,
+        c.trip_,
+        c.trip_con_idx_,
+        c.from_in_allowed_,
+        c.to_out_allowed_,
+        c.clasz_,
+        c.regular_
+            ? &access::trip_section{trips[c.trip_], c.trip_con_idx_}.lcon()
+            : nullptr};
+  });
+}
+
+arrays_data to_arrays_data(std::vector<csa_connection> const& cons) {
+  csa_connection_arrays arrays;
+  arrays.init(cons);
+  auto const copy = [](auto const x) { return x; };
+  arrays_data data;
+  data.departure_ = mcd::to_vec(arrays.departure_, copy);
+  data.arrival_ = mcd::to_vec(arrays.arrival_, copy);
+  data.from_station_ = mcd::to_vec(arrays.from_station_, copy);
+  data.to_station_ = mcd::to_vec(arrays.to_station_, copy);
+  data.trip_ = mcd::to_vec(arrays.trip_, copy);
+  data.flags_ = mcd::to_vec(arrays.flags_, copy);
+  return data;
+}
+
+void map(csa_connection_arrays& arrays, arrays_data const& data,
+         std::vector<csa_connection> const& cons) {
+  utl::verify(data.departure_.size() == cons.size(),
+              "csa timetable: connection arrays size mismatch");
+  arrays.map(data.departure_.data(), data.arrival_.data(),
+             data.from_station_.data(), data.to_station_.data(),
+             data.trip_.data(), data.flags_.data(), data.departure_.size());
+}
+
+}  // namespace
+
+void write_timetable(std::string const& path, schedule const& sched,
+                     csa_timetable const& tt, bool const bridged,
+                     bool const footpaths) {
+  scoped_timer timer("writing csa timetable");
+  timetable_data data;
+  data.schedule_hash_ = sched.hash_;
+  data.bridged_ = bridged;
+  data.footpaths_ = footpaths;
+  data.trip_count_ = tt.trip_count_;
+  data.fwd_connections_ = to_data(tt.fwd_connections_);
+  data.bwd_connections_ = to_data(tt.bwd_connections_);
+  data.fwd_arrays_ = to_arrays_data(tt.fwd_connections_);
+  data.bwd_arrays_ = to_arrays_data(tt.bwd_connections_);
+  auto const copy = [](uint32_t const i) { return i; };
+  data.fwd_bucket_starts_ = mcd::to_vec(tt.fwd_bucket_starts_, copy);
+  data.bwd_bucket_starts_ = mcd::to_vec(tt.bwd_bucket_starts_, copy);
+
+  auto writer = cista::buf<cista::mmap>(
+      cista::mmap{path.c_str(), cista::mmap::protection::WRITE});
+  cista::serialize<MODE>(writer, data);
+}
+
+std::unique_ptr<csa_timetable> read_timetable(std::string const& path,
+                                              schedule const& sched,
+                                              bool const bridged,
+                                              bool const footpaths,
+                                              bool const connection_arrays) {
+  scoped_timer timer("reading csa timetable");
+
+  cista::memory_holder mem;
+  timetable_data const* data = nullptr;
+#if defined(MOTIS_SCHEDULE_MODE_OFFSET) && !defined(CLANG_TIDY)
+  mem = cista::buf<cista::mmap>(
+      cista::mmap{path.c_str(), cista::mmap::protection::READ});
+  data = cista::deserialize<timetable_data, MODE>(
+      std::get<cista::buf<cista::mmap>>(mem));
+#elif defined(MOTIS_SCHEDULE_MODE_RAW) || defined(CLANG_TIDY)
+  mem = cista::file(path.c_str(), "r").content();
+  // NOLINTNEXTLINE
+  data = cista::deserialize<timetable_data, MODE>(std::get<cista::buffer>(mem));
+#else
+#error "no ptr mode specified"
+#endif
+
+  if (data->schedule_hash_ != sched.hash_ || data->bridged_ != bridged ||
+      data->footpaths_ != footpaths) {
+    return nullptr;
+  }
+
+  auto tt = std::make_unique<csa_timetable>();
+  init_stations(sched, *tt);
+
+  // Same trip numbering as build_csa_timetable.
+  std::vector<trip const*> trips;
+  for (auto const& route_trips : sched.expanded_trips_) {
+    for (auto const& trp : route_trips) {
+      tt->trip_ids_[trp] = static_cast<trip_id>(trips.size());
+      trips.emplace_back(trp);
+    }
+  }
+  utl::verify(trips.size() == data->trip_count_,
+              "csa timetable: trip count mismatch (file: {}, schedule: {})",
+              data->trip_count_, trips.size());
+  tt->trip_count_ = data->trip_count_;
+
+  tt->fwd_connections_ = from_data(data->fwd_connections_, trips);
+  tt->bwd_connections_ = from_data(data->bwd_connections_, trips);
+  tt->fwd_bucket_starts_ = std::vector<uint32_t>(
+      begin(data->fwd_bucket_starts_), end(data->fwd_bucket_starts_));
+  tt->bwd_bucket_starts_ = std::vector<uint32_t>(
+      begin(data->bwd_bucket_starts_), end(data->bwd_bucket_starts_));
+
+  finish_csa_timetable(*tt, false);
+  if (connection_arrays) {
+    map(tt->fwd_arrays_, data->fwd_arrays_, tt->fwd_connections_);
+    map(tt->bwd_arrays_, data->bwd_arrays_, tt->bwd_connections_);
+  }
+  tt->file_ = std::move(mem);
+  return tt;
+}
+
+}  // namespace motis::csa
@@ -0,0 +1,448 @@
+#include "motis/csa/update_csa_timetable.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "utl/verify.h"
+
+#include "motis/core/access/trip_iterator.h"
+#include "motis/core/conv/trip_conv.h"
+
+#include "motis/csa/build_csa_timetable.h"
+
+using namespace motis::access;
+using namespace motis::rt;
+
+namespace motis::csa {
+
+namespace {
+
+using time_range = std::pair<time, time>;
+
+std::vector<time_range> merge_ranges(std::vector<time_range> ranges) {
+  std::sort(begin(ranges), end(ranges));
+  std::vector<time_range> merged;
+  for (auto const& r : ranges) {
+    if (!merged.empty() && r.first <= merged.back().second) {
+      merged.back().second = std::max(merged.back().second, r.second);
+    } else {
+      merged.emplace_back(r);
+    }
+  }
+  return merged;
+}
+
+struct trip_update {
+  std::vector<time_range> old_times_;  // (departure, arrival) per section
+  std::vector<light_connection const*> lcons_;
+};
+
+struct timetable_updater {
+  timetable_updater(schedule const& sched, csa_timetable const& tt,
+                    bool const bridged, bool const footpaths,
+                    csa_update_statistics& stats)
+      : sched_{sched},
+        src_{tt},
+        bridged_{bridged},
+        footpaths_{footpaths},
+        stats_{stats} {}
+
+  bool collect(RtUpdates const* updates) {
+    std::set<trip_id> trips;
+    for (auto const& u : *updates->updates()) {
+      switch (u->content_type()) {
+        case Content_RtRerouteUpdate: return false;
+
+        case Content_RtDelayUpdate: {
+          auto const trp = from_fbs(
+              sched_,
+              reinterpret_cast<RtDelayUpdate const*>(u->content())->trip());
+          for (auto const& s : sections{trp}) {
+            for (auto const& merged : *sched_.merged_trips_[s.lcon().trips_]) {
+              auto const it = src_.trip_ids_.find(merged);
+              if (it != src_.trip_ids_.end()) {
+                trips.insert(it->second);
+              }
+            }
+          }
+          break;
+        }
+
+        default: break;
+      }
+    }
+
+    for (auto const id : trips) {
+      if (!collect_trip(id)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool changed() const { return !trips_.empty(); }
+
+  // tt: the collected timetable or a copy of it
+  void apply(csa_timetable& tt) {
+    tt_ = &tt;
+    std::vector<time_range> dep_ranges;
+    for (auto const& [id, upd] : trips_) {
+      for (auto i = 0U; i < upd.lcons_.size(); ++i) {
+        dep_ranges.emplace_back(
+            std::minmax(upd.old_times_[i].first, upd.lcons_[i]->d_time_));
+      }
+    }
+    update<search_dir::FWD>(dep_ranges);
+    update<search_dir::BWD>(arr_ranges_);
+    stats_.updated_trips_ += trips_.size();
+  }
+
+private:
+  bool collect_trip(trip_id const id) {
+    auto const& cons = src_.trip_to_connections_[id];
+    auto upd = trip_update{};
+    auto changed = false;
+    for (auto const& s : sections{sched_.expanded_trips_.data_[id]}) {
+      auto const idx = upd.lcons_.size();
+      if (idx >= cons.size() ||
+          cons[idx]->from_station_ != s.from_station_id() ||
+          cons[idx]->to_station_ != s.to_station_id()) {
+        return false;
+      }
+      auto const& lcon = s.lcon();
+      changed = changed || cons[idx]->light_con_ != &lcon ||
+                cons[idx]->departure_ != lcon.d_time_ ||
+                cons[idx]->arrival_ != lcon.a_time_;
+      upd.old_times_.emplace_back(cons[idx]->departure_, cons[idx]->arrival_);
+      upd.lcons_.emplace_back(&lcon);
+    }
+    if (upd.lcons_.size() != cons.size()) {
+      return false;
+    }
+    if (!changed) {
+      return true;
+    }
+
+    // bridged connections: sections departing in the same minute
+    if (bridged_) {
+      for (auto i = 1U; i < upd.lcons_.size(); ++i) {
+        if ((upd.old_times_[i].first == upd.old_times_[i - 1].first) !=
+            (upd.lcons_[i]->d_time_ == upd.lcons_[i - 1]->d_time_)) {
+          return false;
+        }
+      }
+    }
+
+    trips_.emplace(id, std::move(upd));
+    return true;
+  }
+
+  // New (departure, arrival) of all connections of a section in the order
+  // they are created by build_csa_timetable: bridged connections (each
+  // followed by its footpath connections), footpath connections, regular.
+  std::vector<time_range> group_times(trip_update const& upd,
+                                      trip_id const id,
+                                      con_idx_t const i) const {
+    auto const& cons = tt_->trip_to_connections_[id];
+    auto const departure = upd.lcons_[i]->d_time_;
+    std::vector<time_range> times;
+    auto const add_footpaths = [&](station_id const s, time const arrival) {
+      if (!footpaths_) {
+        return;
+      }
+      for (auto const& fp : tt_->stations_[s].footpaths_) {
+        if (fp.from_station_ != fp.to_station_) {
+          times.emplace_back(
+              departure,
+              static_cast<time>(arrival + fp.duration_ -
+                                tt_->stations_[fp.to_station_].transfer_time_));
+        }
+      }
+    };
+
+    if (bridged_) {
+      for (auto k = i + 1U; k < upd.lcons_.size(); ++k) {
+        if (upd.lcons_[k]->d_time_ != departure) {
+          break;
+        }
+        times.emplace_back(departure, upd.lcons_[k]->a_time_);
+        add_footpaths(cons[k]->to_station_, upd.lcons_[k]->a_time_);
+      }
+    }
+    add_footpaths(cons[i]->to_station_, upd.lcons_[i]->a_time_);
+    times.emplace_back(departure, upd.lcons_[i]->a_time_);
+    return times;
+  }
+
+  // Connections of a section are only distinguishable by their old times
+  // (bridged and footpath connections may coincide). Equal keys map to
+  // interchangeable connections.
+  using con_key =
+      std::tuple<trip_id, con_idx_t, station_id, time, time, bool>;
+
+  static con_key get_key(csa_connection const& c) {
+    return {c.trip_,      c.trip_con_idx_, c.to_station_,
+            c.departure_, c.arrival_,      c.light_con_ != nullptr};
+  }
+
+  struct moved_con {
+    time departure_, arrival_;
+    uint32_t rank_;
+  };
+
+  // Forward connections of a section are contiguous and in creation order.
+  template <typename It>
+  void update_fwd(It const first, It const last,
+                  std::vector<uint32_t>& ranks) {
+    for (auto it = first; it != last;) {
+      auto const upd = trips_.find(it->trip_);
+      if (upd == end(trips_)) {
+        ++it;
+        continue;
+      }
+      auto const id = it->trip_;
+      auto const i = it->trip_con_idx_;
+      auto const times = group_times(upd->second, id, i);
+      for (auto rank = 0U; rank != times.size(); ++rank, ++it) {
+        utl::verify(it != last && it->trip_ == id && it->trip_con_idx_ == i,
+                    "csa update: connections of trip {} section {} corrupt",
+                    id, i);
+        auto const [departure, arrival] = times[rank];
+        moved_.emplace(get_key(*it), moved_con{departure, arrival, rank});
+        arr_ranges_.emplace_back(std::minmax(it->arrival_, arrival));
+        ++stats_.updated_connections_;
+
+        ranks[static_cast<std::size_t>(std::distance(first, it))] = rank;
+        it->departure_ = departure;
+        it->arrival_ = arrival;
+        if (it->light_con_ != nullptr) {
+          it->light_con_ = upd->second.lcons_[i];
+        }
+      }
+    }
+  }
+
+  template <typename It>
+  void update_bwd(It const first, It const last,
+                  std::vector<uint32_t>& ranks) {
+    for (auto it = first; it != last; ++it) {
+      if (trips_.find(it->trip_) == end(trips_)) {
+        continue;
+      }
+      auto const moved = moved_.find(get_key(*it));
+      utl::verify(moved != end(moved_),
+                  "csa update: backward connection of trip {} not found",
+                  it->trip_);
+      ranks[static_cast<std::size_t>(std::distance(first, it))] =
+          moved->second.rank_;
+      it->departure_ = moved->second.departure_;
+      it->arrival_ = moved->second.arrival_;
+      if (it->light_con_ != nullptr) {
+        it->light_con_ = trips_.at(it->trip_).lcons_[it->trip_con_idx_];
+      }
+      moved_.erase(moved);
+    }
+  }
+
+  // Same order as build_csa_timetable (stable sort of the creation order).
+  template <search_dir Dir>
+  static bool scan_before(csa_connection const& a, uint32_t const a_rank,
+                          csa_connection const& b, uint32_t const b_rank) {
+    if constexpr (Dir == search_dir::FWD) {
+      return std::tie(a.departure_, a.trip_, a.trip_con_idx_, a_rank) <
+             std::tie(b.departure_, b.trip_, b.trip_con_idx_, b_rank);
+    } else {
+      return std::tie(b.arrival_, b.departure_, b.trip_, b.trip_con_idx_,
+                      b_rank) < std::tie(a.arrival_, a.departure_, a.trip_,
+                                         a.trip_con_idx_, a_rank);
+    }
+  }
+
+  template <search_dir Dir>
+  void update(std::vector<time_range> const& ranges) {
+    auto& cons =
+        Dir == search_dir::FWD ? tt_->fwd_connections_ : tt_->bwd_connections_;
+    for (auto const& [lo, hi] : merge_ranges(ranges)) {
+      // slice with times in [lo, hi]
+      auto const first =
+          Dir == search_dir::FWD
+              ? std::lower_bound(begin(cons), end(cons), lo,
+                                 [](csa_connection const& c, time const t) {
+                                   return c.departure_ < t;
+                                 })
+              : std::lower_bound(begin(cons), end(cons), hi,
+                                 [](csa_connection const& c, time const t) {
+                                   return c.arrival_ > t;
+                                 });
+      auto const last =
+          Dir == search_dir::FWD
+              ? std::upper_bound(first, end(cons), hi,
+                                 [](time const t, csa_connection const& c) {
+                                   return t < c.departure_;
+                                 })
+              : std::upper_bound(first, end(cons), lo,
+                                 [](time const t, csa_connection const& c) {
+                                   return t > c.arrival_;
+                                 });
+      if (first == last) {
+        continue;
+      }
+
+      std::vector<uint32_t> ranks(
+          static_cast<std::size_t>(std::distance(first, last)));
+      if constexpr (Dir == search_dir::FWD) {
+        update_fwd(first, last, ranks);
+      } else {
+        update_bwd(first, last, ranks);
+      }
+
+      sort_slice<Dir>(first, last, ranks);
+
+      auto const from =
+          static_cast<std::size_t>(std::distance(begin(cons), first));
+      auto const to =
+          static_cast<std::size_t>(std::distance(begin(cons), last));
+      update_bucket_starts<Dir>(from, to);
+      if (auto& arrays =
+              Dir == search_dir::FWD ? tt_->fwd_arrays_ : tt_->bwd_arrays_;
+          !arrays.empty()) {
+        arrays.update(cons, from, to);
+      }
+      stats_.resorted_connections_ +=
+          static_cast<uint64_t>(std::distance(first, last));
+    }
+  }
+
+  template <search_dir Dir>
+  void sort_slice(std::vector<csa_connection>::iterator const first,
+                  std::vector<csa_connection>::iterator const last,
+                  std::vector<uint32_t> const& ranks) {
+    auto const size = static_cast<uint32_t>(std::distance(first, last));
+    std::vector<uint32_t> perm(size);
+    std::iota(begin(perm), end(perm), 0U);
+    std::stable_sort(begin(perm), end(perm),
+                     [&](uint32_t const a, uint32_t const b) {
+                       return scan_before<Dir>(first[a], ranks[a], first[b],
+                                               ranks[b]);
+                     });
+
+    std::vector<csa_connection> sorted;
+    sorted.reserve(size);
+    for (auto const p : perm) {
+      sorted.emplace_back(first[p]);
+    }
+    std::copy(begin(sorted), end(sorted), first);
+
+    if constexpr (Dir == search_dir::FWD) {
+      fix_pointers(&*first, perm);
+    }
+  }
+
+  // trip_to_connections_ and the station connection lists point into the
+  // forward connections.
+  void fix_pointers(csa_connection const* slice_begin,
+                    std::vector<uint32_t> const& perm) {
+    auto const slice_end = slice_begin + perm.size();
+    std::vector<uint32_t> new_pos(perm.size());
+    std::vector<station_id> stations;
+    for (auto i = 0U; i < perm.size(); ++i) {
+      new_pos[perm[i]] = i;
+      auto const& c = slice_begin[i];
+      if (c.light_con_ != nullptr) {
+        tt_->trip_to_connections_[c.trip_][c.trip_con_idx_] = &c;
+        stations.emplace_back(c.from_station_);
+        stations.emplace_back(c.to_station_);
+      }
+    }
+    std::sort(begin(stations), end(stations));
+    stations.erase(std::unique(begin(stations), end(stations)), end(stations));
+
+    auto const fix = [&](std::vector<csa_connection const*>& v) {
+      for (auto& c : v) {
+        if (c >= slice_begin && c < slice_end) {
+          c = slice_begin + new_pos[c - slice_begin];
+        }
+      }
+      std::sort(begin(v), end(v));
+    };
+    for (auto const s : stations) {
+      fix(tt_->stations_[s].outgoing_connections_);
+      fix(tt_->stations_[s].incoming_connections_);
+    }
+  }
+
+  template <search_dir Dir>
+  void update_bucket_starts(std::size_t const from, std::size_t const to) {
+    auto& bucket_starts = Dir == search_dir::FWD ? tt_->fwd_bucket_starts_
+                                                 : tt_->bwd_bucket_starts_;
+    auto const& cons =
+        Dir == search_dir::FWD ? tt_->fwd_connections_ : tt_->bwd_connections_;
+    if (bucket_starts.empty()) {
+      return;
+    }
+
+    // start one connection early: get_bucket_starts never splits on arrivals
+    // of the first connection (which is in the previous bucket here)
+    auto const start = from == 0U ? from : from - 1U;
+    auto slice_starts =
+        get_bucket_starts(std::next(begin(cons), start),
+                          std::next(begin(cons), to), Dir, bridged_);
+    for (auto& s : slice_starts) {
+      s += start;
+    }
+    if (start != from) {
+      slice_starts.erase(begin(slice_starts));
+    }
+
+    auto const first =
+        std::lower_bound(begin(bucket_starts), end(bucket_starts), from);
+    auto const last = std::upper_bound(first, end(bucket_starts), to);
+    auto const pos = bucket_starts.erase(first, last);
+    bucket_starts.insert(pos, begin(slice_starts), end(slice_starts));
+  }
+
+  schedule const& sched_;
+  csa_timetable const& src_;
+  csa_timetable* tt_{nullptr};
+  bool bridged_, footpaths_;
+  csa_update_statistics& stats_;
+  std::map<trip_id, trip_update> trips_;
+  std::multimap<con_key, moved_con> moved_;
+  std::vector<time_range> arr_ranges_;
+};
+
+}  // namespace
+
+bool update_csa_timetable(schedule const& sched, csa_timetable& tt,
+                          RtUpdates const* updates, bool const bridged,
+                          bool const footpaths, csa_update_statistics& stats) {
+  timetable_updater updater{sched, tt, bridged, footpaths, stats};
+  if (!updater.collect(updates)) {
+    return false;
+  }
+  updater.apply(tt);
+  return true;
+}
+
+bool update_csa_timetable_copy(schedule const& sched, csa_timetable const& tt,
+                               std::unique_ptr<csa_timetable>& updated,
+                               RtUpdates const* updates, bool const bridged,
+                               bool const footpaths,
+                               csa_update_statistics& stats) {
+  timetable_updater updater{sched, tt, bridged, footpaths, stats};
+  if (!updater.collect(updates)) {
+    return false;
+  }
+  if (updater.changed()) {
+    updated = copy_csa_timetable(tt);
+    updater.apply(*updated);
+  }
+  return true;
+}
+
+}  // namespace motis::csa
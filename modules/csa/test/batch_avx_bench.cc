@@ -0,0 +1,105 @@
+// Needs the batch kernel: -DMOTIS_AVX2=ON or -DMOTIS_AVX512=ON (motis-bench).
+#ifdef __AVX2__
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "motis/core/schedule/time.h"
+
+#include "motis/csa/cpu/csa_search_batch_avx.h"
+#include "motis/csa/cpu/csa_search_default_cpu.h"
+#include "motis/csa/csa_search_state.h"
+#include "motis/csa/csa_statistics.h"
+
+#include "motis/test/bench_util.h"
+
+#include "./synthetic_timetable.h"
+
+using namespace motis;
+using namespace motis::csa;
+
+// Batched ontrip searches (cpu::batch, BATCH_SIZE queries per scan) compared
+// to the same queries one by one with the scalar CPU search, on a synthetic
+// timetable with ~1M connections (see synthetic_timetable.h):
+//
+//   ./motis-bench --gtest_filter='csa_batch_avx*'
+//
+// MOTIS_BENCH_QUERIES is rounded up to full batches.
+
+namespace {
+
+template <search_dir Dir>
+void run(csa_timetable const& tt, char const* name) {
+  using batch_search = cpu::batch::csa_search<Dir>;
+  using clock = std::chrono::steady_clock;
+  auto const batch_count =
+      (motis::test::bench_query_count() + batch_search::BATCH_SIZE - 1U) /
+      batch_search::BATCH_SIZE;
+
+  std::mt19937 rng{42};
+  uint64_t scalar_us = 0U, batch_us = 0U;
+  csa_search_state state;
+  for (auto b = 0U; b != batch_count; ++b) {
+    std::vector<station_id> starts;
+    std::vector<motis::time> start_times;
+    for (auto q = 0U; q != batch_search::BATCH_SIZE; ++q) {
+      starts.push_back(static_cast<station_id>(rng() % tt.stations_.size()));
+      start_times.push_back(static_cast<motis::time>(
+          SCHEDULE_OFFSET_MINUTES +
+          (Dir == search_dir::FWD ? 300U : 900U) + rng() % 600U));
+    }
+
+    auto const scalar_start = clock::now();
+    for (auto q = 0U; q != starts.size(); ++q) {
+      csa_statistics stats;
+      cpu::csa_search<Dir> scalar{tt, start_times[q], stats, state};
+      scalar.add_start(tt.stations_[starts[q]], 0);
+      scalar.search();
+    }
+    auto const batch_start = clock::now();
+    csa_statistics stats;
+    batch_search batch{tt, start_times, stats};
+    for (auto q = 0U; q != starts.size(); ++q) {
+      batch.add_start(q, tt.stations_[starts[q]], 0);
+    }
+    batch.search();
+    auto const batch_end = clock::now();
+
+    scalar_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                     batch_start - scalar_start)
+                     .count();
+    batch_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                    batch_end - batch_start)
+                    .count();
+  }
+
+  std::cout << name << ": " << batch_count * batch_search::BATCH_SIZE
+            << " queries, " << tt.fwd_connections_.size()
+            << " connections, scalar " << scalar_us << " us, batch "
+            << batch_us << " us, speedup "
+            << (batch_us == 0U ? 0.0
+                               : static_cast<double>(scalar_us) / batch_us)
+            << "\n";
+}
+
+}  // namespace
+
+struct csa_batch_avx_bench : public ::testing::Test {
+  // 100k trips with 10 connections on average
+  synthetic_timetable const t_{20000U, 100000U, true, 42U};
+};
+
+TEST_F(csa_batch_avx_bench, fwd) {
+  run<search_dir::FWD>(t_.tt_, "fwd");
+}
+
+TEST_F(csa_batch_avx_bench, bwd) {
+  run<search_dir::BWD>(t_.tt_, "bwd");
+}
+
+#endif
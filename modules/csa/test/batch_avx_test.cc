@@ -0,0 +1,152 @@
+// The batched kernel needs AVX2 (AVX-512 if available): this file is only
+// compiled with it in motis-csa-avx-test (modules/csa/CMakeLists.txt) and in
+// motis-test with -DMOTIS_AVX2=ON / -DMOTIS_AVX512=ON.
+#ifdef __AVX2__
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "motis/core/common/deadline.h"
+#include "motis/core/schedule/time.h"
+
+#include "motis/csa/cpu/csa_search_batch_avx.h"
+#include "motis/csa/cpu/csa_search_default_cpu.h"
+#include "motis/csa/csa_search_state.h"
+#include "motis/csa/csa_statistics.h"
+
+#include "./synthetic_timetable.h"
+
+using namespace motis;
+using namespace motis::csa;
+
+namespace {
+
+bool cpu_supports_kernel() {
+#ifdef __AVX512BW__
+  return __builtin_cpu_supports("avx512bw") != 0;
+#else
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+// A full batch of random ontrip queries: the arrival times (per station and
+// transfer count) of each query have to be equal to the scalar search.
+template <search_dir Dir>
+void expect_scalar_arrival_times(csa_timetable const& tt,
+                                 unsigned const seed) {
+  using batch_search = cpu::batch::csa_search<Dir>;
+
+  std::mt19937 rng{seed};
+  std::vector<station_id> starts;
+  std::vector<motis::time> start_times;
+  for (auto q = 0U; q != batch_search::BATCH_SIZE; ++q) {
+    starts.push_back(static_cast<station_id>(rng() % tt.stations_.size()));
+    start_times.push_back(static_cast<motis::time>(
+        SCHEDULE_OFFSET_MINUTES +
+        (Dir == search_dir::FWD ? 300U : 900U) + rng() % 600U));
+  }
+
+  csa_statistics batch_stats;
+  batch_search batch{tt, start_times, batch_stats};
+  for (auto q = 0U; q != starts.size(); ++q) {
+    batch.add_start(q, tt.stations_[starts[q]], 0);
+  }
+  batch.search();
+
+  csa_search_state state;
+  for (auto q = 0U; q != starts.size(); ++q) {
+    csa_statistics stats;
+    cpu::csa_search<Dir> scalar{tt, start_times[q], stats, state};
+    scalar.add_start(tt.stations_[starts[q]], 0);
+    scalar.search();
+
+    auto mismatches = 0U;
+    for (auto s = 0U; s != tt.stations_.size(); ++s) {
+      for (auto k = 0U; k != batch_search::QUERY_LANES; ++k) {
+        if (scalar.arrival_time_[s][k] !=
+            batch.arrival_time_[s][q * batch_search::QUERY_LANES + k]) {
+          ++mismatches;
+        }
+      }
+    }
+    EXPECT_EQ(0U, mismatches) << "query " << q;
+  }
+}
+
+}  // namespace
+
+struct csa_batch_avx : public ::testing::Test {
+  void SetUp() override {
+    if (!cpu_supports_kernel()) {
+      GTEST_SKIP() << "CPU does not support the batch kernel";
+    }
+  }
+};
+
+TEST_F(csa_batch_avx, connection_arrays_fwd) {
+  synthetic_timetable const t{2000U, 10000U, true, 1U};
+  expect_scalar_arrival_times<search_dir::FWD>(t.tt_, 2U);
+}
+
+TEST_F(csa_batch_avx, connection_arrays_bwd) {
+  synthetic_timetable const t{2000U, 10000U, true, 3U};
+  expect_scalar_arrival_times<search_dir::BWD>(t.tt_, 4U);
+}
+
+TEST_F(csa_batch_avx, connection_structs_fwd) {
+  synthetic_timetable const t{2000U, 10000U, false, 5U};
+  expect_scalar_arrival_times<search_dir::FWD>(t.tt_, 6U);
+}
+
+TEST_F(csa_batch_avx, connection_structs_bwd) {
+  synthetic_timetable const t{2000U, 10000U, false, 7U};
+  expect_scalar_arrival_times<search_dir::BWD>(t.tt_, 8U);
+}
+
+// A reached deadline stops its query only: the other queries of the batch
+// have the same arrival times as without it.
+TEST_F(csa_batch_avx, deadline_per_query) {
+  using batch_search = cpu::batch::csa_search<search_dir::FWD>;
+  synthetic_timetable const t{2000U, 10000U, true, 9U};
+  auto const start_time =
+      static_cast<motis::time>(SCHEDULE_OFFSET_MINUTES + 300U);
+  std::vector<motis::time> const start_times{start_time, start_time};
+
+  deadline expired{std::chrono::milliseconds{1}};
+  std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  ASSERT_TRUE(expired.check());
+
+  csa_statistics stats, reference_stats;
+  batch_search batch{t.tt_, start_times, stats};
+  batch_search reference{t.tt_, start_times, reference_stats};
+  for (auto q = 0U; q != start_times.size(); ++q) {
+    batch.add_start(q, t.tt_.stations_[0], 0);
+    reference.add_start(q, t.tt_.stations_[0], 0);
+  }
+  batch.set_deadline(0U, &expired);
+  batch.search();
+  reference.search();
+
+  EXPECT_TRUE(batch.timed_out(0U));
+  EXPECT_FALSE(batch.timed_out(1U));
+  EXPECT_FALSE(reference.timed_out(0U));
+
+  auto reached = 0U, mismatches = 0U;
+  for (auto s = 0U; s != t.tt_.stations_.size(); ++s) {
+    for (auto k = 0U; k != batch_search::QUERY_LANES; ++k) {
+      auto const i = batch_search::QUERY_LANES + k;  // query 1
+      mismatches += batch.arrival_time_[s][i] != reference.arrival_time_[s][i]
+                        ? 1U
+                        : 0U;
+      reached += batch.arrival_time_[s][k] != batch_search::INVALID ? 1U : 0U;
+    }
+  }
+  EXPECT_EQ(0U, mismatches);
+  EXPECT_LT(reached, t.tt_.stations_.size());
+}
+
+#endif
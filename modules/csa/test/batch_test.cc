@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+struct csa_batch : public motis_instance_test {
+  csa_batch() : motis::test::motis_instance_test(dataset_opt_short, {"csa"}) {}
+
+  Offset<RoutingRequest> ontrip_request(message_creator& fbb,
+                                        std::string const& from,
+                                        std::string const& to,
+                                        int const start_time,
+                                        SearchDir const dir) const {
+    return create_ontrip_request(fbb, from, to, unix_time(start_time), dir);
+  }
+
+  Offset<RoutingRequest> pretrip_request(message_creator& fbb,
+                                         std::string const& from,
+                                         std::string const& to,
+                                         int const begin,
+                                         int const end) const {
+    return create_pretrip_request(fbb, from, to, unix_time(begin),
+                                  unix_time(end));
+  }
+};
+
+TEST_F(csa_batch, same_results_as_single_queries) {
+  auto const create_requests = [&](message_creator& fbb) {
+    return std::vector<Offset<RoutingRequest>>{
+        ontrip_request(fbb, "8000031", "8000105", 1400, SearchDir_Forward),
+        ontrip_request(fbb, "8000105", "8000031", 1445, SearchDir_Backward),
+        ontrip_request(fbb, "8000068", "8000207", 1400, SearchDir_Forward),
+        pretrip_request(fbb, "8000068", "8000207", 1400, 1500),
+        ontrip_request(fbb, "8000031", "8000105", 1300, SearchDir_Forward)};
+  };
+
+  message_creator fbb;
+  fbb.create_and_finish(
+      MsgContent_RoutingBatchRequest,
+      CreateRoutingBatchRequest(fbb, fbb.CreateVector(create_requests(fbb)))
+          .Union(),
+      "/csa/batch");
+  auto const batch_msg = call(make_msg(fbb));
+  auto const responses =
+      motis_content(RoutingBatchResponse, batch_msg)->responses();
+
+  ASSERT_EQ(5U, responses->size());
+  for (auto i = 0U; i != responses->size(); ++i) {
+    message_creator req_fbb;
+    auto const expected = get_journeys(
+        call(make_routing_msg(req_fbb, create_requests(req_fbb)[i], "/csa")));
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, get_journeys(responses->Get(i)));
+  }
+}
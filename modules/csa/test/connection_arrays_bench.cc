@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "motis/module/message.h"
+
+#include "motis/test/bench_util.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+
+// Scan throughput of the CPU and SSE CSA with the array of structs and with
+// --csa.connection_arrays. All fixtures run the same fixed ontrip queries
+// (see bench_queries() in motis/test/bench_util.h) and print the journey
+// count per query, which has to match between the layouts:
+//
+//   ./motis-bench --gtest_filter='csa_layout_*'
+
+struct csa_layout_bench : public motis_instance_test {
+  explicit csa_layout_bench(bool const connection_arrays)
+      : motis_instance_test(
+            bench_dataset(), {"csa"},
+            {connection_arrays ? "--csa.connection_arrays=true"
+                               : "--csa.connection_arrays=false"}) {}
+
+  void run(char const* layout, std::string const& target) {
+    auto const queries = bench_queries();
+    uint64_t scanned = 0U, duration_us = 0U;
+    for (auto const& q : queries) {
+      message_creator fbb;
+      auto const res = call(make_routing_msg(
+          fbb,
+          create_ontrip_request(fbb, q.from_, q.to_, unix_time(q.departure_)),
+          target));
+      scanned += get_stat(res, "csa", "connections_scanned");
+      duration_us += get_stat(res, "csa", "search_duration_us");
+      std::cout << layout << " " << target << ": " << q.from_ << " -> "
+                << q.to_ << " @" << q.departure_ << ": "
+                << get_journeys(res).size() << " journeys\n";
+    }
+
+    std::cout << layout << " " << target << ": " << queries.size()
+              << " queries, " << scanned << " connections scanned, "
+              << duration_us << " us, "
+              << (duration_us == 0U ? 0.0 : scanned * 1e6 / duration_us)
+              << " connections/s\n";
+    EXPECT_NE(0U, scanned);
+  }
+};
+
+struct csa_layout_structs : public csa_layout_bench {
+  csa_layout_structs() : csa_layout_bench(false) {}
+};
+
+struct csa_layout_arrays : public csa_layout_bench {
+  csa_layout_arrays() : csa_layout_bench(true) {}
+};
+
+TEST_F(csa_layout_structs, connections_per_second) {
+  run("structs", "/csa/cpu");
+#ifdef MOTIS_AVX
+  run("structs", "/csa/cpu/sse");
+#endif
+}
+
+TEST_F(csa_layout_arrays, connections_per_second) {
+  run("arrays", "/csa/cpu");
+#ifdef MOTIS_AVX
+  run("arrays", "/csa/cpu/sse");
+#endif
+}
@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::csa;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+struct csa_one_to_all : public motis_instance_test {
+  csa_one_to_all()
+      : motis::test::motis_instance_test(dataset_opt_short, {"csa"}) {}
+
+  msg_ptr one_to_all_request(std::string const& start, int const start_time,
+                             SearchDir const dir) const {
+    message_creator fbb;
+    fbb.create_and_finish(
+        MsgContent_CsaOneToAllRequest,
+        CreateCsaOneToAllRequest(
+            fbb,
+            CreateInputStation(fbb, fbb.CreateString(start),
+                               fbb.CreateString("")),
+            fbb.CreateVector(std::vector<Offset<MumoEdge>>()),
+            unix_time(start_time), dir, 0U, true)
+            .Union(),
+        "/csa/one_to_all");
+    return make_msg(fbb);
+  }
+
+  msg_ptr routing_request(std::string const& from, std::string const& to,
+                          int const start_time) const {
+    message_creator fbb;
+    return make_routing_msg(
+        fbb, create_ontrip_request(fbb, from, to, unix_time(start_time)),
+        "/csa");
+  }
+};
+
+TEST_F(csa_one_to_all, matches_routing) {
+  auto const res_msg =
+      call(one_to_all_request("8000031", 1400, SearchDir_Forward));
+  auto const res = motis_content(CsaOneToAllResponse, res_msg);
+  ASSERT_FALSE(res->stations()->size() == 0U);
+  ASSERT_EQ(res->stations()->size() * res->trip_counts(),
+            res->travel_times()->size());
+
+  auto const row = [&](std::string const& eva) -> int {
+    for (auto i = 0U; i != res->stations()->size(); ++i) {
+      if (res->stations()->Get(i)->str() == eva) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  };
+
+  // The start station is reachable without trips.
+  auto const start_row = row("8000031");
+  ASSERT_NE(-1, start_row);
+  EXPECT_NE(std::numeric_limits<uint16_t>::max(),
+            res->travel_times()->Get(start_row * res->trip_counts()));
+
+  // Best travel time to the destination is the earliest /csa arrival plus
+  // the transfer time at the destination.
+  auto const dest_row = row("8000105");
+  ASSERT_NE(-1, dest_row);
+  auto best = std::numeric_limits<uint16_t>::max();
+  for (auto k = 0U; k != res->trip_counts(); ++k) {
+    best = std::min(
+        best, res->travel_times()->Get(dest_row * res->trip_counts() + k));
+  }
+
+  auto const journeys = message_to_journeys(motis_content(
+      RoutingResponse, call(routing_request("8000031", "8000105", 1400))));
+  ASSERT_FALSE(journeys.empty());
+  auto earliest = journeys.front().stops_.back().arrival_.timestamp_;
+  for (auto const& j : journeys) {
+    earliest = std::min(earliest, j.stops_.back().arrival_.timestamp_);
+  }
+  auto const routing_minutes = (earliest - unix_time(1400)) / 60;
+  EXPECT_LE(routing_minutes, best);
+  EXPECT_GE(routing_minutes + 15, best);
+}
@@ -21,13 +21,18 @@ using motis::test::schedule::simple_realtime::dataset_opt_short;
 
 constexpr auto const SEARCH_TYPE = 0;
 constexpr auto const TARGET = 1;
+constexpr auto const CONNECTION_ARRAYS = 2;
 
 struct csa_ontrip_station
     : public motis_instance_test,
       public ::testing::WithParamInterface<
-          std::tuple<motis::routing::SearchType, char const*>> {
+          std::tuple<motis::routing::SearchType, char const*, bool>> {
   csa_ontrip_station()
-      : motis::test::motis_instance_test(dataset_opt_short, {"csa"}) {}
+      : motis::test::motis_instance_test(
+            dataset_opt_short, {"csa"},
+            {std::get<CONNECTION_ARRAYS>(GetParam())
+                 ? "--csa.connection_arrays=true"
+                 : "--csa.connection_arrays=false"}) {}
   csa_ontrip_station(csa_ontrip_station const&) = delete;
   csa_ontrip_station(csa_ontrip_station&&) = delete;
   csa_ontrip_station& operator=(csa_ontrip_station const&) = delete;
@@ -195,12 +200,20 @@ TEST_P(csa_ontrip_station, interchange_fwd_pretrip) {  // NOLINT
 #ifdef MOTIS_CUDA
 INSTANTIATE_TEST_SUITE_P(
     csa_ontrip_station, csa_ontrip_station,
-    ::testing::Values(std::make_tuple(SearchType_Default, "/csa/cpu"),
-                      std::make_tuple(SearchType_Default, "/csa/cpu/sse"),
-                      std::make_tuple(SearchType_Default, "/csa/gpu")));
+    ::testing::Values(
+        std::make_tuple(SearchType_Default, "/csa/cpu", false),
+        std::make_tuple(SearchType_Default, "/csa/cpu/profile", false),
+        std::make_tuple(SearchType_Default, "/csa/cpu/sse", false),
+        std::make_tuple(SearchType_Default, "/csa/cpu", true),
+        std::make_tuple(SearchType_Default, "/csa/cpu/sse", true),
+        std::make_tuple(SearchType_Default, "/csa/gpu", false)));
 #else
 INSTANTIATE_TEST_SUITE_P(
     csa_ontrip_station, csa_ontrip_station,
-    ::testing::Values(std::make_tuple(SearchType_Default, "/csa/cpu"),
-                      std::make_tuple(SearchType_Default, "/csa/cpu/sse")));
+    ::testing::Values(
+        std::make_tuple(SearchType_Default, "/csa/cpu", false),
+        std::make_tuple(SearchType_Default, "/csa/cpu/profile", false),
+        std::make_tuple(SearchType_Default, "/csa/cpu/sse", false),
+        std::make_tuple(SearchType_Default, "/csa/cpu", true),
+        std::make_tuple(SearchType_Default, "/csa/cpu/sse", true)));
 #endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+struct csa_pretrip_parallel : public motis_instance_test {
+  csa_pretrip_parallel()
+      : motis::test::motis_instance_test(dataset_opt_short, {"csa"},
+                                         {"--csa.pretrip_jobs=4"}) {}
+
+  Offset<RoutingRequest> pretrip_request(message_creator& fbb,
+                                         std::string const& from,
+                                         std::string const& to,
+                                         SearchDir const dir) const {
+    return create_pretrip_request(fbb, from, to, unix_time(1300),
+                                  unix_time(1500), SearchType_Default, dir);
+  }
+
+  // /csa/batch runs pretrip queries sequentially.
+  void compare(std::string const& from, std::string const& to,
+               SearchDir const dir) {
+    message_creator single_fbb;
+    auto const parallel_msg = call(make_routing_msg(
+        single_fbb, pretrip_request(single_fbb, from, to, dir), "/csa"));
+    auto const parallel = motis_content(RoutingResponse, parallel_msg);
+
+    message_creator batch_fbb;
+    auto const requests = std::vector<Offset<RoutingRequest>>{
+        pretrip_request(batch_fbb, from, to, dir)};
+    batch_fbb.create_and_finish(
+        MsgContent_RoutingBatchRequest,
+        CreateRoutingBatchRequest(batch_fbb, batch_fbb.CreateVector(requests))
+            .Union(),
+        "/csa/batch");
+    auto const batch_msg = call(make_msg(batch_fbb));
+    auto const sequential =
+        motis_content(RoutingBatchResponse, batch_msg)->responses()->Get(0);
+
+    EXPECT_FALSE(get_journeys(sequential).empty());
+    EXPECT_EQ(get_journeys(sequential), get_journeys(parallel));
+    EXPECT_EQ(sequential->interval_begin(), parallel->interval_begin());
+    EXPECT_EQ(sequential->interval_end(), parallel->interval_end());
+    EXPECT_EQ(get_stat(sequential, "csa", "connections_scanned"),
+              get_stat(parallel, "csa", "connections_scanned"));
+    EXPECT_EQ(0U, get_stat(sequential, "csa", "parallel_jobs"));
+    EXPECT_LT(0U, get_stat(parallel, "csa", "parallel_jobs"));
+  }
+};
+
+TEST_F(csa_pretrip_parallel, same_results_fwd) {
+  compare("8000031", "8000105", SearchDir_Forward);
+  compare("8000068", "8000207", SearchDir_Forward);
+}
+
+TEST_F(csa_pretrip_parallel, same_results_bwd) {
+  compare("8000105", "8000031", SearchDir_Backward);
+  compare("8000207", "8000068", SearchDir_Backward);
+}
@@ -0,0 +1,51 @@
+#include "gtest/gtest.h"
+
+
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+struct csa_pretrip_profile : public motis_instance_test {
+  csa_pretrip_profile()
+      : motis::test::motis_instance_test(dataset_opt_short, {"csa"}) {}
+
+  journey_set search(std::string const& from, std::string const& to,
+                     SearchDir const dir, std::string const& target) {
+    message_creator fbb;
+    return get_journeys(call(make_routing_msg(
+        fbb,
+        create_pretrip_request(fbb, from, to, unix_time(1300),
+                               unix_time(1500), SearchType_Default, dir),
+        target)));
+  }
+
+  void compare(std::string const& from, std::string const& to,
+               SearchDir const dir) {
+    auto const iterated = search(from, to, dir, "/csa/cpu");
+    auto const profile = search(from, to, dir, "/csa/cpu/profile");
+    EXPECT_FALSE(iterated.empty());
+    EXPECT_EQ(iterated, profile);
+  }
+};
+
+TEST_F(csa_pretrip_profile, same_journeys_fwd) {
+  compare("8000031", "8000105", SearchDir_Forward);
+  compare("8000068", "8000207", SearchDir_Forward);
+}
+
+TEST_F(csa_pretrip_profile, same_journeys_bwd) {
+  compare("8000105", "8000031", SearchDir_Backward);
+  compare("8000207", "8000068", SearchDir_Backward);
+}
@@ -0,0 +1,212 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "motis/module/message.h"
+
+#include "motis/core/access/station_access.h"
+#include "motis/core/access/time_access.h"
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/csa/build_csa_timetable.h"
+#include "motis/csa/cpu/csa_search_price.h"
+#include "motis/csa/cpu/csa_search_price_buckets.h"
+#include "motis/csa/csa_search_state.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::csa;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+struct csa_price_buckets : public motis_instance_test {
+  csa_price_buckets()
+      : motis::test::motis_instance_test(dataset_opt_short, {"csa"},
+                                         {"--csa.price_buckets=4",
+                                          "--csa.price_bucket_base=100"}) {}
+
+  msg_ptr ontrip_request(std::string const& target, std::string const& from,
+                         std::string const& to, int const start_time,
+                         SearchDir const dir) const {
+    message_creator fbb;
+    return make_routing_msg(
+        fbb, create_ontrip_request(fbb, from, to, unix_time(start_time), dir),
+        target);
+  }
+
+  // Earliest arrival (FWD) / latest departure (BWD) of the journeys.
+  static std::time_t best_time(std::vector<journey> const& journeys,
+                               SearchDir const dir) {
+    auto const time = [&](journey const& j) {
+      return dir == SearchDir_Forward ? j.stops_.back().arrival_.timestamp_
+                                      : j.stops_.front().departure_.timestamp_;
+    };
+    auto const best = std::min_element(
+        begin(journeys), end(journeys),
+        [&](journey const& a, journey const& b) {
+          return dir == SearchDir_Forward ? time(a) < time(b)
+                                          : time(a) > time(b);
+        });
+    return best == end(journeys) ? 0 : time(*best);
+  }
+
+  void compare(std::string const& from, std::string const& to,
+               int const start_time, SearchDir const dir) {
+    auto const get_journeys = [&](std::string const& target) {
+      return message_to_journeys(motis_content(
+          RoutingResponse,
+          call(ontrip_request(target, from, to, start_time, dir))));
+    };
+    auto const exact = get_journeys("/csa/cpu/price");
+    auto const buckets = get_journeys("/csa/cpu/price_buckets");
+
+    ASSERT_FALSE(buckets.empty());
+    EXPECT_EQ(best_time(exact, dir), best_time(buckets, dir));
+    for (auto const& j : buckets) {
+      if (dir == SearchDir_Forward) {
+        EXPECT_GE(j.stops_.front().departure_.timestamp_,
+                  unix_time(start_time));
+      } else {
+        EXPECT_LE(j.stops_.back().arrival_.timestamp_,
+                  unix_time(start_time));
+      }
+    }
+  }
+
+  // Highest fare the bucket search can report instead of the fare of the
+  // exact journey j. At every station (in search direction) the label of j
+  // can be replaced by a label that is not later and in the same or a lower
+  // fare class, i.e. the error of each trip is bounded by its fare class.
+  static unsigned fare_bound(price_buckets::price_bucket_bounds const& buckets,
+                             csa_journey const& j) {
+    using price_buckets::price_bucket_bounds;
+    using price_buckets::price_t;
+    constexpr auto const UNBOUNDED = std::numeric_limits<unsigned>::max();
+    constexpr auto const MAX_FARE =
+        static_cast<unsigned>(std::numeric_limits<price_t>::max());
+
+    // in search direction: FWD journeys are stored in travel order, BWD
+    // journeys from the last trip to the first
+    std::vector<unsigned> trip_fares;
+    for (auto const& e : j.edges_) {
+      if (!e.is_connection()) {
+        continue;
+      }
+      if (e.enter_) {
+        trip_fares.emplace_back(0U);
+      }
+      trip_fares.back() += e.con_->full_con_->price_;
+    }
+
+    auto bound = 0U;
+    for (auto const fare : trip_fares) {
+      auto const bucket = buckets.get_bucket(
+          static_cast<price_t>(std::min(bound + fare, MAX_FARE)));
+      if (bucket == buckets.bounds_.size() ||
+          buckets.bounds_[bucket] == price_bucket_bounds::UNBOUNDED) {
+        return UNBOUNDED;
+      }
+      bound = buckets.bounds_[bucket] - 1U;
+    }
+    return bound;
+  }
+
+  // Compares the (duration, generalized price) Pareto sets of the exact and
+  // the bucket price search (same configuration as the module: 4 buckets,
+  // first bound 100):
+  //  - every bucket journey is weakly dominated by an exact journey
+  //  - the fastest journeys are equally fast
+  //  - every exact journey is matched by a bucket journey that is not
+  //    slower and not more expensive than the exact journey with its fare
+  //    raised to fare_bound
+  template <search_dir Dir>
+  void compare_prices(std::string const& from, std::string const& to,
+                      int const start_time) {
+    auto const tt = build_csa_timetable(sched(), false, false, false);
+    auto const start = unix_to_motistime(sched(), unix_time(start_time));
+    auto const& origin = tt->stations_.at(get_station(sched(), from)->index_);
+    auto const& destination =
+        tt->stations_.at(get_station(sched(), to)->index_);
+    price_buckets::price_bucket_bounds const buckets{4U, 100U};
+
+    csa_statistics exact_stats, bucket_stats;
+    csa_search_state exact_state, bucket_state;
+    price::csa_search<Dir> exact{*tt, start, exact_stats, exact_state};
+    price_buckets::csa_search<Dir> bucket{*tt, start, bucket_stats,
+                                          bucket_state, buckets};
+    exact.add_start(origin, 0);
+    bucket.add_start(origin, 0);
+    exact.search();
+    bucket.search();
+
+    auto exact_journeys = exact.get_results(destination);
+    auto const bucket_journeys = bucket.get_results(destination);
+    ASSERT_FALSE(exact_journeys.empty());
+    ASSERT_FALSE(bucket_journeys.empty());
+
+    auto const dominates = [](csa_journey const& a, csa_journey const& b) {
+      return a.duration_ <= b.duration_ && a.price_ <= b.price_;
+    };
+    for (auto const& b : bucket_journeys) {
+      EXPECT_TRUE(std::any_of(
+          begin(exact_journeys), end(exact_journeys),
+          [&](csa_journey const& e) { return dominates(e, b); }))
+          << "duration=" << b.duration_ << ", price=" << b.price_;
+    }
+
+    auto const fastest = [](std::vector<csa_journey> const& journeys) {
+      return std::min_element(begin(journeys), end(journeys),
+                              [](csa_journey const& a, csa_journey const& b) {
+                                return a.duration_ < b.duration_;
+                              })
+          ->duration_;
+    };
+    EXPECT_EQ(fastest(exact_journeys), fastest(bucket_journeys));
+
+    for (auto& e : exact_journeys) {
+      ASSERT_TRUE(exact.extract_journey(e));
+      auto const fare = e.price_ - e.duration_ * price::MINUTE_PRICE;
+      auto const bound = fare_bound(buckets, e);
+      EXPECT_TRUE(std::any_of(
+          begin(bucket_journeys), end(bucket_journeys),
+          [&](csa_journey const& b) {
+            return b.duration_ <= e.duration_ &&
+                   (bound == std::numeric_limits<unsigned>::max() ||
+                    b.price_ <= bound + e.duration_ * price::MINUTE_PRICE);
+          }))
+          << "duration=" << e.duration_ << ", fare=" << fare
+          << ", bound=" << bound;
+    }
+  }
+};
+
+TEST_F(csa_price_buckets, earliest_arrival_fwd) {
+  compare("8000031", "8000105", 1400, SearchDir_Forward);
+  compare("8000068", "8000207", 1300, SearchDir_Forward);
+}
+
+TEST_F(csa_price_buckets, latest_departure_bwd) {
+  compare("8000105", "8000031", 1445, SearchDir_Backward);
+  compare("8000207", "8000068", 1500, SearchDir_Backward);
+}
+
+TEST_F(csa_price_buckets, pareto_quality_fwd) {
+  compare_prices<search_dir::FWD>("8000031", "8000105", 1400);
+  compare_prices<search_dir::FWD>("8000068", "8000207", 1300);
+}
+
+TEST_F(csa_price_buckets, pareto_quality_bwd) {
+  compare_prices<search_dir::BWD>("8000105", "8000031", 1445);
+  compare_prices<search_dir::BWD>("8000207", "8000068", 1500);
+}
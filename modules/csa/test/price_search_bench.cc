@@ -0,0 +1,54 @@
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "motis/module/message.h"
+
+#include "motis/test/bench_util.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+
+// Search time and labels of the exact price-aware CSA (/csa/cpu/price)
+// compared to the price bucket CSA (/csa/cpu/price_buckets) and the CSA
+// without prices (/csa/cpu). All targets run the same fixed ontrip queries
+// (see bench_queries() in motis/test/bench_util.h):
+//
+//   ./motis-bench --gtest_filter='csa_price_bench.*'
+
+struct csa_price_bench : public motis_instance_test {
+  csa_price_bench() : motis_instance_test(bench_dataset(), {"csa"}) {}
+
+  void run(std::string const& target) {
+    auto const queries = bench_queries();
+    uint64_t labels = 0U, duration_us = 0U, journeys = 0U;
+    for (auto const& q : queries) {
+      message_creator fbb;
+      auto const res = call(make_routing_msg(
+          fbb,
+          create_ontrip_request(fbb, q.from_, q.to_, unix_time(q.departure_)),
+          target));
+      labels += get_stat(res, "csa", "labels_created");
+      duration_us += get_stat(res, "csa", "search_duration_us");
+      journeys += get_journeys(res).size();
+    }
+
+    auto const n = queries.size();
+    std::cout << target << ": " << n << " queries, " << journeys
+              << " journeys, " << labels << " labels, search "
+              << duration_us / 1000U << " ms ("
+              << (n == 0U ? 0U : duration_us / n) << " us/query)\n";
+  }
+};
+
+TEST_F(csa_price_bench, search_time) {
+  run("/csa/cpu");
+  run("/csa/cpu/price");
+  run("/csa/cpu/price_buckets");
+}
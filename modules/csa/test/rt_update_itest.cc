@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/csa/csa.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+struct csa_rt_update : public motis_instance_test {
+  csa_rt_update()
+      : motis::test::motis_instance_test(
+            dataset_opt, {"csa", "ris", "rt"},
+            {"--ris.input=test/schedule/simple_realtime/risml/delays.xml",
+             "--ris.init_time=2015-11-24T11:00:00"}) {}
+
+};
+
+TEST_F(csa_rt_update, uses_realtime_times) {
+  get_module<csa::csa>("csa").wait_for_rebuild();
+
+  auto const res = call(simple_realtime_request(*this, "/csa"));
+  auto const content = motis_content(RoutingResponse, res);
+  EXPECT_LE(1U, get_stat(content, "csa_rt", "update_count"));
+  EXPECT_EQ(0U, get_stat(content, "csa_rt", "pending_rebuilds"));
+
+  auto const journeys = message_to_journeys(content);
+  ASSERT_FALSE(journeys.empty());
+  // ICE 628 departs one minute late in Aschaffenburg
+  auto const delayed = [&](journey const& j) {
+    return j.stops_.front().eva_no_ == "8000260" &&
+           j.stops_.back().eva_no_ == "8000208" &&
+           std::any_of(begin(j.stops_), end(j.stops_), [&](auto const& s) {
+             return s.departure_.schedule_timestamp_ == unix_time(1436) &&
+                    s.departure_.timestamp_ == unix_time(1437);
+           });
+  };
+  EXPECT_TRUE(std::any_of(begin(journeys), end(journeys), delayed));
+}
+
+struct csa_no_rt_update : public motis_instance_test {
+  csa_no_rt_update()
+      : motis::test::motis_instance_test(dataset_opt, {"csa"}) {}
+};
+
+TEST_F(csa_no_rt_update, no_realtime_statistics) {
+  auto const res = call(simple_realtime_request(*this, "/csa"));
+  auto const content = motis_content(RoutingResponse, res);
+  EXPECT_NE(nullptr, content->statistics()->LookupByKey("csa"));
+  EXPECT_EQ(nullptr, content->statistics()->LookupByKey("csa_rt"));
+}
@@ -0,0 +1,74 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+struct csa_state_pool : public motis_instance_test {
+  csa_state_pool()
+      : motis::test::motis_instance_test(dataset_opt_short, {"csa"}) {}
+
+  msg_ptr ontrip_request(std::string const& from, std::string const& to,
+                         int const start_time, SearchDir const dir,
+                         std::string const& target = "/csa") const {
+    message_creator fbb;
+    return make_routing_msg(
+        fbb, create_ontrip_request(fbb, from, to, unix_time(start_time), dir),
+        target);
+  }
+};
+
+TEST_F(csa_state_pool, reused_between_searches) {
+  auto const first =
+      call(ontrip_request("8000031", "8000105", 1400, SearchDir_Forward));
+  EXPECT_EQ(1U, get_stat(first, "csa", "state_allocations"));
+  EXPECT_EQ(0U, get_stat(first, "csa", "state_reuses"));
+
+  auto const bwd =
+      call(ontrip_request("8000105", "8000031", 1445, SearchDir_Backward));
+  EXPECT_FALSE(get_journeys(bwd).empty());
+
+  auto const second =
+      call(ontrip_request("8000031", "8000105", 1400, SearchDir_Forward));
+  EXPECT_EQ(0U, get_stat(second, "csa", "state_allocations"));
+  EXPECT_EQ(1U, get_stat(second, "csa", "state_reuses"));
+  EXPECT_LT(0U, get_stat(second, "csa", "state_entries_reset"));
+
+  EXPECT_FALSE(get_journeys(first).empty());
+  EXPECT_EQ(get_journeys(first), get_journeys(second));
+}
+
+TEST_F(csa_state_pool, price_searches_reuse_states) {
+  for (auto const target : {"/csa/cpu/price", "/csa/cpu/price_buckets"}) {
+    auto const first = call(ontrip_request("8000031", "8000105", 1400,
+                                           SearchDir_Forward, target));
+    EXPECT_EQ(1U, get_stat(first, "csa", "state_allocations")) << target;
+
+    // other search kinds in between: the price buffers stay allocated
+    call(ontrip_request("8000031", "8000105", 1400, SearchDir_Forward));
+    call(ontrip_request("8000105", "8000031", 1445, SearchDir_Backward,
+                        target));
+
+    auto const second = call(ontrip_request("8000031", "8000105", 1400,
+                                            SearchDir_Forward, target));
+    EXPECT_EQ(0U, get_stat(second, "csa", "state_allocations")) << target;
+    EXPECT_EQ(1U, get_stat(second, "csa", "state_reuses")) << target;
+
+    EXPECT_FALSE(get_journeys(first).empty()) << target;
+    EXPECT_EQ(get_journeys(first), get_journeys(second)) << target;
+  }
+}
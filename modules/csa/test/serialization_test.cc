@@ -0,0 +1,146 @@
+#include "gtest/gtest.h"
+
+#include "boost/filesystem.hpp"
+
+#include "motis/csa/build_csa_timetable.h"
+#include "motis/csa/serialization.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace motis;
+using namespace motis::csa;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+struct csa_serialization : public motis_instance_test {
+  csa_serialization()
+      : motis::test::motis_instance_test(dataset_opt, {"csa"},
+                                         {"--csa.use_data_file=false"}) {}
+
+  ~csa_serialization() override { boost::filesystem::remove(path_); }
+
+  csa_serialization(csa_serialization const&) = delete;
+  csa_serialization& operator=(csa_serialization const&) = delete;
+  csa_serialization(csa_serialization&&) = delete;
+  csa_serialization& operator=(csa_serialization&&) = delete;
+
+  static void expect_same(std::vector<csa_connection> const& a,
+                          std::vector<csa_connection> const& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (auto i = 0U; i != a.size(); ++i) {
+      EXPECT_EQ(a[i].from_station_, b[i].from_station_);
+      EXPECT_EQ(a[i].to_station_, b[i].to_station_);
+      EXPECT_EQ(a[i].trip_, b[i].trip_);
+      EXPECT_EQ(a[i].departure_, b[i].departure_);
+      EXPECT_EQ(a[i].arrival_, b[i].arrival_);
+      EXPECT_EQ(a[i].price_, b[i].price_);
+      EXPECT_EQ(a[i].trip_con_idx_, b[i].trip_con_idx_);
+      EXPECT_EQ(a[i].from_in_allowed_, b[i].from_in_allowed_);
+      EXPECT_EQ(a[i].to_out_allowed_, b[i].to_out_allowed_);
+      EXPECT_EQ(a[i].clasz_, b[i].clasz_);
+      EXPECT_EQ(a[i].light_con_, b[i].light_con_);
+    }
+  }
+
+  static void expect_same(csa_connection_arrays const& a,
+                          csa_connection_arrays const& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (auto i = 0U; i != a.size(); ++i) {
+      EXPECT_EQ(a.departure(i), b.departure(i));
+      EXPECT_EQ(a.arrival(i), b.arrival(i));
+      EXPECT_EQ(a.from_station(i), b.from_station(i));
+      EXPECT_EQ(a.to_station(i), b.to_station(i));
+      EXPECT_EQ(a.trip(i), b.trip(i));
+      EXPECT_EQ(a.from_in_allowed(i), b.from_in_allowed(i));
+      EXPECT_EQ(a.to_out_allowed(i), b.to_out_allowed(i));
+    }
+  }
+
+  std::string path_{"csa_serialization_test.bin"};
+};
+
+TEST_F(csa_serialization, read_equals_build) {
+  auto const built = build_csa_timetable(sched(), true, true, true);
+  write_timetable(path_, sched(), *built, true, true);
+  auto const read = read_timetable(path_, sched(), true, true, true);
+  ASSERT_NE(nullptr, read);
+
+  EXPECT_EQ(built->trip_count_, read->trip_count_);
+  EXPECT_EQ(built->stations_.size(), read->stations_.size());
+  EXPECT_EQ(built->fwd_bucket_starts_, read->fwd_bucket_starts_);
+  EXPECT_EQ(built->bwd_bucket_starts_, read->bwd_bucket_starts_);
+  expect_same(built->fwd_connections_, read->fwd_connections_);
+  expect_same(built->bwd_connections_, read->bwd_connections_);
+  expect_same(built->fwd_arrays_, read->fwd_arrays_);
+  expect_same(built->bwd_arrays_, read->bwd_arrays_);
+  EXPECT_TRUE(read->fwd_arrays_.mapped());
+  EXPECT_TRUE(read->bwd_arrays_.mapped());
+
+  ASSERT_EQ(built->trip_to_connections_.size(),
+            read->trip_to_connections_.size());
+  for (auto i = 0U; i != built->trip_to_connections_.size(); ++i) {
+    EXPECT_EQ(built->trip_to_connections_[i].size(),
+              read->trip_to_connections_[i].size());
+  }
+  for (auto const& [trp, id] : built->trip_ids_) {
+    EXPECT_EQ(id, read->trip_ids_.at(trp));
+  }
+}
+
+TEST_F(csa_serialization, outdated_options) {
+  auto const built = build_csa_timetable(sched(), false, false, false);
+  write_timetable(path_, sched(), *built, false, false);
+  EXPECT_EQ(nullptr, read_timetable(path_, sched(), true, false, false));
+  EXPECT_EQ(nullptr, read_timetable(path_, sched(), false, true, false));
+  EXPECT_NE(nullptr, read_timetable(path_, sched(), false, false, false));
+}
+
+TEST_F(csa_serialization, update_copies_mapped_arrays) {
+  auto const built = build_csa_timetable(sched(), false, false, true);
+  write_timetable(path_, sched(), *built, false, false);
+  auto const read = read_timetable(path_, sched(), false, false, true);
+  ASSERT_NE(nullptr, read);
+  ASSERT_TRUE(read->fwd_arrays_.mapped());
+
+  read->fwd_arrays_.update(read->fwd_connections_, 0U, 0U);
+  EXPECT_FALSE(read->fwd_arrays_.mapped());
+  EXPECT_TRUE(read->bwd_arrays_.mapped());
+  expect_same(built->fwd_arrays_, read->fwd_arrays_);
+}
+
+TEST_F(csa_serialization, copy_of_mapped_timetable) {
+  auto const built = build_csa_timetable(sched(), true, true, true);
+  write_timetable(path_, sched(), *built, true, true);
+  auto const read = read_timetable(path_, sched(), true, true, true);
+  ASSERT_NE(nullptr, read);
+
+  auto const copy = copy_csa_timetable(*read);
+  EXPECT_FALSE(copy->fwd_arrays_.mapped());
+  EXPECT_FALSE(copy->bwd_arrays_.mapped());
+  expect_same(read->fwd_connections_, copy->fwd_connections_);
+  expect_same(read->bwd_connections_, copy->bwd_connections_);
+  expect_same(read->fwd_arrays_, copy->fwd_arrays_);
+  expect_same(read->bwd_arrays_, copy->bwd_arrays_);
+  EXPECT_EQ(read->fwd_bucket_starts_, copy->fwd_bucket_starts_);
+
+  // no pointers into the copied timetable
+  auto const in_copy = [&](csa_connection const* c) {
+    return c >= copy->fwd_connections_.data() &&
+           c < copy->fwd_connections_.data() + copy->fwd_connections_.size();
+  };
+  ASSERT_EQ(read->trip_to_connections_.size(),
+            copy->trip_to_connections_.size());
+  for (auto const& cons : copy->trip_to_connections_) {
+    for (auto const c : cons) {
+      EXPECT_TRUE(in_copy(c));
+    }
+  }
+  for (auto i = 0U; i != copy->stations_.size(); ++i) {
+    EXPECT_EQ(read->stations_[i].outgoing_connections_.size(),
+              copy->stations_[i].outgoing_connections_.size());
+    for (auto const c : copy->stations_[i].outgoing_connections_) {
+      EXPECT_TRUE(in_copy(c));
+    }
+  }
+}
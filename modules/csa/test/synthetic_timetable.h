@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "utl/to_vec.h"
+
+#include "motis/core/schedule/station.h"
+#include "motis/core/schedule/time.h"
+
+#include "motis/csa/build_csa_timetable.h"
+#include "motis/csa/csa_timetable.h"
+
+namespace motis::csa {
+
+// Random timetable without a schedule (no light connections, no trips in the
+// schedule sense): trips with 2 to 20 stops between random stations,
+// departures between 04:00 and 24:00 of the first schedule day and two
+// random footpaths per station. Only suitable for the arrival time searches
+// (no journey reconstruction).
+struct synthetic_timetable {
+  synthetic_timetable(unsigned const station_count, unsigned const trip_count,
+                      bool const connection_arrays, unsigned const seed) {
+    std::mt19937 rng{seed};
+
+    stations_.resize(station_count);
+    for (auto i = 0U; i < station_count; ++i) {
+      stations_[i].index_ = i;
+      stations_[i].transfer_time_ = static_cast<motis::time>(2U + rng() % 4U);
+    }
+    tt_.stations_ = utl::to_vec(
+        stations_, [](station const& s) { return csa_station{&s}; });
+
+    for (auto from = 0U; from < station_count; ++from) {
+      for (auto i = 0U; i < 2U; ++i) {
+        auto const to = static_cast<station_id>(rng() % station_count);
+        auto const duration = static_cast<motis::time>(3U + rng() % 10U);
+        if (to != from) {
+          tt_.stations_[from].footpaths_.push_back({from, to, duration});
+          tt_.stations_[to].incoming_footpaths_.push_back(
+              {from, to, duration});
+        }
+      }
+    }
+
+    for (auto trip = 0U; trip < trip_count; ++trip) {
+      auto const stop_count = 2U + rng() % 19U;
+      auto t = static_cast<motis::time>(SCHEDULE_OFFSET_MINUTES + 240U +
+                                        rng() % 1200U);
+      auto from = static_cast<station_id>(rng() % station_count);
+      for (auto i = 0U; i + 1U < stop_count; ++i) {
+        auto to = static_cast<station_id>(rng() % station_count);
+        if (to == from) {
+          to = (to + 1U) % station_count;
+        }
+        auto const arr = static_cast<motis::time>(t + 1U + rng() % 20U);
+        tt_.fwd_connections_.emplace_back(
+            from, to, t, arr, 0U, trip, static_cast<con_idx_t>(i), true, true,
+            service_class::OTHER, nullptr);
+        t = static_cast<motis::time>(arr + rng() % 5U);
+        from = to;
+      }
+    }
+    tt_.trip_count_ = trip_count;
+
+    // same order as build_csa_timetable
+    std::stable_sort(begin(tt_.fwd_connections_), end(tt_.fwd_connections_),
+                     [](csa_connection const& a, csa_connection const& b) {
+                       return a.departure_ < b.departure_;
+                     });
+    tt_.bwd_connections_ = tt_.fwd_connections_;
+    std::reverse(begin(tt_.bwd_connections_), end(tt_.bwd_connections_));
+    std::stable_sort(begin(tt_.bwd_connections_), end(tt_.bwd_connections_),
+                     [](csa_connection const& a, csa_connection const& b) {
+                       return a.arrival_ > b.arrival_;
+                     });
+
+    finish_csa_timetable(tt_, connection_arrays);
+  }
+
+  synthetic_timetable(synthetic_timetable const&) = delete;
+  synthetic_timetable& operator=(synthetic_timetable const&) = delete;
+
+  std::vector<station> stations_;  // referenced by tt_.stations_
+  csa_timetable tt_;
+};
+
+}  // namespace motis::csa
@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt_short;
+
+struct csa_target_pruning : public motis_instance_test {
+  csa_target_pruning()
+      : motis::test::motis_instance_test(dataset_opt_short, {"csa"}) {}
+
+  msg_ptr ontrip_request(std::string const& from, std::string const& to,
+                         int const start_time, SearchDir const dir,
+                         bool const target_pruning) const {
+    message_creator fbb;
+    fbb.create_and_finish(
+        MsgContent_RoutingRequest,
+        CreateRoutingRequest(
+            fbb, Start_OntripStationStart,
+            CreateOntripStationStart(
+                fbb,
+                CreateInputStation(fbb, fbb.CreateString(from),
+                                   fbb.CreateString("")),
+                unix_time(start_time))
+                .Union(),
+            CreateInputStation(fbb, fbb.CreateString(to), fbb.CreateString("")),
+            SearchType_Default, dir,
+            fbb.CreateVector(std::vector<Offset<Via>>()),
+            fbb.CreateVector(std::vector<Offset<AdditionalEdgeWrapper>>()),
+            true, true, true, 0U, target_pruning)
+            .Union(),
+        "/csa");
+    return make_msg(fbb);
+  }
+
+  void check(std::string const& from, std::string const& to,
+             int const start_time, SearchDir const dir) {
+    auto const full = call(ontrip_request(from, to, start_time, dir, false));
+    auto const pruned = call(ontrip_request(from, to, start_time, dir, true));
+
+    auto const expected = get_journeys(full);
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, get_journeys(pruned));
+
+    EXPECT_EQ(0U, get_stat(full, "csa", "connections_skipped"));
+    EXPECT_LT(0U, get_stat(pruned, "csa", "connections_skipped"));
+    EXPECT_GT(get_stat(full, "csa", "connections_scanned"),
+              get_stat(pruned, "csa", "connections_scanned"));
+  }
+};
+
+TEST_F(csa_target_pruning, same_results_fwd) {
+  check("8000031", "8000105", 1400, SearchDir_Forward);
+}
+
+TEST_F(csa_target_pruning, same_results_bwd) {
+  check("8000105", "8000031", 1445, SearchDir_Backward);
+}
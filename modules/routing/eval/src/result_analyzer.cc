@@ -237,6 +237,48 @@ int main(int argc, char* argv[]) {
             << "       counted: " << count << "\n"
             << std::endl;
 
+  // label throughput of the search itself (e.g. to compare graph layouts)
+  if (auto const routing = categories.find("routing");
+      routing != end(categories)) {
+    auto const& stats = routing->second.stats_;
+    auto const labels = stats.find("labels_created");
+    auto const search_time = stats.find("pareto_dijkstra");
+    if (labels != end(stats) && search_time != end(stats) &&
+        search_time->second.sum_ != 0U) {
+      std::cout << "      labels/s: "
+                << static_cast<uint64_t>(1000.0 * labels->second.sum_ /
+                                         search_time->second.sum_)
+                << "\n"
+                << std::endl;
+    }
+  }
+
+  // connection scan throughput (e.g. to compare CSA timetable layouts)
+  if (auto const csa = categories.find("csa"); csa != end(categories)) {
+    auto const& stats = csa->second.stats_;
+    auto const connections = stats.find("connections_scanned");
+    auto const search_time = stats.find("search_duration_us");
+    if (connections != end(stats) && search_time != end(stats) &&
+        search_time->second.sum_ != 0U) {
+      std::cout << " connections/s: "
+                << static_cast<uint64_t>(1000000.0 * connections->second.sum_ /
+                                         search_time->second.sum_)
+                << "\n"
+                << std::endl;
+    }
+
+    // label throughput of the price searches (/csa/cpu/price*)
+    auto const labels = stats.find("labels_created");
+    if (labels != end(stats) && labels->second.sum_ != 0U &&
+        search_time != end(stats) && search_time->second.sum_ != 0U) {
+      std::cout << "      labels/s: "
+                << static_cast<uint64_t>(1000000.0 * labels->second.sum_ /
+                                         search_time->second.sum_)
+                << "\n"
+                << std::endl;
+    }
+  }
+
   if (filtered_categories.empty()) {
     for (auto& c : categories) {
       print_category(c.second, count, !long_output, top);
@@ -1,16 +1,19 @@
 #pragma once
 
+#include <cassert>
+#include <iterator>
 #include <numeric>
 #include <vector>
 
-#include "utl/parser/buffer.h"
+#include "motis/routing/arena_block.h"
 
 namespace motis::routing {
 
 struct allocator {
-  explicit allocator(size_t const initial_size) {
-    mem_.emplace_back(utl::buffer(initial_size));
-    clear();
+  explicit allocator(size_t const initial_size, bool const huge_pages = false)
+      : huge_pages_{huge_pages} {
+    mem_.emplace_back(initial_size, huge_pages_);
+    clear(0U);
   }
 
   ~allocator() = default;
@@ -31,8 +34,7 @@ struct allocator {
       next_ptr_ += size;
       return mem_ptr;
     } else {
-      mem_.emplace_back(utl::buffer{mem_.back().size_ * 2});
-      set_range();
+      next_block();
       assert(next_ptr_ + size < end_ptr_);
       auto const mem_ptr = next_ptr_;
       next_ptr_ += size;
@@ -40,26 +42,59 @@ struct allocator {
     }
   }
 
-  inline void clear() {
+  // Blocks are kept for the next search as long as their total size does not
+  // exceed keep_bytes (the first block is always kept). Released blocks are
+  // returned to the operating system.
+  inline void clear(size_t const keep_bytes) {
     list_.next_ = nullptr;
-    mem_.resize(1);
+
+    auto keep = std::size_t{1U};
+    auto kept_bytes = mem_.front().size();
+    while (keep < mem_.size() &&
+           kept_bytes + mem_[keep].size() <= keep_bytes) {
+      kept_bytes += mem_[keep].size();
+      ++keep;
+    }
+    mem_.erase(std::next(begin(mem_), static_cast<long>(keep)), end(mem_));
+
+    current_ = 0U;
     set_range();
   }
 
+  // Size of the blocks used by the current search.
   inline size_t get_num_bytes_in_use() const {
+    return std::accumulate(
+        begin(mem_), std::next(begin(mem_), static_cast<long>(current_) + 1),
+        size_t{0U}, [](size_t const sum, arena_block const& block) {
+          return sum + block.size();
+        });
+  }
+
+  // Size of all blocks (including blocks kept from former searches).
+  inline size_t get_num_bytes_reserved() const {
     return std::accumulate(begin(mem_), end(mem_), size_t{0U},
-                           [](size_t const sum, utl::buffer const& buf) {
-                             return sum + buf.size_;
+                           [](size_t const sum, arena_block const& block) {
+                             return sum + block.size();
                            });
   }
 
 private:
+  inline void next_block() {
+    if (current_ + 1U == mem_.size()) {
+      mem_.emplace_back(mem_.back().size() * 2, huge_pages_);
+    }
+    ++current_;
+    set_range();
+  }
+
   inline void set_range() {
-    next_ptr_ = mem_.back().begin();
-    end_ptr_ = mem_.back().end();
+    next_ptr_ = mem_[current_].begin();
+    end_ptr_ = mem_[current_].end();
   }
 
-  std::vector<utl::buffer> mem_;
+  bool huge_pages_;
+  std::vector<arena_block> mem_;
+  std::size_t current_{0U};
   unsigned char* next_ptr_{nullptr};
   unsigned char* end_ptr_{nullptr};
 
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+namespace motis::routing {
+
+// Memory block of the label store.
+// On Linux, blocks are anonymous memory mappings: they are returned to the
+// operating system as soon as they are released (independent of the malloc
+// implementation) and can be backed by huge pages. Huge pages are requested
+// with MAP_HUGETLB (reserved huge pages) with a fallback to transparent
+// huge pages (madvise). Other platforms use malloc.
+struct arena_block {
+  static constexpr auto const HUGE_PAGE_SIZE = std::size_t{2U} << 20U;
+
+  arena_block(std::size_t size, bool huge_pages);
+  ~arena_block();
+
+  arena_block(arena_block const&) = delete;
+  arena_block& operator=(arena_block const&) = delete;
+
+  arena_block(arena_block&&) noexcept;
+  arena_block& operator=(arena_block&&) noexcept;
+
+  unsigned char* begin() const { return mem_; }
+  unsigned char* end() const { return mem_ + size_; }
+  std::size_t size() const { return size_; }
+
+private:
+  void release();
+
+  unsigned char* mem_{nullptr};
+  std::size_t size_{0U};
+};
+
+}  // namespace motis::routing
@@ -12,11 +12,16 @@
 #include "motis/routing/label/filter.h"
 #include "motis/routing/label/initializer.h"
 #include "motis/routing/label/label.h"
+#include "motis/routing/label/pareto_bag.h"
 #include "motis/routing/label/tie_breakers.h"
 #include "motis/routing/label/updater.h"
 
 namespace motis::routing {
 
+// The soa_bag keys of a label have to reflect its (non post search) dominance.
+// Labels with dominance criteria that cannot be expressed as keys (e.g.
+// late_connections) use the default label_list_bag.
+
 template <search_dir Dir>
 using default_label =
     label<Dir, MAX_TRAVEL_TIME, false, get_travel_time_lb,
@@ -28,7 +33,8 @@ using default_label =
           dominance<absurdity_tb, travel_time_dominance, transfers_dominance>,
           dominance<absurdity_post_search_tb, travel_time_alpha_dominance,
                     transfers_dominance>,
-          comparator<transfers_dominance>>;
+          comparator<transfers_dominance>,
+          soa_bag<travel_time_key, transfers_key, absurdity_key>>;
 
 template <search_dir Dir>
 using default_simple_label = label<
@@ -39,14 +45,15 @@ using default_simple_label = label<
     filter<travel_time_filter, transfers_filter>,
     dominance<default_tb, travel_time_dominance, transfers_dominance>,
     dominance<post_search_tb, travel_time_alpha_dominance, transfers_dominance>,
-    comparator<transfers_dominance>>;
+    comparator<transfers_dominance>, soa_bag<travel_time_key, transfers_key>>;
 
 template <search_dir Dir>
 using single_criterion_label =
     label<Dir, MAX_WEIGHTED, false, get_weighted_lb, label_data<weighted>,
           initializer<weighted_initializer>, updater<weighted_updater>,
           filter<weighted_filter>, dominance<default_tb, weighted_dominance>,
-          dominance<post_search_tb>, comparator<weighted_dominance>>;
+          dominance<post_search_tb>, comparator<weighted_dominance>,
+          soa_bag<weighted_key>>;
 
 template <search_dir Dir>
 using single_criterion_no_intercity_label =
@@ -54,7 +61,7 @@ using single_criterion_no_intercity_label =
           initializer<weighted_initializer>, updater<weighted_updater>,
           filter<weighted_filter, no_intercity_filter>,
           dominance<default_tb, weighted_dominance>, dominance<post_search_tb>,
-          comparator<weighted_dominance>>;
+          comparator<weighted_dominance>, soa_bag<weighted_key>>;
 
 template <search_dir Dir>
 using late_connections_label = label<
@@ -98,6 +105,8 @@ using accessibility_label =
                     accessibility_dominance>,
           dominance<absurdity_post_search_tb, travel_time_alpha_dominance,
                     transfers_dominance, accessibility_dominance>,
-          comparator<transfers_dominance, accessibility_dominance>>;
+          comparator<transfers_dominance, accessibility_dominance>,
+          soa_bag<travel_time_key, transfers_key, accessibility_key,
+                  absurdity_key>>;
 
 }  // namespace motis::routing
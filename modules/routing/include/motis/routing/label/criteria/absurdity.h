@@ -39,4 +39,12 @@ struct absurdity_updater {
   }
 };
 
+// absurdity_tb
+struct absurdity_key {
+  template <typename Label>
+  static uint8_t get(Label const& l) {
+    return l.absurdity_;
+  }
+};
+
 }  // namespace motis::routing
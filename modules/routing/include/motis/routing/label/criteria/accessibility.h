@@ -45,4 +45,11 @@ struct accessibility_dominance {
   }
 };
 
+struct accessibility_key {
+  template <typename Label>
+  static uint16_t get(Label const& l) {
+    return l.accessibility_;
+  }
+};
+
 }  // namespace motis::routing
@@ -57,6 +57,13 @@ struct transfers_dominance {
   }
 };
 
+struct transfers_key {
+  template <typename Label>
+  static uint8_t get(Label const& l) {
+    return l.transfers_lb_;
+  }
+};
+
 struct transfers_filter {
   template <typename Label>
   static bool is_filtered(Label const& l) {
@@ -60,6 +60,13 @@ struct travel_time_dominance {
   }
 };
 
+struct travel_time_key {
+  template <typename Label>
+  static duration get(Label const& l) {
+    return l.travel_time_lb_;
+  }
+};
+
 struct travel_time_alpha_dominance {
   template <typename Label>
   struct domination_info {
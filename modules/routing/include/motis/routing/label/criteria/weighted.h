@@ -71,6 +71,13 @@ struct weighted_dominance {
   }
 };
 
+struct weighted_key {
+  template <typename Label>
+  static duration get(Label const& l) {
+    return l.weighted_lb_;
+  }
+};
+
 struct weighted_filter {
   template <typename Label>
   static bool is_filtered(Label const& l) {
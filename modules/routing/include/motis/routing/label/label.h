@@ -1,6 +1,7 @@
 #pragma once
 
 #include "motis/core/schedule/edges.h"
+#include "motis/routing/label/pareto_bag.h"
 #include "motis/routing/lower_bounds.h"
 
 namespace motis::routing {
@@ -11,13 +12,17 @@ struct label_data : public DataClass... {};
 template <search_dir Dir, std::size_t MaxBucket,
           bool PostSearchDominanceEnabled, typename GetBucket, typename Data,
           typename Init, typename Updater, typename Filter, typename Dominance,
-          typename PostSearchDominance, typename Comparator>
+          typename PostSearchDominance, typename Comparator,
+          typename NodeBag = label_list_bag>
 struct label : public Data {  // NOLINT
   enum : std::size_t { MAX_BUCKET = MaxBucket };
 
+  using node_bag = typename NodeBag::template bag<label>;
+
   label() = default;  // NOLINT
 
-  label(edge const* e, label* pred, time now, lower_bounds& lb,
+  template <typename LowerBounds>
+  label(edge const* e, label* pred, time now, LowerBounds& lb,
         light_connection const* lcon = nullptr)
       : pred_(pred),
         edge_(e),
@@ -32,7 +37,8 @@ struct label : public Data {  // NOLINT
 
   template <typename Edge, typename LowerBounds>
   bool create_label(label& l, Edge const& e, LowerBounds& lb, bool no_cost,
-                    int additional_time_cost = 0) {
+                    int additional_time_cost = 0,
+                    route_edge_indices const* indices = nullptr) {
     if (pred_ && e.template get_destination<Dir>() == pred_->get_node()) {
       return false;
     }
@@ -42,7 +48,7 @@ struct label : public Data {  // NOLINT
       return false;
     }
 
-    auto ec = e.template get_edge_cost<Dir>(now_, connection_);
+    auto ec = e.template get_edge_cost<Dir>(now_, connection_, indices);
     if (!ec.is_valid()) {
       return false;
     }
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace motis::routing {
+
+// Label set of one node stored as a list of label pointers.
+// Every dominance check dereferences both labels.
+struct label_list_bag {
+  template <typename Label>
+  struct bag {
+    void push(Label* l) { labels_.emplace_back(l); }
+
+    bool add(Label* new_label) {
+      for (auto it = labels_.begin(); it != labels_.end();) {
+        Label* o = *it;
+        if (o->dominates(*new_label)) {
+          return false;
+        }
+
+        if (new_label->dominates(*o)) {
+          it = labels_.erase(it);
+          o->dominated_ = true;
+        } else {
+          ++it;
+        }
+      }
+
+      // it is very important for the performance to push front here
+      // because earlier labels tend not to dominate later ones (not comparable)
+      labels_.insert(std::begin(labels_), new_label);
+      return true;
+    }
+
+    void clear() { labels_.clear(); }
+
+    std::size_t size() const { return labels_.size(); }
+
+    std::vector<Label*> labels_;
+  };
+};
+
+// A label can only dominate labels with an interval [begin, end] containing
+// its own interval (see label::incomparable).
+struct current_begin_key {
+  template <typename Label>
+  static uint16_t get(Label const& l) {
+    return std::numeric_limits<uint16_t>::max() - l.current_begin();
+  }
+};
+
+struct current_end_key {
+  template <typename Label>
+  static uint16_t get(Label const& l) {
+    return l.current_end();
+  }
+};
+
+// Label set of one node stored as structure of arrays: one array per
+// dominance criterion plus one array with the label pointers.
+//
+// Each key maps a label to an unsigned value such that a label a can only
+// dominate a label b if key(a) <= key(b). The keys have to describe the
+// (non post search) dominance of the label exactly: a dominates b iff
+// key(a) <= key(b) holds for all keys. Thereby, dominance checks are a
+// sequence of element wise compares over contiguous arrays that the compiler
+// can vectorize. Label pointers are only dereferenced for dominated labels.
+template <typename... Keys>
+struct soa_bag {
+  template <typename Label>
+  struct bag {
+    using value_t = uint16_t;
+
+    static constexpr auto const KEY_COUNT = 2U + sizeof...(Keys);
+    static constexpr auto const BLOCK_SIZE = std::size_t{32U};
+
+    using row_t = std::array<value_t, KEY_COUNT>;
+    using mask_t = std::array<uint8_t, BLOCK_SIZE>;
+
+    void push(Label* l) { push(get_row(*l), l); }
+
+    bool add(Label* new_label) {
+      auto const row = get_row(*new_label);
+      if (is_dominated(row)) {
+        return false;
+      }
+      remove_dominated(row);
+      push(row, new_label);
+      return true;
+    }
+
+    void clear() {
+      for (auto& v : values_) {
+        v.clear();
+      }
+      labels_.clear();
+    }
+
+    std::size_t size() const { return labels_.size(); }
+
+    static row_t get_row(Label const& l) {
+      return {current_begin_key::get(l), current_end_key::get(l),
+              static_cast<value_t>(Keys::get(l))...};
+    }
+
+    std::array<std::vector<value_t>, KEY_COUNT> values_;
+    std::vector<Label*> labels_;
+
+  private:
+    void push(row_t const& row, Label* l) {
+      for (auto k = 0U; k < KEY_COUNT; ++k) {
+        values_[k].push_back(row[k]);
+      }
+      labels_.push_back(l);
+    }
+
+    bool is_dominated(row_t const& row) const {
+      auto const size = labels_.size();
+      for (auto begin = std::size_t{0U}; begin < size; begin += BLOCK_SIZE) {
+        auto const n = std::min(BLOCK_SIZE, size - begin);
+
+        mask_t dominates;
+        dominates.fill(1U);
+        for (auto k = 0U; k < KEY_COUNT; ++k) {
+          auto const* v = values_[k].data() + begin;
+          auto const r = row[k];
+          for (auto i = std::size_t{0U}; i < n; ++i) {
+            dominates[i] &= static_cast<uint8_t>(v[i] <= r);
+          }
+        }
+
+        uint8_t any = 0U;
+        for (auto i = std::size_t{0U}; i < n; ++i) {
+          any |= dominates[i];
+        }
+        if (any != 0U) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Removes all labels dominated by row (stable compaction).
+    void remove_dominated(row_t const& row) {
+      auto const size = labels_.size();
+      auto write = std::size_t{0U};
+      for (auto begin = std::size_t{0U}; begin < size; begin += BLOCK_SIZE) {
+        auto const n = std::min(BLOCK_SIZE, size - begin);
+
+        mask_t dominated;
+        dominated.fill(1U);
+        for (auto k = 0U; k < KEY_COUNT; ++k) {
+          auto const* v = values_[k].data() + begin;
+          auto const r = row[k];
+          for (auto i = std::size_t{0U}; i < n; ++i) {
+            dominated[i] &= static_cast<uint8_t>(r <= v[i]);
+          }
+        }
+
+        for (auto i = std::size_t{0U}; i < n; ++i) {
+          auto const idx = begin + i;
+          if (dominated[i] != 0U) {
+            labels_[idx]->dominated_ = true;
+          } else {
+            if (write != idx) {
+              for (auto k = 0U; k < KEY_COUNT; ++k) {
+                values_[k][write] = values_[k][idx];
+              }
+              labels_[write] = labels_[idx];
+            }
+            ++write;
+          }
+        }
+      }
+
+      if (write != size) {
+        for (auto& v : values_) {
+          v.resize(write);
+        }
+        labels_.resize(write);
+      }
+    }
+  };
+};
+
+}  // namespace motis::routing
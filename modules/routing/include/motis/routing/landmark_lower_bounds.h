@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cassert>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "motis/core/schedule/constant_graph.h"
+#include "motis/core/schedule/schedule.h"
+
+#include "motis/routing/label/criteria/transfers.h"
+#include "motis/routing/label/criteria/travel_time.h"
+#include "motis/routing/landmarks.h"
+
+namespace motis::routing {
+
+// Drop-in replacement for constant_graph_dijkstra using the triangle
+// inequality with precomputed landmark distances (ALT):
+//   d(goal, n) >= d(landmark, n) - d(landmark, goal)
+//   d(goal, n) >= d(goal, landmark) - d(n, landmark)
+// run() only aggregates the landmark distances of the goal set.
+template <uint32_t MaxValue, typename Dist, typename MapNodeFn>
+class landmark_bound {
+public:
+  using dist_t = uint32_t;
+  using distances = landmark_distances<Dist>;
+
+  enum : dist_t { UNREACHABLE = std::numeric_limits<dist_t>::max() };
+
+  landmark_bound(distances const& dists, uint32_t landmark_count,
+                 std::vector<int> const& goals,
+                 MapNodeFn map_node = MapNodeFn())
+      : dists_(dists),
+        landmark_count_(landmark_count),
+        goals_(goals),
+        map_node_(std::forward<MapNodeFn>(map_node)) {}
+
+  void run() {
+    goal_info_.resize(landmark_count_);
+    for (auto i = 0U; i < landmark_count_; ++i) {
+      auto& info = goal_info_[i];
+      for (auto const goal : goals_) {
+        auto const idx = static_cast<std::size_t>(goal) * landmark_count_ + i;
+
+        auto const from = dists_.from_landmark_[idx];
+        if (from == distances::UNREACHABLE) {
+          info.goals_reachable_from_landmark_ = false;
+          info.from_landmark_usable_ = false;
+        } else if (from == distances::UNKNOWN) {
+          info.from_landmark_usable_ = false;
+        } else {
+          info.max_from_landmark_ = std::max(info.max_from_landmark_,
+                                             static_cast<dist_t>(from));
+        }
+
+        auto const to = dists_.to_landmark_[idx];
+        if (to != distances::UNREACHABLE) {
+          info.landmark_reachable_from_goals_ = true;
+          if (to == distances::UNKNOWN) {
+            info.to_landmark_usable_ = false;
+          } else {
+            info.min_to_landmark_ =
+                std::min(info.min_to_landmark_, static_cast<dist_t>(to));
+          }
+        }
+      }
+    }
+  }
+
+  inline dist_t operator[](node const* n) const {
+    auto const idx = static_cast<std::size_t>(map_node_(n)) * landmark_count_;
+    assert(idx + landmark_count_ <= dists_.from_landmark_.size());
+
+    auto const from = &dists_.from_landmark_[idx];
+    auto const to = &dists_.to_landmark_[idx];
+    dist_t bound = 0U;
+    for (auto i = 0U; i < landmark_count_; ++i) {
+      auto const& info = goal_info_[i];
+
+      if (from[i] == distances::UNREACHABLE) {
+        if (info.goals_reachable_from_landmark_) {
+          return UNREACHABLE;
+        }
+      } else if (from[i] != distances::UNKNOWN && info.from_landmark_usable_ &&
+                 from[i] > info.max_from_landmark_) {
+        bound = std::max(bound, from[i] - info.max_from_landmark_);
+      }
+
+      if (to[i] != distances::UNREACHABLE) {
+        if (!info.landmark_reachable_from_goals_) {
+          return UNREACHABLE;
+        } else if (to[i] != distances::UNKNOWN && info.to_landmark_usable_ &&
+                   info.min_to_landmark_ > to[i]) {
+          bound = std::max(bound, info.min_to_landmark_ - to[i]);
+        }
+      }
+    }
+    return bound <= MaxValue ? bound : UNREACHABLE;
+  }
+
+  inline bool is_reachable(dist_t val) const { return val != UNREACHABLE; }
+
+private:
+  struct goal_info {
+    dist_t max_from_landmark_{0U};
+    dist_t min_to_landmark_{UNREACHABLE};
+    bool from_landmark_usable_{true};
+    bool to_landmark_usable_{true};
+    bool goals_reachable_from_landmark_{true};
+    bool landmark_reachable_from_goals_{false};
+  };
+
+  distances const& dists_;
+  uint32_t landmark_count_;
+  std::vector<int> const& goals_;
+  std::vector<goal_info> goal_info_;
+  MapNodeFn map_node_;
+};
+
+struct landmark_lower_bounds {
+  landmark_lower_bounds(schedule const& sched, landmarks const& lm,
+                        search_dir const dir, std::vector<int> const& goals)
+      : travel_time_(dir == search_dir::FWD ? lm.travel_time_fwd_
+                                            : lm.travel_time_bwd_,
+                     lm.landmark_count_, goals),
+        transfers_(
+            dir == search_dir::FWD ? lm.transfers_fwd_ : lm.transfers_bwd_,
+            lm.landmark_count_, goals,
+            map_interchange_graph_node(sched.station_nodes_.size())) {}
+
+  landmark_bound<MAX_TRAVEL_TIME, uint16_t, map_station_graph_node>
+      travel_time_;
+  landmark_bound<MAX_TRANSFERS, uint8_t, map_interchange_graph_node>
+      transfers_;
+};
+
+}  // namespace motis::routing
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "cista/hash.h"
+#include "cista/memory_holder.h"
+
+#include "motis/memory.h"
+#include "motis/vector.h"
+
+#include "motis/core/schedule/schedule.h"
+
+namespace motis::routing {
+
+// Distances between all nodes of one constant graph and the landmarks.
+// Stored node-major (node * landmark_count + landmark) so that evaluating the
+// bound of a single node touches only one cache line.
+template <typename Dist>
+struct landmark_distances {
+  static constexpr Dist UNREACHABLE = std::numeric_limits<Dist>::max();
+
+  // Distance exists but does not fit into Dist.
+  static constexpr Dist UNKNOWN = UNREACHABLE - 1;
+
+  mcd::vector<Dist> from_landmark_;  // d(landmark, node)
+  mcd::vector<Dist> to_landmark_;  // d(node, landmark)
+};
+
+struct landmarks {
+  cista::hash_t schedule_hash_{0U};
+  uint32_t constant_graph_version_{0U};
+  uint32_t requested_landmark_count_{0U};  // configured, >= landmark_count_
+  uint32_t landmark_count_{0U};  // selected
+  mcd::vector<uint32_t> stations_;
+  landmark_distances<uint16_t> travel_time_fwd_, travel_time_bwd_;
+  landmark_distances<uint8_t> transfers_fwd_, transfers_bwd_;
+};
+
+// Landmark distances are only valid as long as the constant graphs were not
+// modified by realtime updates (rt module).
+inline bool is_up_to_date(landmarks const& lm, schedule const& sched) {
+  return lm.schedule_hash_ == sched.hash_ &&
+         lm.constant_graph_version_ == sched.constant_graph_version_;
+}
+
+mcd::unique_ptr<landmarks> build_landmarks(schedule const&,
+                                           unsigned landmark_count);
+
+mcd::unique_ptr<landmarks> read_landmarks(std::string const& path,
+                                          cista::memory_holder&);
+
+void write_landmarks(std::string const& path, landmarks const&);
+
+}  // namespace motis::routing
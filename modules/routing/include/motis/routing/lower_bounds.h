@@ -2,8 +2,7 @@
 
 #include <vector>
 
-#include "motis/hash_map.h"
-
+#include "motis/core/common/overlay_edges.h"
 #include "motis/core/schedule/constant_graph.h"
 #include "motis/core/schedule/schedule.h"
 
@@ -17,10 +16,8 @@ struct lower_bounds {
                constant_graph const& travel_time_graph,
                constant_graph const& transfers_graph,  //
                std::vector<int> const& goals,
-               mcd::hash_map<unsigned, std::vector<simple_edge>> const&
-                   additional_travel_time_edges,
-               mcd::hash_map<unsigned, std::vector<simple_edge>> const&
-                   additional_transfers_edges)
+               overlay_edges<simple_edge> const& additional_travel_time_edges,
+               overlay_edges<simple_edge> const& additional_transfers_edges)
       : travel_time_(travel_time_graph, goals, additional_travel_time_edges),
         transfers_(transfers_graph, goals, additional_transfers_edges,
                    map_interchange_graph_node(sched.station_nodes_.size())) {}
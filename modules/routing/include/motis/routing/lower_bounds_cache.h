@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "cista/hash.h"
+
+#include "motis/core/schedule/schedule.h"
+
+#include "motis/routing/search.h"
+
+namespace motis::routing {
+
+// Bounded LRU cache of destination lower bounds (see shared_lower_bounds).
+// Entries are only valid for the constant graphs they were computed on:
+// the cache is cleared as soon as the schedule hash or the constant graph
+// version (incremented by the rt module) changes.
+struct lower_bounds_cache {
+  explicit lower_bounds_cache(std::size_t max_size);
+
+  // Returns the lower bounds for the given goals (computed on a miss) and
+  // whether they were found in the cache.
+  std::pair<std::shared_ptr<shared_lower_bounds>, bool> get(
+      schedule const&, search_dir, std::vector<int> const& goals);
+
+  uint64_t hits() const;
+  uint64_t misses() const;
+
+private:
+  using key_t = std::pair<search_dir, std::vector<int>>;
+  using entry_t = std::pair<key_t, std::shared_ptr<shared_lower_bounds>>;
+
+  void invalidate_outdated(schedule const&);
+
+  mutable std::mutex mutex_;
+  std::size_t max_size_;
+  cista::hash_t schedule_hash_{0U};
+  uint32_t constant_graph_version_{0U};
+  std::list<entry_t> lru_;  // most recently used first
+  std::map<key_t, std::list<entry_t>::iterator> entries_;
+  uint64_t hits_{0U}, misses_{0U};
+};
+
+}  // namespace motis::routing
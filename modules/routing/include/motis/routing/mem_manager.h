@@ -3,6 +3,9 @@
 #include <cassert>
 #include <cstdlib>
 #include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
 
 #include "motis/routing/allocator.h"
 
@@ -10,8 +13,9 @@ namespace motis::routing {
 
 struct mem_manager {
 public:
-  explicit mem_manager(std::size_t const initial_size)
-      : allocations_(0), alloc_(initial_size) {}
+  explicit mem_manager(std::size_t const initial_size,
+                       bool const huge_pages = false)
+      : allocations_(0), alloc_(initial_size, huge_pages) {}
 
   mem_manager(mem_manager const&) = delete;
   mem_manager& operator=(mem_manager const&) = delete;
@@ -21,12 +25,23 @@ public:
 
   ~mem_manager() = default;
 
-  void reset() {
+  // Keeps up to keep_bytes of label memory (at least the initial block) for
+  // the next search. If the search needed more, the node label sets are
+  // released as well (unless keep_bytes is 0).
+  // Returns whether memory was released.
+  bool reset(std::size_t const keep_bytes = 0U) {
     allocations_ = 0;
-    alloc_.clear();
-    for (auto& labels : node_labels_) {
-      labels.clear();
+    auto const reserved = alloc_.get_num_bytes_reserved();
+    alloc_.clear(keep_bytes);
+    auto const trim = alloc_.get_num_bytes_reserved() != reserved;
+    if (trim && keep_bytes != 0U) {
+      node_bags_.clear();
+    } else {
+      for (auto& bags : node_bags_) {
+        bags.second->clear();
+      }
     }
+    return trim;
   }
 
   template <typename T, typename... Args>
@@ -41,20 +56,52 @@ public:
     alloc_.dealloc(ptr);
   }
 
-  template <typename T>
-  std::vector<std::vector<T*>>* get_node_labels(std::size_t size) {
-    node_labels_.resize(size);
-    return reinterpret_cast<std::vector<std::vector<T*>>*>(&node_labels_);
+  template <typename Bag>
+  std::vector<Bag>* get_node_bags(std::size_t size) {
+    auto& bags = node_bags_[std::type_index(typeid(Bag))];
+    if (!bags) {
+      bags = std::make_unique<node_bags<Bag>>();
+    }
+    auto& v = static_cast<node_bags<Bag>*>(bags.get())->bags_;
+    v.resize(size);
+    return &v;
   }
 
   size_t allocations() const { return allocations_; }
 
   size_t get_num_bytes_in_use() const { return alloc_.get_num_bytes_in_use(); }
 
+  size_t get_num_bytes_reserved() const {
+    return alloc_.get_num_bytes_reserved();
+  }
+
 private:
+  struct node_bags_base {
+    node_bags_base() = default;
+    node_bags_base(node_bags_base const&) = delete;
+    node_bags_base& operator=(node_bags_base const&) = delete;
+    node_bags_base(node_bags_base&&) = delete;
+    node_bags_base& operator=(node_bags_base&&) = delete;
+    virtual ~node_bags_base() = default;
+    virtual void clear() = 0;
+  };
+
+  template <typename Bag>
+  struct node_bags : public node_bags_base {
+    void clear() override {
+      for (auto& bag : bags_) {
+        bag.clear();
+      }
+    }
+    std::vector<Bag> bags_;
+  };
+
   size_t allocations_;
   allocator alloc_;
-  std::vector<std::vector<void*>> node_labels_;
+
+  // node label sets are kept between searches (one set per bag type)
+  std::unordered_map<std::type_index, std::unique_ptr<node_bags_base>>
+      node_bags_;
 };
 
 }  // namespace motis::routing
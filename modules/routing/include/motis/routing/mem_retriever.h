@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -9,16 +10,104 @@
 namespace motis::routing {
 
 struct memory {
-  explicit memory(std::size_t bytes) : in_use_(false), mem_(bytes) {}
+  memory(std::size_t bytes, bool huge_pages)
+      : in_use_(false), mem_(bytes, huge_pages) {}
   bool in_use_;
+  std::size_t bytes_reserved_{0U};
   mem_manager mem_;
 };
 
+struct mem_pool_config {
+  // size of the first block of each label store
+  std::size_t initial_size_{0U};
+
+  // label memory kept per label store after a search (0 = first block only)
+  std::size_t high_water_mark_{0U};
+
+  // maximum number of idle label stores (0 = unlimited)
+  std::size_t max_idle_{0U};
+
+  bool huge_pages_{false};
+};
+
+struct mem_pool_stats {
+  std::size_t bytes_reserved_{0U};
+  std::size_t bytes_in_use_{0U};
+  std::size_t peak_bytes_reserved_{0U};
+  std::size_t trims_{0U};
+};
+
+// Label stores of the running searches (i.e. at most one per worker thread)
+// and idle label stores for the next searches. Label stores exceeding the
+// high water mark after a search are trimmed, surplus idle label stores are
+// released.
+struct mem_pool {
+  explicit mem_pool(mem_pool_config const& config) : config_{config} {}
+
+  memory* acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(begin(memory_), end(memory_),
+                           [](auto&& m) { return !m->in_use_; });
+    if (it == end(memory_)) {
+      auto m = std::make_unique<memory>(config_.initial_size_,
+                                        config_.huge_pages_);
+      m->bytes_reserved_ = m->mem_.get_num_bytes_reserved();
+      stats_.bytes_reserved_ += m->bytes_reserved_;
+      update_peak(0U);
+      it = memory_.insert(end(memory_), std::move(m));
+    }
+    auto& m = **it;
+    m.in_use_ = true;
+    stats_.bytes_in_use_ += m.bytes_reserved_;
+    return &m;
+  }
+
+  void release(memory* m) {
+    // measured and trimmed outside the lock: the label store is not shared
+    auto const peak = m->mem_.get_num_bytes_reserved();
+    auto const trimmed = m->mem_.reset(config_.high_water_mark_);
+    auto const reserved = m->mem_.get_num_bytes_reserved();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    update_peak(peak - m->bytes_reserved_);
+    stats_.bytes_in_use_ -= m->bytes_reserved_;
+    stats_.bytes_reserved_ -= m->bytes_reserved_;
+    stats_.trims_ += trimmed ? 1U : 0U;
+    m->in_use_ = false;
+
+    auto const idle = std::count_if(begin(memory_), end(memory_),
+                                    [](auto&& mem) { return !mem->in_use_; });
+    if (config_.max_idle_ != 0U &&
+        static_cast<std::size_t>(idle) > config_.max_idle_) {
+      memory_.erase(std::find_if(begin(memory_), end(memory_),
+                                 [&](auto&& mem) { return mem.get() == m; }));
+    } else {
+      m->bytes_reserved_ = reserved;
+      stats_.bytes_reserved_ += reserved;
+    }
+  }
+
+  mem_pool_stats get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+private:
+  void update_peak(std::size_t const additional_bytes) {
+    stats_.peak_bytes_reserved_ =
+        std::max(stats_.peak_bytes_reserved_,
+                 stats_.bytes_reserved_ + additional_bytes);
+  }
+
+  mem_pool_config config_;
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<memory>> memory_;
+  mem_pool_stats stats_;
+};
+
 struct mem_retriever {
-  mem_retriever(std::mutex& mutex,
-                std::vector<std::unique_ptr<memory>>& mem_pool,
-                std::size_t bytes)
-      : mutex_(mutex), memory_(retrieve(mem_pool, bytes)) {}
+  explicit mem_retriever(mem_pool& pool)
+      : pool_(pool), memory_(pool.acquire()) {}
 
   mem_retriever(mem_retriever const&) = delete;
   mem_retriever& operator=(mem_retriever const&) = delete;
@@ -26,30 +115,12 @@ struct mem_retriever {
   mem_retriever(mem_retriever&&) = delete;
   mem_retriever& operator=(mem_retriever&&) = delete;
 
-  ~mem_retriever() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    memory_->in_use_ = false;
-    memory_->mem_.reset();
-  }
+  ~mem_retriever() { pool_.release(memory_); }
 
   mem_manager& get() { return memory_->mem_; }
 
 private:
-  memory* retrieve(std::vector<std::unique_ptr<memory>>& mem_pool,
-                   std::size_t bytes) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = std::find_if(begin(mem_pool), end(mem_pool),
-                           [](auto&& m) { return !m->in_use_; });
-    if (it == end(mem_pool)) {
-      mem_pool.emplace_back(std::make_unique<memory>(bytes));
-      mem_pool.back()->in_use_ = true;
-      return mem_pool.back().get();
-    }
-    it->get()->in_use_ = true;
-    return it->get();
-  }
-
-  std::mutex& mutex_;
+  mem_pool& pool_;
   memory* memory_;
 };
 
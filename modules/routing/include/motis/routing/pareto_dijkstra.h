@@ -5,9 +5,9 @@
 #include "boost/container/vector.hpp"
 #include "utl/erase_if.h"
 
-#include "motis/hash_map.h"
-
+#include "motis/core/common/deadline.h"
 #include "motis/core/common/dial.h"
+#include "motis/core/common/overlay_edges.h"
 
 #include "motis/routing/mem_manager.h"
 #include "motis/routing/statistics.h"
@@ -18,6 +18,8 @@ const bool FORWARDING = true;
 
 template <search_dir Dir, typename Label, typename LowerBounds>
 struct pareto_dijkstra {
+  using node_bag = typename Label::node_bag;
+
   struct compare_labels {
     bool operator()(Label const* a, Label const* b) const {
       return a->operator<(*b);
@@ -31,20 +33,24 @@ struct pareto_dijkstra {
   pareto_dijkstra(
       int node_count, unsigned int station_node_count,
       boost::container::vector<bool> const& is_goal,
-      mcd::hash_map<node const*, std::vector<edge>> additional_edges,
-      LowerBounds& lower_bounds, mem_manager& label_store)
+      overlay_edges<edge> const& additional_edges, LowerBounds& lower_bounds,
+      mem_manager& label_store,
+      deadline* search_deadline = nullptr,
+      route_edge_indices const* indices = nullptr)
       : is_goal_(is_goal),
         station_node_count_(station_node_count),
-        node_labels_(*label_store.get_node_labels<Label>(node_count)),
-        additional_edges_(std::move(additional_edges)),
+        node_labels_(*label_store.get_node_bags<node_bag>(node_count)),
+        additional_edges_(additional_edges),
         lower_bounds_(lower_bounds),
         label_store_(label_store),
+        deadline_(search_deadline),
+        route_edge_indices_(indices),
         max_labels_(1024 * 1024 * 128) {}
 
   void add_start_labels(std::vector<Label*> const& start_labels) {
     for (auto const& l : start_labels) {
       if (!l->is_filtered()) {
-        node_labels_[l->get_node()->id_].emplace_back(l);
+        node_labels_[l->get_node()->id_].push(l);
         queue_.push(l);
       }
     }
@@ -62,6 +68,12 @@ struct pareto_dijkstra {
         return;
       }
 
+      if (deadline_ != nullptr && deadline_->reached()) {
+        stats_.timeout_quit_ = true;
+        filter_results();
+        return;
+      }
+
       // get best label
       Label* label = nullptr;
       if (!equals_.empty()) {
@@ -95,12 +107,11 @@ struct pareto_dijkstra {
         continue;
       }
 
-      auto it = additional_edges_.find(label->get_node());
-      if (it != std::end(additional_edges_)) {
-        for (auto const& additional_edge : it->second) {
-          create_new_label(label, additional_edge);
-        }
-      }
+      additional_edges_.for_each_edge(
+          label->get_node()->id_,
+          [&](edge const& additional_edge) {
+            create_new_label(label, additional_edge);
+          });
 
       if (Dir == search_dir::FWD) {
         for (auto const& edge : label->get_node()->edges_) {
@@ -128,7 +139,8 @@ private:
         (Dir == search_dir::FWD && edge.type() == edge::EXIT_EDGE &&
          is_goal_[edge.get_source<Dir>()->get_station()->id_]) ||
             (Dir == search_dir::BWD && edge.type() == edge::ENTER_EDGE &&
-             is_goal_[edge.get_source<Dir>()->get_station()->id_]));
+             is_goal_[edge.get_source<Dir>()->get_station()->id_]),
+        0, route_edge_indices_);
     if (!created) {
       return;
     }
@@ -184,25 +196,7 @@ private:
   }
 
   bool add_label_to_node(Label* new_label, node const* dest) {
-    auto& dest_labels = node_labels_[dest->id_];
-    for (auto it = dest_labels.begin(); it != dest_labels.end();) {
-      Label* o = *it;
-      if (o->dominates(*new_label)) {
-        return false;
-      }
-
-      if (new_label->dominates(*o)) {
-        it = dest_labels.erase(it);
-        o->dominated_ = true;
-      } else {
-        ++it;
-      }
-    }
-
-    // it is very important for the performance to push front here
-    // because earlier labels tend not to dominate later ones (not comparable)
-    dest_labels.insert(std::begin(dest_labels), new_label);
-    return true;
+    return node_labels_[dest->id_].add(new_label);
   }
 
   bool dominated_by_results(Label* label) {
@@ -234,13 +228,15 @@ private:
 
   boost::container::vector<bool> const& is_goal_;
   unsigned int station_node_count_;
-  std::vector<std::vector<Label*>>& node_labels_;
+  std::vector<node_bag>& node_labels_;
   dial<Label*, Label::MAX_BUCKET, get_bucket> queue_;
   std::vector<Label*> equals_;
-  mcd::hash_map<node const*, std::vector<edge>> additional_edges_;
+  overlay_edges<edge> const& additional_edges_;
   std::vector<Label*> results_;
   LowerBounds& lower_bounds_;
   mem_manager& label_store_;
+  deadline* deadline_;
+  route_edge_indices const* route_edge_indices_;
   statistics stats_;
   std::size_t max_labels_;
 };
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "motis/core/common/overlay_edges.h"
+#include "motis/core/schedule/constant_graph.h"
+#include "motis/core/schedule/edges.h"
+#include "motis/core/schedule/schedule.h"
+
+namespace motis::routing {
+
+// Query specific edges (search_query::query_edges_) prepared once per query
+// for the search graph (indexed by the node id of the edge source in search
+// direction) and for both lower bound graphs.
+struct query_overlay {
+  query_overlay() = default;
+
+  query_overlay(schedule const& sched, search_dir const dir,
+                std::vector<edge> const& query_edges) {
+    if (query_edges.empty()) {
+      return;
+    }
+
+    std::vector<std::pair<uint32_t, edge>> graph_edges;
+    std::vector<std::pair<uint32_t, simple_edge>> travel_time_edges;
+    std::vector<std::pair<uint32_t, simple_edge>> transfers_edges;
+
+    auto const route_offset =
+        static_cast<uint32_t>(sched.station_nodes_.size());
+    for (auto const& e : query_edges) {
+      auto const from_node = (dir == search_dir::FWD) ? e.from_ : e.to_;
+      auto const to_node = (dir == search_dir::FWD) ? e.to_ : e.from_;
+
+      graph_edges.emplace_back(from_node->id_, e);
+
+      // station graph
+      auto const from_station = from_node->get_station()->id_;
+      auto const to_station = to_node->get_station()->id_;
+
+      // interchange graph
+      auto const from_interchange = from_node->is_route_node()
+                                        ? route_offset + from_node->route_
+                                        : from_station;
+      auto const to_interchange = to_node->is_route_node()
+                                      ? route_offset + to_node->route_
+                                      : to_station;
+
+      auto const ec = e.get_minimum_cost();
+
+      travel_time_edges.emplace_back(to_station,
+                                     simple_edge{from_station, ec.time_});
+      transfers_edges.emplace_back(
+          to_interchange,
+          simple_edge{from_interchange,
+                      static_cast<uint16_t>(ec.transfer_ ? 1 : 0)});
+    }
+
+    graph_ = overlay_edges<edge>{std::move(graph_edges)};
+    travel_time_lb_ = overlay_edges<simple_edge>{std::move(travel_time_edges)};
+    transfers_lb_ = overlay_edges<simple_edge>{std::move(transfers_edges)};
+  }
+
+  overlay_edges<edge> graph_;
+  overlay_edges<simple_edge> travel_time_lb_;
+  overlay_edges<simple_edge> transfers_lb_;
+};
+
+}  // namespace motis::routing
@@ -1,14 +1,22 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
-#include <mutex>
-#include <vector>
+
+#include "cista/memory_holder.h"
+
+#include "motis/memory.h"
 
 #include "motis/module/module.h"
 
 namespace motis::routing {
 
-struct memory;
+struct mem_pool;
+struct landmarks;
+struct lower_bounds_cache;
+struct search_query;
+struct search_result;
+struct RoutingRequest;
 
 struct routing : public motis::module::module {
   routing();
@@ -23,13 +31,32 @@ struct routing : public motis::module::module {
   void init(motis::module::registry&) override;
 
 private:
+  void load_landmarks();
+
   motis::module::msg_ptr ontrip_train(motis::module::msg_ptr const&);
   motis::module::msg_ptr route(motis::module::msg_ptr const&);
+  motis::module::msg_ptr route_batch(motis::module::msg_ptr const&);
+  search_result run_search(RoutingRequest const*, search_query&);
   static motis::module::msg_ptr trip_to_connection(
       motis::module::msg_ptr const&);
 
-  std::mutex mem_pool_mutex_;
-  std::vector<std::unique_ptr<memory>> mem_pool_;
+  unsigned label_store_high_water_mb_{1024U};
+  unsigned label_store_pool_size_{0U};
+  bool huge_pages_{false};
+  std::unique_ptr<mem_pool> mem_pool_;
+
+  unsigned timeout_{0U};
+
+  unsigned lb_cache_size_{0U};
+  std::unique_ptr<lower_bounds_cache> lb_cache_;
+
+  unsigned interval_parts_{0U};
+  unsigned interval_parts_max_searches_{1U};
+  std::atomic<unsigned> active_searches_{0U};
+
+  unsigned landmark_count_{0U};
+  cista::memory_holder landmarks_buf_;
+  mcd::unique_ptr<landmarks> landmarks_;
 };
 
 }  // namespace motis::routing
@@ -1,17 +1,62 @@
 #pragma once
 
-#include "utl/to_vec.h"
+#include <cassert>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
 
-#include "motis/hash_map.h"
+#include "utl/erase_if.h"
+#include "utl/to_vec.h"
 
+#include "motis/core/common/deadline.h"
+#include "motis/core/common/overlay_edges.h"
 #include "motis/core/common/timing.h"
 #include "motis/core/schedule/schedule.h"
+#include "motis/routing/landmark_lower_bounds.h"
+#include "motis/routing/landmarks.h"
 #include "motis/routing/lower_bounds.h"
 #include "motis/routing/output/labels_to_journey.h"
 #include "motis/routing/pareto_dijkstra.h"
+#include "motis/routing/query_overlay.h"
 
 namespace motis::routing {
 
+// Lower bounds for a goal set without query specific edges. Computed once
+// and shared (read only) between queries with the same goals and direction.
+struct shared_lower_bounds {
+  shared_lower_bounds(schedule const& sched, search_dir const dir,
+                      std::vector<int> goals)
+      : goals_(std::move(goals)),
+        lbs_(sched,  //
+             dir == search_dir::FWD ? sched.travel_time_lower_bounds_fwd_
+                                    : sched.travel_time_lower_bounds_bwd_,
+             dir == search_dir::FWD ? sched.transfers_lower_bounds_fwd_
+                                    : sched.transfers_lower_bounds_bwd_,
+             goals_, no_edges_, no_edges_) {
+    lbs_.travel_time_.run();
+    lbs_.transfers_.run();
+  }
+
+  shared_lower_bounds(shared_lower_bounds const&) = delete;
+  shared_lower_bounds& operator=(shared_lower_bounds const&) = delete;
+
+  shared_lower_bounds(shared_lower_bounds&&) = delete;
+  shared_lower_bounds& operator=(shared_lower_bounds&&) = delete;
+
+  ~shared_lower_bounds() = default;
+
+  std::vector<int> goals_;
+  overlay_edges<simple_edge> no_edges_;
+  lower_bounds lbs_;
+};
+
+// A job of a parallel search. Each job gets its own label store.
+using search_job = std::function<void(mem_manager&)>;
+
+// Runs the given jobs concurrently and returns when all jobs are done.
+using run_jobs_fn = std::function<void(std::vector<search_job> const&)>;
+
 struct search_query {
   schedule const* sched_{nullptr};
   mem_manager* mem_{nullptr};
@@ -27,8 +72,30 @@ struct search_query {
   bool use_dest_metas_{false};
   bool use_start_footpaths_{false};
   light_connection const* lcon_{nullptr};
+  landmarks const* landmarks_{nullptr};
+  deadline* deadline_{nullptr};
+  shared_lower_bounds* shared_lbs_{nullptr};
+
+  // Pretrip queries only: number of concurrently searched sub intervals
+  // of the departure interval (requires run_parallel_, <= 1: sequential).
+  unsigned interval_parts_{1U};
+  run_jobs_fn run_parallel_;
 };
 
+inline std::vector<int> get_goal_ids(search_query const& q) {
+  std::vector<int> goal_ids;
+  for (auto const& meta_goal : q.sched_->stations_[q.to_->id_]->equivalent_) {
+    goal_ids.push_back(meta_goal->index_);
+    if (!q.use_dest_metas_) {
+      break;
+    }
+  }
+  if (q.to_ == q.sched_->station_nodes_.at(1).get()) {
+    goal_ids.push_back(q.to_->id_);
+  }
+  return goal_ids;
+}
+
 struct search_result {
   search_result() = default;
   search_result(statistics stats, std::vector<journey> journeys,
@@ -47,47 +114,28 @@ struct search_result {
 template <search_dir Dir, typename StartLabelGenerator, typename Label>
 struct search {
   static search_result get_connections(search_query const& q) {
-    mcd::hash_map<unsigned, std::vector<simple_edge>>
-        travel_time_lb_graph_edges;
-    mcd::hash_map<unsigned, std::vector<simple_edge>> transfers_lb_graph_edges;
-    auto const route_offset = q.sched_->station_nodes_.size();
-    for (auto const& e : q.query_edges_) {
-      auto const from_node = (Dir == search_dir::FWD) ? e.from_ : e.to_;
-      auto const to_node = (Dir == search_dir::FWD) ? e.to_ : e.from_;
-
-      // station graph
-      auto const from_station = from_node->get_station()->id_;
-      auto const to_station = to_node->get_station()->id_;
-
-      // interchange graph
-      auto const from_interchange = from_node->is_route_node()
-                                        ? route_offset + from_node->route_
-                                        : from_station;
-      auto const to_interchange = to_node->is_route_node()
-                                      ? route_offset + to_node->route_
-                                      : to_station;
-
-      auto const ec = e.get_minimum_cost();
-
-      travel_time_lb_graph_edges[to_station].emplace_back(
-          simple_edge{from_station, ec.time_});
-      transfers_lb_graph_edges[to_interchange].emplace_back(simple_edge{
-          from_interchange, static_cast<uint16_t>(ec.transfer_ ? 1 : 0)});
+    auto const goal_ids = get_goal_ids(q);
+    boost::container::vector<bool> is_goal(q.sched_->stations_.size(), false);
+    for (auto const goal : goal_ids) {
+      is_goal[goal] = true;
     }
 
-    auto const& meta_goals = q.sched_->stations_[q.to_->id_]->equivalent_;
-    std::vector<int> goal_ids;
-    boost::container::vector<bool> is_goal(q.sched_->stations_.size(), false);
-    for (auto const& meta_goal : meta_goals) {
-      goal_ids.push_back(meta_goal->index_);
-      is_goal[meta_goal->index_] = true;
-      if (!q.use_dest_metas_) {
-        break;
-      }
+    query_overlay const overlay{*q.sched_, Dir, q.query_edges_};
+
+    if (q.shared_lbs_ != nullptr) {
+      assert(q.query_edges_.empty() && q.shared_lbs_->goals_ == goal_ids);
+      auto res =
+          get_connections(q, q.shared_lbs_->lbs_, is_goal, overlay, false);
+      res.stats_.shared_lb_ = true;
+      return res;
     }
-    if (q.to_ == q.sched_->station_nodes_.at(1).get()) {
-      goal_ids.push_back(q.to_->id_);
-      is_goal[q.to_->id_] = true;
+
+    if (q.landmarks_ != nullptr && q.query_edges_.empty() &&
+        is_up_to_date(*q.landmarks_, *q.sched_)) {
+      landmark_lower_bounds lbs(*q.sched_, *q.landmarks_, Dir, goal_ids);
+      auto res = get_connections(q, lbs, is_goal, overlay);
+      res.stats_.landmark_lb_ = true;
+      return res;
     }
 
     lower_bounds lbs(
@@ -96,10 +144,20 @@ struct search {
                                : q.sched_->travel_time_lower_bounds_bwd_,
         Dir == search_dir::FWD ? q.sched_->transfers_lower_bounds_fwd_
                                : q.sched_->transfers_lower_bounds_bwd_,
-        goal_ids, travel_time_lb_graph_edges, transfers_lb_graph_edges);
+        goal_ids, overlay.travel_time_lb_, overlay.transfers_lb_);
+
+    return get_connections(q, lbs, is_goal, overlay);
+  }
 
+  template <typename LowerBounds>
+  static search_result get_connections(
+      search_query const& q, LowerBounds& lbs,
+      boost::container::vector<bool> const& is_goal,
+      query_overlay const& overlay, bool const compute_lbs = true) {
     MOTIS_START_TIMING(travel_time_lb_timing);
-    lbs.travel_time_.run();
+    if (compute_lbs) {
+      lbs.travel_time_.run();
+    }
     MOTIS_STOP_TIMING(travel_time_lb_timing);
 
     if (!lbs.travel_time_.is_reachable(lbs.travel_time_[q.from_])) {
@@ -107,7 +165,9 @@ struct search {
     }
 
     MOTIS_START_TIMING(transfers_lb_timing);
-    lbs.transfers_.run();
+    if (compute_lbs) {
+      lbs.transfers_.run();
+    }
     MOTIS_STOP_TIMING(transfers_lb_timing);
 
     auto const create_start_edge = [&](node* to) {
@@ -146,14 +206,40 @@ struct search {
       }
     }
 
-    mcd::hash_map<node const*, std::vector<edge>> additional_edges;
-    for (auto const& e : q.query_edges_) {
-      additional_edges[e.get_source<Dir>()].push_back(e);
-    }
+    auto res = is_parallel(q) ? search_parallel(q, lbs, is_goal, overlay,
+                                                start_edge, meta_edges)
+                              : search_sequential(q, lbs, is_goal, overlay,
+                                                  start_edge, meta_edges);
+    res.stats_.travel_time_lb_ = MOTIS_TIMING_MS(travel_time_lb_timing);
+    res.stats_.transfers_lb_ = MOTIS_TIMING_MS(transfers_lb_timing);
+    res.stats_.lower_bounds_us_ = MOTIS_TIMING_US(travel_time_lb_timing) +
+                                  MOTIS_TIMING_US(transfers_lb_timing);
+    return res;
+  }
+
+  // Pretrip searches also find journeys departing after the interval (the
+  // start label of the first departure after the interval end).
+  static bool departs_in_interval(Label const* l, time interval_begin,
+                                  time interval_end) {
+    return interval_end == INVALID_TIME ||  // ontrip
+           (l->start_ >= interval_begin && l->start_ <= interval_end);
+  }
+
+  static bool is_parallel(search_query const& q) {
+    return q.interval_parts_ > 1U && q.run_parallel_ &&
+           q.interval_end_ != INVALID_TIME && q.lcon_ == nullptr;
+  }
 
-    pareto_dijkstra<Dir, Label, lower_bounds> pd(
+  template <typename LowerBounds>
+  static search_result search_sequential(
+      search_query const& q, LowerBounds& lbs,
+      boost::container::vector<bool> const& is_goal,
+      query_overlay const& overlay, edge const& start_edge,
+      std::vector<edge> const& meta_edges) {
+    pareto_dijkstra<Dir, Label, LowerBounds> pd(
         q.sched_->node_count_, q.sched_->stations_.size(), is_goal,
-        std::move(additional_edges), lbs, *q.mem_);
+        overlay.graph_, lbs, *q.mem_, q.deadline_,
+        &q.sched_->route_edge_indices_);
 
     auto const add_start_labels = [&](time interval_begin, time interval_end) {
       pd.add_start_labels(StartLabelGenerator::generate(
@@ -176,16 +262,8 @@ struct search {
     auto interval_begin = q.interval_begin_;
     auto interval_end = q.interval_end_;
 
-    auto const departs_in_interval = [](Label const* l,
-                                        motis::time interval_begin,
-                                        motis::time interval_end) {
-      return interval_end == INVALID_TIME ||  // ontrip
-             (l->start_ >= interval_begin && l->start_ <= interval_end);
-    };
-
     auto const number_of_results_in_interval =
-        [&interval_begin, &interval_end,
-         departs_in_interval](std::vector<Label*> const& labels) {
+        [&interval_begin, &interval_end](std::vector<Label*> const& labels) {
           return std::count_if(begin(labels), end(labels), [&](Label const* l) {
             return departs_in_interval(l, interval_begin, interval_end);
           });
@@ -201,6 +279,10 @@ struct search {
       pd.search();
       ++search_iterations;
 
+      if (pd.get_statistics().timeout_quit_) {
+        break;
+      }
+
       if (number_of_results_in_interval(pd.get_results()) >=
           q.min_journey_count_) {
         break;
@@ -228,8 +310,6 @@ struct search {
     MOTIS_STOP_TIMING(pareto_dijkstra_timing);
 
     auto stats = pd.get_statistics();
-    stats.travel_time_lb_ = MOTIS_TIMING_MS(travel_time_lb_timing);
-    stats.transfers_lb_ = MOTIS_TIMING_MS(transfers_lb_timing);
     stats.pareto_dijkstra_ = MOTIS_TIMING_MS(pareto_dijkstra_timing);
     stats.interval_extensions_ = search_iterations - 1;
 
@@ -249,6 +329,232 @@ struct search {
                                      }),
                          interval_begin, interval_end);
   }
+
+  // Terminal label of a sub search. The label is copied for the dominance
+  // checks of the merge (its predecessors are gone with the label store of
+  // the sub search), the journey is extracted by the sub search.
+  struct part_result {
+    Label label_;
+    journey journey_;
+  };
+
+  struct part {
+    time interval_begin_{INVALID_TIME}, interval_end_{INVALID_TIME};
+    std::vector<part_result> results_;
+    statistics stats_;
+  };
+
+  // Searches the departure interval of the query in q.interval_parts_
+  // sub intervals concurrently, each with its own label store, and merges
+  // the results of the sub searches with the dominance rules of the
+  // pareto_dijkstra result set: a label pruned by a result of another part
+  // in the sequential search is dominated by that result in the merge.
+  //
+  // Interval extensions are searched speculatively in steps of the
+  // sequential search (60 minutes earlier / later). The steps are merged
+  // in order and merging stops at the same interval where the sequential
+  // search would stop. Thus, the result set is the same as the sequential
+  // result set (up to the choice between equivalent journeys).
+  template <typename LowerBounds>
+  static search_result search_parallel(
+      search_query const& q, LowerBounds& lbs,
+      boost::container::vector<bool> const& is_goal,
+      query_overlay const& overlay, edge const& start_edge,
+      std::vector<edge> const& meta_edges) {
+    time const schedule_begin = SCHEDULE_OFFSET_MINUTES;
+    time const schedule_end =
+        (q.sched_->schedule_end_ - q.sched_->schedule_begin_) / 60;
+
+    auto const map_to_interval = [&schedule_begin, &schedule_end](int t) {
+      return static_cast<time>(std::min(
+          static_cast<int>(schedule_end),
+          std::max(static_cast<int>(schedule_begin), t)));
+    };
+
+    auto const run = [&](std::vector<part>& parts) {
+      q.run_parallel_(utl::to_vec(parts, [&](part& p) -> search_job {
+        return [&, target = &p](mem_manager& mem) {
+          search_part(q, lbs, is_goal, overlay, start_edge, meta_edges, mem,
+                      *target);
+        };
+      }));
+    };
+
+    MOTIS_START_TIMING(pareto_dijkstra_timing);
+    statistics stats;
+    std::vector<part_result> results;
+    auto const merge = [&](part& p) {
+      add_stats(stats, p.stats_);
+      for (auto& r : p.results_) {
+        add_result(results, std::move(r));
+      }
+    };
+
+    // Requested interval.
+    auto interval_begin = q.interval_begin_;
+    auto interval_end = q.interval_end_;
+    auto const length =
+        static_cast<unsigned>(interval_end - interval_begin) + 1U;
+    auto const part_count = std::min(q.interval_parts_, length);
+    std::vector<part> initial(part_count);
+    for (auto i = 0U; i < part_count; ++i) {
+      initial[i].interval_begin_ =
+          static_cast<time>(interval_begin + i * length / part_count);
+      initial[i].interval_end_ =
+          static_cast<time>(interval_begin + (i + 1) * length / part_count - 1);
+    }
+    run(initial);
+    for (auto& p : initial) {
+      merge(p);
+    }
+    filter_results(results);
+
+    // Interval extensions: one step = up to two parts (earlier, later).
+    auto const in_interval = [&](part_result const& r) {
+      return departs_in_interval(&r.label_, interval_begin, interval_end);
+    };
+    auto const is_done = [&]() {
+      return stats.timeout_quit_ ||
+             static_cast<unsigned>(std::count_if(
+                 begin(results), end(results), in_interval)) >=
+                 q.min_journey_count_ ||
+             ((!q.extend_interval_earlier_ ||
+               interval_begin == schedule_begin) &&
+              (!q.extend_interval_later_ || interval_end == schedule_end));
+    };
+
+    auto search_iterations = 1UL;
+    while (!is_done()) {
+      std::vector<part> parts;
+      std::vector<std::size_t> step_end;
+      auto spec_begin = interval_begin, spec_end = interval_end;
+      for (auto step = 0U; step < q.interval_parts_; ++step) {
+        if (q.extend_interval_earlier_ && spec_begin != schedule_begin) {
+          auto& p = parts.emplace_back();
+          p.interval_begin_ = map_to_interval(spec_begin - 60);
+          p.interval_end_ = map_to_interval(spec_begin - 1);
+          spec_begin = p.interval_begin_;
+        }
+        if (q.extend_interval_later_ && spec_end != schedule_end) {
+          auto& p = parts.emplace_back();
+          p.interval_begin_ = map_to_interval(spec_end + 1);
+          p.interval_end_ = map_to_interval(spec_end + 60);
+          spec_end = p.interval_end_;
+        }
+        step_end.push_back(parts.size());
+      }
+      run(parts);
+
+      auto part_idx = std::size_t{0U};
+      for (auto const end_idx : step_end) {
+        for (; part_idx != end_idx; ++part_idx) {
+          auto& p = parts[part_idx];
+          merge(p);
+          interval_begin = std::min(interval_begin, p.interval_begin_);
+          interval_end = std::max(interval_end, p.interval_end_);
+        }
+        filter_results(results);
+        ++search_iterations;
+        if (is_done()) {
+          break;
+        }
+      }
+    }
+    MOTIS_STOP_TIMING(pareto_dijkstra_timing);
+
+    stats.pareto_dijkstra_ = MOTIS_TIMING_MS(pareto_dijkstra_timing);
+    stats.interval_extensions_ = search_iterations - 1;
+    stats.interval_parts_ = part_count;
+
+    // Results outside of the interval take part in the dominance checks
+    // (as in the sequential search) but are not returned.
+    utl::erase_if(results,
+                  [&](part_result const& r) { return !in_interval(r); });
+
+    return search_result(
+        stats,
+        utl::to_vec(results,
+                    [](part_result& r) { return std::move(r.journey_); }),
+        interval_begin, interval_end);
+  }
+
+  template <typename LowerBounds>
+  static void search_part(search_query const& q, LowerBounds& lbs,
+                          boost::container::vector<bool> const& is_goal,
+                          query_overlay const& overlay,
+                          edge const& start_edge,
+                          std::vector<edge> const& meta_edges,
+                          mem_manager& mem, part& p) {
+    // deadline::reached() counts calls: each sub search needs its own copy
+    auto part_deadline = q.deadline_ != nullptr ? *q.deadline_ : deadline{};
+    pareto_dijkstra<Dir, Label, LowerBounds> pd(
+        q.sched_->node_count_, q.sched_->stations_.size(), is_goal,
+        overlay.graph_, lbs, mem, &part_deadline,
+        &q.sched_->route_edge_indices_);
+    pd.add_start_labels(StartLabelGenerator::generate(
+        *q.sched_, mem, lbs, &start_edge, meta_edges, q.query_edges_,
+        p.interval_begin_, p.interval_end_, q.lcon_, q.use_start_footpaths_));
+    pd.search();
+
+    p.stats_ = pd.get_statistics();
+    p.stats_.labels_created_ = mem.allocations();
+    p.stats_.num_bytes_in_use_ = mem.get_num_bytes_in_use();
+    p.results_ = utl::to_vec(pd.get_results(), [&](Label* l) {
+      return part_result{*l, output::labels_to_journey(*q.sched_, l, Dir)};
+    });
+  }
+
+  // Same rules as pareto_dijkstra::add_result.
+  static void add_result(std::vector<part_result>& results, part_result&& r) {
+    for (auto it = begin(results); it != end(results);) {
+      if (r.label_.dominates(it->label_)) {
+        it = results.erase(it);
+      } else if (it->label_.dominates(r.label_)) {
+        return;
+      } else {
+        ++it;
+      }
+    }
+    results.emplace_back(std::move(r));
+  }
+
+  // Same rules as pareto_dijkstra::filter_results.
+  static void filter_results(std::vector<part_result>& results) {
+    if (!Label::is_post_search_dominance_enabled()) {
+      return;
+    }
+    bool restart = false;
+    for (auto it = std::begin(results); it != std::end(results);
+         it = restart ? std::begin(results) : std::next(it)) {
+      restart = false;
+      auto const size_before = results.size();
+      utl::erase_if(results, [&](part_result const& o) {
+        return &o == &(*it) ? false
+                            : it->label_.dominates_post_search(o.label_);
+      });
+      if (results.size() != size_before) {
+        restart = true;
+      }
+    }
+  }
+
+  static void add_stats(statistics& sum, statistics const& s) {
+    sum.max_label_quit_ |= s.max_label_quit_;
+    sum.timeout_quit_ |= s.timeout_quit_;
+    sum.labels_created_ += s.labels_created_;
+    sum.labels_popped_ += s.labels_popped_;
+    sum.labels_dominated_by_results_ += s.labels_dominated_by_results_;
+    sum.labels_filtered_ += s.labels_filtered_;
+    sum.labels_dominated_by_former_labels_ +=
+        s.labels_dominated_by_former_labels_;
+    sum.labels_dominated_by_later_labels_ +=
+        s.labels_dominated_by_later_labels_;
+    sum.labels_equals_popped_ += s.labels_equals_popped_;
+    sum.priority_queue_max_size_ =
+        std::max(sum.priority_queue_max_size_, s.priority_queue_max_size_);
+    sum.start_label_count_ += s.start_label_count_;
+    sum.num_bytes_in_use_ += s.num_bytes_in_use_;
+  }
 };
 
 }  // namespace motis::routing
@@ -17,8 +17,9 @@ namespace motis::routing {
 
 template <search_dir Dir, typename Label>
 struct pretrip_gen {
+  template <typename LowerBounds>
   static std::vector<Label*> generate(schedule const& sched, mem_manager& mem,
-                                      lower_bounds& lbs, edge const* start_edge,
+                                      LowerBounds& lbs, edge const* start_edge,
                                       std::vector<edge> const& meta_edges,
                                       std::vector<edge> const& query_edges,
                                       time interval_begin, time interval_end,
@@ -38,8 +39,9 @@ struct pretrip_gen {
     return labels;
   }
 
+  template <typename LowerBounds>
   static void generate_intermodal_starts(schedule const& sched,
-                                         mem_manager& mem, lower_bounds& lbs,
+                                         mem_manager& mem, LowerBounds& lbs,
                                          edge const* start_edge,
                                          std::vector<edge> const& query_edges,
                                          time interval_begin, time interval_end,
@@ -73,8 +75,9 @@ struct pretrip_gen {
     }
   }
 
+  template <typename LowerBounds>
   static void generate_meta_starts(schedule const& sched, mem_manager& mem,
-                                   lower_bounds& lbs,
+                                   LowerBounds& lbs,
                                    std::vector<edge> const& meta_edges,
                                    time interval_begin, time interval_end,
                                    bool starting_footpaths,
@@ -86,8 +89,9 @@ struct pretrip_gen {
     }
   }
 
+  template <typename LowerBounds>
   static void generate_labels_at_route_nodes(
-      schedule const& sched, mem_manager& mem, lower_bounds& lbs,
+      schedule const& sched, mem_manager& mem, LowerBounds& lbs,
       const std::vector<std::pair<edge const*, int>>& initial_path,
       time interval_begin, time interval_end, bool starting_footpaths,
       bool add_first_interchange_time, std::vector<Label*>& labels) {
@@ -100,9 +104,10 @@ struct pretrip_gen {
         });
   }
 
+  template <typename LowerBounds>
   static void generate_start_labels(
       std::vector<std::pair<edge const*, int>> const& path, edge const& re,
-      mem_manager& mem, lower_bounds& lbs, time interval_begin,
+      mem_manager& mem, LowerBounds& lbs, time interval_begin,
       time interval_end, duration initial_walk, std::vector<Label*>& labels) {
     assert(!path.empty());
 
@@ -136,8 +141,9 @@ struct pretrip_gen {
     generate_ontrip_label(mem, lbs, path, interval_begin, interval_end, labels);
   }
 
+  template <typename LowerBounds>
   static void generate_ontrip_label(
-      mem_manager& mem, lower_bounds& lbs,
+      mem_manager& mem, LowerBounds& lbs,
       std::vector<std::pair<edge const*, int>> const& path, time interval_begin,
       time interval_end, std::vector<Label*>& labels) {
     auto const start =
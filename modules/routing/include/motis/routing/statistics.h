@@ -16,6 +16,7 @@ struct statistics {
       : travel_time_lb_{travel_time_lb} {}
 
   bool max_label_quit_{};
+  bool timeout_quit_{};
   std::size_t labels_created_{};
   uint64_t labels_popped_{};
   uint64_t labels_dominated_by_results_{};
@@ -35,6 +36,18 @@ struct statistics {
   uint64_t num_bytes_in_use_{};
   uint64_t labels_to_journey_{};
   uint64_t interval_extensions_{};
+  uint64_t interval_parts_{};
+  uint64_t mem_pool_bytes_reserved_{};
+  uint64_t mem_pool_bytes_in_use_{};
+  uint64_t mem_pool_peak_bytes_reserved_{};
+  uint64_t mem_pool_trims_{};
+  uint64_t lower_bounds_us_{};
+  bool landmark_lb_{};
+  bool shared_lb_{};
+  bool lb_cache_hit_{};
+  bool lb_cache_miss_{};
+  uint64_t lb_cache_hits_total_{};
+  uint64_t lb_cache_misses_total_{};
 
   friend flatbuffers::Offset<Statistics> to_fbs(
       flatbuffers::FlatBufferBuilder& fbb, char const* category,
@@ -63,6 +76,7 @@ struct statistics {
               s.labels_popped_until_first_result_);
     add_entry("labels_to_journey", s.labels_to_journey_);
     add_entry("max_label_quit", s.max_label_quit_ ? 1 : 0);
+    add_entry("timeout_quit", s.timeout_quit_ ? 1 : 0);
     add_entry("num_bytes_in_use", s.num_bytes_in_use_);
     add_entry("pareto_dijkstra", s.pareto_dijkstra_);
     add_entry("priority_queue_max_size", s.priority_queue_max_size_);
@@ -71,6 +85,19 @@ struct statistics {
     add_entry("transfers_lb", s.transfers_lb_);
     add_entry("travel_time_lb", s.travel_time_lb_);
     add_entry("interval_extensions", s.interval_extensions_);
+    add_entry("interval_parts", s.interval_parts_);
+    add_entry("mem_pool_bytes_reserved", s.mem_pool_bytes_reserved_);
+    add_entry("mem_pool_bytes_in_use", s.mem_pool_bytes_in_use_);
+    add_entry("mem_pool_peak_bytes_reserved",
+              s.mem_pool_peak_bytes_reserved_);
+    add_entry("mem_pool_trims", s.mem_pool_trims_);
+    add_entry("lower_bounds_us", s.lower_bounds_us_);
+    add_entry("landmark_lb", s.landmark_lb_ ? 1 : 0);
+    add_entry("shared_lb", s.shared_lb_ ? 1 : 0);
+    add_entry("lb_cache_hit", s.lb_cache_hit_ ? 1 : 0);
+    add_entry("lb_cache_miss", s.lb_cache_miss_ ? 1 : 0);
+    add_entry("lb_cache_hits_total", s.lb_cache_hits_total_);
+    add_entry("lb_cache_misses_total", s.lb_cache_misses_total_);
 
     return CreateStatistics(fbb, fbb.CreateString(category),
                             fbb.CreateVectorOfSortedTables(&stats));
@@ -95,6 +122,7 @@ struct statistics {
           s.labels_popped_until_first_result_},
          {"labels_to_journey", s.labels_to_journey_},
          {"max_label_quit", s.max_label_quit_ ? 1U : 0U},
+         {"timeout_quit", s.timeout_quit_ ? 1U : 0U},
          {"num_bytes_in_use", s.num_bytes_in_use_},
          {"pareto_dijkstra", s.pareto_dijkstra_},
          {"priority_queue_max_size", s.priority_queue_max_size_},
@@ -102,7 +130,19 @@ struct statistics {
          {"total_calculation_time", s.total_calculation_time_},
          {"transfers_lb", s.transfers_lb_},
          {"travel_time_lb", s.travel_time_lb_},
-         {"interval_extensions", s.interval_extensions_}}};
+         {"interval_extensions", s.interval_extensions_},
+         {"interval_parts", s.interval_parts_},
+         {"mem_pool_bytes_reserved", s.mem_pool_bytes_reserved_},
+         {"mem_pool_bytes_in_use", s.mem_pool_bytes_in_use_},
+         {"mem_pool_peak_bytes_reserved", s.mem_pool_peak_bytes_reserved_},
+         {"mem_pool_trims", s.mem_pool_trims_},
+         {"lower_bounds_us", s.lower_bounds_us_},
+         {"landmark_lb", s.landmark_lb_ ? 1U : 0U},
+         {"shared_lb", s.shared_lb_ ? 1U : 0U},
+         {"lb_cache_hit", s.lb_cache_hit_ ? 1U : 0U},
+         {"lb_cache_miss", s.lb_cache_miss_ ? 1U : 0U},
+         {"lb_cache_hits_total", s.lb_cache_hits_total_},
+         {"lb_cache_misses_total", s.lb_cache_misses_total_}}};
   }
 };
 
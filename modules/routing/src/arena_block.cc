@@ -0,0 +1,81 @@
+#include "motis/routing/arena_block.h"
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace motis::routing {
+
+namespace {
+
+#ifdef __linux__
+void* map(std::size_t const size, bool const huge_pages) {
+  auto const prot = PROT_READ | PROT_WRITE;
+  auto const flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+  if (huge_pages) {
+    auto const mem = mmap(nullptr, size, prot, flags | MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+      return mem;
+    }
+  }
+
+  auto const mem = mmap(nullptr, size, prot, flags, -1, 0);
+  if (mem == MAP_FAILED) {
+    throw std::bad_alloc{};
+  }
+  if (huge_pages) {
+    madvise(mem, size, MADV_HUGEPAGE);
+  }
+  return mem;
+}
+#endif
+
+}  // namespace
+
+arena_block::arena_block(std::size_t const size, bool const huge_pages)
+    : size_{(size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE} {
+#ifdef __linux__
+  mem_ = static_cast<unsigned char*>(map(size_, huge_pages));
+#else
+  (void)huge_pages;
+  mem_ = static_cast<unsigned char*>(std::malloc(size_));
+  if (mem_ == nullptr) {
+    throw std::bad_alloc{};
+  }
+#endif
+}
+
+arena_block::~arena_block() { release(); }
+
+arena_block::arena_block(arena_block&& o) noexcept
+    : mem_{std::exchange(o.mem_, nullptr)},
+      size_{std::exchange(o.size_, 0U)} {}
+
+arena_block& arena_block::operator=(arena_block&& o) noexcept {
+  if (this != &o) {
+    release();
+    mem_ = std::exchange(o.mem_, nullptr);
+    size_ = std::exchange(o.size_, 0U);
+  }
+  return *this;
+}
+
+void arena_block::release() {
+  if (mem_ == nullptr) {
+    return;
+  }
+#ifdef __linux__
+  munmap(mem_, size_);
+#else
+  std::free(mem_);  // NOLINT
+#endif
+  mem_ = nullptr;
+  size_ = 0U;
+}
+
+}  // namespace motis::routing
@@ -0,0 +1,191 @@
+#include "motis/routing/landmarks.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "cista/serialization.h"
+
+#include "motis/core/common/logging.h"
+#include "motis/core/schedule/constant_graph.h"
+
+using namespace motis::logging;
+
+namespace motis::routing {
+
+constexpr auto const MODE =
+    cista::mode::WITH_INTEGRITY | cista::mode::WITH_VERSION;
+
+constexpr auto const INF = std::numeric_limits<uint32_t>::max();
+
+constant_graph transpose(constant_graph const& g) {
+  constant_graph t(g.size());
+  for (auto from = 0U; from < g.size(); ++from) {
+    for (auto const& e : g[from]) {
+      t[e.to_].emplace_back(from, e.cost_);
+    }
+  }
+  return t;
+}
+
+// Plain Dijkstra without an upper bound on the distance: in contrast to the
+// per query constant_graph_dijkstra, landmark distances span the whole graph.
+std::vector<uint32_t> dijkstra(constant_graph const& g, uint32_t const source) {
+  using entry = std::pair<uint32_t /* dist */, uint32_t /* node */>;
+
+  std::vector<uint32_t> dists(g.size(), INF);
+  std::priority_queue<entry, std::vector<entry>, std::greater<>> pq;
+  dists[source] = 0U;
+  pq.emplace(0U, source);
+  while (!pq.empty()) {
+    auto const [dist, node] = pq.top();
+    pq.pop();
+
+    if (dist > dists[node]) {
+      continue;
+    }
+
+    for (auto const& e : g[node]) {
+      auto const new_dist = dist + e.cost_;
+      if (new_dist < dists[e.to_]) {
+        dists[e.to_] = new_dist;
+        pq.emplace(new_dist, e.to_);
+      }
+    }
+  }
+  return dists;
+}
+
+// Farthest selection: the next landmark is the station with the largest
+// distance (in either direction) to all landmarks selected so far.
+std::vector<uint32_t> select_landmarks(schedule const& sched,
+                                       unsigned const landmark_count) {
+  auto const& fwd = sched.travel_time_lower_bounds_fwd_;
+  auto const& bwd = sched.travel_time_lower_bounds_bwd_;
+  auto const station_count = static_cast<uint32_t>(fwd.size());
+
+  // stations 0 and 1 are the virtual intermodal start and destination
+  auto const is_candidate = [&](uint32_t const s) {
+    return s > 1 && (!fwd[s].empty() || !bwd[s].empty());
+  };
+
+  std::vector<uint32_t> selected;
+  std::vector<uint32_t> min_dist(station_count, INF);
+  while (selected.size() < landmark_count) {
+    auto best = INF;
+    if (selected.empty()) {
+      for (auto s = 0U; s < station_count; ++s) {
+        if (is_candidate(s) &&
+            (best == INF || fwd[s].size() + bwd[s].size() >
+                                fwd[best].size() + bwd[best].size())) {
+          best = s;
+        }
+      }
+    } else {
+      for (auto s = 0U; s < station_count; ++s) {
+        if (is_candidate(s) && min_dist[s] != INF && min_dist[s] != 0U &&
+            (best == INF || min_dist[s] > min_dist[best])) {
+          best = s;
+        }
+      }
+    }
+
+    if (best == INF) {
+      break;
+    }
+
+    selected.push_back(best);
+    auto const fwd_dists = dijkstra(fwd, best);
+    auto const bwd_dists = dijkstra(bwd, best);
+    for (auto s = 0U; s < station_count; ++s) {
+      min_dist[s] = std::min({min_dist[s], fwd_dists[s], bwd_dists[s]});
+    }
+  }
+  return selected;
+}
+
+template <typename Dist>
+landmark_distances<Dist> compute_distances(
+    constant_graph const& g, std::vector<uint32_t> const& stations) {
+  using distances = landmark_distances<Dist>;
+
+  auto const k = stations.size();
+  auto const store = [&](mcd::vector<Dist>& target,
+                         std::vector<uint32_t> const& dists,
+                         std::size_t const landmark) {
+    for (auto node = 0U; node < dists.size(); ++node) {
+      target[node * k + landmark] =
+          dists[node] == INF
+              ? distances::UNREACHABLE
+              : static_cast<Dist>(std::min(
+                    dists[node], static_cast<uint32_t>(distances::UNKNOWN)));
+    }
+  };
+
+  auto const g_transposed = transpose(g);
+
+  distances d;
+  d.from_landmark_.resize(g.size() * k);
+  d.to_landmark_.resize(g.size() * k);
+  for (auto i = 0U; i < k; ++i) {
+    store(d.from_landmark_, dijkstra(g, stations[i]), i);
+    store(d.to_landmark_, dijkstra(g_transposed, stations[i]), i);
+  }
+  return d;
+}
+
+mcd::unique_ptr<landmarks> build_landmarks(schedule const& sched,
+                                           unsigned const landmark_count) {
+  scoped_timer timer("computing landmarks");
+
+  auto const stations = select_landmarks(sched, landmark_count);
+
+  auto lm = mcd::make_unique<landmarks>();
+  lm->schedule_hash_ = sched.hash_;
+  lm->constant_graph_version_ = sched.constant_graph_version_;
+  lm->requested_landmark_count_ = landmark_count;
+  lm->landmark_count_ = static_cast<uint32_t>(stations.size());
+  for (auto const s : stations) {
+    lm->stations_.push_back(s);
+  }
+  lm->travel_time_fwd_ = compute_distances<uint16_t>(
+      sched.travel_time_lower_bounds_fwd_, stations);
+  lm->travel_time_bwd_ = compute_distances<uint16_t>(
+      sched.travel_time_lower_bounds_bwd_, stations);
+  lm->transfers_fwd_ = compute_distances<uint8_t>(
+      sched.transfers_lower_bounds_fwd_, stations);
+  lm->transfers_bwd_ = compute_distances<uint8_t>(
+      sched.transfers_lower_bounds_bwd_, stations);
+
+  LOG(info) << "selected " << lm->landmark_count_ << " landmarks";
+  return lm;
+}
+
+mcd::unique_ptr<landmarks> read_landmarks(std::string const& path,
+                                          cista::memory_holder& mem) {
+  mcd::unique_ptr<landmarks> ptr;
+  ptr.self_allocated_ = false;
+#if defined(MOTIS_SCHEDULE_MODE_OFFSET) && !defined(CLANG_TIDY)
+  mem = cista::buf<cista::mmap>(
+      cista::mmap{path.c_str(), cista::mmap::protection::READ});
+  ptr.el_ = cista::deserialize<landmarks, MODE>(
+      std::get<cista::buf<cista::mmap>>(mem));
+#elif defined(MOTIS_SCHEDULE_MODE_RAW) || defined(CLANG_TIDY)
+  mem = cista::file(path.c_str(), "r").content();
+  // NOLINTNEXTLINE
+  ptr.el_ = cista::deserialize<landmarks, MODE>(std::get<cista::buffer>(mem));
+#else
+#error "no ptr mode specified"
+#endif
+  return ptr;
+}
+
+void write_landmarks(std::string const& path, landmarks const& lm) {
+  auto writer = cista::buf<cista::mmap>(
+      cista::mmap{path.c_str(), cista::mmap::protection::WRITE});
+  cista::serialize<MODE>(writer, lm);
+}
+
+}  // namespace motis::routing
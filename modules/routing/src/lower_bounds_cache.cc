@@ -0,0 +1,68 @@
+#include "motis/routing/lower_bounds_cache.h"
+
+namespace motis::routing {
+
+lower_bounds_cache::lower_bounds_cache(std::size_t const max_size)
+    : max_size_{max_size} {}
+
+std::pair<std::shared_ptr<shared_lower_bounds>, bool> lower_bounds_cache::get(
+    schedule const& sched, search_dir const dir,
+    std::vector<int> const& goals) {
+  auto key = key_t{dir, goals};
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    invalidate_outdated(sched);
+    if (auto const it = entries_.find(key); it != end(entries_)) {
+      lru_.splice(begin(lru_), lru_, it->second);
+      ++hits_;
+      return {it->second->second, true};
+    }
+    ++misses_;
+  }
+
+  // Computed without holding the lock: concurrent misses for the same key
+  // may compute the lower bounds twice, the first insert wins.
+  auto lbs = std::make_shared<shared_lower_bounds>(sched, dir, goals);
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  invalidate_outdated(sched);
+  if (auto const it = entries_.find(key); it != end(entries_)) {
+    lru_.splice(begin(lru_), lru_, it->second);
+    return {it->second->second, false};
+  }
+
+  if (max_size_ == 0U) {
+    return {lbs, false};
+  }
+
+  while (lru_.size() >= max_size_) {
+    entries_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+  lru_.emplace_front(std::move(key), lbs);
+  entries_.emplace(lru_.front().first, begin(lru_));
+  return {lbs, false};
+}
+
+uint64_t lower_bounds_cache::hits() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return hits_;
+}
+
+uint64_t lower_bounds_cache::misses() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return misses_;
+}
+
+void lower_bounds_cache::invalidate_outdated(schedule const& sched) {
+  if (schedule_hash_ != sched.hash_ ||
+      constant_graph_version_ != sched.constant_graph_version_) {
+    entries_.clear();
+    lru_.clear();
+    schedule_hash_ = sched.hash_;
+    constant_graph_version_ = sched.constant_graph_version_;
+  }
+}
+
+}  // namespace motis::routing
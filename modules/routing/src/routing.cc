@@ -1,11 +1,20 @@
 #include "motis/routing/routing.h"
 
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <utility>
+
 #include "boost/date_time/gregorian/gregorian_types.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/filesystem.hpp"
 #include "boost/program_options.hpp"
 
 #include "utl/to_vec.h"
 
+#include "motis/core/common/deadline.h"
 #include "motis/core/common/logging.h"
 #include "motis/core/common/timing.h"
 #include "motis/core/schedule/schedule.h"
@@ -13,11 +22,14 @@
 #include "motis/core/conv/trip_conv.h"
 #include "motis/core/journey/journeys_to_message.h"
 #include "motis/module/context/get_schedule.h"
+#include "motis/module/context/motis_spawn.h"
 
 #include "motis/routing/additional_edges.h"
 #include "motis/routing/build_query.h"
 #include "motis/routing/error.h"
 #include "motis/routing/label/configs.h"
+#include "motis/routing/landmarks.h"
+#include "motis/routing/lower_bounds_cache.h"
 #include "motis/routing/mem_manager.h"
 #include "motis/routing/mem_retriever.h"
 #include "motis/routing/search.h"
@@ -33,48 +45,274 @@ using namespace motis::module;
 
 namespace motis::routing {
 
-routing::routing() : module("Routing", "routing") {}
+namespace fs = boost::filesystem;
+
+struct active_searches_guard {
+  explicit active_searches_guard(std::atomic<unsigned>& active)
+      : active_{active}, count_{++active} {}
+
+  active_searches_guard(active_searches_guard const&) = delete;
+  active_searches_guard& operator=(active_searches_guard const&) = delete;
+
+  active_searches_guard(active_searches_guard&&) = delete;
+  active_searches_guard& operator=(active_searches_guard&&) = delete;
+
+  ~active_searches_guard() { --active_; }
+
+  std::atomic<unsigned>& active_;
+  unsigned const count_;
+};
+
+routing::routing() : module("Routing", "routing") {
+  param(timeout_, "timeout",
+        "default search time budget in milliseconds (0 = unlimited)");
+  param(lb_cache_size_, "lb_cache_size",
+        "number of cached destination lower bounds (0 = disabled)");
+  param(landmark_count_, "landmarks",
+        "number of landmarks for precomputed lower bounds (0 = disabled)");
+  param(label_store_high_water_mb_, "label_store_high_water",
+        "label store memory (MB) kept per pooled label store after a search "
+        "(0 = initial block only)");
+  param(label_store_pool_size_, "label_store_pool_size",
+        "maximum number of idle pooled label stores (0 = hardware threads)");
+  param(huge_pages_, "huge_pages",
+        "back label stores with huge pages (MAP_HUGETLB if reserved, "
+        "transparent huge pages otherwise)");
+  param(interval_parts_, "interval_parts",
+        "number of concurrently searched sub intervals of pretrip queries "
+        "(0/1 = disabled)");
+  param(interval_parts_max_searches_, "interval_parts_max_searches",
+        "split intervals only while at most this many searches are running");
+}
 
 routing::~routing() = default;
 
 void routing::init(motis::module::registry& reg) {
+  mem_pool_config config;
+  config.initial_size_ = LABEL_STORE_START_SIZE;
+  config.high_water_mark_ =
+      static_cast<std::size_t>(label_store_high_water_mb_) * 1024U * 1024U;
+  config.max_idle_ = label_store_pool_size_ != 0U
+                         ? label_store_pool_size_
+                         : std::max(1U, std::thread::hardware_concurrency());
+  config.huge_pages_ = huge_pages_;
+  mem_pool_ = std::make_unique<mem_pool>(config);
+
+  if (lb_cache_size_ != 0U) {
+    lb_cache_ = std::make_unique<lower_bounds_cache>(lb_cache_size_);
+  }
+
+  if (landmark_count_ != 0U) {
+    load_landmarks();
+  }
+
   reg.register_op("/routing",
                   [this](msg_ptr const& msg) { return route(msg); });
+  reg.register_op("/routing/batch",
+                  [this](msg_ptr const& msg) { return route_batch(msg); });
   reg.register_op("/trip_to_connection", &routing::trip_to_connection);
 }
 
-msg_ptr routing::route(msg_ptr const& msg) {
-  MOTIS_START_TIMING(routing_timing);
+void routing::load_landmarks() {
+  auto const& sched = get_sched();
+  auto const dir = get_data_directory() / "routing";
+  auto const filename = (dir / "landmarks.bin").generic_string();
 
-  auto const req = motis_content(RoutingRequest, msg);
-  auto const& sched = get_schedule();
-  auto query = build_query(sched, req);
+  if (fs::exists(filename)) {
+    try {
+      landmarks_ = read_landmarks(filename, landmarks_buf_);
+      if (is_up_to_date(*landmarks_, sched) &&
+          landmarks_->requested_landmark_count_ == landmark_count_) {
+        LOG(info) << "using " << landmarks_->landmark_count_
+                  << " landmarks from " << filename;
+        return;
+      }
+      LOG(info) << "landmarks file outdated";
+    } catch (std::exception const& e) {
+      LOG(warn) << "unable to read landmarks file: " << e.what();
+    }
+  }
+
+  landmarks_ = build_landmarks(sched, landmark_count_);
+  landmarks_buf_ = cista::memory_holder{};
+  fs::create_directories(dir);
+  write_landmarks(filename, *landmarks_);
+}
+
+flatbuffers::Offset<RoutingResponse> write_response(
+    message_creator& fbb, schedule const& sched, search_result const& res) {
+  std::vector<flatbuffers::Offset<Statistics>> stats{
+      to_fbs(fbb, "routing", res.stats_)};
+  return CreateRoutingResponse(
+      fbb, fbb.CreateVectorOfSortedTables(&stats),
+      fbb.CreateVector(utl::to_vec(
+          res.journeys_,
+          [&](journey const& j) { return to_connection(fbb, j); })),
+      motis_to_unixtime(sched, res.interval_begin_),
+      motis_to_unixtime(sched, res.interval_end_),
+      fbb.CreateVector(std::vector<flatbuffers::Offset<DirectConnection>>{}));
+}
+
+search_result routing::run_search(RoutingRequest const* req,
+                                  search_query& query) {
+  MOTIS_START_TIMING(routing_timing);
 
-  mem_retriever mem(mem_pool_mutex_, mem_pool_, LABEL_STORE_START_SIZE);
+  auto search_deadline = deadline::from_timeout_ms(req->timeout(), timeout_);
+  mem_retriever mem(*mem_pool_);
   query.mem_ = &mem.get();
+  query.landmarks_ = landmarks_.get();
+  query.deadline_ = &search_deadline;
+
+  active_searches_guard const active{active_searches_};
+  if (interval_parts_ > 1U &&
+      active.count_ <= interval_parts_max_searches_) {
+    query.interval_parts_ = interval_parts_;
+    query.run_parallel_ = [this](std::vector<search_job> const& jobs) {
+      std::vector<ctx::future_ptr<ctx_data, void>> futures;
+      for (auto const& job : jobs) {
+        futures.emplace_back(spawn_job_void([this, &job]() {
+          mem_retriever mem(*mem_pool_);
+          job(mem.get());
+        }));
+      }
+      ctx::await_all(futures);
+    };
+  }
+
+  MOTIS_START_TIMING(lb_cache_timing);
+  std::shared_ptr<shared_lower_bounds> cached_lbs;
+  auto lb_cache_hit = false;
+  if (lb_cache_ != nullptr && query.shared_lbs_ == nullptr &&
+      query.query_edges_.empty()) {
+    std::tie(cached_lbs, lb_cache_hit) = lb_cache_->get(
+        *query.sched_,
+        req->search_dir() == SearchDir_Forward ? search_dir::FWD
+                                               : search_dir::BWD,
+        get_goal_ids(query));
+    query.shared_lbs_ = cached_lbs.get();
+  }
+  MOTIS_STOP_TIMING(lb_cache_timing);
 
   auto res = search_dispatch(query, req->start_type(), req->search_type(),
                              req->search_dir());
 
+  if (cached_lbs != nullptr) {
+    res.stats_.lb_cache_hit_ = lb_cache_hit;
+    res.stats_.lb_cache_miss_ = !lb_cache_hit;
+    res.stats_.lower_bounds_us_ += MOTIS_TIMING_US(lb_cache_timing);
+  }
+
   MOTIS_STOP_TIMING(routing_timing);
   res.stats_.total_calculation_time_ = MOTIS_TIMING_MS(routing_timing);
-  res.stats_.labels_created_ = query.mem_->allocations();
-  res.stats_.num_bytes_in_use_ = query.mem_->get_num_bytes_in_use();
+  if (res.stats_.interval_parts_ == 0U) {
+    // parallel searches report the sum over their label stores
+    res.stats_.labels_created_ = query.mem_->allocations();
+    res.stats_.num_bytes_in_use_ = query.mem_->get_num_bytes_in_use();
+  }
+
+  auto const pool_stats = mem_pool_->get_stats();
+  res.stats_.mem_pool_bytes_reserved_ = pool_stats.bytes_reserved_;
+  res.stats_.mem_pool_bytes_in_use_ = pool_stats.bytes_in_use_;
+  res.stats_.mem_pool_peak_bytes_reserved_ = pool_stats.peak_bytes_reserved_;
+  res.stats_.mem_pool_trims_ = pool_stats.trims_;
+
+  if (lb_cache_ != nullptr) {
+    res.stats_.lb_cache_hits_total_ = lb_cache_->hits();
+    res.stats_.lb_cache_misses_total_ = lb_cache_->misses();
+  }
+
+  query.mem_ = nullptr;
+  query.deadline_ = nullptr;
+  query.run_parallel_ = nullptr;
+  return res;
+}
+
+msg_ptr routing::route(msg_ptr const& msg) {
+  auto const req = motis_content(RoutingRequest, msg);
+  auto const& sched = get_schedule();
+  auto query = build_query(sched, req);
+  auto const res = run_search(req, query);
+
+  message_creator fbb;
+  fbb.create_and_finish(MsgContent_RoutingResponse,
+                        write_response(fbb, sched, res).Union());
+  return make_msg(fbb);
+}
+
+msg_ptr routing::route_batch(msg_ptr const& msg) {
+  auto const batch = motis_content(RoutingBatchRequest, msg);
+  auto const& sched = get_schedule();
+
+  auto const requests = utl::to_vec(
+      *batch->requests(), [](RoutingRequest const* req) { return req; });
+  auto queries = utl::to_vec(requests, [&](RoutingRequest const* req) {
+    return build_query(sched, req);
+  });
+
+  // Share the destination dependent lower bounds between queries with the
+  // same goals and search direction. Not applicable for queries with
+  // additional edges (query specific lower bound graph). Without lower bounds
+  // cache, landmark lower bounds are preferred if available.
+  auto const landmarks_usable =
+      landmarks_ != nullptr && is_up_to_date(*landmarks_, sched);
+  std::map<std::pair<SearchDir, std::vector<int>>, std::vector<std::size_t>>
+      groups;
+  for (auto i = 0U; i < queries.size(); ++i) {
+    if ((lb_cache_ != nullptr || !landmarks_usable) &&
+        queries[i].query_edges_.empty()) {
+      groups[{requests[i]->search_dir(), get_goal_ids(queries[i])}].push_back(
+          i);
+    }
+  }
+
+  std::vector<std::shared_ptr<shared_lower_bounds>> shared_lbs;
+  std::vector<std::size_t> lb_cache_hits, lb_cache_misses;
+  for (auto const& [key, indices] : groups) {
+    if (indices.size() < 2U) {
+      continue;  // single queries use the cache in run_search
+    }
+
+    auto const dir =
+        key.first == SearchDir_Forward ? search_dir::FWD : search_dir::BWD;
+    if (lb_cache_ != nullptr) {
+      auto [lbs, hit] = lb_cache_->get(sched, dir, key.second);
+      shared_lbs.emplace_back(std::move(lbs));
+      auto& stat = hit ? lb_cache_hits : lb_cache_misses;
+      stat.insert(end(stat), begin(indices), end(indices));
+    } else {
+      shared_lbs.emplace_back(
+          std::make_shared<shared_lower_bounds>(sched, dir, key.second));
+    }
+
+    for (auto const i : indices) {
+      queries[i].shared_lbs_ = shared_lbs.back().get();
+    }
+  }
+
+  std::vector<search_result> results(queries.size());
+  std::vector<ctx::future_ptr<ctx_data, void>> futures;
+  for (auto i = 0U; i < queries.size(); ++i) {
+    futures.emplace_back(spawn_job_void(
+        [&, i]() { results[i] = run_search(requests[i], queries[i]); }));
+  }
+  ctx::await_all(futures);
+
+  for (auto const i : lb_cache_hits) {
+    results[i].stats_.lb_cache_hit_ = true;
+  }
+  for (auto const i : lb_cache_misses) {
+    results[i].stats_.lb_cache_miss_ = true;
+  }
 
   message_creator fbb;
-  std::vector<flatbuffers::Offset<Statistics>> stats{
-      to_fbs(fbb, "routing", res.stats_)};
   fbb.create_and_finish(
-      MsgContent_RoutingResponse,
-      CreateRoutingResponse(
-          fbb, fbb.CreateVectorOfSortedTables(&stats),
-          fbb.CreateVector(utl::to_vec(
-              res.journeys_,
-              [&](journey const& j) { return to_connection(fbb, j); })),
-          motis_to_unixtime(sched, res.interval_begin_),
-          motis_to_unixtime(sched, res.interval_end_),
-          fbb.CreateVector(
-              std::vector<flatbuffers::Offset<DirectConnection>>{}))
+      MsgContent_RoutingBatchResponse,
+      CreateRoutingBatchResponse(
+          fbb, fbb.CreateVector(utl::to_vec(
+                   results,
+                   [&](search_result const& res) {
+                     return write_response(fbb, sched, res);
+                   })))
           .Union());
   return make_msg(fbb);
 }
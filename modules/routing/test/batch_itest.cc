@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+#include "motis/module/message.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis::test;
+using namespace motis::module;
+using namespace motis::routing;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+namespace motis::routing {
+
+struct routing_batch : public motis_instance_test {
+  routing_batch()
+      : motis::test::motis_instance_test(dataset_opt, {"routing"}) {}
+
+  Offset<RoutingRequest> create_request(message_creator& fbb,
+                                        std::string const& from,
+                                        std::string const& to,
+                                        int const departure) const {
+    return create_pretrip_request(fbb, from, to, unix_time(departure),
+                                  unix_time(departure),
+                                  SearchType_SingleCriterion);
+  }
+};
+
+TEST_F(routing_batch, ordered_responses_with_shared_lower_bounds) {
+  message_creator fbb;
+  fbb.create_and_finish(
+      MsgContent_RoutingBatchRequest,
+      CreateRoutingBatchRequest(
+          fbb, fbb.CreateVector(std::vector<Offset<RoutingRequest>>{
+                   create_request(fbb, "8000260", "8000208", 1355),
+                   create_request(fbb, "8000260", "8000208", 1355),
+                   create_request(fbb, "8000208", "8000260", 1355)}))
+          .Union(),
+      "/routing/batch");
+  auto const res = call(make_msg(fbb));
+  auto const responses = motis_content(RoutingBatchResponse, res)->responses();
+  ASSERT_EQ(3, responses->size());
+
+  auto const shared_lb = [](RoutingResponse const* r) {
+    return get_stat(r, "routing", "shared_lb") != 0U;
+  };
+  EXPECT_TRUE(shared_lb(responses->Get(0)));
+  EXPECT_TRUE(shared_lb(responses->Get(1)));
+  EXPECT_FALSE(shared_lb(responses->Get(2)));
+
+  for (auto i = 0U; i < 2U; ++i) {
+    auto const journeys = message_to_journeys(responses->Get(i));
+    ASSERT_EQ(1, journeys.size());
+    auto const& j = journeys[0];
+    EXPECT_EQ("8000260", j.stops_.front().eva_no_);
+    EXPECT_EQ(unix_time(1355),
+              j.stops_.front().departure_.schedule_timestamp_);
+    EXPECT_EQ("8000208", j.stops_.back().eva_no_);
+    EXPECT_EQ(unix_time(1651), j.stops_.back().arrival_.schedule_timestamp_);
+  }
+
+  for (auto const& j : message_to_journeys(responses->Get(2))) {
+    EXPECT_EQ("8000208", j.stops_.front().eva_no_);
+    EXPECT_EQ("8000260", j.stops_.back().eva_no_);
+  }
+}
+
+}  // namespace motis::routing
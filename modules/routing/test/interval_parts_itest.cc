@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+#include "motis/module/message.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis::test;
+using namespace motis::module;
+using namespace motis::routing;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+namespace motis::routing {
+
+// Second instance on the same schedule without interval parts.
+struct routing_sequential_instance : public motis_instance_test {
+  routing_sequential_instance()
+      : motis::test::motis_instance_test(dataset_opt, {"routing"}) {}
+  void TestBody() override {}
+};
+
+struct routing_interval_parts : public motis_instance_test {
+  routing_interval_parts()
+      : motis::test::motis_instance_test(dataset_opt, {"routing"},
+                                         {"--routing.interval_parts=4"}) {}
+
+  msg_ptr routing_request(int const begin, int const end,
+                          unsigned const min_connection_count,
+                          std::string const& from = "8000260",
+                          std::string const& to = "8000208") const {
+    message_creator fbb;
+    return make_routing_msg(
+        fbb,
+        create_pretrip_request(fbb, from, to, unix_time(begin),
+                               unix_time(end), SearchType_Default,
+                               SearchDir_Forward, min_connection_count),
+        "/routing");
+  }
+
+  void compare_with_sequential(int const begin, int const end,
+                               unsigned const min_connection_count,
+                               std::string const& from,
+                               std::string const& to) {
+    auto const req =
+        routing_request(begin, end, min_connection_count, from, to);
+    auto const parallel_msg = call(req);
+    auto const sequential_msg = sequential_.call(req);
+    auto const parallel = motis_content(RoutingResponse, parallel_msg);
+    auto const sequential = motis_content(RoutingResponse, sequential_msg);
+
+    EXPECT_LT(1U, get_stat(parallel, "routing", "interval_parts"));
+    EXPECT_EQ(0U, get_stat(sequential, "routing", "interval_parts"));
+    EXPECT_EQ(get_journeys(sequential), get_journeys(parallel));
+    EXPECT_EQ(sequential->interval_begin(), parallel->interval_begin());
+    EXPECT_EQ(sequential->interval_end(), parallel->interval_end());
+  }
+
+  routing_sequential_instance sequential_;
+
+  static void check_pareto_set(RoutingResponse const* res) {
+    auto const journeys = message_to_journeys(res);
+    for (auto const& j : journeys) {
+      auto const dep = j.stops_.front().departure_.schedule_timestamp_;
+      EXPECT_GE(dep, res->interval_begin());
+      EXPECT_LE(dep, res->interval_end());
+    }
+
+    // no journey departs later, arrives earlier and has fewer transfers
+    for (auto const& a : journeys) {
+      for (auto const& b : journeys) {
+        if (&a == &b) {
+          continue;
+        }
+        auto const a_dep = a.stops_.front().departure_.schedule_timestamp_;
+        auto const b_dep = b.stops_.front().departure_.schedule_timestamp_;
+        auto const a_arr = a.stops_.back().arrival_.schedule_timestamp_;
+        auto const b_arr = b.stops_.back().arrival_.schedule_timestamp_;
+        EXPECT_FALSE(a_dep >= b_dep && a_arr <= b_arr &&
+                     a.transfers_ <= b.transfers_ &&
+                     (a_dep != b_dep || a_arr != b_arr ||
+                      a.transfers_ != b.transfers_));
+      }
+    }
+  }
+};
+
+TEST_F(routing_interval_parts, split_interval) {
+  auto const res = call(routing_request(1300, 1500, 0U));
+  auto const content = motis_content(RoutingResponse, res);
+
+  EXPECT_EQ(4U, get_stat(content, "routing", "interval_parts"));
+  check_pareto_set(content);
+
+  auto const journeys = message_to_journeys(content);
+  ASSERT_FALSE(journeys.empty());
+  auto const is_reference = [&](journey const& j) {
+    return j.stops_.front().eva_no_ == "8000260" &&
+           j.stops_.front().departure_.schedule_timestamp_ ==
+               unix_time(1355) &&
+           j.stops_.back().eva_no_ == "8000208" &&
+           j.stops_.back().arrival_.schedule_timestamp_ == unix_time(1651);
+  };
+  EXPECT_TRUE(std::any_of(begin(journeys), end(journeys), is_reference));
+}
+
+TEST_F(routing_interval_parts, extend_interval) {
+  auto const res = call(routing_request(1300, 1330, 1U));
+  auto const content = motis_content(RoutingResponse, res);
+
+  EXPECT_EQ(4U, get_stat(content, "routing", "interval_parts"));
+  EXPECT_NE(0U, get_stat(content, "routing", "interval_extensions"));
+  EXPECT_GT(content->interval_end(), unix_time(1330));
+  check_pareto_set(content);
+  EXPECT_FALSE(message_to_journeys(content).empty());
+}
+
+TEST_F(routing_interval_parts, same_results_as_sequential) {
+  compare_with_sequential(1300, 1500, 0U, "8000260", "8000208");
+  compare_with_sequential(1300, 1330, 1U, "8000260", "8000208");
+  compare_with_sequential(1300, 1330, 3U, "8000260", "8000208");
+  compare_with_sequential(1000, 1800, 0U, "8000208", "8000260");
+}
+
+}  // namespace motis::routing
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "motis/core/common/overlay_edges.h"
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+#include "motis/module/message.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+#include "motis/routing/landmark_lower_bounds.h"
+#include "motis/routing/landmarks.h"
+#include "motis/routing/lower_bounds.h"
+
+using namespace flatbuffers;
+using namespace motis::test;
+using namespace motis::module;
+using namespace motis::routing;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+namespace motis::routing {
+
+struct routing_landmarks : public motis_instance_test {
+  routing_landmarks()
+      : motis::test::motis_instance_test(dataset_opt, {"routing"},
+                                         {"--routing.landmarks=4"}) {}
+};
+
+TEST_F(routing_landmarks, uses_landmark_lower_bounds) {
+  auto const res = call(
+      simple_realtime_request(*this, "/routing", SearchType_SingleCriterion));
+  auto const content = motis_content(RoutingResponse, res);
+  EXPECT_EQ(1U, get_stat(content, "routing", "landmark_lb"));
+
+  auto const journeys = message_to_journeys(content);
+  ASSERT_EQ(1, journeys.size());
+
+  auto const& j = journeys[0];
+  EXPECT_EQ("8000260", j.stops_.front().eva_no_);
+  EXPECT_EQ(unix_time(1355), j.stops_.front().departure_.schedule_timestamp_);
+  EXPECT_EQ("8000208", j.stops_.back().eva_no_);
+  EXPECT_EQ(unix_time(1651), j.stops_.back().arrival_.schedule_timestamp_);
+}
+
+// Landmark bounds must not overestimate the exact (Dijkstra) lower bounds for
+// any goal and node.
+TEST_F(routing_landmarks, bounds_are_admissible) {
+  auto const& s = sched();
+  auto const lm = build_landmarks(s, 4U);
+  ASSERT_EQ(4U, lm->requested_landmark_count_);
+  ASSERT_NE(0U, lm->landmark_count_);
+
+  std::vector<node const*> nodes;
+  for (auto const& sn : s.station_nodes_) {
+    nodes.push_back(sn.get());
+    sn->for_each_route_node([&](node const* rn) { nodes.push_back(rn); });
+  }
+
+  overlay_edges<simple_edge> const no_edges;
+  for (auto const dir : {search_dir::FWD, search_dir::BWD}) {
+    auto const fwd = dir == search_dir::FWD;
+    for (auto const& goal : s.station_nodes_) {
+      std::vector<int> const goals{static_cast<int>(goal->id_)};
+      lower_bounds exact(s,
+                         fwd ? s.travel_time_lower_bounds_fwd_
+                             : s.travel_time_lower_bounds_bwd_,
+                         fwd ? s.transfers_lower_bounds_fwd_
+                             : s.transfers_lower_bounds_bwd_,
+                         goals, no_edges, no_edges);
+      exact.travel_time_.run();
+      exact.transfers_.run();
+
+      landmark_lower_bounds lbs(s, *lm, dir, goals);
+      lbs.travel_time_.run();
+      lbs.transfers_.run();
+
+      for (auto const n : nodes) {
+        EXPECT_LE(lbs.travel_time_[n], exact.travel_time_[n]);
+        EXPECT_LE(lbs.transfers_[n], exact.transfers_[n]);
+      }
+    }
+  }
+}
+
+}  // namespace motis::routing
@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+#include "motis/module/message.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis::test;
+using namespace motis::module;
+using namespace motis::routing;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+namespace motis::routing {
+
+struct routing_lower_bounds_cache : public motis_instance_test {
+  routing_lower_bounds_cache()
+      : motis::test::motis_instance_test(dataset_opt, {"routing"},
+                                         {"--routing.lb_cache_size=4"}) {}
+
+  msg_ptr routing_request() const {
+    return simple_realtime_request(*this, "/routing",
+                                   SearchType_SingleCriterion);
+  }
+};
+
+TEST_F(routing_lower_bounds_cache, second_query_hits_cache) {
+  auto const first = call(routing_request());
+  auto const first_content = motis_content(RoutingResponse, first);
+  EXPECT_EQ(1U, get_stat(first_content, "routing", "lb_cache_miss"));
+  EXPECT_EQ(0U, get_stat(first_content, "routing", "lb_cache_hit"));
+
+  auto const second = call(routing_request());
+  auto const second_content = motis_content(RoutingResponse, second);
+  EXPECT_EQ(0U, get_stat(second_content, "routing", "lb_cache_miss"));
+  EXPECT_EQ(1U, get_stat(second_content, "routing", "lb_cache_hit"));
+  EXPECT_EQ(1U, get_stat(second_content, "routing", "lb_cache_hits_total"));
+  EXPECT_EQ(1U, get_stat(second_content, "routing", "lb_cache_misses_total"));
+
+  auto const first_journeys = message_to_journeys(first_content);
+  auto const second_journeys = message_to_journeys(second_content);
+  ASSERT_EQ(1, first_journeys.size());
+  ASSERT_EQ(1, second_journeys.size());
+  EXPECT_EQ(unix_time(1651),
+            second_journeys[0].stops_.back().arrival_.schedule_timestamp_);
+  EXPECT_EQ(first_journeys[0].stops_.back().arrival_.schedule_timestamp_,
+            second_journeys[0].stops_.back().arrival_.schedule_timestamp_);
+}
+
+}  // namespace motis::routing
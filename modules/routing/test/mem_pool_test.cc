@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cstdint>
+
+#include "motis/routing/mem_retriever.h"
+
+using namespace motis::routing;
+
+namespace {
+
+constexpr auto const MB = std::size_t{1024U * 1024U};
+
+void allocate(mem_manager& mem, std::size_t const bytes) {
+  for (auto i = std::size_t{0U}; i < bytes / 1024U; ++i) {
+    mem.create<std::array<uint8_t, 1024U>>();
+  }
+}
+
+}  // namespace
+
+TEST(routing_mem_pool, reuse_label_store) {
+  mem_pool pool{mem_pool_config{4 * MB, 0U, 0U, false}};
+  mem_manager* first = nullptr;
+  {
+    mem_retriever mem(pool);
+    first = &mem.get();
+    EXPECT_EQ(4 * MB, pool.get_stats().bytes_in_use_);
+  }
+  {
+    mem_retriever mem(pool);
+    EXPECT_EQ(first, &mem.get());
+  }
+  EXPECT_EQ(4 * MB, pool.get_stats().bytes_reserved_);
+  EXPECT_EQ(0U, pool.get_stats().bytes_in_use_);
+}
+
+TEST(routing_mem_pool, trim_to_high_water_mark) {
+  mem_pool pool{mem_pool_config{2 * MB, 8 * MB, 0U, false}};
+
+  {
+    mem_retriever mem(pool);
+    allocate(mem.get(), 5 * MB);  // blocks: 2 + 4 (kept)
+  }
+  EXPECT_EQ(6 * MB, pool.get_stats().bytes_reserved_);
+  EXPECT_EQ(0U, pool.get_stats().trims_);
+
+  {
+    mem_retriever mem(pool);
+    EXPECT_EQ(2 * MB, mem.get().get_num_bytes_in_use());
+    allocate(mem.get(), 20 * MB);  // blocks: 2 + 4 + 8 + 16 (trimmed)
+    EXPECT_EQ(30 * MB, mem.get().get_num_bytes_reserved());
+  }
+  auto const stats = pool.get_stats();
+  EXPECT_EQ(6 * MB, stats.bytes_reserved_);
+  EXPECT_EQ(30 * MB, stats.peak_bytes_reserved_);
+  EXPECT_EQ(1U, stats.trims_);
+}
+
+TEST(routing_mem_pool, release_surplus_idle_label_stores) {
+  mem_pool pool{mem_pool_config{2 * MB, 0U, 1U, false}};
+  {
+    mem_retriever a(pool);
+    mem_retriever b(pool);
+    EXPECT_NE(&a.get(), &b.get());
+    EXPECT_EQ(4 * MB, pool.get_stats().bytes_in_use_);
+  }
+  EXPECT_EQ(2 * MB, pool.get_stats().bytes_reserved_);
+}
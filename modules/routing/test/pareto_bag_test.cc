@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "motis/routing/label/configs.h"
+
+namespace motis::routing {
+
+using test_label = default_label<search_dir::FWD>;
+
+std::vector<test_label> random_labels(std::size_t const count) {
+  std::mt19937 gen{42};
+  auto const rand = [&](int const max) {
+    return std::uniform_int_distribution<int>{0, max}(gen);
+  };
+
+  std::vector<test_label> labels(count);
+  for (auto& l : labels) {
+    l.pred_ = nullptr;
+    l.edge_ = nullptr;
+    l.connection_ = nullptr;
+    l.start_ = static_cast<time>(rand(20));
+    l.now_ = static_cast<time>(l.start_ + rand(20));
+    l.dominated_ = false;
+    l.travel_time_ = static_cast<duration>(l.now_ - l.start_);
+    l.travel_time_lb_ = static_cast<duration>(l.travel_time_ + rand(30));
+    l.transfers_ = 0U;
+    l.transfers_lb_ = static_cast<uint8_t>(rand(5));
+    l.absurdity_ = static_cast<uint8_t>(rand(2));
+    l.foot_counter_ = 0U;
+  }
+  return labels;
+}
+
+template <typename Bag>
+std::vector<std::size_t> indices(Bag const& bag,
+                                 std::vector<test_label> const& labels) {
+  std::vector<std::size_t> idx;
+  for (auto const* l : bag.labels_) {
+    idx.push_back(static_cast<std::size_t>(l - labels.data()));
+  }
+  std::sort(begin(idx), end(idx));
+  return idx;
+}
+
+TEST(routing_pareto_bag, soa_bag_matches_label_dominance) {
+  auto list_labels = random_labels(2000U);
+  auto soa_labels = list_labels;
+
+  label_list_bag::bag<test_label> list_bag;
+  test_label::node_bag soa_bag;
+  for (auto i = 0U; i < list_labels.size(); ++i) {
+    ASSERT_EQ(list_bag.add(&list_labels[i]), soa_bag.add(&soa_labels[i]));
+    ASSERT_EQ(list_bag.size(), soa_bag.size());
+  }
+
+  EXPECT_EQ(indices(list_bag, list_labels), indices(soa_bag, soa_labels));
+  for (auto i = 0U; i < list_labels.size(); ++i) {
+    EXPECT_EQ(list_labels[i].dominated_, soa_labels[i].dominated_);
+  }
+
+  soa_bag.clear();
+  EXPECT_EQ(0U, soa_bag.size());
+}
+
+}  // namespace motis::routing
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "motis/module/message.h"
+#include "motis/test/bench_util.h"
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+
+// Label throughput of the routing search with and without
+// dataset.reorder_graph. Both fixtures run the same fixed pretrip queries
+// (see bench_queries() in motis/test/bench_util.h) and print the journey
+// count per query, which has to match between the two layouts:
+//
+//   ./motis-bench --gtest_filter='routing_graph_*'
+
+namespace {
+
+loader::loader_options bench_dataset(bool const reorder) {
+  auto opt = motis::test::bench_dataset();
+  opt.reorder_graph_ = reorder;
+  return opt;
+}
+
+}  // namespace
+
+struct routing_graph_bench : public motis_instance_test {
+  explicit routing_graph_bench(bool const reorder)
+      : motis_instance_test(bench_dataset(reorder), {"routing"}) {}
+
+  void run(char const* layout) {
+    auto const queries = bench_queries();
+    uint64_t labels = 0U, pareto_dijkstra_ms = 0U;
+    auto const start = std::chrono::steady_clock::now();
+    for (auto const& q : queries) {
+      message_creator fbb;
+      auto const res = call(make_routing_msg(
+          fbb,
+          create_pretrip_request(fbb, q.from_, q.to_, unix_time(q.departure_),
+                                 unix_time(q.departure_) + 2 * 3600),
+          "/routing"));
+      labels += get_stat(res, "routing", "labels_created");
+      pareto_dijkstra_ms += get_stat(res, "routing", "pareto_dijkstra");
+      std::cout << layout << ": " << q.from_ << " -> " << q.to_ << " @"
+                << q.departure_ << ": " << get_journeys(res).size()
+                << " journeys\n";
+    }
+    auto const total_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+
+    std::cout << layout << ": " << queries.size() << " queries, " << labels
+              << " labels, pareto_dijkstra " << pareto_dijkstra_ms
+              << " ms, total " << total_ms << " ms, "
+              << (pareto_dijkstra_ms == 0U
+                      ? 0.0
+                      : labels * 1000.0 / pareto_dijkstra_ms)
+              << " labels/s\n";
+    EXPECT_NE(0U, labels);
+  }
+};
+
+struct routing_graph_default : public routing_graph_bench {
+  routing_graph_default() : routing_graph_bench(false) {}
+};
+
+struct routing_graph_reordered : public routing_graph_bench {
+  routing_graph_reordered() : routing_graph_bench(true) {}
+};
+
+TEST_F(routing_graph_default, labels_per_second) { run("default"); }
+
+TEST_F(routing_graph_reordered, labels_per_second) { run("reordered"); }
@@ -331,6 +331,7 @@ inline void update_trip(schedule& sched, trip* trp,
   for (auto const& trp_e : *trp->edges_) {
     auto const e = trp_e.get_edge();
     e->m_.route_edge_.conns_[trp->lcon_idx_].valid_ = 0U;
+    e->update_route_edge_index(sched.route_edge_indices_);
   }
 
   auto const trps = mcd::vector<ptr<trip>>{trp};
@@ -347,10 +348,12 @@ inline void update_trip(schedule& sched, trip* trp,
   trp->lcon_idx_ = 0;
 }
 
-inline void disable_trip(mcd::vector<trip::route_edge> const& edges,
+inline void disable_trip(schedule& sched,
+                         mcd::vector<trip::route_edge> const& edges,
                          int lcon_idx) {
   for (auto const& e : edges) {
     e->m_.route_edge_.conns_[lcon_idx].valid_ = 0U;
+    e->update_route_edge_index(sched.route_edge_indices_);
   }
 }
 
@@ -387,7 +390,7 @@ inline std::pair<reroute_result, trip const*> reroute(
   add_additional_events(stats, sched, cancelled_delays, trp, additional, evs);
   add_not_deleted_trip_events(sched, del_evs, trp, evs);
   if (evs.empty()) {
-    disable_trip(*old_trip, old_lcon_idx);
+    disable_trip(sched, *old_trip, old_lcon_idx);
     return {reroute_result::OK, trp};
   }
   std::sort(begin(evs), end(evs));
@@ -406,7 +409,7 @@ inline std::pair<reroute_result, trip const*> reroute(
   update_delay_infos(sched, evs, trip_edges);
   update_trip(sched, trp, trip_edges);
   store_cancelled_delays(sched, trp, del_evs, cancelled_delays, cancelled_evs);
-  disable_trip(*old_trip, old_lcon_idx);
+  disable_trip(sched, *old_trip, old_lcon_idx);
 
   update_builder.add_reroute(trp, *old_trip, old_lcon_idx);
 
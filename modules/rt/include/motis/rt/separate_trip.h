@@ -28,11 +28,14 @@ inline std::map<node const*, in_out_allowed> get_route_in_out_allowed(
   return in_out_allowed;
 }
 
-inline edge copy_edge(edge const& original, node* from, node* to,
-                      int lcon_index) {
+inline edge copy_edge(schedule& sched, edge const& original, node* from,
+                      node* to, int lcon_index) {
   edge e;
   if (original.type() == edge::ROUTE_EDGE) {
     e = make_route_edge(from, to, {original.m_.route_edge_.conns_[lcon_index]});
+    if (original.has_route_edge_index()) {
+      e.build_route_edge_index(sched.route_edge_indices_);
+    }
   } else {
     e = original;
     e.from_ = from;
@@ -60,13 +63,14 @@ inline void copy_trip_route(
     auto const to =
         utl::get_or_create(nodes, e->to_, [&] { return build_node(e->to_); });
 
-    from->edges_.push_back(copy_edge(*e, from, to, k.lcon_idx_));
+    from->edges_.push_back(copy_edge(sched, *e, from, to, k.lcon_idx_));
     edges[e] = trip::route_edge(&from->edges_.back());
     constant_graph_add_route_edge(sched, edges[e]);
 
     if (e->type() == edge::ROUTE_EDGE) {
       auto const& lcon = e->m_.route_edge_.conns_[k.lcon_idx_];
       const_cast<light_connection&>(lcon).valid_ = false;  // NOLINT
+      e->update_route_edge_index(sched.route_edge_indices_);
     }
   }
 }
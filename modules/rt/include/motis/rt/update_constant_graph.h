@@ -19,6 +19,7 @@ inline void constant_graph_add_route_node(schedule& sched, int route_index,
           return se.to_ == from;
         }) == end(fwd_edges)) {
       fwd_edges.emplace_back(from, is_exit);
+      ++sched.constant_graph_version_;
     }
 
     auto& bwd_edges = sched.transfers_lower_bounds_bwd_[from];
@@ -26,11 +27,15 @@ inline void constant_graph_add_route_node(schedule& sched, int route_index,
           return se.to_ == to;
         }) == end(bwd_edges)) {
       bwd_edges.emplace_back(to, !is_exit);
+      ++sched.constant_graph_version_;
     }
   };
 
-  sched.transfers_lower_bounds_fwd_.resize(cg_size);
-  sched.transfers_lower_bounds_bwd_.resize(cg_size);
+  if (sched.transfers_lower_bounds_fwd_.size() != cg_size) {
+    sched.transfers_lower_bounds_fwd_.resize(cg_size);
+    sched.transfers_lower_bounds_bwd_.resize(cg_size);
+    ++sched.constant_graph_version_;
+  }
 
   if (in_allowed) {
     add_edge(sn->id_, route_lb_node_id, false);
@@ -51,11 +56,15 @@ inline void constant_graph_add_route_edge(schedule& sched,
                               uint32_t const to) {
     for (auto& se : cg[from]) {
       if (se.to_ == to) {
-        se.cost_ = std::min(se.cost_, min_cost.time_);
+        if (min_cost.time_ < se.cost_) {
+          se.cost_ = min_cost.time_;
+          ++sched.constant_graph_version_;
+        }
         return;
       }
     }
     cg[from].emplace_back(to, min_cost.time_);
+    ++sched.constant_graph_version_;
   };
 
   auto const from_station_id = route_edge->from_->get_station()->id_;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 
 #include "utl/verify.h"
@@ -43,6 +44,30 @@ inline void validate_graph(schedule const& sched) {
       }(),
       "all light connections sorted after rt update");
 
+  utl::verify(
+      [&] {
+        for (auto const& sn : sched.station_nodes_) {
+          for (auto const& rn : sn->route_nodes_) {
+            for (auto const& re : rn->edges_) {
+              if (!re.has_route_edge_index()) {
+                continue;
+              }
+
+              mcd::vector<uint16_t> expected;
+              re.write_route_edge_index(expected);
+              auto const& actual =
+                  sched.route_edge_indices_[re.m_.route_edge_.index_id_ - 1U];
+              if (!std::equal(begin(expected), end(expected), begin(actual),
+                              end(actual))) {
+                return false;
+              }
+            }
+          }
+        }
+        return true;
+      }(),
+      "route edge indices up to date after rt update");
+
   utl::verify(
       [&] {
         auto const check_edges = [](node const* n) {
@@ -264,6 +264,7 @@ void rt_handler::propagate() {
   }
 
   for (auto const& re : updated_route_edges) {
+    re->update_route_edge_index(sched_.route_edge_indices_);
     constant_graph_add_route_edge(sched_, re);
   }
 
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "motis/core/common/fws_multimap.h"
+
+#include "motis/tripbased/data.h"
+
+namespace motis::tripbased {
+
+// Encodes the transfers of the data (see compressed_transfers in data.h),
+// also data with compressed transfers and a transfer overlay.
+compressed_transfers compress_transfers(tb_data const& data);
+
+// Replaces data.transfers_ (or the compressed transfers and the transfer
+// overlay) with new compressed transfers (searches use
+// tb_data::for_each_transfer).
+void use_compressed_transfers(tb_data& data);
+
+// Decodes the compressed transfers (and the transfer overlay) of the data.
+void decompress_transfers(tb_data const& data,
+                          nested_fws_multimap<tb_transfer>& transfers);
+
+}  // namespace motis::tripbased
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -77,18 +80,157 @@ struct tb_reverse_transfer {
   stop_idx_t to_stop_idx_{std::numeric_limits<stop_idx_t>::max()};
 };
 
+// Forward transfers as a byte stream of varints (7 bits per byte, high bit:
+// more bytes follow), built by compress_transfers (compressed_transfers.h).
+// Each transfer: zigzag delta of the target trip (to the previous target, for
+// the first one to the source trip) and the target stop index. The keys of
+// transfers_ are grouped in blocks of BLOCK_SIZE with the byte offset of each
+// block in the skip index; the transfers of each key are prefixed with their
+// length in bytes.
+struct compressed_transfers {
+  static constexpr auto const BLOCK_SIZE = 16U;
+
+  static uint32_t read_varint(uint8_t const*& pos) {
+    auto val = 0U;
+    for (auto shift = 0U;; shift += 7U) {
+      auto const b = *pos++;
+      val |= static_cast<uint32_t>(b & 0x7FU) << shift;
+      if ((b & 0x80U) == 0U) {
+        return val;
+      }
+    }
+  }
+
+  bool empty() const { return block_offsets_.empty(); }
+
+  std::size_t size_in_bytes() const {
+    return block_offsets_.size() * sizeof(uint64_t) + data_.size();
+  }
+
+  template <typename Fn>
+  void for_each(uint64_t const key, trip_id const from_trip, Fn&& fn) const {
+    auto pos = data_.data() + block_offsets_[key / BLOCK_SIZE];
+    for (auto i = key % BLOCK_SIZE; i != 0U; --i) {
+      auto const skip = read_varint(pos);
+      pos += skip;
+    }
+    auto const len = read_varint(pos);
+    auto const end = pos + len;
+    auto to_trip = from_trip;
+    while (pos != end) {
+      auto const zigzag = read_varint(pos);
+      to_trip += (zigzag >> 1U) ^ (0U - (zigzag & 1U));
+      auto const to_stop_idx = static_cast<stop_idx_t>(read_varint(pos));
+      fn(tb_transfer{to_trip, to_stop_idx});
+    }
+  }
+
+  std::vector<uint64_t> block_offsets_;  // + end offset
+  std::vector<uint8_t> data_;
+};
+
+// Transfers recomputed by realtime updates since the transfers were
+// compressed (see apply_trip_updates in update_data.h): they replace the
+// compressed transfers of their trips until the overlay is merged into new
+// compressed transfers in the background. Updates can re-sort the trips of a
+// line, i.e. the trip ids of the compressed transfers can differ from the
+// current trip ids.
+struct transfer_overlay {
+  static constexpr auto const NO_KEY = std::numeric_limits<uint32_t>::max();
+
+  bool empty() const {
+    return first_key_.empty() && to_compressed_trip_.empty();
+  }
+
+  std::size_t size_in_bytes() const {
+    return (first_key_.size() + index_.size() + to_compressed_trip_.size() +
+            to_current_trip_.size()) *
+               sizeof(uint32_t) +
+           transfers_.size() * sizeof(tb_transfer);
+  }
+
+  // Trip -> key of its first stop in index_ (NO_KEY: compressed transfers).
+  std::vector<uint32_t> first_key_;
+  std::vector<uint32_t> index_;  // + end
+  std::vector<tb_transfer> transfers_;
+
+  // Trip ids current <-> compressed transfers (empty: equal).
+  std::vector<trip_id> to_compressed_trip_;
+  std::vector<trip_id> to_current_trip_;
+};
+
+// Number of times < t (<= t if Inclusive) in a sorted time column: counting
+// scan (vectorizable) for short columns, branchless binary search otherwise.
+template <bool Inclusive>
+inline std::size_t count_times_before(motis::time const* times,
+                                      std::size_t count, motis::time t) {
+  constexpr auto const LINEAR_SEARCH_LIMIT = 32U;
+  auto const before = [t](motis::time const x) {
+    return Inclusive ? x <= t : x < t;
+  };
+  if (count <= LINEAR_SEARCH_LIMIT) {
+    std::size_t result = 0U;
+    for (auto i = 0U; i < count; ++i) {
+      result += before(times[i]) ? 1U : 0U;
+    }
+    return result;
+  }
+  auto base = times;
+  while (count > 1) {
+    auto const half = count / 2;
+    base = before(base[half]) ? base + half : base;
+    count -= half;
+  }
+  return static_cast<std::size_t>(base - times) + (before(*base) ? 1U : 0U);
+}
+
 struct tb_data {
+  // Lines whose trips are not in FIFO order (realtime updates, see
+  // update_data.h): no trip dominates the later trips of the line.
+  bool is_dirty(line_id line) const {
+    return !dirty_lines_.empty() && dirty_lines_[line] != 0U;
+  }
+
+  // Index of the trip in sched.expanded_trips_.data_.
+  uint32_t sched_trip_idx(trip_id trip) const {
+    return sched_trip_idx_.empty() ? trip : sched_trip_idx_[trip];
+  }
+
+  trip_id tb_trip_idx(uint32_t sched_trip_idx) const {
+    return tb_trip_idx_.empty() ? sched_trip_idx
+                                : tb_trip_idx_[sched_trip_idx];
+  }
+
+  std::size_t line_trip_count(line_id line) const {
+    return line_to_last_trip_[line] - line_to_first_trip_[line] + 1;
+  }
+
+  // Departure / arrival times of all trips of the line at the stop.
+  motis::time const* line_departure_times(line_id line,
+                                          stop_idx_t stop_idx) const {
+    return line_departure_times_.data_.data() +
+           line_departure_times_.index_[line] +
+           stop_idx * line_trip_count(line);
+  }
+
+  motis::time const* line_arrival_times(line_id line,
+                                        stop_idx_t stop_idx) const {
+    return line_arrival_times_.data_.data() +
+           line_departure_times_.index_[line] +
+           stop_idx * line_trip_count(line);
+  }
+
   std::optional<std::pair<trip_id, time>> first_reachable_trip(
       line_id line, stop_idx_t stop_idx, time earliest_departure) const {
     assert(line < line_count_);
-    for (auto trip = line_to_first_trip_[line];
-         trip < trip_count_ && trip_to_line_[trip] == line; ++trip) {
-      auto const dep_time = departure_times_[trip][stop_idx];
-      if (dep_time >= earliest_departure) {
-        return std::make_pair(trip, dep_time);
-      }
+    auto const times = line_departure_times(line, stop_idx);
+    auto const count = line_trip_count(line);
+    auto const idx = static_cast<trip_id>(
+        count_times_before<false>(times, count, earliest_departure));
+    if (idx == count) {
+      return {};
     }
-    return {};
+    return std::make_pair(line_to_first_trip_[line] + idx, times[idx]);
   }
 
   std::pair<std::optional<std::pair<trip_id, time>>,
@@ -96,35 +238,31 @@ struct tb_data {
   first_and_previous_reachable_trip(line_id line, stop_idx_t stop_idx,
                                     time earliest_departure) const {
     assert(line < line_count_);
+    auto const times = line_departure_times(line, stop_idx);
+    auto const count = line_trip_count(line);
     auto const first_trip_in_line = line_to_first_trip_[line];
-    auto const last_trip_in_line = line_to_last_trip_[line];
-    for (auto trip = first_trip_in_line; trip <= last_trip_in_line; ++trip) {
-      auto const dep_time = departure_times_[trip][stop_idx];
-      if (dep_time >= earliest_departure) {
-        if (trip != first_trip_in_line) {
-          return {{{trip, dep_time}},
-                  {{trip - 1, departure_times_[trip - 1][stop_idx]}}};
-        } else {
-          return {{{trip, dep_time}}, {}};
-        }
-      }
+    auto const idx = static_cast<trip_id>(
+        count_times_before<false>(times, count, earliest_departure));
+    if (idx == count) {
+      return {{}, {{first_trip_in_line + idx - 1, times[idx - 1]}}};
+    } else if (idx != 0) {
+      return {{{first_trip_in_line + idx, times[idx]}},
+              {{first_trip_in_line + idx - 1, times[idx - 1]}}};
+    } else {
+      return {{{first_trip_in_line, times[0]}}, {}};
     }
-    return {
-        {},
-        {{last_trip_in_line, departure_times_[last_trip_in_line][stop_idx]}}};
   }
 
   std::optional<std::pair<trip_id, time>> last_reachable_trip(
       line_id line, stop_idx_t stop_idx, time latest_arrival) const {
     assert(line < line_count_);
-    for (auto trip = static_cast<int>(line_to_last_trip_[line]);
-         trip >= 0 && trip_to_line_[trip] == line; --trip) {
-      auto const arr_time = arrival_times_[trip][stop_idx];
-      if (arr_time <= latest_arrival) {
-        return std::make_pair(trip, arr_time);
-      }
+    auto const times = line_arrival_times(line, stop_idx);
+    auto const idx = static_cast<trip_id>(count_times_before<true>(
+        times, line_trip_count(line), latest_arrival));
+    if (idx == 0) {
+      return {};
     }
-    return {};
+    return std::make_pair(line_to_first_trip_[line] + idx - 1, times[idx - 1]);
   }
 
   std::pair<std::optional<std::pair<trip_id, time>>,
@@ -132,23 +270,48 @@ struct tb_data {
   last_and_next_reachable_trip(line_id line, stop_idx_t stop_idx,
                                time latest_arrival) const {
     assert(line < line_count_);
+    auto const times = line_arrival_times(line, stop_idx);
+    auto const count = line_trip_count(line);
     auto const first_trip_in_line = line_to_first_trip_[line];
-    auto const last_trip_in_line = line_to_last_trip_[line];
-    for (auto trip = static_cast<int>(line_to_last_trip_[line]);
-         trip >= static_cast<int>(first_trip_in_line); --trip) {
-      auto const arr_time = arrival_times_[trip][stop_idx];
-      if (arr_time <= latest_arrival) {
-        if (trip != last_trip_in_line) {
-          return {{{trip, arr_time}},
-                  {{trip + 1, arrival_times_[trip + 1][stop_idx]}}};
-        } else {
-          return {{{trip, arr_time}}, {}};
-        }
+    auto const idx = static_cast<trip_id>(
+        count_times_before<true>(times, count, latest_arrival));
+    if (idx == 0) {
+      return {{}, {{first_trip_in_line, times[0]}}};
+    } else if (idx != count) {
+      return {{{first_trip_in_line + idx - 1, times[idx - 1]}},
+              {{first_trip_in_line + idx, times[idx]}}};
+    } else {
+      return {{{first_trip_in_line + idx - 1, times[idx - 1]}}, {}};
+    }
+  }
+
+  // Calls fn for the transfers of the trip at the stop, decoded on the fly if
+  // the transfers are compressed.
+  template <typename Fn>
+  void for_each_transfer(trip_id const trip, stop_idx_t const stop_idx,
+                         Fn&& fn) const {
+    auto const& overlay = transfer_overlay_;
+    if (compressed_transfers_ == nullptr) {
+      for (auto const& transfer : transfers_.at(trip, stop_idx)) {
+        fn(transfer);
+      }
+    } else if (!overlay.first_key_.empty() &&
+               overlay.first_key_[trip] != transfer_overlay::NO_KEY) {
+      auto const key = overlay.first_key_[trip] + stop_idx;
+      for (auto i = overlay.index_[key]; i != overlay.index_[key + 1]; ++i) {
+        fn(overlay.transfers_[i]);
       }
+    } else if (overlay.to_compressed_trip_.empty()) {
+      compressed_transfers_->for_each(arrival_times_.index_[trip] + stop_idx,
+                                      trip, fn);
+    } else {
+      auto const from = overlay.to_compressed_trip_[trip];
+      compressed_transfers_->for_each(
+          arrival_times_.index_[from] + stop_idx, from, [&](tb_transfer t) {
+            t.to_trip_ = overlay.to_current_trip_[t.to_trip_];
+            fn(t);
+          });
     }
-    return {
-        {},
-        {{first_trip_in_line, arrival_times_[first_trip_in_line][stop_idx]}}};
   }
 
   uint64_t trip_count_{};
@@ -170,8 +333,25 @@ struct tb_data {
   nested_fws_multimap<tb_reverse_transfer> reverse_transfers_{
       arrival_times_.index_};
 
+  // Same times, stop-major per line (all trips of the line at stop 0, then
+  // at stop 1, ...), sorted for each stop (FIFO) unless the line is dirty.
+  fws_multimap<motis::time> line_departure_times_{};
+  shared_idx_fws_multimap<motis::time> line_arrival_times_{
+      line_departure_times_.index_};
+
   fws_multimap<uint8_t, uint32_t> in_allowed_{};
   shared_idx_fws_multimap<uint8_t, uint32_t> out_allowed_{in_allowed_.index_};
+
+  // Realtime state (not serialized, empty until trips are re-sorted /
+  // lines become dirty): tb trip -> expanded trip and inverse, dirty flags.
+  std::vector<uint32_t> sched_trip_idx_;
+  std::vector<trip_id> tb_trip_idx_;
+  std::vector<uint8_t> dirty_lines_;
+
+  // Replace transfers_ if set (not serialized). The compressed transfers are
+  // shared by the data versions of realtime updates.
+  std::shared_ptr<compressed_transfers const> compressed_transfers_;
+  transfer_overlay transfer_overlay_;
 };
 
 }  // namespace motis::tripbased
@@ -2,8 +2,7 @@
 
 #include <vector>
 
-#include "motis/hash_map.h"
-
+#include "motis/core/common/overlay_edges.h"
 #include "motis/core/schedule/constant_graph.h"
 #include "motis/core/schedule/schedule.h"
 
@@ -15,8 +14,7 @@ namespace motis::tripbased {
 struct lower_bounds {
   lower_bounds(constant_graph const& travel_time_graph,
                std::vector<int> const& goals,
-               mcd::hash_map<unsigned, std::vector<simple_edge>> const&
-                   additional_travel_time_edges)
+               overlay_edges<simple_edge> const& additional_travel_time_edges)
       : travel_time_(travel_time_graph, goals, additional_travel_time_edges) {}
   constant_graph_dijkstra<MAX_TRAVEL_TIME, map_station_graph_node> travel_time_;
 };
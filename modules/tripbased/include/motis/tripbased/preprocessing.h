@@ -1,15 +1,37 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "motis/core/schedule/schedule.h"
 
 #include "motis/tripbased/data.h"
+#include "motis/tripbased/serialization.h"
 
 namespace motis::tripbased {
 
 std::unique_ptr<tb_data> build_data(schedule const& sched);
 
-std::unique_ptr<tb_data> load_data(schedule const& sched,
-                                   std::string const& filename);
+// Transfers / reverse transfers (per stop) of the given trips, computed on
+// the current trip times (used for realtime updates, see update_data.h).
+std::vector<std::vector<std::vector<tb_transfer>>> compute_transfers(
+    schedule const& sched, tb_data& data, std::vector<trip_id> const& trips);
+
+std::vector<std::vector<std::vector<tb_reverse_transfer>>>
+compute_reverse_transfers(schedule const& sched, tb_data& data,
+                          std::vector<trip_id> const& trips);
+
+// Copies the (changed) trip times of the line to the stop-major line times.
+void update_line_times(tb_data& data, line_id line);
+
+// Computes all transfers of data without transfers (trips, lines and
+// footpaths must be initialized).
+void precompute_transfers(schedule const& sched, tb_data& data);
+
+// Uses the file contents in place (read-only, see mapped_data).
+std::unique_ptr<serialization::mapped_data> load_data(
+    schedule const& sched, std::string const& filename);
 
 void update_data_file(schedule const& sched, std::string const& filename,
                       bool force_update);
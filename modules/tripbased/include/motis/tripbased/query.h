@@ -1,5 +1,7 @@
 #pragma once
 
+#include "motis/core/common/deadline.h"
+
 #include "motis/tripbased/data.h"
 
 #include "motis/protocol/RoutingRequest_generated.h"
@@ -59,6 +61,11 @@ struct trip_based_query {
   search_dir dir_{search_dir::FWD};
   std::vector<additional_edge> start_edges_;
   std::vector<additional_edge> destination_edges_;
+  deadline* deadline_{nullptr};
+
+  // Number of concurrent profile searches over parts of the interval of
+  // pretrip queries (<= 1: sequential).
+  unsigned profile_jobs_{1U};
 };
 
 }  // namespace motis::tripbased
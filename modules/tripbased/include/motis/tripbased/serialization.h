@@ -2,59 +2,54 @@
 
 #include <cstdint>
 #include <ctime>
+#include <memory>
 #include <string>
 
+#include "cista/memory_holder.h"
+
+#include "motis/string.h"
+#include "motis/vector.h"
+
+#include "motis/core/common/fws_multimap.h"
 #include "motis/core/schedule/schedule.h"
 #include "motis/tripbased/data.h"
 
 namespace motis::tripbased::serialization {
 
-struct array_offset {
-  array_offset() = default;
-  array_offset(uint64_t start, uint64_t length)
-      : start_(start), length_(length) {}
-
-  uint64_t start_{};
-  uint64_t length_{};
-};
-
-struct fws_multimap_offset {
-  fws_multimap_offset() = default;
-  fws_multimap_offset(array_offset const& index, array_offset const& data)
-      : index_(index), data_(data) {}
-
-  array_offset index_{};
-  array_offset data_{};
-};
-
-struct header {
+// Layout of tripbased.bin (cista). Used in place: tb_data read from the file
+// refers to these vectors without copying them (memory mapped in offset
+// mode).
+struct tb_serialized_data {
   uint64_t version_{};
 
-  char schedule_name_[1024]{};
+  mcd::string schedule_name_;
   int64_t schedule_begin_{};
   int64_t schedule_end_{};
 
   uint64_t trip_count_{};
   uint64_t line_count_{};
 
-  // offsets
-  array_offset line_to_first_trip_{};
-  array_offset line_to_last_trip_{};
-  array_offset trip_to_line_{};
-  array_offset line_stop_count_{};
-
-  fws_multimap_offset footpaths_{};
-  fws_multimap_offset reverse_footpaths_{};
-  fws_multimap_offset lines_at_stop_{};
-  fws_multimap_offset stops_on_line_{};
-
-  fws_multimap_offset arrival_times_{};
-  array_offset departure_times_data_{};
-  fws_multimap_offset transfers_{};
-  fws_multimap_offset reverse_transfers_{};
-
-  fws_multimap_offset in_allowed_{};
-  array_offset out_allowed_data_{};
+  mcd::vector<trip_id> line_to_first_trip_;
+  mcd::vector<trip_id> line_to_last_trip_;
+  mcd::vector<line_id> trip_to_line_;
+  mcd::vector<stop_idx_t> line_stop_count_;
+
+  fws_multimap<tb_footpath, station_id> footpaths_;
+  fws_multimap<tb_footpath, station_id> reverse_footpaths_;
+  fws_multimap<line_stop, station_id> lines_at_stop_;
+  fws_multimap<station_id, line_id> stops_on_line_;
+
+  fws_multimap<motis::time> arrival_times_;
+  mcd::vector<motis::time> departure_times_;
+  mcd::vector<uint64_t> transfers_index_;
+  mcd::vector<tb_transfer> transfers_;
+  mcd::vector<uint64_t> reverse_transfers_index_;
+  mcd::vector<tb_reverse_transfer> reverse_transfers_;
+  fws_multimap<motis::time> line_departure_times_;
+  mcd::vector<motis::time> line_arrival_times_;
+
+  fws_multimap<uint8_t, uint32_t> in_allowed_;
+  mcd::vector<uint8_t> out_allowed_;
 };
 
 void write_data(tb_data const& data, std::string const& filename,
@@ -62,7 +57,25 @@ void write_data(tb_data const& data, std::string const& filename,
 
 bool data_okay_for_schedule(std::string const& filename, schedule const& sched);
 
-std::unique_ptr<tb_data> read_data(std::string const& filename,
-                                   schedule const& sched);
+// tb_data that uses the vectors of a data file in place (memory mapped
+// read-only in offset mode, one buffer in raw mode). Only const access: the
+// data cannot be patched. Realtime updates build new data on the heap
+// (apply_trip_updates) that replaces the mapping, transfer compression works
+// on a deep copy (copy_data).
+struct mapped_data {
+  mapped_data(std::string const& filename, schedule const& sched);
+
+  mapped_data(mapped_data const&) = delete;
+  mapped_data& operator=(mapped_data const&) = delete;
+  mapped_data(mapped_data&&) = delete;
+  mapped_data& operator=(mapped_data&&) = delete;
+  ~mapped_data() = default;
+
+  tb_data const& get() const { return data_; }
+
+private:
+  cista::memory_holder mem_;
+  tb_data data_;  // non-owning views of mem_
+};
 
 }  // namespace motis::tripbased::serialization
@@ -9,6 +9,7 @@
 
 #include "utl/erase_if.h"
 
+#include "motis/core/common/deadline.h"
 #include "motis/core/common/logging.h"
 #include "motis/core/schedule/edges.h"
 
@@ -92,6 +93,9 @@ struct tb_ontrip_search {
     add_direct_walks();
 
     for (auto transfers = 0U; transfers < MAX_TRANSFERS; ++transfers) {
+      if (timeout_reached()) {
+        break;
+      }
       auto& queue = queues_[transfers];  // NOLINT
       if (!queue.empty()) {
         ++stats_.queue_count_;
@@ -134,7 +138,17 @@ struct tb_ontrip_search {
   tb_statistics& get_statistics() { return stats_; }
   tb_statistics const& get_statistics() const { return stats_; }
 
+  void set_deadline(deadline* search_deadline) { deadline_ = search_deadline; }
+
 private:
+  bool timeout_reached() {
+    if (deadline_ != nullptr && deadline_->check()) {
+      stats_.timeout_quit_ = 1;
+      return true;
+    }
+    return false;
+  }
+
   void add_start(tb_footpath const& fp, time initial_duration) {
     auto const offset = initial_duration + fp.duration_;
     auto const arrival_time = static_cast<time>(
@@ -154,6 +168,10 @@ private:
           (Dir == search_dir::BWD && stop_idx == 0)) {
         continue;
       }
+      if (data_.is_dirty(line)) {
+        add_dirty_line_start(line, stop_idx, arrival_time);
+        continue;
+      }
       auto const trip =
           Dir == search_dir::FWD
               ? data_.first_reachable_trip(line, stop_idx, arrival_time)
@@ -164,6 +182,21 @@ private:
     }
   }
 
+  // No FIFO order: every trip that can be reached is a candidate.
+  void add_dirty_line_start(line_id line, stop_idx_t stop_idx,
+                            time arrival_time) {
+    for (auto trip = data_.line_to_first_trip_[line];
+         trip <= data_.line_to_last_trip_[line]; ++trip) {
+      auto const t = Dir == search_dir::FWD
+                         ? data_.departure_times_[trip][stop_idx]
+                         : data_.arrival_times_[trip][stop_idx];
+      if (t != INVALID_TIME && (Dir == search_dir::FWD ? t >= arrival_time
+                                                       : t <= arrival_time)) {
+        enqueue(trip, stop_idx, 0, 0);
+      }
+    }
+  }
+
   void add_destination(tb_footpath const& fp) {
     auto const dest_stop = Dir == search_dir::FWD ? fp.from_stop_ : fp.to_stop_;
     for (auto const& [line, stop_idx, _] : data_.lines_at_stop_[dest_stop]) {
@@ -252,12 +285,12 @@ private:
                    static_cast<stop_idx_t>(data_.line_stop_count_[line] - 1));
       for (auto stop_idx = entry.from_stop_index_ + 1; stop_idx <= stop_count;
            ++stop_idx) {
-        for (auto const& transfer :
-             data_.transfers_.at(entry.trip_, stop_idx)) {
-          ++stats_.transfers_scanned_;
-          enqueue(transfer.to_trip_, transfer.to_stop_idx_, transfers + 1,
-                  current_trip_segment);
-        }
+        data_.for_each_transfer(
+            entry.trip_, stop_idx, [&](tb_transfer const& transfer) {
+              ++stats_.transfers_scanned_;
+              enqueue(transfer.to_trip_, transfer.to_stop_idx_,
+                      transfers + 1, current_trip_segment);
+            });
       }
     }
   }
@@ -320,8 +353,11 @@ private:
                          previous_trip_segment);
 
       auto const line = data_.trip_to_line_[trip];
-      for (trip_id t = trip;
-           t < data_.trip_count_ && data_.trip_to_line_[t] == line; ++t) {
+      auto const dirty = data_.is_dirty(line);
+      for (trip_id t = trip; t < data_.trip_count_ &&
+                             data_.trip_to_line_[t] == line &&
+                             (t == trip || !dirty);
+           ++t) {
         first_reachable_stop_[t] =
             std::min(first_reachable_stop_[t], stop_index);
       }
@@ -334,7 +370,10 @@ private:
       queue.emplace_back(trip, old_last_reachable, stop_index,
                          previous_trip_segment);
       auto const line = data_.trip_to_line_[trip];
-      for (trip_id t = trip; t >= 0 && data_.trip_to_line_[t] == line; --t) {
+      auto const dirty = data_.is_dirty(line);
+      for (trip_id t = trip;
+           t >= 0 && data_.trip_to_line_[t] == line && (t == trip || !dirty);
+           --t) {
         first_reachable_stop_[t] =
             std::max(first_reachable_stop_[t], stop_index);
         if (t == 0) {
@@ -446,6 +485,7 @@ private:
   std::array<std::vector<queue_entry>, MAX_TRANSFERS + 1> queues_;
   std::vector<stop_idx_t> first_reachable_stop_;
   tb_statistics stats_{};
+  deadline* deadline_{nullptr};
 };
 
 }  // namespace motis::tripbased
@@ -2,7 +2,10 @@
 
 #include <algorithm>
 #include <array>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <numeric>
 #include <optional>
 #include <queue>
 #include <tuple>
@@ -12,6 +15,7 @@
 #include "utl/erase_if.h"
 #include "utl/get_or_create.h"
 
+#include "motis/core/common/deadline.h"
 #include "motis/core/common/logging.h"
 #include "motis/core/schedule/edges.h"
 
@@ -101,19 +105,36 @@ struct tb_profile_search {
     journeys_.resize(sched_.stations_.size());
     if (Dir == search_dir::FWD) {
       for (start_time_ = static_cast<time>(interval_end_ + 1);
-           start_time_ >= interval_begin_;
+           start_time_ >= interval_begin_ && !timeout_reached();
            start_time_ = next_iteration_start_time_) {
         search_iteration();
       }
     } else {
       for (start_time_ = static_cast<time>(interval_begin_ - 1);
-           start_time_ <= interval_end_;
+           start_time_ <= interval_end_ && !timeout_reached();
            start_time_ = next_iteration_start_time_) {
         search_iteration();
       }
     }
   }
 
+  // Adds the results of a search over a later (FWD) / earlier (BWD) part of
+  // the interval. Journeys dominated by a journey that departs no earlier,
+  // arrives no later and has no more transfers are removed (the sequential
+  // search prunes them with its earliest arrival times).
+  void merge_results(tb_profile_search& other) {
+    for (auto& [destination, journeys] : other.results_) {
+      auto& results = utl::get_or_create(
+          results_, destination, []() { return std::vector<tb_journey>(); });
+      results.reserve(results.size() + journeys.size());
+      std::move(begin(journeys), end(journeys), std::back_inserter(results));
+      remove_dominated(results);
+    }
+    other.results_.clear();
+    result_count_ += other.result_count_;
+    add_statistics(stats_, other.stats_);
+  }
+
   std::vector<tb_journey>& get_results(station_id destination) {
     return results_.at(destination);
   }
@@ -121,11 +142,21 @@ struct tb_profile_search {
   tb_statistics& get_statistics() { return stats_; }
   tb_statistics const& get_statistics() const { return stats_; }
 
+  void set_deadline(deadline* search_deadline) { deadline_ = search_deadline; }
+
   std::pair<time, time> get_interval() const {
     return {interval_begin_, interval_end_};
   }
 
 private:
+  bool timeout_reached() {
+    if (deadline_ != nullptr && deadline_->check()) {
+      stats_.timeout_quit_ = 1;
+      return true;
+    }
+    return false;
+  }
+
   void add_starts() {
     next_iteration_start_time_ = INVALID_TIME;
     for (auto const& [stop_id, initial_duration, allow_footpaths] :
@@ -183,6 +214,10 @@ private:
           (Dir == search_dir::BWD && stop_idx == 0)) {
         continue;
       }
+      if (data_.is_dirty(line)) {
+        add_dirty_line_start(line, stop_idx, arrival_time, offset);
+        continue;
+      }
       auto const [trip, next_trip] =
           Dir == search_dir::FWD ? data_.first_and_previous_reachable_trip(
                                        line, stop_idx, arrival_time)
@@ -197,6 +232,26 @@ private:
     }
   }
 
+  // No FIFO order: every trip that can be reached is a candidate, the others
+  // are candidates for the next iteration.
+  void add_dirty_line_start(line_id line, stop_idx_t stop_idx,
+                            time arrival_time, time offset) {
+    for (auto trip = data_.line_to_first_trip_[line];
+         trip <= data_.line_to_last_trip_[line]; ++trip) {
+      auto const t = Dir == search_dir::FWD
+                         ? data_.departure_times_[trip][stop_idx]
+                         : data_.arrival_times_[trip][stop_idx];
+      if (t == INVALID_TIME) {
+        continue;
+      }
+      if (Dir == search_dir::FWD ? t >= arrival_time : t <= arrival_time) {
+        enqueue(trip, stop_idx, 0, 0);
+      } else {
+        update_next_iteration_start_time(t, offset);
+      }
+    }
+  }
+
   void update_next_iteration_start_time(time t, time offset) {
     if (Dir == search_dir::FWD) {
       auto const new_time = t - offset;
@@ -299,12 +354,12 @@ private:
                    static_cast<stop_idx_t>(data_.line_stop_count_[line] - 1));
       for (auto stop_idx = entry.from_stop_index_ + 1; stop_idx <= stop_count;
            ++stop_idx) {
-        for (auto const& transfer :
-             data_.transfers_.at(entry.trip_, stop_idx)) {
-          ++stats_.transfers_scanned_;
-          enqueue(transfer.to_trip_, transfer.to_stop_idx_, transfers + 1,
-                  current_trip_segment);
-        }
+        data_.for_each_transfer(
+            entry.trip_, stop_idx, [&](tb_transfer const& transfer) {
+              ++stats_.transfers_scanned_;
+              enqueue(transfer.to_trip_, transfer.to_stop_idx_,
+                      transfers + 1, current_trip_segment);
+            });
       }
     }
   }
@@ -371,8 +426,11 @@ private:
                          previous_trip_segment);
 
       auto const line = data_.trip_to_line_[trip];
-      for (trip_id t = trip;
-           t < data_.trip_count_ && data_.trip_to_line_[t] == line; ++t) {
+      auto const dirty = data_.is_dirty(line);
+      for (trip_id t = trip; t < data_.trip_count_ &&
+                             data_.trip_to_line_[t] == line &&
+                             (t == trip || !dirty);
+           ++t) {
         for (auto trfs = transfers; trfs <= MAX_TRANSFERS; ++trfs) {
           first_reachable_stop_[t][trfs] =
               std::min(first_reachable_stop_[t][trfs], stop_index);
@@ -387,7 +445,10 @@ private:
       queue.emplace_back(trip, old_last_reachable, stop_index,
                          previous_trip_segment);
       auto const line = data_.trip_to_line_[trip];
-      for (trip_id t = trip; t >= 0 && data_.trip_to_line_[t] == line; --t) {
+      auto const dirty = data_.is_dirty(line);
+      for (trip_id t = trip;
+           t >= 0 && data_.trip_to_line_[t] == line && (t == trip || !dirty);
+           --t) {
         for (auto trfs = transfers; trfs <= MAX_TRANSFERS; ++trfs) {
           first_reachable_stop_[t][trfs] =
               std::max(first_reachable_stop_[t][trfs], stop_index);
@@ -485,6 +546,51 @@ private:
     return result;
   }
 
+  // Keeps the first of equal journeys (the parts overlap at their bounds).
+  // Sweep in order of departure (latest first), arrival and transfers: a
+  // journey is dominated iff an earlier journey of the sweep with no more
+  // transfers arrives no later.
+  static void remove_dominated(std::vector<tb_journey>& journeys) {
+    std::vector<std::size_t> order(journeys.size());
+    std::iota(begin(order), end(order), 0U);
+    std::stable_sort(begin(order), end(order), [&](auto const a, auto const b) {
+      auto const& ja = journeys[a];
+      auto const& jb = journeys[b];
+      return std::make_tuple(jb.departure_time(), ja.arrival_time(),
+                             ja.transfers_) <
+             std::make_tuple(ja.departure_time(), jb.arrival_time(),
+                             jb.transfers_);
+    });
+
+    auto max_transfers = 0U;
+    for (auto const& j : journeys) {
+      max_transfers = std::max(max_transfers, j.transfers_);
+    }
+
+    // best_arrival[t]: earliest arrival of the sweep with <= t transfers
+    std::vector<time> best_arrival(max_transfers + 1U,
+                                   std::numeric_limits<time>::max());
+    std::vector<bool> keep(journeys.size(), false);
+    for (auto const i : order) {
+      auto const& j = journeys[i];
+      if (best_arrival[j.transfers_] <= j.arrival_time()) {
+        continue;
+      }
+      keep[i] = true;
+      for (auto t = j.transfers_; t <= max_transfers; ++t) {
+        best_arrival[t] = std::min(best_arrival[t], j.arrival_time());
+      }
+    }
+
+    std::vector<tb_journey> pareto;
+    for (auto i = 0U; i < journeys.size(); ++i) {
+      if (keep[i]) {
+        pareto.push_back(std::move(journeys[i]));
+      }
+    }
+    journeys = std::move(pareto);
+  }
+
   void add_result(std::vector<tb_journey>& journeys, tb_journey new_result) {
     if (std::any_of(begin(journeys), end(journeys), [&](auto const& existing) {
           return existing.dominates(new_result);
@@ -562,6 +668,7 @@ private:
   std::array<std::vector<queue_entry>, MAX_TRANSFERS + 1> queues_;
   std::vector<std::array<stop_idx_t, MAX_TRANSFERS + 1>> first_reachable_stop_;
   tb_statistics stats_{};
+  deadline* deadline_{nullptr};
 };
 
 }  // namespace motis::tripbased
@@ -42,14 +42,15 @@ inline tb_reverse_transfer find_reverse_transfer(queue_entry const& from_qe,
 
   for (auto from_stop_idx = from_qe.from_stop_index_;
        from_stop_idx <= stop_count; ++from_stop_idx) {
-    for (auto const& transfer : data.transfers_.at(from_trip, from_stop_idx)) {
-      if (transfer.to_trip_ == to_trip) {
-        if (transfer.to_stop_idx_ != to_qe.from_stop_index_) {
-          continue;
-        }
-        return {from_trip, from_stop_idx,
-                std::numeric_limits<stop_idx_t>::max()};
-      }
+    auto found = false;
+    data.for_each_transfer(
+        from_trip, from_stop_idx, [&](tb_transfer const& transfer) {
+          found = found || (transfer.to_trip_ == to_trip &&
+                            transfer.to_stop_idx_ == to_qe.from_stop_index_);
+        });
+    if (found) {
+      return {from_trip, from_stop_idx,
+              std::numeric_limits<stop_idx_t>::max()};
     }
   }
   LOG(logging::error) << "trip-based journey reconstruction: find reverse "
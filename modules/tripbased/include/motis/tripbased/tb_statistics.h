@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <algorithm>
 #include <array>
 
 #include "motis/core/statistics/statistics.h"
@@ -27,8 +28,30 @@ struct tb_statistics {
   uint64_t all_destinations_reached_{};
   uint64_t total_earliest_arrival_updates_{};
   uint64_t lower_bounds_duration_;
+  uint64_t timeout_quit_{};
 };
 
+// Combines the statistics of searches over parts of one query.
+inline void add_statistics(tb_statistics& s, tb_statistics const& o) {
+  s.trip_segments_scanned_ += o.trip_segments_scanned_;
+  s.lines_reaching_destination_ += o.lines_reaching_destination_;
+  s.destination_arrivals_scanned_ += o.destination_arrivals_scanned_;
+  s.destination_reached_ += o.destination_reached_;
+  s.results_added_ += o.results_added_;
+  s.queue_count_ += o.queue_count_;
+  s.transfers_scanned_ += o.transfers_scanned_;
+  s.reconstruction_count_ += o.reconstruction_count_;
+  for (auto i = 0U; i < s.queue_size_.size(); ++i) {
+    s.queue_size_[i] = std::max(s.queue_size_[i], o.queue_size_[i]);
+  }
+  s.max_queue_size_ = std::max(s.max_queue_size_, o.max_queue_size_);
+  s.search_iterations_ += o.search_iterations_;
+  s.max_travel_time_reached_ += o.max_travel_time_reached_;
+  s.pruned_by_earliest_arrival_ += o.pruned_by_earliest_arrival_;
+  s.total_earliest_arrival_updates_ += o.total_earliest_arrival_updates_;
+  s.timeout_quit_ = std::max(s.timeout_quit_, o.timeout_quit_);
+}
+
 inline stats_category to_stats_category(char const* name,
                                         tb_statistics const& s) {
   return {
@@ -58,7 +81,8 @@ inline stats_category to_stats_category(char const* name,
        {"pruned_by_earliest_arrival", s.pruned_by_earliest_arrival_},
        {"all_destinations_reached", s.all_destinations_reached_},
        {"total_earliest_arrival_updates", s.total_earliest_arrival_updates_},
-       {"lower_bounds_duration", s.lower_bounds_duration_}}};
+       {"lower_bounds_duration", s.lower_bounds_duration_},
+       {"timeout_quit", s.timeout_quit_}}};
 }
 
 }  // namespace motis::tripbased
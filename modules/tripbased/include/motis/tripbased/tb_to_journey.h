@@ -7,6 +7,7 @@
 
 namespace motis::tripbased {
 
-journey tb_to_journey(schedule const& sched, tb_journey const& tbj);
+journey tb_to_journey(schedule const& sched, tb_data const& data,
+                      tb_journey const& tbj);
 
 }  // namespace motis::tripbased
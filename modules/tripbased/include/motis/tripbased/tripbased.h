@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "motis/module/module.h"
 
 namespace motis::tripbased {
@@ -22,10 +24,20 @@ struct tripbased : public motis::module::module {
 
   bool import_successful() const override;
 
-  tb_data const* get_data() const;
+  // Snapshot of the current data: realtime updates replace it (updates above
+  // rt_rebuild_threshold when their background rebuild is done).
+  std::shared_ptr<tb_data const> get_data() const;
+
+  // Blocks until the background rebuild of the last large realtime update
+  // (if any) has replaced the data.
+  void wait_for_rebuild();
 
 private:
   bool use_data_file_{true};
+  unsigned timeout_{0U};
+  unsigned profile_jobs_{1U};
+  unsigned rt_rebuild_threshold_{1000U};
+  bool compress_transfers_{false};
 
   bool import_successful_{false};
 
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "motis/hash_map.h"
+
+#include "motis/core/schedule/schedule.h"
+#include "motis/core/statistics/statistics.h"
+
+#include "motis/tripbased/data.h"
+
+#include "motis/protocol/RtUpdate_generated.h"
+
+namespace motis::tripbased {
+
+struct tb_update_statistics {
+  uint64_t update_count_{};
+  uint64_t updated_trips_{};
+  uint64_t disabled_trips_{};
+  uint64_t resorted_lines_{};
+  uint64_t dirty_lines_{};
+  uint64_t recomputed_transfers_{};
+  uint64_t recomputed_reverse_transfers_{};
+  uint64_t full_rebuilds_{};
+  uint64_t transfer_merges_{};
+  uint64_t pending_rebuilds_{};
+  uint64_t deferred_updates_{};
+  uint64_t ignored_additional_trains_{};
+  uint64_t last_update_duration_us_{};
+  uint64_t max_update_duration_us_{};
+  uint64_t total_update_duration_us_{};
+};
+
+inline stats_category to_stats_category(char const* name,
+                                        tb_update_statistics const& s) {
+  return {name,
+          {{"update_count", s.update_count_},
+           {"updated_trips", s.updated_trips_},
+           {"disabled_trips", s.disabled_trips_},
+           {"resorted_lines", s.resorted_lines_},
+           {"dirty_lines", s.dirty_lines_},
+           {"recomputed_transfers", s.recomputed_transfers_},
+           {"recomputed_reverse_transfers", s.recomputed_reverse_transfers_},
+           {"full_rebuilds", s.full_rebuilds_},
+           {"transfer_merges", s.transfer_merges_},
+           {"pending_rebuilds", s.pending_rebuilds_},
+           {"deferred_updates", s.deferred_updates_},
+           {"ignored_additional_trains", s.ignored_additional_trains_},
+           {"last_update_duration_us", s.last_update_duration_us_},
+           {"max_update_duration_us", s.max_update_duration_us_},
+           {"total_update_duration_us", s.total_update_duration_us_}}};
+}
+
+// New times of a trip changed by realtime updates. Trips whose stop sequence
+// no longer matches their line (reroutes, cancellations) are disabled: all
+// times are INVALID_TIME.
+struct tb_trip_update {
+  uint32_t sched_trip_idx_{};
+  std::vector<time> arrival_times_, departure_times_;
+};
+
+using expanded_trip_indices = mcd::hash_map<trip const*, uint32_t>;
+
+expanded_trip_indices get_expanded_trip_indices(schedule const&);
+
+// Current times of the trips (including merged trips) of the updates.
+// Additional trains are deliberately not supported: they are not part of
+// the expanded trips, i.e. they have no line and no transfers, and adding
+// them would change the line structure built by preprocessing (which the
+// updates and the background rebuild keep). Their updates are counted in
+// ignored_additional_trains_; they become searchable with the next import.
+std::vector<tb_trip_update> collect_trip_updates(schedule const&,
+                                                 tb_data const&,
+                                                 expanded_trip_indices const&,
+                                                 motis::rt::RtUpdates const*,
+                                                 tb_update_statistics&);
+
+// Removes the trips whose times are equal to the data.
+void erase_unchanged_trips(tb_data const&, std::vector<tb_trip_update>&);
+
+// Copy of the data with the updated trip times: the data is only read (also
+// data of the data file), i.e. searches can use it until the copy replaces
+// it. Affected lines are re-sorted if their trips are still FIFO in some
+// order, otherwise they are marked dirty (the searches do not rely on the
+// trip order of dirty lines). Transfers are only recomputed for the updated
+// trips and for trips with transfers that could reach the old or new times
+// of an updated trip, all other transfers are copied. Compressed transfers
+// are not copied but shared, the recomputed transfers are added to the
+// transfer overlay of the copy (see data.h).
+std::unique_ptr<tb_data> apply_trip_updates(schedule const&, tb_data const&,
+                                            std::vector<tb_trip_update> const&,
+                                            tb_update_statistics&);
+
+// Deep copy (owns all vectors, e.g. of data that refers to a read-only file)
+// with uncompressed transfers.
+std::unique_ptr<tb_data> copy_data(tb_data const&);
+
+// Whether the transfer overlay is larger than a quarter of the compressed
+// transfers: copy_with_merged_transfers (in the background) compresses all
+// transfers again.
+bool needs_transfer_merge(tb_data const&);
+
+std::unique_ptr<tb_data> copy_with_merged_transfers(tb_data const&);
+
+// First step of a rebuild for large updates: copy with the updated times
+// (lines re-sorted or marked dirty as in apply_trip_updates), but without
+// transfers. precompute_transfers on the copy completes the rebuild without
+// access to the original data, which can still be used (and updated) while
+// the transfers are computed.
+std::unique_ptr<tb_data> copy_with_trip_updates(
+    tb_data const&, std::vector<tb_trip_update> const&, tb_update_statistics&);
+
+}  // namespace motis::tripbased
@@ -0,0 +1,86 @@
+#include "motis/tripbased/compressed_transfers.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "utl/verify.h"
+
+namespace motis::tripbased {
+
+namespace {
+
+void write_varint(std::vector<uint8_t>& out, uint32_t val) {
+  while (val >= 0x80U) {
+    out.push_back(static_cast<uint8_t>(val | 0x80U));
+    val >>= 7U;
+  }
+  out.push_back(static_cast<uint8_t>(val));
+}
+
+uint32_t zigzag(trip_id const from, trip_id const to) {
+  auto const delta = static_cast<int32_t>(to - from);
+  return (static_cast<uint32_t>(delta) << 1U) ^
+         static_cast<uint32_t>(delta >> 31);
+}
+
+}  // namespace
+
+compressed_transfers compress_transfers(tb_data const& data) {
+  utl::verify(
+      data.compressed_transfers_ != nullptr || data.transfers_.finished(),
+      "compress_transfers: not finished");
+  compressed_transfers ct;
+  auto const key_count = data.arrival_times_.index_.back();
+  ct.block_offsets_.reserve(key_count / compressed_transfers::BLOCK_SIZE + 2);
+
+  std::vector<uint8_t> buf;
+  uint64_t key = 0U;
+  for (trip_id trip = 0U; trip < data.trip_count_; ++trip) {
+    auto const stop_count = data.arrival_times_[trip].size();
+    for (stop_idx_t stop_idx = 0U; stop_idx < stop_count; ++stop_idx, ++key) {
+      if (key % compressed_transfers::BLOCK_SIZE == 0U) {
+        ct.block_offsets_.push_back(ct.data_.size());
+      }
+      buf.clear();
+      auto prev = trip;
+      data.for_each_transfer(trip, stop_idx, [&](tb_transfer const& t) {
+        write_varint(buf, zigzag(prev, t.to_trip_));
+        write_varint(buf, t.to_stop_idx_);
+        prev = t.to_trip_;
+      });
+      write_varint(ct.data_, static_cast<uint32_t>(buf.size()));
+      ct.data_.insert(end(ct.data_), begin(buf), end(buf));
+    }
+  }
+  utl::verify(key == key_count, "compress_transfers: key count mismatch");
+  ct.block_offsets_.push_back(ct.data_.size());
+  ct.data_.shrink_to_fit();
+  return ct;
+}
+
+void use_compressed_transfers(tb_data& data) {
+  data.compressed_transfers_ =
+      std::make_shared<compressed_transfers const>(compress_transfers(data));
+  data.transfer_overlay_ = transfer_overlay{};
+  data.transfers_.index_ = mcd::vector<uint64_t>{};
+  data.transfers_.data_ = mcd::vector<tb_transfer>{};
+}
+
+void decompress_transfers(tb_data const& data,
+                          nested_fws_multimap<tb_transfer>& transfers) {
+  transfers.reserve_index(data.arrival_times_.index_.back());
+  for (trip_id trip = 0U; trip < data.trip_count_; ++trip) {
+    auto const stop_count = data.arrival_times_[trip].size();
+    for (stop_idx_t stop_idx = 0U; stop_idx < stop_count; ++stop_idx) {
+      data.for_each_transfer(trip, stop_idx, [&](tb_transfer const& t) {
+        transfers.push_back(t);
+      });
+      transfers.finish_nested_key();
+    }
+    transfers.finish_base_key();
+  }
+  transfers.finish_map();
+}
+
+}  // namespace motis::tripbased
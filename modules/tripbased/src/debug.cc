@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "utl/to_vec.h"
 #include "utl/verify.h"
@@ -28,8 +29,8 @@ trip_id find_trip(tb_data const& data, schedule const& sched,
       if (expanded_trip == end(sched.expanded_trips_.data_)) {
         throw std::system_error(error::trip_not_found);
       }
-      return static_cast<trip_id>(
-          std::distance(begin(sched.expanded_trips_.data_), expanded_trip));
+      return data.tb_trip_idx(static_cast<uint32_t>(
+          std::distance(begin(sched.expanded_trips_.data_), expanded_trip)));
     }
     case TripSelector_ExpandedTripId: {
       auto const index =
@@ -46,9 +47,10 @@ trip_id find_trip(tb_data const& data, schedule const& sched,
 }
 
 Offset<TripBasedTripId> fbs_tb_trip_id(FlatBufferBuilder& fbb,
+                                       tb_data const& data,
                                        schedule const& sched,
                                        trip_id const trp) {
-  auto const t = sched.expanded_trips_.data_.at(trp);
+  auto const t = sched.expanded_trips_.data_.at(data.sched_trip_idx(trp));
   return CreateTripBasedTripId(fbb, trp, to_fbs(sched, fbb, t));
 }
 
@@ -71,11 +73,13 @@ Offset<Station> fbs_station(FlatBufferBuilder& fbb, schedule const& sched,
 
 std::pair<Offset<Vector<Offset<TransportDebugInfo>>>,
           Offset<Vector<Offset<TransportDebugInfo>>>>
-get_transport_debug_infos(FlatBufferBuilder& fbb, schedule const& sched,
-                          trip_id const trp, stop_idx_t const stop_idx) {
+get_transport_debug_infos(FlatBufferBuilder& fbb, tb_data const& data,
+                          schedule const& sched, trip_id const trp,
+                          stop_idx_t const stop_idx) {
   std::vector<Offset<TransportDebugInfo>> arrival_transports,
       departure_transports;
-  access::trip_stop stop{sched.expanded_trips_.data_[trp], stop_idx};
+  access::trip_stop stop{
+      sched.expanded_trips_.data_[data.sched_trip_idx(trp)], stop_idx};
   auto const add_transports = [&](std::vector<Offset<TransportDebugInfo>>&
                                       transports,
                                   light_connection const& lcon) {
@@ -112,14 +116,19 @@ get_transport_debug_infos(FlatBufferBuilder& fbb, schedule const& sched,
 Offset<Vector<Offset<TransferDebugInfo>>> get_transfer_debug_info(
     FlatBufferBuilder& fbb, tb_data const& data, schedule const& sched,
     trip_id const trp, stop_idx_t const stop_idx) {
-  auto const from_trip = fbs_tb_trip_id(fbb, sched, trp);
+  auto const from_trip = fbs_tb_trip_id(fbb, data, sched, trp);
   auto const from_station = fbs_station(
       fbb, sched, data.stops_on_line_[data.trip_to_line_[trp]][stop_idx]);
-  return fbb.CreateVector(utl::to_vec(
-      data.transfers_.at(trp, stop_idx), [&](tb_transfer const& transfer) {
+  std::vector<tb_transfer> transfers;
+  data.for_each_transfer(trp, stop_idx, [&](tb_transfer const& transfer) {
+    transfers.push_back(transfer);
+  });
+  return fbb.CreateVector(
+      utl::to_vec(transfers, [&](tb_transfer const& transfer) {
         return CreateTransferDebugInfo(
-            fbb, from_trip, fbs_tb_trip_id(fbb, sched, transfer.to_trip_),
-            stop_idx, transfer.to_stop_idx_,
+            fbb, from_trip,
+            fbs_tb_trip_id(fbb, data, sched, transfer.to_trip_), stop_idx,
+            transfer.to_stop_idx_,
             static_cast<uint64_t>(
                 motis_to_unixtime(sched, data.arrival_times_[trp][stop_idx])),
             static_cast<uint64_t>(motis_to_unixtime(
@@ -136,15 +145,15 @@ Offset<Vector<Offset<TransferDebugInfo>>> get_transfer_debug_info(
 Offset<Vector<Offset<TransferDebugInfo>>> get_reverse_transfer_debug_info(
     FlatBufferBuilder& fbb, tb_data const& data, schedule const& sched,
     trip_id const trp, stop_idx_t const stop_idx) {
-  auto const to_trip = fbs_tb_trip_id(fbb, sched, trp);
+  auto const to_trip = fbs_tb_trip_id(fbb, data, sched, trp);
   auto const to_station = fbs_station(
       fbb, sched, data.stops_on_line_[data.trip_to_line_[trp]][stop_idx]);
   return fbb.CreateVector(utl::to_vec(
       data.reverse_transfers_.at(trp, stop_idx),
       [&](tb_reverse_transfer const& transfer) {
         return CreateTransferDebugInfo(
-            fbb, fbs_tb_trip_id(fbb, sched, transfer.from_trip_), to_trip,
-            transfer.from_stop_idx_, stop_idx,
+            fbb, fbs_tb_trip_id(fbb, data, sched, transfer.from_trip_),
+            to_trip, transfer.from_stop_idx_, stop_idx,
             static_cast<uint64_t>(motis_to_unixtime(
                 sched, data.arrival_times_[transfer.from_trip_]
                                           [transfer.from_stop_idx_])),
@@ -198,7 +207,7 @@ Offset<Vector<Offset<StopDebugInfo>>> get_trip_stop_debug_info(
   for (stop_idx_t stop_idx = 0U; stop_idx < stop_count; ++stop_idx) {
     auto const station = stops[stop_idx];
     auto const [arrival_transports, departure_transports] =  // NOLINT
-        get_transport_debug_infos(fbb, sched, trp, stop_idx);
+        get_transport_debug_infos(fbb, data, sched, trp, stop_idx);
     sdis.push_back(CreateStopDebugInfo(
         fbb, fbs_station(fbb, sched, station), ts(arrivals[stop_idx]),
         ts(departures[stop_idx]), in_allowed[stop_idx] != 0,
@@ -227,7 +236,7 @@ Offset<TripDebugInfo> get_trip_debug_info(FlatBufferBuilder& fbb,
   utl::verify(trp < data.trip_count_, "get_trip_debug_info: invalid trip id");
   auto const line = data.trip_to_line_[trp];
   return CreateTripDebugInfo(
-      fbb, fbs_tb_trip_id(fbb, sched, trp),
+      fbb, fbs_tb_trip_id(fbb, data, sched, trp),
       get_line_debug_info(fbb, data, line),
       get_trip_stop_debug_info(fbb, data, sched, trp, line));
 }
@@ -244,9 +253,9 @@ Offset<Vector<Offset<TripAtStopDebugInfo>>> get_trips_at_stop_debug_info(
     for (auto trp = data.line_to_first_trip_[ls.line_];
          trp <= data.line_to_last_trip_[ls.line_]; ++trp) {
       auto const [arrival_transports, departure_transports] =  // NOLINT
-          get_transport_debug_infos(fbb, sched, trp, ls.stop_idx_);
+          get_transport_debug_infos(fbb, data, sched, trp, ls.stop_idx_);
       trips.push_back(CreateTripAtStopDebugInfo(
-          fbb, fbs_tb_trip_id(fbb, sched, trp), ls.stop_idx_,
+          fbb, fbs_tb_trip_id(fbb, data, sched, trp), ls.stop_idx_,
           ts(data.arrival_times_[trp][ls.stop_idx_]),
           ts(data.departure_times_[trp][ls.stop_idx_]),
           data.in_allowed_[ls.line_][ls.stop_idx_] != 0,
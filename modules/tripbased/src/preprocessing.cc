@@ -247,9 +247,43 @@ struct preprocessing {
     utl::verify(data_.stops_on_line_.finished(), "stops on line not finished");
     utl::verify(data_.arrival_times_.finished(), "arrival times not finished");
     utl::verify(data_.in_allowed_.finished(), "in allowed not finished");
+
+    progress_tracker_->status("Init: Line Times");
+    init_line_times();
     std::cout.imbue(prev_locale);
   }
 
+  void init_line_times() {
+    data_.line_departure_times_.reserve_index(data_.line_count_);
+    for (line_id line = 0U; line < data_.line_count_; ++line) {
+      auto const first_trip = data_.line_to_first_trip_[line];
+      auto const last_trip = data_.line_to_last_trip_[line];
+      for (stop_idx_t stop_idx = 0U; stop_idx < data_.line_stop_count_[line];
+           ++stop_idx) {
+        for (auto trip = first_trip; trip <= last_trip; ++trip) {
+          data_.line_departure_times_.push_back(
+              data_.departure_times_[trip][stop_idx]);
+          data_.line_arrival_times_.push_back(
+              data_.arrival_times_[trip][stop_idx]);
+        }
+        auto const count = data_.line_trip_count(line);
+        auto const departures = data_.line_departure_times(line, stop_idx);
+        auto const arrivals = data_.line_arrival_times(line, stop_idx);
+        utl::verify(std::is_sorted(departures, departures + count) &&
+                        std::is_sorted(arrivals, arrivals + count),
+                    "line {} is not FIFO at stop {}", line, stop_idx);
+      }
+      data_.line_departure_times_.finish_key();
+    }
+    data_.line_departure_times_.finish_map();
+    utl::verify(
+        data_.line_departure_times_.index_size() == data_.line_count_ + 1,
+        "incorrect size of line departure times");
+    utl::verify(data_.line_arrival_times_.data_size() ==
+                    data_.line_departure_times_.data_size(),
+                "different number of line arrival and departure times");
+  }
+
   void precompute() {
     precompute_transfers();
     precompute_reverse_transfers();
@@ -337,7 +371,55 @@ struct preprocessing {
     std::cout.imbue(prev_locale);
   }
 
+  std::vector<std::vector<std::vector<tb_transfer>>> recompute_transfers(
+      std::vector<trip_id> const& trips) {
+    return compute_parallel<tb_transfer>(
+        trips, [&](trip_id const trip, std::vector<time>& earliest_arrival,
+                   std::vector<time>& earliest_change) {
+          return compute_transfers(trip, earliest_arrival, earliest_change);
+        });
+  }
+
+  std::vector<std::vector<std::vector<tb_reverse_transfer>>>
+  recompute_reverse_transfers(std::vector<trip_id> const& trips) {
+    return compute_parallel<tb_reverse_transfer>(
+        trips, [&](trip_id const trip, std::vector<time>& latest_departure,
+                   std::vector<time>& latest_change) {
+          return compute_reverse_transfers(trip, latest_departure,
+                                           latest_change);
+        });
+  }
+
 private:
+  template <typename Transfer, typename Fn>
+  std::vector<std::vector<std::vector<Transfer>>> compute_parallel(
+      std::vector<trip_id> const& trips, Fn const& compute) {
+    std::vector<std::vector<std::vector<Transfer>>> results(trips.size());
+    auto const stop_count = sched_.stations_.size();
+    auto const run = [&](std::size_t const first, std::size_t const stride) {
+      std::vector<time> best(stop_count);
+      std::vector<time> best_change(stop_count);
+      for (auto i = first; i < trips.size(); i += stride) {
+        results[i] = compute(trips[i], best, best_change);
+      }
+    };
+
+    auto const thread_count = std::thread::hardware_concurrency();
+    if (trips.size() > thread_count) {
+      std::vector<std::thread> threads;
+      threads.reserve(thread_count);
+      for (auto t = 0U; t < thread_count; ++t) {
+        threads.emplace_back(run, t, thread_count);
+      }
+      for (auto& t : threads) {
+        t.join();
+      }
+    } else {
+      run(0, 1);
+    }
+    return results;
+  }
+
   void precompute_transfers_thread(trip_id first_trip_idx, trip_id stride) {
     auto const stop_count = sched_.stations_.size();
     std::vector<time> earliest_arrival(stop_count);
@@ -345,91 +427,115 @@ private:
 
     for (uint64_t trip_idx = first_trip_idx; trip_idx < data_.trip_count_;
          trip_idx += stride) {
-      auto const line_idx = data_.trip_to_line_[trip_idx];
-      auto const out_allowed = data_.out_allowed_[line_idx];
+      add_transfers(trip_idx, compute_transfers(static_cast<trip_id>(trip_idx),
+                                                earliest_arrival,
+                                                earliest_change));
+    }
+  }
 
-      auto const line_stop_count = data_.line_stop_count_[line_idx];
-      auto const line_stops = data_.stops_on_line_[line_idx];
+  std::vector<std::vector<tb_transfer>> compute_transfers(
+      trip_id const trip_idx, std::vector<time>& earliest_arrival,
+      std::vector<time>& earliest_change) {
+    auto const line_idx = data_.trip_to_line_[trip_idx];
+    auto const out_allowed = data_.out_allowed_[line_idx];
 
-      std::vector<std::vector<tb_transfer>> transfers(line_stop_count);
+    auto const line_stop_count = data_.line_stop_count_[line_idx];
+    auto const line_stops = data_.stops_on_line_[line_idx];
 
-      std::fill(begin(earliest_arrival), end(earliest_arrival), INVALID_TIME);
-      std::fill(begin(earliest_change), end(earliest_change), INVALID_TIME);
+    std::vector<std::vector<tb_transfer>> transfers(line_stop_count);
 
-      for (auto from_stop_idx = line_stop_count - 1; from_stop_idx > 0;
-           --from_stop_idx) {
-        auto const station_idx = line_stops[from_stop_idx];
+    std::fill(begin(earliest_arrival), end(earliest_arrival), INVALID_TIME);
+    std::fill(begin(earliest_change), end(earliest_change), INVALID_TIME);
 
-        auto const trip_arrival = data_.arrival_times_[trip_idx][from_stop_idx];
-        if (out_allowed[from_stop_idx] == 0) {
-          continue;
-        }
+    for (auto from_stop_idx = line_stop_count - 1; from_stop_idx > 0;
+         --from_stop_idx) {
+      auto const station_idx = line_stops[from_stop_idx];
 
-        if (trip_arrival < earliest_arrival[station_idx]) {
-          earliest_arrival[station_idx] = trip_arrival;
-        }
+      auto const trip_arrival = data_.arrival_times_[trip_idx][from_stop_idx];
+      if (out_allowed[from_stop_idx] == 0 || trip_arrival == INVALID_TIME) {
+        continue;
+      }
 
-        auto const footpaths = outgoing_footpaths(station_idx);
+      if (trip_arrival < earliest_arrival[station_idx]) {
+        earliest_arrival[station_idx] = trip_arrival;
+      }
 
-        for (auto const& fp : footpaths) {
-          auto const fp_arrival =
-              static_cast<time>(trip_arrival + fp.duration_);
-          if (fp_arrival < earliest_arrival[fp.to_stop_]) {
-            earliest_arrival[fp.to_stop_] = fp_arrival;
-          }
-          if (fp_arrival < earliest_change[fp.to_stop_]) {
-            earliest_change[fp.to_stop_] = fp_arrival;
-          }
+      auto const footpaths = outgoing_footpaths(station_idx);
+
+      for (auto const& fp : footpaths) {
+        auto const fp_arrival = static_cast<time>(trip_arrival + fp.duration_);
+        if (fp_arrival < earliest_arrival[fp.to_stop_]) {
+          earliest_arrival[fp.to_stop_] = fp_arrival;
+        }
+        if (fp_arrival < earliest_change[fp.to_stop_]) {
+          earliest_change[fp.to_stop_] = fp_arrival;
         }
+      }
 
-        for (auto const& fp : footpaths) {
-          auto const station_arrival =
-              static_cast<time>(trip_arrival + fp.duration_);
-          for (auto const& [other_line, other_stop_idx, _] :
-               data_.lines_at_stop_[fp.to_stop_]) {
-            (void)_;
-            if (is_last_stop_of_line(other_line, other_stop_idx) ||
-                data_.in_allowed_[other_line][other_stop_idx] == 0) {
-              continue;
-            }
-            auto const reachable = data_.first_reachable_trip(
-                other_line, other_stop_idx, station_arrival);
-            if (!reachable || (reachable->second - trip_arrival) > 1440) {
-              continue;
-            }
-            auto const other_trip = reachable->first;
-            if (other_line != line_idx || other_stop_idx < from_stop_idx ||
-                other_trip < trip_idx) {
-              // don't add u-turn transfers
-              assert(from_stop_idx > 0);
-              utl::verify(other_stop_idx < data_.line_stop_count_[other_line],
-                          "invalid other stop index 1");
-              auto const from_prev_stop =
-                  data_.stops_on_line_[line_idx][from_stop_idx - 1];
-              auto const to_next_stop =
-                  data_.stops_on_line_[other_line][other_stop_idx + 1];
-              if (from_prev_stop == to_next_stop &&
-                  out_allowed[from_stop_idx - 1] != 0 &&
-                  data_.in_allowed_[other_line][other_stop_idx + 1] != 0 &&
-                  (data_.arrival_times_[trip_idx][from_stop_idx - 1] +
-                       sched_.stations_[from_prev_stop]->transfer_time_ <=
-                   data_.departure_times_[other_trip][other_stop_idx + 1])) {
-                ++uturns_;
-                continue;
-              }
-              if (!keep_transfer(other_line, other_trip, other_stop_idx,
-                                 earliest_arrival, earliest_change)) {
-                ++no_improvements_;
-                continue;
+      auto const add_transfer = [&](line_id const other_line,
+                                    stop_idx_t const other_stop_idx,
+                                    trip_id const other_trip) {
+        if (other_line == line_idx && other_stop_idx >= from_stop_idx &&
+            (other_trip == trip_idx ||
+             (other_trip > trip_idx && !data_.is_dirty(line_idx)))) {
+          return;
+        }
+        // don't add u-turn transfers
+        assert(from_stop_idx > 0);
+        utl::verify(other_stop_idx < data_.line_stop_count_[other_line],
+                    "invalid other stop index 1");
+        auto const from_prev_stop =
+            data_.stops_on_line_[line_idx][from_stop_idx - 1];
+        auto const to_next_stop =
+            data_.stops_on_line_[other_line][other_stop_idx + 1];
+        if (from_prev_stop == to_next_stop &&
+            out_allowed[from_stop_idx - 1] != 0 &&
+            data_.in_allowed_[other_line][other_stop_idx + 1] != 0 &&
+            (data_.arrival_times_[trip_idx][from_stop_idx - 1] +
+                 sched_.stations_[from_prev_stop]->transfer_time_ <=
+             data_.departure_times_[other_trip][other_stop_idx + 1])) {
+          ++uturns_;
+          return;
+        }
+        if (!keep_transfer(other_line, other_trip, other_stop_idx,
+                           earliest_arrival, earliest_change)) {
+          ++no_improvements_;
+          return;
+        }
+        transfers[from_stop_idx].emplace_back(other_trip, other_stop_idx);
+      };
+
+      for (auto const& fp : footpaths) {
+        auto const station_arrival =
+            static_cast<time>(trip_arrival + fp.duration_);
+        for (auto const& [other_line, other_stop_idx, _] :
+             data_.lines_at_stop_[fp.to_stop_]) {
+          (void)_;
+          if (is_last_stop_of_line(other_line, other_stop_idx) ||
+              data_.in_allowed_[other_line][other_stop_idx] == 0) {
+            continue;
+          }
+          if (data_.is_dirty(other_line)) {
+            for (auto const& [other_trip, departure] : departing_trips(
+                     other_line, other_stop_idx, station_arrival)) {
+              if (departure - trip_arrival > 1440) {
+                break;
               }
-              transfers[from_stop_idx].emplace_back(other_trip, other_stop_idx);
+              add_transfer(other_line, other_stop_idx, other_trip);
             }
+            continue;
+          }
+          auto const reachable = data_.first_reachable_trip(
+              other_line, other_stop_idx, station_arrival);
+          if (!reachable || (reachable->second - trip_arrival) > 1440) {
+            continue;
           }
+          add_transfer(other_line, other_stop_idx, reachable->first);
         }
       }
-
-      add_transfers(trip_idx, std::move(transfers));
     }
+
+    return transfers;
   }
 
   void precompute_reverse_transfers_thread(trip_id first_trip_idx,
@@ -440,94 +546,158 @@ private:
 
     for (uint64_t trip_idx = first_trip_idx; trip_idx < data_.trip_count_;
          trip_idx += stride) {
-      auto const line_idx = data_.trip_to_line_[trip_idx];
-      auto const in_allowed = data_.in_allowed_[line_idx];
+      add_reverse_transfers(
+          trip_idx,
+          compute_reverse_transfers(static_cast<trip_id>(trip_idx),
+                                    latest_departure, latest_change));
+    }
+  }
 
-      auto const line_stop_count = data_.line_stop_count_[line_idx];
-      auto const line_stops = data_.stops_on_line_[line_idx];
+  std::vector<std::vector<tb_reverse_transfer>> compute_reverse_transfers(
+      trip_id const trip_idx, std::vector<time>& latest_departure,
+      std::vector<time>& latest_change) {
+    auto const line_idx = data_.trip_to_line_[trip_idx];
+    auto const in_allowed = data_.in_allowed_[line_idx];
 
-      std::vector<std::vector<tb_reverse_transfer>> transfers(line_stop_count);
+    auto const line_stop_count = data_.line_stop_count_[line_idx];
+    auto const line_stops = data_.stops_on_line_[line_idx];
 
-      std::fill(begin(latest_departure), end(latest_departure), 0);
-      std::fill(begin(latest_change), end(latest_change), 0);
+    std::vector<std::vector<tb_reverse_transfer>> transfers(line_stop_count);
 
-      for (int to_stop_idx = 0; to_stop_idx <= line_stop_count - 2;
-           ++to_stop_idx) {
-        auto const station_idx = line_stops[to_stop_idx];
+    std::fill(begin(latest_departure), end(latest_departure), 0);
+    std::fill(begin(latest_change), end(latest_change), 0);
 
-        auto const trip_departure =
-            data_.departure_times_[trip_idx][to_stop_idx];
-        if (in_allowed[to_stop_idx] == 0) {
-          continue;
-        }
+    for (int to_stop_idx = 0; to_stop_idx <= line_stop_count - 2;
+         ++to_stop_idx) {
+      auto const station_idx = line_stops[to_stop_idx];
 
-        if (trip_departure > latest_departure[station_idx]) {
-          latest_departure[station_idx] = trip_departure;
-        }
+      auto const trip_departure = data_.departure_times_[trip_idx][to_stop_idx];
+      if (in_allowed[to_stop_idx] == 0 || trip_departure == INVALID_TIME) {
+        continue;
+      }
 
-        auto const footpaths = incoming_footpaths(station_idx);
+      if (trip_departure > latest_departure[station_idx]) {
+        latest_departure[station_idx] = trip_departure;
+      }
 
-        for (auto const& fp : footpaths) {
-          auto const fp_departure =
-              static_cast<time>(trip_departure - fp.duration_);
-          if (fp_departure > latest_departure[fp.from_stop_]) {
-            latest_departure[fp.from_stop_] = fp_departure;
-          }
-          if (fp_departure > latest_change[fp.from_stop_]) {
-            latest_change[fp.from_stop_] = fp_departure;
-          }
+      auto const footpaths = incoming_footpaths(station_idx);
+
+      for (auto const& fp : footpaths) {
+        auto const fp_departure =
+            static_cast<time>(trip_departure - fp.duration_);
+        if (fp_departure > latest_departure[fp.from_stop_]) {
+          latest_departure[fp.from_stop_] = fp_departure;
         }
+        if (fp_departure > latest_change[fp.from_stop_]) {
+          latest_change[fp.from_stop_] = fp_departure;
+        }
+      }
 
-        for (auto const& fp : footpaths) {
-          auto const station_departure =
-              static_cast<time>(trip_departure - fp.duration_);
-          for (auto const& [other_line, other_stop_idx, _] :
-               data_.lines_at_stop_[fp.from_stop_]) {
-            (void)_;
-            if (other_stop_idx == 0 ||
-                data_.out_allowed_[other_line][other_stop_idx] == 0) {
-              continue;
-            }
-            auto const reachable = data_.last_reachable_trip(
-                other_line, other_stop_idx, station_departure);
-            if (!reachable || (trip_departure - reachable->second) > 1440) {
-              continue;
-            }
-            auto const other_trip = reachable->first;
-            if (other_line != line_idx || to_stop_idx < other_stop_idx ||
-                trip_idx < other_trip) {
-              // don't add u-turn transfers
-              utl::verify(other_stop_idx > 0, "invalid other stop index 2");
-              utl::verify(other_stop_idx < data_.line_stop_count_[other_line],
-                          "invalid other stop index 3");
-              auto const to_next_stop =
-                  data_.stops_on_line_[line_idx][to_stop_idx + 1];
-              auto const from_prev_stop =
-                  data_.stops_on_line_[other_line][other_stop_idx - 1];
-              if (from_prev_stop == to_next_stop &&
-                  in_allowed[to_stop_idx + 1] != 0 &&
-                  data_.out_allowed_[other_line][other_stop_idx - 1] != 0 &&
-                  (data_.departure_times_[trip_idx][to_stop_idx + 1] -
-                       sched_.stations_[to_next_stop]->transfer_time_ >=
-                   data_.arrival_times_[other_trip][other_stop_idx - 1])) {
-                ++uturns_;
-                continue;
-              }
-              if (!keep_reverse_transfer(other_line, other_trip, other_stop_idx,
-                                         latest_departure, latest_change)) {
-                ++no_improvements_;
-                continue;
+      auto const add_transfer = [&](line_id const other_line,
+                                    stop_idx_t const other_stop_idx,
+                                    trip_id const other_trip) {
+        if (other_line == line_idx && to_stop_idx >= other_stop_idx &&
+            (other_trip == trip_idx ||
+             (trip_idx > other_trip && !data_.is_dirty(line_idx)))) {
+          return;
+        }
+        // don't add u-turn transfers
+        utl::verify(other_stop_idx > 0, "invalid other stop index 2");
+        utl::verify(other_stop_idx < data_.line_stop_count_[other_line],
+                    "invalid other stop index 3");
+        auto const to_next_stop =
+            data_.stops_on_line_[line_idx][to_stop_idx + 1];
+        auto const from_prev_stop =
+            data_.stops_on_line_[other_line][other_stop_idx - 1];
+        if (from_prev_stop == to_next_stop &&
+            in_allowed[to_stop_idx + 1] != 0 &&
+            data_.out_allowed_[other_line][other_stop_idx - 1] != 0 &&
+            (data_.departure_times_[trip_idx][to_stop_idx + 1] -
+                 sched_.stations_[to_next_stop]->transfer_time_ >=
+             data_.arrival_times_[other_trip][other_stop_idx - 1])) {
+          ++uturns_;
+          return;
+        }
+        if (!keep_reverse_transfer(other_line, other_trip, other_stop_idx,
+                                   latest_departure, latest_change)) {
+          ++no_improvements_;
+          return;
+        }
+        transfers[to_stop_idx].emplace_back(other_trip, other_stop_idx,
+                                            to_stop_idx);
+      };
+
+      for (auto const& fp : footpaths) {
+        auto const station_departure =
+            static_cast<time>(trip_departure - fp.duration_);
+        for (auto const& [other_line, other_stop_idx, _] :
+             data_.lines_at_stop_[fp.from_stop_]) {
+          (void)_;
+          if (other_stop_idx == 0 ||
+              data_.out_allowed_[other_line][other_stop_idx] == 0) {
+            continue;
+          }
+          if (data_.is_dirty(other_line)) {
+            for (auto const& [other_trip, arrival] : arriving_trips(
+                     other_line, other_stop_idx, station_departure)) {
+              if (trip_departure - arrival > 1440) {
+                break;
               }
-              transfers[to_stop_idx].emplace_back(other_trip, other_stop_idx,
-                                                  to_stop_idx);
+              add_transfer(other_line, other_stop_idx, other_trip);
             }
+            continue;
+          }
+          auto const reachable = data_.last_reachable_trip(
+              other_line, other_stop_idx, station_departure);
+          if (!reachable || (trip_departure - reachable->second) > 1440) {
+            continue;
           }
+          add_transfer(other_line, other_stop_idx, reachable->first);
         }
       }
+    }
 
-      assert(transfers.size() == line_stop_count);
-      add_reverse_transfers(trip_idx, std::move(transfers));
+    assert(transfers.size() == line_stop_count);
+    return transfers;
+  }
+
+  // Trips of a dirty line ordered by departure (earliest first) / arrival
+  // (latest first): later candidates are only kept if they improve arrival /
+  // departure times at some stop.
+  std::vector<std::pair<trip_id, time>> departing_trips(
+      line_id const line, stop_idx_t const stop_idx,
+      time const earliest_departure) const {
+    std::vector<std::pair<trip_id, time>> trips;
+    for (auto trip = data_.line_to_first_trip_[line];
+         trip <= data_.line_to_last_trip_[line]; ++trip) {
+      auto const departure = data_.departure_times_[trip][stop_idx];
+      if (departure != INVALID_TIME && departure >= earliest_departure) {
+        trips.emplace_back(trip, departure);
+      }
     }
+    std::stable_sort(begin(trips), end(trips),
+                     [](auto const& a, auto const& b) {
+                       return a.second < b.second;
+                     });
+    return trips;
+  }
+
+  std::vector<std::pair<trip_id, time>> arriving_trips(
+      line_id const line, stop_idx_t const stop_idx,
+      time const latest_arrival) const {
+    std::vector<std::pair<trip_id, time>> trips;
+    for (auto trip = data_.line_to_first_trip_[line];
+         trip <= data_.line_to_last_trip_[line]; ++trip) {
+      auto const arrival = data_.arrival_times_[trip][stop_idx];
+      if (arrival != INVALID_TIME && arrival <= latest_arrival) {
+        trips.emplace_back(trip, arrival);
+      }
+    }
+    std::stable_sort(begin(trips), end(trips),
+                     [](auto const& a, auto const& b) {
+                       return a.second > b.second;
+                     });
+    return trips;
   }
 
   void add_transfers(trip_id trip_idx,
@@ -737,12 +907,47 @@ std::unique_ptr<tb_data> build_data(schedule const& sched) {
   return data;
 }
 
-std::unique_ptr<tb_data> load_data(schedule const& sched,
-                                   std::string const& filename) {
+std::vector<std::vector<std::vector<tb_transfer>>> compute_transfers(
+    schedule const& sched, tb_data& data, std::vector<trip_id> const& trips) {
+  preprocessing pp(sched, data);
+  return pp.recompute_transfers(trips);
+}
+
+std::vector<std::vector<std::vector<tb_reverse_transfer>>>
+compute_reverse_transfers(schedule const& sched, tb_data& data,
+                          std::vector<trip_id> const& trips) {
+  preprocessing pp(sched, data);
+  return pp.recompute_reverse_transfers(trips);
+}
+
+void update_line_times(tb_data& data, line_id const line) {
+  auto const first_trip = data.line_to_first_trip_[line];
+  auto const last_trip = data.line_to_last_trip_[line];
+  auto i = data.line_departure_times_.index_[line];
+  for (stop_idx_t stop_idx = 0U; stop_idx < data.line_stop_count_[line];
+       ++stop_idx) {
+    for (auto trip = first_trip; trip <= last_trip; ++trip, ++i) {
+      data.line_departure_times_.data_[i] =
+          data.departure_times_[trip][stop_idx];
+      data.line_arrival_times_.data_[i] = data.arrival_times_[trip][stop_idx];
+    }
+  }
+}
+
+void precompute_transfers(schedule const& sched, tb_data& data) {
+  utl::verify(data.transfers_.data_size() == 0 &&
+                  data.reverse_transfers_.data_size() == 0,
+              "precompute_transfers: transfers not empty");
+  preprocessing pp(sched, data);
+  pp.precompute();
+}
+
+std::unique_ptr<serialization::mapped_data> load_data(
+    schedule const& sched, std::string const& filename) {
   utl::verify(!filename.empty(), "update_data_file: filename empty");
   utl::verify(fs::exists(filename), "update_data_file: file does not exist {}",
               filename);
-  return serialization::read_data(filename, sched);
+  return std::make_unique<serialization::mapped_data>(filename, sched);
 }
 
 void update_data_file(schedule const& sched, std::string const& filename,
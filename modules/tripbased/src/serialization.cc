@@ -1,12 +1,15 @@
 #include "motis/tripbased/serialization.h"
 
-#include <cstdio>
-#include <cstring>
+#include <map>
+#include <sstream>
+#include <string_view>
 
 #include "boost/filesystem.hpp"
 
+#include "cista/mmap.h"
+#include "cista/serialization.h"
+
 #include "utl/enumerate.h"
-#include "utl/to_vec.h"
 #include "utl/verify.h"
 
 #include "motis/core/common/date_time_util.h"
@@ -15,52 +18,67 @@
 namespace fs = boost::filesystem;
 using namespace motis::logging;
 
-namespace motis::tripbased::serialization {
+namespace motis::tripbased {
 
-constexpr uint64_t CURRENT_VERSION = 11;
+template <typename Ctx>
+inline void serialize(Ctx&, tb_footpath const*, cista::offset_t const) {}
 
-struct file {
-  file(char const* path, char const* mode) : f_(std::fopen(path, mode)) {
-    utl::verify(f_ != nullptr, "unable to open file");
-  }
+template <typename Ctx>
+inline void deserialize(Ctx const&, tb_footpath*) {}
 
-  ~file() {
-    if (f_ != nullptr) {
-      fclose(f_);
-    }
-    f_ = nullptr;
-  }
+cista::hash_t type_hash(tb_footpath const& el, cista::hash_t const h,
+                        std::map<cista::hash_t, unsigned>& done) {
+  return cista::hash_combine(cista::type_hash(el.from_stop_, h, done),
+                             cista::type_hash(el.to_stop_, h, done),
+                             cista::type_hash(el.duration_, h, done));
+}
 
-  file(file const&) = delete;
-  file& operator=(file const&) = delete;
+template <typename Ctx>
+inline void serialize(Ctx&, line_stop const*, cista::offset_t const) {}
 
-  file(file&&) = delete;
-  file& operator=(file&&) = delete;
+template <typename Ctx>
+inline void deserialize(Ctx const&, line_stop*) {}
 
-  std::size_t size() const {
-    auto const err = std::fseek(f_, 0, SEEK_END);
-    utl::verify(err == 0, "fseek to SEEK_END error");
-    auto const size = std::ftell(f_);
-    std::rewind(f_);
-    return static_cast<std::size_t>(size);
-  }
+cista::hash_t type_hash(line_stop const& el, cista::hash_t const h,
+                        std::map<cista::hash_t, unsigned>& done) {
+  return cista::hash_combine(cista::type_hash(el.line_, h, done),
+                             cista::type_hash(el.stop_idx_, h, done), 1);
+}
 
-  void write(void const* buf, std::size_t size) const {
-    auto const bytes_written = std::fwrite(buf, 1, size, f_);
-    utl::verify(bytes_written == size, "file write error");
-  }
+template <typename Ctx>
+inline void serialize(Ctx&, tb_transfer const*, cista::offset_t const) {}
 
-  void read(void* buf, std::size_t offset, std::size_t size) const {
-    auto const err = std::fseek(f_, offset, SEEK_SET);
-    utl::verify(err == 0, "fseek error");
-    auto const bytes_read = std::fread(buf, 1, size, f_);
-    utl::verify(bytes_read == size, "file read error");
-  }
+template <typename Ctx>
+inline void deserialize(Ctx const&, tb_transfer*) {}
+
+cista::hash_t type_hash(tb_transfer const& el, cista::hash_t const h,
+                        std::map<cista::hash_t, unsigned>& done) {
+  return cista::hash_combine(cista::type_hash(el.to_trip_, h, done),
+                             cista::type_hash(el.to_stop_idx_, h, done), 1);
+}
+
+template <typename Ctx>
+inline void serialize(Ctx&, tb_reverse_transfer const*,
+                      cista::offset_t const) {}
 
-  explicit operator FILE*() const { return f_; }
+template <typename Ctx>
+inline void deserialize(Ctx const&, tb_reverse_transfer*) {}
 
-  FILE* f_;
-};
+cista::hash_t type_hash(tb_reverse_transfer const& el, cista::hash_t const h,
+                        std::map<cista::hash_t, unsigned>& done) {
+  return cista::hash_combine(cista::type_hash(el.from_trip_, h, done),
+                             cista::type_hash(el.from_stop_idx_, h, done),
+                             cista::type_hash(el.to_stop_idx_, h, done));
+}
+
+}  // namespace motis::tripbased
+
+namespace motis::tripbased::serialization {
+
+// No integrity check: it would read the whole file at startup.
+constexpr auto const MODE = cista::mode::WITH_VERSION;
+
+constexpr uint64_t CURRENT_VERSION = 13;
 
 std::string serialize_schedule_names(schedule const& sched) {
   std::stringstream ss;
@@ -73,164 +91,114 @@ std::string serialize_schedule_names(schedule const& sched) {
   return ss.str();
 }
 
+// Makes dst a non-owning view of src (which has to outlive it). Only for
+// vectors that are not modified while the view exists: write_data (heap
+// data) and mapped_data (const access only).
 template <typename T>
-void set_array_offset(uint64_t& current_offset, array_offset& off,
-                      mcd::vector<T> const& data) {
-  off.start_ = current_offset;
-  off.length_ = data.size() * sizeof(T);
-  current_offset += off.length_;
-}
-
-template <typename T, typename Index>
-void set_fws_multimap_offset(uint64_t& current_offset, fws_multimap_offset& off,
-                             fws_multimap<T, Index> const& map) {
-  set_array_offset(current_offset, off.index_, map.index_);
-  set_array_offset(current_offset, off.data_, map.data_);
-}
-
-template <typename T, typename Index>
-void set_fws_multimap_offset(uint64_t& current_offset, fws_multimap_offset& off,
-                             nested_fws_multimap<T, Index> const& map) {
-  set_array_offset(current_offset, off.index_, map.index_);
-  set_array_offset(current_offset, off.data_, map.data_);
-}
-
-template <typename T>
-void write_array(file& f, mcd::vector<T> const& data) {
-  if (!data.empty()) {
-    f.write(data.data(), data.size() * sizeof(T));
-  }
+void share(mcd::vector<T>& dst, mcd::vector<T> const& src) {
+  dst.el_ = const_cast<T*>(src.data());  // NOLINT
+  dst.used_size_ = src.used_size_;
+  dst.allocated_size_ = src.used_size_;
+  dst.self_allocated_ = false;
 }
 
 template <typename T, typename Index>
-void write_fws_multimap(file& f, fws_multimap<T, Index> const& map) {
-  write_array(f, map.index_);
-  write_array(f, map.data_);
-}
-
-template <typename T, typename Index>
-void write_fws_multimap(file& f, nested_fws_multimap<T, Index> const& map) {
-  write_array(f, map.index_);
-  write_array(f, map.data_);
+void share(fws_multimap<T, Index>& dst, fws_multimap<T, Index> const& src) {
+  share(dst.data_, src.data_);
+  share(dst.index_, src.index_);
+  dst.current_start_ = src.current_start_;
+  dst.complete_ = true;
 }
 
 void write_data(tb_data const& data, std::string const& filename,
                 schedule const& sched) {
-  file f(filename.c_str(), "wb");
-
-  header h{};
-  h.version_ = CURRENT_VERSION;
-  auto const& schedule_name = serialize_schedule_names(sched);
-  if (schedule_name.size() > sizeof(h.schedule_name_)) {
-    LOG(warn) << "tripbased: serialized schedule name to long";
-  }
-  std::strncpy(h.schedule_name_, schedule_name.data(),
-               std::min(static_cast<size_t>(schedule_name.size()),
-                        sizeof(h.schedule_name_)));
-
-  h.schedule_begin_ = static_cast<int64_t>(sched.schedule_begin_);
-  h.schedule_end_ = static_cast<int64_t>(sched.schedule_end_);
-  h.trip_count_ = data.trip_count_;
-  h.line_count_ = data.line_count_;
-
-  uint64_t offset = sizeof(header);
-
-  set_array_offset(offset, h.line_to_first_trip_, data.line_to_first_trip_);
-  set_array_offset(offset, h.line_to_last_trip_, data.line_to_last_trip_);
-  set_array_offset(offset, h.trip_to_line_, data.trip_to_line_);
-  set_array_offset(offset, h.line_stop_count_, data.line_stop_count_);
-
-  set_fws_multimap_offset(offset, h.footpaths_, data.footpaths_);
-  set_fws_multimap_offset(offset, h.reverse_footpaths_,
-                          data.reverse_footpaths_);
-  set_fws_multimap_offset(offset, h.lines_at_stop_, data.lines_at_stop_);
-  set_fws_multimap_offset(offset, h.stops_on_line_, data.stops_on_line_);
-
-  set_fws_multimap_offset(offset, h.arrival_times_, data.arrival_times_);
-  set_array_offset(offset, h.departure_times_data_,
-                   data.departure_times_.data_);
-  set_fws_multimap_offset(offset, h.transfers_, data.transfers_);
-  set_fws_multimap_offset(offset, h.reverse_transfers_,
-                          data.reverse_transfers_);
-
-  set_fws_multimap_offset(offset, h.in_allowed_, data.in_allowed_);
-  set_array_offset(offset, h.out_allowed_data_, data.out_allowed_.data_);
-
-  f.write(&h, sizeof(header));
-
-  write_array(f, data.line_to_first_trip_);
-  write_array(f, data.line_to_last_trip_);
-  write_array(f, data.trip_to_line_);
-  write_array(f, data.line_stop_count_);
-
-  write_fws_multimap(f, data.footpaths_);
-  write_fws_multimap(f, data.reverse_footpaths_);
-  write_fws_multimap(f, data.lines_at_stop_);
-  write_fws_multimap(f, data.stops_on_line_);
-
-  write_fws_multimap(f, data.arrival_times_);
-  write_array(f, data.departure_times_.data_);
-  write_fws_multimap(f, data.transfers_);
-  write_fws_multimap(f, data.reverse_transfers_);
-
-  write_fws_multimap(f, data.in_allowed_);
-  write_array(f, data.out_allowed_.data_);
-}
-
-template <typename T>
-void read_array(file& f, array_offset const& off, mcd::vector<T>& data) {
-  assert(off.length_ % sizeof(T) == 0);
-  data.resize(off.length_ / sizeof(T));
-  f.read(data.data(), off.start_, off.length_);
-}
-
-template <typename T, typename Index>
-void read_fws_multimap(file& f, fws_multimap_offset const& off,
-                       fws_multimap<T, Index>& map) {
-  read_array(f, off.index_, map.index_);
-  read_array(f, off.data_, map.data_);
+  tb_serialized_data s;
+  s.version_ = CURRENT_VERSION;
+  auto const schedule_name = serialize_schedule_names(sched);
+  s.schedule_name_ = mcd::string{std::string_view{schedule_name}};
+  s.schedule_begin_ = static_cast<int64_t>(sched.schedule_begin_);
+  s.schedule_end_ = static_cast<int64_t>(sched.schedule_end_);
+  s.trip_count_ = data.trip_count_;
+  s.line_count_ = data.line_count_;
+
+  share(s.line_to_first_trip_, data.line_to_first_trip_);
+  share(s.line_to_last_trip_, data.line_to_last_trip_);
+  share(s.trip_to_line_, data.trip_to_line_);
+  share(s.line_stop_count_, data.line_stop_count_);
+
+  share(s.footpaths_, data.footpaths_);
+  share(s.reverse_footpaths_, data.reverse_footpaths_);
+  share(s.lines_at_stop_, data.lines_at_stop_);
+  share(s.stops_on_line_, data.stops_on_line_);
+
+  share(s.arrival_times_, data.arrival_times_);
+  share(s.departure_times_, data.departure_times_.data_);
+  share(s.transfers_index_, data.transfers_.index_);
+  share(s.transfers_, data.transfers_.data_);
+  share(s.reverse_transfers_index_, data.reverse_transfers_.index_);
+  share(s.reverse_transfers_, data.reverse_transfers_.data_);
+  share(s.line_departure_times_, data.line_departure_times_);
+  share(s.line_arrival_times_, data.line_arrival_times_.data_);
+
+  share(s.in_allowed_, data.in_allowed_);
+  share(s.out_allowed_, data.out_allowed_.data_);
+
+  auto writer = cista::buf<cista::mmap>(
+      cista::mmap{filename.c_str(), cista::mmap::protection::WRITE});
+  cista::serialize<MODE>(writer, s);
 }
 
-template <typename T, typename Index>
-void read_fws_multimap(file& f, fws_multimap_offset const& off,
-                       nested_fws_multimap<T, Index>& map) {
-  read_array(f, off.index_, map.index_);
-  read_array(f, off.data_, map.data_);
+tb_serialized_data const* read_serialized_data(std::string const& filename,
+                                               cista::memory_holder& mem) {
+#if defined(MOTIS_SCHEDULE_MODE_OFFSET) && !defined(CLANG_TIDY)
+  mem = cista::buf<cista::mmap>(
+      cista::mmap{filename.c_str(), cista::mmap::protection::READ});
+  return cista::deserialize<tb_serialized_data, MODE>(
+      std::get<cista::buf<cista::mmap>>(mem));
+#elif defined(MOTIS_SCHEDULE_MODE_RAW) || defined(CLANG_TIDY)
+  mem = cista::file(filename.c_str(), "r").content();
+  // NOLINTNEXTLINE
+  return cista::deserialize<tb_serialized_data, MODE>(
+      std::get<cista::buffer>(mem));
+#else
+#error "no ptr mode specified"
+#endif
 }
 
-bool data_okay_for_schedule(header const& h, schedule const& sched) {
-  if (h.version_ != CURRENT_VERSION) {
-    LOG(info) << "trip-based data file is old version (" << h.version_
+bool data_okay_for_schedule(tb_serialized_data const& s,
+                            schedule const& sched) {
+  if (s.version_ != CURRENT_VERSION) {
+    LOG(info) << "trip-based data file is old version (" << s.version_
               << "), expected " << CURRENT_VERSION;
     return false;
   }
 
   auto const& schedule_name = serialize_schedule_names(sched);
-  if (schedule_name != h.schedule_name_) {
+  if (s.schedule_name_.view() != schedule_name) {
     LOG(info) << "trip-based data file contains data for different schedule: "
-              << h.schedule_name_;
+              << s.schedule_name_.view();
     return false;
   }
 
-  if (sched.schedule_begin_ != static_cast<std::time_t>(h.schedule_begin_) ||
-      sched.schedule_end_ != static_cast<std::time_t>(h.schedule_end_)) {
+  if (sched.schedule_begin_ != static_cast<std::time_t>(s.schedule_begin_) ||
+      sched.schedule_end_ != static_cast<std::time_t>(s.schedule_end_)) {
     LOG(info) << "trip-based data file contains different schedule range: "
                  "schedule=["
               << format_unix_time(sched.schedule_begin_) << " ("
               << sched.schedule_begin_ << ") - "
               << format_unix_time(sched.schedule_end_) << " ("
               << sched.schedule_end_ << ")], serialized=["
-              << format_unix_time(h.schedule_begin_) << " ("
-              << h.schedule_begin_ << "), " << format_unix_time(h.schedule_end_)
-              << " (" << h.schedule_end_ << ")]";
+              << format_unix_time(s.schedule_begin_) << " ("
+              << s.schedule_begin_ << "), " << format_unix_time(s.schedule_end_)
+              << " (" << s.schedule_end_ << ")]";
     return false;
   }
 
-  if (sched.expanded_trips_.data_size() != h.trip_count_) {
+  if (sched.expanded_trips_.data_size() != s.trip_count_) {
     LOG(info)
         << "trip-based data file contains different number of trips: schedule="
         << sched.expanded_trips_.data_size()
-        << ", serialized=" << h.trip_count_;
+        << ", serialized=" << s.trip_count_;
     return false;
   }
 
@@ -243,52 +211,50 @@ bool data_okay_for_schedule(std::string const& filename,
     LOG(info) << "trip-based data file not found";
     return false;
   }
-  file f(filename.c_str(), "rb");
-  if (f.size() < sizeof(header)) {
-    LOG(info) << "trip-based data file does not contain header";
+  try {
+    cista::memory_holder mem;
+    return data_okay_for_schedule(*read_serialized_data(filename, mem), sched);
+  } catch (std::exception const& e) {
+    LOG(info) << "trip-based data file not readable (" << e.what() << ")";
     return false;
   }
-  header h{};
-  f.read(&h, 0, sizeof(header));
-  return data_okay_for_schedule(h, sched);
 }
 
-std::unique_ptr<tb_data> read_data(std::string const& filename,
-                                   schedule const& sched) {
-  utl::verify(fs::exists(filename), "read_data: does not exist: {}", filename);
-
-  file f(filename.c_str(), "rb");
-  utl::verify(f.size() >= sizeof(header),
-              "trip-based data file does not contain header");
-
-  header h{};
-  f.read(&h, 0, sizeof(header));
-  utl::verify(data_okay_for_schedule(h, sched), "trip-based data file ist");
-
-  auto data = std::make_unique<tb_data>();
-
-  data->trip_count_ = h.trip_count_;
-  data->line_count_ = h.line_count_;
-
-  read_array(f, h.line_to_first_trip_, data->line_to_first_trip_);
-  read_array(f, h.line_to_last_trip_, data->line_to_last_trip_);
-  read_array(f, h.trip_to_line_, data->trip_to_line_);
-  read_array(f, h.line_stop_count_, data->line_stop_count_);
-
-  read_fws_multimap(f, h.footpaths_, data->footpaths_);
-  read_fws_multimap(f, h.reverse_footpaths_, data->reverse_footpaths_);
-  read_fws_multimap(f, h.lines_at_stop_, data->lines_at_stop_);
-  read_fws_multimap(f, h.stops_on_line_, data->stops_on_line_);
-
-  read_fws_multimap(f, h.arrival_times_, data->arrival_times_);
-  read_array(f, h.departure_times_data_, data->departure_times_.data_);
-  read_fws_multimap(f, h.transfers_, data->transfers_);
-  read_fws_multimap(f, h.reverse_transfers_, data->reverse_transfers_);
-
-  read_fws_multimap(f, h.in_allowed_, data->in_allowed_);
-  read_array(f, h.out_allowed_data_, data->out_allowed_.data_);
-
-  return data;
+mapped_data::mapped_data(std::string const& filename,
+                         schedule const& sched) {
+  utl::verify(fs::exists(filename), "mapped_data: does not exist: {}",
+              filename);
+
+  auto const& s = *read_serialized_data(filename, mem_);
+  utl::verify(data_okay_for_schedule(s, sched),
+              "trip-based data file does not match schedule");
+
+  data_.trip_count_ = s.trip_count_;
+  data_.line_count_ = s.line_count_;
+
+  share(data_.line_to_first_trip_, s.line_to_first_trip_);
+  share(data_.line_to_last_trip_, s.line_to_last_trip_);
+  share(data_.trip_to_line_, s.trip_to_line_);
+  share(data_.line_stop_count_, s.line_stop_count_);
+
+  share(data_.footpaths_, s.footpaths_);
+  share(data_.reverse_footpaths_, s.reverse_footpaths_);
+  share(data_.lines_at_stop_, s.lines_at_stop_);
+  share(data_.stops_on_line_, s.stops_on_line_);
+
+  share(data_.arrival_times_, s.arrival_times_);
+  share(data_.departure_times_.data_, s.departure_times_);
+  share(data_.transfers_.index_, s.transfers_index_);
+  share(data_.transfers_.data_, s.transfers_);
+  data_.transfers_.complete_ = true;
+  share(data_.reverse_transfers_.index_, s.reverse_transfers_index_);
+  share(data_.reverse_transfers_.data_, s.reverse_transfers_);
+  data_.reverse_transfers_.complete_ = true;
+  share(data_.line_departure_times_, s.line_departure_times_);
+  share(data_.line_arrival_times_.data_, s.line_arrival_times_);
+
+  share(data_.in_allowed_, s.in_allowed_);
+  share(data_.out_allowed_.data_, s.out_allowed_);
 }
 
 }  // namespace motis::tripbased::serialization
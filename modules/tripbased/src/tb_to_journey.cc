@@ -35,7 +35,8 @@ bool is_out_allowed(node const* route_node) {
 }  // namespace debug
 
 std::pair<std::vector<intermediate::stop>, std::vector<intermediate::transport>>
-parse_tb_journey(schedule const& sched, tb_journey const& tbj) {
+parse_tb_journey(schedule const& sched, tb_data const& data,
+                 tb_journey const& tbj) {
   using namespace debug;
   std::vector<intermediate::stop> stops;
   std::vector<intermediate::transport> transports;
@@ -51,7 +52,8 @@ parse_tb_journey(schedule const& sched, tb_journey const& tbj) {
 
   for (auto const& e : tbj.edges_) {
     if (e.is_connection()) {
-      auto const trp = sched.expanded_trips_.data_[e.trip_];
+      auto const trp =
+          sched.expanded_trips_.data_[data.sched_trip_idx(e.trip_)];
       assert(trp != nullptr);
       assert(e.to_stop_index_ > e.from_stop_index_);
       for (auto trip_stop_idx = e.from_stop_index_;
@@ -89,7 +91,8 @@ parse_tb_journey(schedule const& sched, tb_journey const& tbj) {
   auto const& last_edge = tbj.edges_.back();
   auto last_stop = 0U;
   if (last_edge.is_connection()) {
-    auto const trp = sched.expanded_trips_.data_[last_edge.trip_];
+    auto const trp =
+        sched.expanded_trips_.data_[data.sched_trip_idx(last_edge.trip_)];
     assert(trp != nullptr);
     trip_stop stop{trp, last_edge.to_stop_index_};
     last_stop = stop.get_station_id();
@@ -103,9 +106,10 @@ parse_tb_journey(schedule const& sched, tb_journey const& tbj) {
   return {stops, transports};
 }
 
-journey tb_to_journey(schedule const& sched, tb_journey const& tbj) {
+journey tb_to_journey(schedule const& sched, tb_data const& data,
+                      tb_journey const& tbj) {
   assert(tbj.is_reconstructed());
-  auto const parsed = parse_tb_journey(sched, tbj);
+  auto const parsed = parse_tb_journey(sched, data, tbj);
   auto const& stops = parsed.first;
   auto const& transports = parsed.second;
 
@@ -3,9 +3,13 @@
 #include <cstring>
 #include <algorithm>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <utility>
 #include <vector>
 
@@ -15,6 +19,7 @@
 #include "utl/raii.h"
 #include "utl/to_vec.h"
 
+#include "motis/tripbased/compressed_transfers.h"
 #include "motis/tripbased/data.h"
 #include "motis/tripbased/debug.h"
 #include "motis/tripbased/error.h"
@@ -26,7 +31,9 @@
 #include "motis/tripbased/tb_profile_search.h"
 #include "motis/tripbased/tb_to_journey.h"
 #include "motis/tripbased/tripbased.h"
+#include "motis/tripbased/update_data.h"
 
+#include "motis/core/common/deadline.h"
 #include "motis/core/common/logging.h"
 #include "motis/core/common/timing.h"
 #include "motis/core/access/station_access.h"
@@ -37,6 +44,7 @@
 #include "motis/core/statistics/statistics.h"
 #include "motis/module/context/get_schedule.h"
 #include "motis/module/context/motis_call.h"
+#include "motis/module/context/motis_spawn.h"
 #include "motis/module/event_collector.h"
 #include "motis/module/ini_io.h"
 
@@ -239,16 +247,54 @@ void add_result(std::vector<tb_journey>& results, tb_journey const& tbj,
 }
 
 struct tripbased::impl {
-  explicit impl(std::unique_ptr<tb_data> data) : tb_data_{std::move(data)} {}
+  impl(std::unique_ptr<tb_data> data, bool const compress_transfers)
+      : compress_transfers_{compress_transfers} {
+    if (compress_transfers_) {
+      auto const size = data->transfers_.index_.size() * sizeof(uint64_t) +
+                        data->transfers_.data_.size() * sizeof(tb_transfer);
+      use_compressed_transfers(*data);
+      LOG(info) << "tripbased: compressed transfers: " << size << " -> "
+                << data->compressed_transfers_->size_in_bytes() << " bytes";
+    }
+    data_ = std::move(data);
+  }
+
+  explicit impl(std::unique_ptr<serialization::mapped_data> mapped) {
+    std::shared_ptr<serialization::mapped_data const> const owner{
+        std::move(mapped)};
+    data_ = std::shared_ptr<tb_data const>{owner, &owner->get()};
+  }
 
-  msg_ptr route(msg_ptr const& msg) {
+  // Snapshot for a search: realtime updates never modify data that is in
+  // use, they replace it (see update).
+  std::shared_ptr<tb_data const> get_data() const {
+    std::shared_lock lock{data_mutex_};
+    return data_;
+  }
+
+  msg_ptr route(msg_ptr const& msg, unsigned const default_timeout,
+                unsigned const profile_jobs) {
     MOTIS_START_TIMING(total_timing);
     auto const req = motis_content(RoutingRequest, msg);
+    auto search_deadline =
+        deadline::from_timeout_ms(req->timeout(), default_timeout);
 
     auto const& sched = get_schedule();
-    auto const query = build_tb_query(req, sched);
-
-    auto res = route_dispatch(query, sched);
+    auto query = build_tb_query(req, sched);
+    query.deadline_ = &search_deadline;
+    query.profile_jobs_ = profile_jobs;
+
+    // no lock is held during the search (the profile search jobs run on
+    // other threads): the snapshot keeps the data alive
+    std::shared_ptr<tb_data const> data;
+    tb_update_statistics update_stats;
+    {
+      std::shared_lock lock{data_mutex_};
+      data = data_;
+      update_stats = update_stats_;
+    }
+    auto res = route_dispatch(query, sched, *data);
+    res.stats_.emplace_back(to_stats_category("tripbased_rt", update_stats));
 
     MOTIS_STOP_TIMING(total_timing);
 
@@ -271,37 +317,41 @@ struct tripbased::impl {
   }
 
   inline trip_based_result route_dispatch(trip_based_query const& q,
-                                          schedule const& sched) {
+                                          schedule const& sched,
+                                          tb_data const& data) {
     if ((q.intermodal_start_ && q.start_edges_.empty()) ||
         (q.intermodal_destination_ && q.destination_edges_.empty())) {
       return {};
     }
     if (q.dir_ == search_dir::FWD) {
-      return route_dispatch_dir<search_dir::FWD>(q, sched);
+      return route_dispatch_dir<search_dir::FWD>(q, sched, data);
     } else {
-      return route_dispatch_dir<search_dir::BWD>(q, sched);
+      return route_dispatch_dir<search_dir::BWD>(q, sched, data);
     }
   }
 
   template <search_dir Dir>
   inline trip_based_result route_dispatch_dir(trip_based_query const& q,
-                                              schedule const& sched) {
+                                              schedule const& sched,
+                                              tb_data const& data) {
     if (q.is_ontrip()) {
-      return route_ontrip_station<Dir>(q, sched);
+      return route_ontrip_station<Dir>(q, sched, data);
     } else {
-      return route_pretrip<Dir>(q, sched);
+      return route_pretrip<Dir>(q, sched, data);
     }
   }
 
   template <search_dir Dir>
   trip_based_result route_ontrip_station(trip_based_query const& q,
-                                         schedule const& sched) {
+                                         schedule const& sched,
+                                         tb_data const& data) {
     trip_based_result res{};
     MOTIS_START_TIMING(search_timing);
     tb_ontrip_search<Dir> tbs(
-        *tb_data_, sched, q.start_time_, q.intermodal_start_,
+        data, sched, q.start_time_, q.intermodal_start_,
         q.intermodal_destination_,
         q.use_dest_metas_ ? destination_mode::ANY : destination_mode::ALL);
+    tbs.set_deadline(q.deadline_);
 
     add_starts_and_destinations(q, tbs);
 
@@ -312,13 +362,14 @@ struct tripbased::impl {
     res.stats_.emplace_back(
         to_stats_category("tripbased", tbs.get_statistics()));
 
-    build_results<Dir>(q, res, sched, tbs);
+    build_results<Dir>(q, res, sched, data, tbs);
     return res;
   }
 
   template <search_dir Dir>
   trip_based_result route_pretrip(trip_based_query const& q,
-                                  schedule const& sched) {
+                                  schedule const& sched,
+                                  tb_data const& data) {
     trip_based_result res{};
     std::vector<tb_statistics> tb_stats;
     MOTIS_START_TIMING(total_search_timing);
@@ -381,19 +432,18 @@ struct tripbased::impl {
           (!q.extend_interval_earlier_ || interval_begin == schedule_begin) &&
           (!q.extend_interval_later_ || interval_end == schedule_end);
 
-      tb_profile_search<Dir> tbs(*tb_data_, sched, interval_begin, interval_end,
-                                 q.intermodal_start_, q.intermodal_destination_,
-                                 dest_mode);
-      add_starts_and_destinations(q, tbs);
-      tbs.search();
+      auto const searches = profile_search<Dir>(
+          q, sched, data, interval_begin, interval_end, dest_mode);
+      auto& tbs = *searches.front();
       res.interval_begin_ = interval_begin;
       res.interval_end_ = interval_end;
-      build_results<Dir>(q, res, sched, tbs);
+      build_results<Dir>(q, res, sched, data, tbs);
       MOTIS_STOP_TIMING(iteration_search_timing);
       tbs.get_statistics().search_duration_ =
           MOTIS_TIMING_MS(iteration_search_timing);
       tb_stats.push_back(tbs.get_statistics());
-      if (res.journeys_.size() >= q.min_connection_count_) {
+      if (res.journeys_.size() >= q.min_connection_count_ ||
+          tbs.get_statistics().timeout_quit_ != 0U) {
         break;
       }
 
@@ -443,6 +493,58 @@ struct tripbased::impl {
     return res;
   }
 
+  // Splits the interval into q.profile_jobs_ parts searched concurrently.
+  // The results are merged into the first search (the others have to be
+  // kept until the journeys are built).
+  template <search_dir Dir>
+  std::vector<std::unique_ptr<tb_profile_search<Dir>>> profile_search(
+      trip_based_query const& q, schedule const& sched, tb_data const& data,
+      time const interval_begin, time const interval_end,
+      destination_mode const dest_mode) {
+    auto const interval_length =
+        static_cast<unsigned>(interval_end - interval_begin) + 1U;
+    auto const jobs = std::max(1U, std::min(q.profile_jobs_, interval_length));
+
+    // deadline::check() is not thread safe: one copy per part (timeout_quit
+    // of the parts is combined by merge_results)
+    std::vector<deadline> part_deadlines(
+        jobs, q.deadline_ != nullptr ? *q.deadline_ : deadline{});
+
+    std::vector<std::unique_ptr<tb_profile_search<Dir>>> searches;
+    for (auto i = 0U; i < jobs; ++i) {
+      auto const part_begin =
+          static_cast<time>(interval_begin + interval_length * i / jobs);
+      auto const part_end = static_cast<time>(
+          interval_begin + interval_length * (i + 1) / jobs - 1);
+      auto const& tbs =
+          searches.emplace_back(std::make_unique<tb_profile_search<Dir>>(
+              data, sched, part_begin, part_end, q.intermodal_start_,
+              q.intermodal_destination_, dest_mode));
+      tbs->set_deadline(jobs == 1U ? q.deadline_ : &part_deadlines[i]);
+      add_starts_and_destinations(q, *tbs);
+    }
+
+    if (jobs == 1U) {
+      searches.front()->search();
+      return searches;
+    }
+
+    std::vector<ctx::future_ptr<ctx_data, void>> futures;
+    for (auto const& tbs : searches) {
+      futures.emplace_back(
+          spawn_job_void([tbs = tbs.get()]() { tbs->search(); }));
+    }
+    ctx::await_all(futures);
+
+    for (auto i = 1U; i < jobs; ++i) {
+      searches.front()->merge_results(*searches[i]);
+    }
+    for (auto const& tbs : searches) {
+      tbs->set_deadline(q.deadline_);  // part_deadlines go out of scope
+    }
+    return searches;
+  }
+
   static bool is_reachable(schedule const& sched, trip_based_query const& q,
                            uint64_t& lower_bounds_duration) {
     MOTIS_START_TIMING(lower_bounds_timing);
@@ -483,7 +585,7 @@ struct tripbased::impl {
 
   template <search_dir Dir, typename TBS>
   void build_results(trip_based_query const& q, trip_based_result& res,
-                     schedule const& sched, TBS& tbs) {
+                     schedule const& sched, tb_data const& data, TBS& tbs) {
     std::vector<tb_journey> results;
     auto const add_starts = [&](std::vector<tb_journey>& tbjs) {
       for (auto& tbj : tbjs) {
@@ -582,7 +684,7 @@ struct tripbased::impl {
     filter_results(results, q, res);
 
     res.journeys_ = utl::to_vec(results, [&](tb_journey const& tbj) {
-      return tb_to_journey(sched, tbj);
+      return tb_to_journey(sched, data, tbj);
     });
   }
 
@@ -603,6 +705,7 @@ struct tripbased::impl {
   msg_ptr debug(msg_ptr const& msg) const {
     auto const req = motis_content(TripBasedTripDebugRequest, msg);
     auto const& sched = get_schedule();
+    auto const data = get_data();
 
     message_creator fbb;
     fbb.create_and_finish(
@@ -612,19 +715,186 @@ struct tripbased::impl {
             fbb.CreateVector(utl::to_vec(*req->trips(),
                                          [&](TripSelectorWrapper const* tsw) {
                                            return get_trip_debug_info(
-                                               fbb, *tb_data_, sched, tsw);
+                                               fbb, *data, sched, tsw);
                                          })),
             fbb.CreateVector(utl::to_vec(*req->stations(),
                                          [&](flatbuffers::String const* eva) {
                                            return get_station_debug_info(
-                                               fbb, *tb_data_, sched,
+                                               fbb, *data, sched,
                                                eva->str());
                                          })))
             .Union());
     return make_msg(fbb);
   }
 
-  std::unique_ptr<tb_data> tb_data_;
+  ~impl() {
+    if (rebuild_.valid()) {
+      rebuild_.wait();
+    }
+  }
+
+  impl(impl const&) = delete;
+  impl& operator=(impl const&) = delete;
+  impl(impl&&) = delete;
+  impl& operator=(impl&&) = delete;
+
+  void update(motis::rt::RtUpdates const* updates,
+              unsigned const rebuild_threshold) {
+    std::lock_guard update_lock{update_mutex_};
+    MOTIS_START_TIMING(update_timing);
+    auto const& sched = get_schedule();
+    if (!trip_indices_) {
+      trip_indices_ = get_expanded_trip_indices(sched);
+    }
+
+    // the data is only replaced with update_mutex_ held (here and in
+    // finish_rebuild): it can be read without data_mutex_
+    auto const& current = *data_;
+    auto stats = update_stats_;
+    auto const ignored = stats.ignored_additional_trains_;
+    auto trip_updates = collect_trip_updates(sched, current, *trip_indices_,
+                                             updates, stats);
+    if (stats.ignored_additional_trains_ != ignored) {
+      LOG(info) << "tripbased: ignored "
+                << stats.ignored_additional_trains_ - ignored
+                << " updates of additional trains";
+    }
+    if (stats.pending_rebuilds_ != 0U && !trip_updates.empty()) {
+      // applied to the rebuilt data before it replaces the current data
+      // (all trips: the rebuilt times can differ)
+      deferred_updates_.push_back(trip_updates);
+      ++stats.deferred_updates_;
+    }
+    erase_unchanged_trips(current, trip_updates);
+
+    std::shared_ptr<tb_data const> updated;
+    auto const large = trip_updates.size() > rebuild_threshold;
+    if (large && stats.pending_rebuilds_ == 0U) {
+      LOG(info) << "tripbased: rebuilding transfers in the background ("
+                << trip_updates.size() << " updated trips)";
+      start_rebuild(sched,
+                    copy_with_trip_updates(current, trip_updates, stats));
+      stats.pending_rebuilds_ = 1U;
+    }
+    if (!large && !trip_updates.empty()) {
+      // large updates: searches use the old times until the rebuild is done
+      updated = apply_trip_updates(sched, current, trip_updates, stats);
+    }
+    if (updated != nullptr && stats.pending_rebuilds_ == 0U &&
+        needs_transfer_merge(*updated)) {
+      start_transfer_merge(sched, updated);
+      stats.pending_rebuilds_ = 1U;
+    }
+    MOTIS_STOP_TIMING(update_timing);
+
+    auto const duration =
+        static_cast<uint64_t>(MOTIS_TIMING_US(update_timing));
+    ++stats.update_count_;
+    stats.last_update_duration_us_ = duration;
+    stats.max_update_duration_us_ =
+        std::max(stats.max_update_duration_us_, duration);
+    stats.total_update_duration_us_ += duration;
+    replace_data(std::move(updated), stats);
+  }
+
+  // Swaps in the new data (if any) and the statistics. The previous data is
+  // released after the lock. Caller holds update_mutex_.
+  void replace_data(std::shared_ptr<tb_data const> data,
+                    tb_update_statistics const& stats) {
+    std::unique_lock lock{data_mutex_};
+    if (data) {
+      data_.swap(data);
+    }
+    update_stats_ = stats;
+    lock.unlock();
+  }
+
+  // Computes the transfers of the copy without blocking searches or further
+  // updates. Updates received in the meantime are applied to the copy before
+  // it replaces the current data. Caller holds update_mutex_.
+  void start_rebuild(schedule const& sched, std::unique_ptr<tb_data> data) {
+    rebuild_ = std::async(std::launch::async,
+                          [this, &sched, data = std::move(data)]() mutable {
+                            finish_rebuild(sched, std::move(data), true);
+                          })
+                   .share();
+  }
+
+  // Compresses all transfers again (the transfer overlay of realtime updates
+  // gets too large), like start_rebuild. Caller holds update_mutex_.
+  void start_transfer_merge(schedule const& sched,
+                            std::shared_ptr<tb_data const> data) {
+    LOG(info) << "tripbased: merging the transfer overlay in the background ("
+              << data->transfer_overlay_.size_in_bytes() << " bytes)";
+    rebuild_ = std::async(std::launch::async,
+                          [this, &sched, data = std::move(data)]() {
+                            std::unique_ptr<tb_data> merged;
+                            try {
+                              merged = copy_with_merged_transfers(*data);
+                            } catch (std::exception const& e) {
+                              LOG(logging::error)
+                                  << "tripbased: transfer merge failed: "
+                                  << e.what();
+                            }
+                            finish_rebuild(sched, std::move(merged), false);
+                          })
+                   .share();
+  }
+
+  // full: computes the transfers first (start_rebuild), otherwise the
+  // transfers are merged already (start_transfer_merge).
+  void finish_rebuild(schedule const& sched, std::unique_ptr<tb_data> data,
+                      bool const full) {
+    if (full) {
+      try {
+        precompute_transfers(sched, *data);
+      } catch (std::exception const& e) {
+        LOG(logging::error) << "tripbased: rebuild failed: " << e.what();
+        data.reset();
+      }
+    }
+
+    std::lock_guard update_lock{update_mutex_};
+    auto stats = update_stats_;
+    if (data) {
+      for (auto const& trip_updates : deferred_updates_) {
+        data = apply_trip_updates(sched, *data, trip_updates, stats);
+      }
+      if (compress_transfers_ && data->compressed_transfers_ == nullptr) {
+        use_compressed_transfers(*data);
+      }
+      ++(full ? stats.full_rebuilds_ : stats.transfer_merges_);
+    }
+    deferred_updates_.clear();
+    stats.pending_rebuilds_ = 0U;
+    replace_data(std::move(data), stats);
+  }
+
+  void wait_for_rebuild() {
+    std::shared_future<void> rebuild;
+    {
+      std::lock_guard update_lock{update_mutex_};
+      rebuild = rebuild_;
+    }
+    if (rebuild.valid()) {
+      rebuild.wait();
+    }
+  }
+
+  // Either the data file (until the first realtime update) or heap data.
+  // Searches copy the pointer (get_data), realtime updates replace it.
+  std::shared_ptr<tb_data const> data_;
+  bool compress_transfers_{false};
+
+  // Guards data_ and update_stats_ (held only to copy / replace them).
+  mutable std::shared_mutex data_mutex_;
+  std::mutex update_mutex_;
+  tb_update_statistics update_stats_;
+  std::optional<expanded_trip_indices> trip_indices_;
+
+  // Background rebuild (see start_rebuild), guarded by update_mutex_.
+  std::shared_future<void> rebuild_;
+  std::vector<std::vector<tb_trip_update>> deferred_updates_;
 };
 
 struct import_state {
@@ -635,6 +905,19 @@ struct import_state {
 tripbased::tripbased() : module("Trip-Based Routing Options", "tripbased") {
   param(use_data_file_, "use_data_file",
         "create a data_file to speed up subsequent loading");
+  param(timeout_, "timeout",
+        "default search time budget in milliseconds (0 = unlimited)");
+  param(profile_jobs_, "profile_jobs",
+        "number of concurrent searches over parts of the interval of pretrip "
+        "queries (<= 1: sequential)");
+  param(rt_rebuild_threshold_, "rt_rebuild_threshold",
+        "number of trips changed by a realtime update above which all "
+        "transfers are recomputed on a copy of the data (in the background, "
+        "searches use the old times until it is done)");
+  param(compress_transfers_, "compress_transfers",
+        "store the transfers compressed (less memory, slower scans; "
+        "transfers recomputed by realtime updates stay uncompressed until "
+        "they are merged in the background)");
 }
 
 tripbased::~tripbased() = default;
@@ -675,16 +958,28 @@ void tripbased::init(motis::module::registry& reg) {
     if (use_data_file_) {
       auto const filename =
           get_data_directory() / "tripbased" / "tripbased.bin";
-      impl_ = std::make_unique<impl>(
-          load_data(get_sched(), filename.generic_string()));
+      auto mapped = load_data(get_sched(), filename.generic_string());
+      if (compress_transfers_) {
+        // the data file is read-only
+        impl_ = std::make_unique<impl>(copy_data(mapped->get()), true);
+      } else {
+        impl_ = std::make_unique<impl>(std::move(mapped));
+      }
     } else {
-      impl_ = std::make_unique<impl>(build_data(get_sched()));
+      impl_ =
+          std::make_unique<impl>(build_data(get_sched()), compress_transfers_);
     }
 
-    reg.register_op("/tripbased",
-                    [this](msg_ptr const& m) { return impl_->route(m); });
+    reg.register_op("/tripbased", [this](msg_ptr const& m) {
+      return impl_->route(m, timeout_, profile_jobs_);
+    });
     reg.register_op("/tripbased/debug",
                     [this](msg_ptr const& m) { return impl_->debug(m); });
+    reg.subscribe("/rt/update", [this](msg_ptr const& m) {
+      using motis::rt::RtUpdates;
+      impl_->update(motis_content(RtUpdates, m), rt_rebuild_threshold_);
+      return nullptr;
+    });
 
   } catch (std::exception const& e) {
     LOG(logging::warn) << "tripbased module not initialized (" << e.what()
@@ -694,9 +989,15 @@ void tripbased::init(motis::module::registry& reg) {
 
 bool tripbased::import_successful() const { return import_successful_; }
 
-tb_data const* tripbased::get_data() const {
+void tripbased::wait_for_rebuild() {
+  if (impl_) {
+    impl_->wait_for_rebuild();
+  }
+}
+
+std::shared_ptr<tb_data const> tripbased::get_data() const {
   if (impl_) {
-    return impl_->tb_data_.get();
+    return impl_->get_data();
   } else {
     return nullptr;
   }
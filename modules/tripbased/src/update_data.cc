@@ -0,0 +1,648 @@
+#include "motis/tripbased/update_data.h"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <utility>
+
+#include "utl/erase_if.h"
+#include "utl/verify.h"
+
+#include "motis/core/access/trip_iterator.h"
+#include "motis/core/conv/trip_conv.h"
+
+#include "motis/tripbased/compressed_transfers.h"
+#include "motis/tripbased/preprocessing.h"
+
+using namespace motis::access;
+using namespace motis::rt;
+
+namespace motis::tripbased {
+
+namespace {
+
+// Maximum time between arrival and departure of a transfer (preprocessing).
+constexpr auto const MAX_TRANSFER_TIME = 1440;
+
+bool is_disabled(tb_data const& data, trip_id const trip) {
+  return data.departure_times_[trip][0] == INVALID_TIME;
+}
+
+bool has_times(tb_data const& data, trip_id const trip,
+               tb_trip_update const& upd) {
+  auto const arrivals = data.arrival_times_[trip];
+  auto const departures = data.departure_times_[trip];
+  return std::equal(begin(arrivals), end(arrivals),
+                    begin(upd.arrival_times_), end(upd.arrival_times_)) &&
+         std::equal(begin(departures), end(departures),
+                    begin(upd.departure_times_), end(upd.departure_times_));
+}
+
+void init_rt_state(tb_data& data) {
+  if (data.sched_trip_idx_.empty()) {
+    data.sched_trip_idx_.resize(data.trip_count_);
+    std::iota(begin(data.sched_trip_idx_), end(data.sched_trip_idx_), 0U);
+    data.tb_trip_idx_ = data.sched_trip_idx_;
+  }
+  if (data.dirty_lines_.empty()) {
+    data.dirty_lines_.resize(data.line_count_, 0U);
+  }
+}
+
+// Returns the previous times of the updated trips.
+std::vector<tb_trip_update> patch_times(
+    tb_data& data, std::vector<tb_trip_update> const& updates,
+    tb_update_statistics& stats) {
+  init_rt_state(data);
+  std::vector<tb_trip_update> old_times;
+  old_times.reserve(updates.size());
+  for (auto const& upd : updates) {
+    auto const trip = data.tb_trip_idx(upd.sched_trip_idx_);
+    auto const arrivals = data.arrival_times_[trip];
+    auto const departures = data.departure_times_[trip];
+    utl::verify(arrivals.size() == upd.arrival_times_.size() &&
+                    departures.size() == upd.departure_times_.size(),
+                "tripbased update: invalid stop count");
+
+    auto& old = old_times.emplace_back();
+    old.sched_trip_idx_ = upd.sched_trip_idx_;
+    old.arrival_times_.assign(begin(arrivals), end(arrivals));
+    old.departure_times_.assign(begin(departures), end(departures));
+
+    auto const first = data.arrival_times_.index_[trip];
+    for (auto i = 0U; i < upd.arrival_times_.size(); ++i) {
+      data.arrival_times_.data_[first + i] = upd.arrival_times_[i];
+      data.departure_times_.data_[first + i] = upd.departure_times_[i];
+    }
+
+    if (is_disabled(data, trip)) {
+      ++stats.disabled_trips_;
+    }
+  }
+  stats.updated_trips_ += updates.size();
+  return old_times;
+}
+
+std::set<line_id> get_lines(tb_data const& data,
+                            std::vector<tb_trip_update> const& updates) {
+  std::set<line_id> lines;
+  for (auto const& upd : updates) {
+    lines.insert(data.trip_to_line_[data.tb_trip_idx(upd.sched_trip_idx_)]);
+  }
+  return lines;
+}
+
+bool is_fifo(tb_data const& data, std::vector<trip_id> const& order,
+             stop_idx_t const stop_count) {
+  for (auto i = 1U; i < order.size(); ++i) {
+    auto const a = order[i - 1];
+    auto const b = order[i];
+    for (stop_idx_t stop = 0U; stop < stop_count; ++stop) {
+      if ((stop + 1 < stop_count &&
+           data.departure_times_[a][stop] > data.departure_times_[b][stop]) ||
+          (stop > 0 &&
+           data.arrival_times_[a][stop] > data.arrival_times_[b][stop])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Stores the trips of the line (starting at first) in the given order.
+void permute_trips(tb_data& data, trip_id const first,
+                   std::vector<trip_id> const& order) {
+  std::vector<time> arrivals, departures;
+  std::vector<uint32_t> sched_trips;
+  for (auto const trip : order) {
+    auto const a = data.arrival_times_[trip];
+    auto const d = data.departure_times_[trip];
+    arrivals.insert(end(arrivals), begin(a), end(a));
+    departures.insert(end(departures), begin(d), end(d));
+    sched_trips.push_back(data.sched_trip_idx_[trip]);
+  }
+
+  auto const base = data.arrival_times_.index_[first];
+  for (auto i = 0U; i < arrivals.size(); ++i) {
+    data.arrival_times_.data_[base + i] = arrivals[i];
+    data.departure_times_.data_[base + i] = departures[i];
+  }
+  for (auto i = 0U; i < sched_trips.size(); ++i) {
+    data.sched_trip_idx_[first + i] = sched_trips[i];
+    data.tb_trip_idx_[sched_trips[i]] = first + i;
+  }
+}
+
+struct sort_result {
+  std::vector<trip_id> new_to_old_;  // empty: no line was re-sorted
+  std::vector<line_id> changed_lines_;  // re-sorted or dirty state changed
+};
+
+sort_result sort_lines(tb_data& data, std::set<line_id> const& lines,
+                       tb_update_statistics& stats) {
+  sort_result result;
+  for (auto const line : lines) {
+    auto const first = data.line_to_first_trip_[line];
+    auto const stop_count = data.line_stop_count_[line];
+    std::vector<trip_id> order(data.line_to_last_trip_[line] - first + 1);
+    std::iota(begin(order), end(order), first);
+
+    auto const was_dirty = data.is_dirty(line);
+    auto dirty = std::any_of(begin(order), end(order), [&](trip_id const t) {
+      return is_disabled(data, t);
+    });
+    if (!dirty && !is_fifo(data, order, stop_count)) {
+      std::stable_sort(begin(order), end(order), [&](trip_id a, trip_id b) {
+        auto const da = data.departure_times_[a];
+        auto const db = data.departure_times_[b];
+        auto const aa = data.arrival_times_[a];
+        auto const ab = data.arrival_times_[b];
+        return std::lexicographical_compare(begin(da), end(da), begin(db),
+                                            end(db)) ||
+               (std::equal(begin(da), end(da), begin(db), end(db)) &&
+                std::lexicographical_compare(begin(aa), end(aa), begin(ab),
+                                             end(ab)));
+      });
+      dirty = !is_fifo(data, order, stop_count);
+      if (!dirty) {
+        if (result.new_to_old_.empty()) {
+          result.new_to_old_.resize(data.trip_count_);
+          std::iota(begin(result.new_to_old_), end(result.new_to_old_), 0U);
+        }
+        for (auto i = 0U; i < order.size(); ++i) {
+          result.new_to_old_[first + i] = order[i];
+        }
+        permute_trips(data, first, order);
+        result.changed_lines_.push_back(line);
+        ++stats.resorted_lines_;
+      }
+    }
+
+    update_line_times(data, line);
+    data.dirty_lines_[line] = dirty ? 1U : 0U;
+    if (dirty != was_dirty) {
+      result.changed_lines_.push_back(line);
+    }
+  }
+  stats.dirty_lines_ = static_cast<uint64_t>(
+      std::count(begin(data.dirty_lines_), end(data.dirty_lines_), 1U));
+  return result;
+}
+
+std::optional<std::pair<int, int>> time_range(time const a, time const b) {
+  if (a == INVALID_TIME && b == INVALID_TIME) {
+    return {};
+  } else if (a == INVALID_TIME || b == INVALID_TIME) {
+    auto const t = a == INVALID_TIME ? b : a;
+    return std::make_pair(t, t);
+  } else {
+    return std::make_pair(std::min(a, b), std::max(a, b));
+  }
+}
+
+// Trips whose transfers / reverse transfers can change because the updated
+// trip departs / arrives at a different time: trips arriving (departing) in
+// the window between the departure (arrival) of the previous (next) trip of
+// the line and the old / new time. No trip order in dirty lines: all trips
+// within the maximum transfer time.
+void add_affected_trips(schedule const& sched, tb_data const& data,
+                        trip_id const trip, tb_trip_update const& old,
+                        std::vector<trip_id>& transfer_trips,
+                        std::vector<trip_id>& reverse_transfer_trips) {
+  auto const line = data.trip_to_line_[trip];
+  auto const first = data.line_to_first_trip_[line];
+  auto const last = data.line_to_last_trip_[line];
+  auto const stop_count = data.line_stop_count_[line];
+  auto const dirty = data.is_dirty(line);
+
+  for (stop_idx_t stop = 0U; stop < stop_count; ++stop) {
+    auto const station = data.stops_on_line_[line][stop];
+    auto const transfer_time =
+        static_cast<uint32_t>(sched.stations_[station]->transfer_time_);
+
+    auto const departures = time_range(old.departure_times_[stop],
+                                       data.departure_times_[trip][stop]);
+    if (departures && data.in_allowed_[line][stop] != 0U) {
+      auto const [lo, hi] = *departures;
+      auto lower = lo - MAX_TRANSFER_TIME - 1;
+      for (auto t = first; !dirty && t <= last; ++t) {
+        auto const dep = data.departure_times_[t][stop];
+        if (t != trip && dep != INVALID_TIME && dep < lo) {
+          lower = std::max(lower, static_cast<int>(dep));
+        }
+      }
+      auto const add_arriving = [&, hi = hi](station_id const from,
+                                             uint32_t duration) {
+        for (auto const& ls : data.lines_at_stop_[from]) {
+          if (ls.stop_idx_ == 0 ||
+              data.out_allowed_[ls.line_][ls.stop_idx_] == 0U) {
+            continue;
+          }
+          for (auto t = data.line_to_first_trip_[ls.line_];
+               t <= data.line_to_last_trip_[ls.line_]; ++t) {
+            auto const arr = data.arrival_times_[t][ls.stop_idx_];
+            auto const a = static_cast<int>(arr + duration);
+            if (arr != INVALID_TIME && a > lower && a <= hi) {
+              transfer_trips.push_back(t);
+            }
+          }
+        }
+      };
+      add_arriving(station, transfer_time);
+      for (auto const& fp : data.reverse_footpaths_[station]) {
+        add_arriving(fp.from_stop_, fp.duration_);
+      }
+    }
+
+    auto const arrivals = time_range(old.arrival_times_[stop],
+                                     data.arrival_times_[trip][stop]);
+    if (arrivals && data.out_allowed_[line][stop] != 0U) {
+      auto const [lo, hi] = *arrivals;
+      auto upper = hi + MAX_TRANSFER_TIME + 1;
+      for (auto t = first; !dirty && t <= last; ++t) {
+        auto const arr = data.arrival_times_[t][stop];
+        if (t != trip && arr != INVALID_TIME && arr > hi) {
+          upper = std::min(upper, static_cast<int>(arr));
+        }
+      }
+      auto const add_departing = [&, lo = lo](station_id const to,
+                                              uint32_t duration) {
+        for (auto const& ls : data.lines_at_stop_[to]) {
+          if (ls.stop_idx_ == data.line_stop_count_[ls.line_] - 1 ||
+              data.in_allowed_[ls.line_][ls.stop_idx_] == 0U) {
+            continue;
+          }
+          for (auto t = data.line_to_first_trip_[ls.line_];
+               t <= data.line_to_last_trip_[ls.line_]; ++t) {
+            auto const dep = data.departure_times_[t][ls.stop_idx_];
+            auto const d = static_cast<int>(dep) - static_cast<int>(duration);
+            if (dep != INVALID_TIME && d >= lo && d < upper) {
+              reverse_transfer_trips.push_back(t);
+            }
+          }
+        }
+      };
+      add_departing(station, transfer_time);
+      for (auto const& fp : data.footpaths_[station]) {
+        add_departing(fp.to_stop_, fp.duration_);
+      }
+    }
+  }
+}
+
+// Builds the nested transfer map of the updated data: recomputed transfers
+// for the given (sorted) trips, remapped transfers of the previous data
+// (for_each_old(old_trip, stop, fn)) for all other trips.
+template <typename T, typename Index, typename ForEachOld, typename Remap>
+void replace_transfers(nested_fws_multimap<T, Index>& transfers,
+                       tb_data const& data,
+                       std::vector<trip_id> const& new_to_old,
+                       std::vector<trip_id> const& trips,
+                       std::vector<std::vector<std::vector<T>>> const& updated,
+                       ForEachOld const& for_each_old, Remap const& remap) {
+  mcd::vector<Index> index;
+  mcd::vector<T> entries;
+  index.reserve(data.arrival_times_.index_.back() + 1);
+
+  auto next = 0U;
+  for (trip_id trip = 0U; trip < data.trip_count_; ++trip) {
+    auto const stop_count = data.line_stop_count_[data.trip_to_line_[trip]];
+    if (next < trips.size() && trips[next] == trip) {
+      auto const& trip_transfers = updated[next++];
+      utl::verify(trip_transfers.size() == stop_count,
+                  "tripbased update: invalid transfer stop count");
+      for (auto const& stop_transfers : trip_transfers) {
+        index.push_back(static_cast<Index>(entries.size()));
+        for (auto const& t : stop_transfers) {
+          entries.push_back(t);
+        }
+      }
+    } else {
+      auto const src = new_to_old.empty() ? trip : new_to_old[trip];
+      for (stop_idx_t stop = 0U; stop < stop_count; ++stop) {
+        index.push_back(static_cast<Index>(entries.size()));
+        for_each_old(src, stop,
+                     [&](T const& t) { entries.push_back(remap(t)); });
+      }
+    }
+  }
+  index.push_back(static_cast<Index>(entries.size()));
+
+  transfers.index_ = std::move(index);
+  transfers.data_ = std::move(entries);
+  transfers.current_start_ = static_cast<Index>(transfers.data_.size());
+  transfers.complete_ = true;
+}
+
+// Compressed transfers: shared with the updated data, the recomputed
+// transfers and the remapped overlay of the previous data for all other
+// trips form the new overlay (instead of compressing all transfers again).
+template <typename Remap>
+void update_transfer_overlay(
+    tb_data& updated, tb_data const& data,
+    std::vector<trip_id> const& new_to_old, std::vector<trip_id> const& trips,
+    std::vector<std::vector<std::vector<tb_transfer>>> const& recomputed,
+    Remap const& remap) {
+  auto const& old = data.transfer_overlay_;
+  auto& overlay = updated.transfer_overlay_;
+  updated.compressed_transfers_ = data.compressed_transfers_;
+
+  if (new_to_old.empty()) {
+    overlay.to_compressed_trip_ = old.to_compressed_trip_;
+    overlay.to_current_trip_ = old.to_current_trip_;
+  } else {
+    overlay.to_compressed_trip_.resize(data.trip_count_);
+    overlay.to_current_trip_.resize(data.trip_count_);
+    for (trip_id trip = 0U; trip < data.trip_count_; ++trip) {
+      auto const src = new_to_old[trip];
+      auto const compressed = old.to_compressed_trip_.empty()
+                                  ? src
+                                  : old.to_compressed_trip_[src];
+      overlay.to_compressed_trip_[trip] = compressed;
+      overlay.to_current_trip_[compressed] = trip;
+    }
+  }
+
+  overlay.first_key_.resize(data.trip_count_, transfer_overlay::NO_KEY);
+  auto next = 0U;
+  for (trip_id trip = 0U; trip < data.trip_count_; ++trip) {
+    auto const stop_count = data.line_stop_count_[data.trip_to_line_[trip]];
+    auto const src = new_to_old.empty() ? trip : new_to_old[trip];
+    if (next < trips.size() && trips[next] == trip) {
+      auto const& trip_transfers = recomputed[next++];
+      utl::verify(trip_transfers.size() == stop_count,
+                  "tripbased update: invalid transfer stop count");
+      overlay.first_key_[trip] = static_cast<uint32_t>(overlay.index_.size());
+      for (auto const& stop_transfers : trip_transfers) {
+        overlay.index_.push_back(
+            static_cast<uint32_t>(overlay.transfers_.size()));
+        overlay.transfers_.insert(end(overlay.transfers_),
+                                  begin(stop_transfers), end(stop_transfers));
+      }
+    } else if (!old.first_key_.empty() &&
+               old.first_key_[src] != transfer_overlay::NO_KEY) {
+      overlay.first_key_[trip] = static_cast<uint32_t>(overlay.index_.size());
+      auto const first = old.first_key_[src];
+      for (stop_idx_t stop = 0U; stop < stop_count; ++stop) {
+        overlay.index_.push_back(
+            static_cast<uint32_t>(overlay.transfers_.size()));
+        for (auto i = old.index_[first + stop];
+             i != old.index_[first + stop + 1]; ++i) {
+          overlay.transfers_.push_back(remap(old.transfers_[i]));
+        }
+      }
+    }
+  }
+  overlay.index_.push_back(static_cast<uint32_t>(overlay.transfers_.size()));
+}
+
+void sort_unique(std::vector<trip_id>& trips) {
+  std::sort(begin(trips), end(trips));
+  trips.erase(std::unique(begin(trips), end(trips)), end(trips));
+}
+
+std::unique_ptr<tb_data> copy_without_transfers(tb_data const& data) {
+  auto copy = std::make_unique<tb_data>();
+  copy->trip_count_ = data.trip_count_;
+  copy->line_count_ = data.line_count_;
+  copy->line_to_first_trip_ = data.line_to_first_trip_;
+  copy->line_to_last_trip_ = data.line_to_last_trip_;
+  copy->trip_to_line_ = data.trip_to_line_;
+  copy->line_stop_count_ = data.line_stop_count_;
+  copy->footpaths_ = data.footpaths_;
+  copy->reverse_footpaths_ = data.reverse_footpaths_;
+  copy->lines_at_stop_ = data.lines_at_stop_;
+  copy->stops_on_line_ = data.stops_on_line_;
+  copy->arrival_times_ = data.arrival_times_;
+  copy->departure_times_.data_ = data.departure_times_.data_;
+  copy->line_departure_times_ = data.line_departure_times_;
+  copy->line_arrival_times_.data_ = data.line_arrival_times_.data_;
+  copy->in_allowed_ = data.in_allowed_;
+  copy->out_allowed_.data_ = data.out_allowed_.data_;
+  copy->sched_trip_idx_ = data.sched_trip_idx_;
+  copy->tb_trip_idx_ = data.tb_trip_idx_;
+  copy->dirty_lines_ = data.dirty_lines_;
+  return copy;
+}
+
+void copy_reverse_transfers(tb_data const& data, tb_data& copy) {
+  copy.reverse_transfers_.index_ = data.reverse_transfers_.index_;
+  copy.reverse_transfers_.data_ = data.reverse_transfers_.data_;
+  copy.reverse_transfers_.current_start_ =
+      data.reverse_transfers_.current_start_;
+  copy.reverse_transfers_.complete_ = data.reverse_transfers_.complete_;
+}
+
+}  // namespace
+
+std::unique_ptr<tb_data> copy_data(tb_data const& data) {
+  auto copy = copy_without_transfers(data);
+  if (data.compressed_transfers_ == nullptr) {
+    copy->transfers_.index_ = data.transfers_.index_;
+    copy->transfers_.data_ = data.transfers_.data_;
+    copy->transfers_.current_start_ = data.transfers_.current_start_;
+    copy->transfers_.complete_ = data.transfers_.complete_;
+  } else {
+    decompress_transfers(data, copy->transfers_);
+  }
+  copy_reverse_transfers(data, *copy);
+  return copy;
+}
+
+bool needs_transfer_merge(tb_data const& data) {
+  return data.compressed_transfers_ != nullptr &&
+         data.transfer_overlay_.size_in_bytes() * 4U >
+             data.compressed_transfers_->size_in_bytes();
+}
+
+std::unique_ptr<tb_data> copy_with_merged_transfers(tb_data const& data) {
+  auto copy = copy_without_transfers(data);
+  copy->compressed_transfers_ =
+      std::make_shared<compressed_transfers const>(compress_transfers(data));
+  copy_reverse_transfers(data, *copy);
+  return copy;
+}
+
+expanded_trip_indices get_expanded_trip_indices(schedule const& sched) {
+  expanded_trip_indices indices;
+  for (auto i = 0U; i < sched.expanded_trips_.data_size(); ++i) {
+    indices[sched.expanded_trips_.data_[i]] = i;
+  }
+  return indices;
+}
+
+std::vector<tb_trip_update> collect_trip_updates(
+    schedule const& sched, tb_data const& data,
+    expanded_trip_indices const& trip_indices, RtUpdates const* updates,
+    tb_update_statistics& stats) {
+  std::set<uint32_t> trips;
+  auto const add_trip = [&](trip const* trp) {
+    auto const add = [&](trip const* t) {
+      auto const it = trip_indices.find(t);
+      if (it != trip_indices.end()) {
+        trips.insert(it->second);
+        return true;
+      }
+      return false;
+    };
+    if (!add(trp)) {
+      // additional train (reroute update without old route, later delays):
+      // not supported (see update_data.h)
+      ++stats.ignored_additional_trains_;
+      return;
+    }
+    for (auto const& s : sections{trp}) {
+      for (auto const& merged : *sched.merged_trips_[s.lcon().trips_]) {
+        add(merged);
+      }
+    }
+  };
+
+  for (auto const& u : *updates->updates()) {
+    switch (u->content_type()) {
+      case Content_RtDelayUpdate:
+        add_trip(from_fbs(
+            sched,
+            reinterpret_cast<RtDelayUpdate const*>(u->content())->trip()));
+        break;
+
+      case Content_RtRerouteUpdate:
+        add_trip(from_fbs(
+            sched,
+            reinterpret_cast<RtRerouteUpdate const*>(u->content())->trip()));
+        break;
+
+      default: break;
+    }
+  }
+
+  std::vector<tb_trip_update> result;
+  for (auto const sched_trip : trips) {
+    auto const trip = data.tb_trip_idx(sched_trip);
+    auto const line = data.trip_to_line_[trip];
+    auto const stop_count = data.line_stop_count_[line];
+    auto const line_stops = data.stops_on_line_[line];
+
+    tb_trip_update upd;
+    upd.sched_trip_idx_ = sched_trip;
+    upd.arrival_times_.resize(stop_count, INVALID_TIME);
+    upd.departure_times_.resize(stop_count, INVALID_TIME);
+
+    auto stop = 0U;
+    auto valid = true;
+    for (auto const& s : sections{sched.expanded_trips_.data_[sched_trip]}) {
+      if (stop + 1 >= stop_count || s.from_station_id() != line_stops[stop] ||
+          s.to_station_id() != line_stops[stop + 1]) {
+        valid = false;
+        break;
+      }
+      upd.departure_times_[stop] = s.lcon().d_time_;
+      upd.arrival_times_[stop + 1] = s.lcon().a_time_;
+      ++stop;
+    }
+    if (!valid || stop + 1 != stop_count) {
+      std::fill(begin(upd.arrival_times_), end(upd.arrival_times_),
+                INVALID_TIME);
+      std::fill(begin(upd.departure_times_), end(upd.departure_times_),
+                INVALID_TIME);
+    }
+
+    result.emplace_back(std::move(upd));
+  }
+  return result;
+}
+
+void erase_unchanged_trips(tb_data const& data,
+                           std::vector<tb_trip_update>& updates) {
+  utl::erase_if(updates, [&](tb_trip_update const& upd) {
+    return has_times(data, data.tb_trip_idx(upd.sched_trip_idx_), upd);
+  });
+}
+
+std::unique_ptr<tb_data> apply_trip_updates(
+    schedule const& sched, tb_data const& data,
+    std::vector<tb_trip_update> const& updates, tb_update_statistics& stats) {
+  auto updated = copy_without_transfers(data);
+  auto const old_times = patch_times(*updated, updates, stats);
+  auto const sorted =
+      sort_lines(*updated, get_lines(*updated, updates), stats);
+
+  std::vector<trip_id> transfer_trips, reverse_transfer_trips;
+  for (auto const line : sorted.changed_lines_) {
+    for (auto t = updated->line_to_first_trip_[line];
+         t <= updated->line_to_last_trip_[line]; ++t) {
+      transfer_trips.push_back(t);
+      reverse_transfer_trips.push_back(t);
+    }
+  }
+  for (auto const& old : old_times) {
+    auto const trip = updated->tb_trip_idx(old.sched_trip_idx_);
+    transfer_trips.push_back(trip);
+    reverse_transfer_trips.push_back(trip);
+    add_affected_trips(sched, *updated, trip, old, transfer_trips,
+                       reverse_transfer_trips);
+  }
+  sort_unique(transfer_trips);
+  sort_unique(reverse_transfer_trips);
+
+  std::vector<trip_id> old_to_new;
+  if (!sorted.new_to_old_.empty()) {
+    old_to_new.resize(data.trip_count_);
+    for (trip_id t = 0U; t < data.trip_count_; ++t) {
+      old_to_new[sorted.new_to_old_[t]] = t;
+    }
+  }
+  auto const remap = [&](trip_id const t) {
+    return old_to_new.empty() ? t : old_to_new[t];
+  };
+
+  auto const remap_transfer = [&](tb_transfer t) {
+    t.to_trip_ = remap(t.to_trip_);
+    return t;
+  };
+  if (data.compressed_transfers_ == nullptr) {
+    replace_transfers(
+        updated->transfers_, *updated, sorted.new_to_old_, transfer_trips,
+        compute_transfers(sched, *updated, transfer_trips),
+        [&](trip_id const trip, stop_idx_t const stop, auto const& fn) {
+          for (auto const& t : data.transfers_.at(trip, stop)) {
+            fn(t);
+          }
+        },
+        remap_transfer);
+  } else {
+    update_transfer_overlay(
+        *updated, data, sorted.new_to_old_, transfer_trips,
+        compute_transfers(sched, *updated, transfer_trips), remap_transfer);
+  }
+  replace_transfers(
+      updated->reverse_transfers_, *updated, sorted.new_to_old_,
+      reverse_transfer_trips,
+      compute_reverse_transfers(sched, *updated, reverse_transfer_trips),
+      [&](trip_id const trip, stop_idx_t const stop, auto const& fn) {
+        for (auto const& t : data.reverse_transfers_.at(trip, stop)) {
+          fn(t);
+        }
+      },
+      [&](tb_reverse_transfer t) {
+        t.from_trip_ = remap(t.from_trip_);
+        return t;
+      });
+
+  stats.recomputed_transfers_ += transfer_trips.size();
+  stats.recomputed_reverse_transfers_ += reverse_transfer_trips.size();
+  return updated;
+}
+
+std::unique_ptr<tb_data> copy_with_trip_updates(
+    tb_data const& data, std::vector<tb_trip_update> const& updates,
+    tb_update_statistics& stats) {
+  auto copy = copy_without_transfers(data);
+  patch_times(*copy, updates, stats);
+  sort_lines(*copy, get_lines(*copy, updates), stats);
+  return copy;
+}
+
+}  // namespace motis::tripbased
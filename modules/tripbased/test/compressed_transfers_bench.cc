@@ -0,0 +1,54 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+#include "motis/tripbased/compressed_transfers.h"
+#include "motis/tripbased/data.h"
+
+#include "./random_transfers.h"
+
+using namespace motis;
+using namespace motis::tripbased;
+
+// Memory / scan time of the compressed transfers compared to transfers_
+// (scanning the transfers of all stops of each trip, as the searches do):
+//
+//   ./motis-bench --gtest_filter='tripbased_compressed_transfers_bench.*'
+
+TEST(tripbased_compressed_transfers_bench, scan) {
+  std::mt19937 rng{7};
+  tb_data data;
+  build_random_transfers(data, rng);
+
+  auto const scan = [&](char const* name) {
+    auto const start = std::chrono::steady_clock::now();
+    uint64_t checksum = 0U, count = 0U;
+    for (trip_id trip = 0U; trip < data.trip_count_; ++trip) {
+      for (stop_idx_t stop = 0U; stop < data.arrival_times_[trip].size();
+           ++stop) {
+        data.for_each_transfer(trip, stop, [&](tb_transfer const& t) {
+          checksum += t.to_trip_ + t.to_stop_idx_;
+          ++count;
+        });
+      }
+    }
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    std::cout << name << ": " << static_cast<double>(ns) / count
+              << " ns/transfer\n";
+    return checksum;
+  };
+
+  auto const size = data.transfers_.index_.size() * sizeof(uint64_t) +
+                    data.transfers_.data_.size() * sizeof(tb_transfer);
+  auto const expected = scan("uncompressed");
+  use_compressed_transfers(data);
+  EXPECT_EQ(expected, scan("compressed"));
+
+  std::cout << "uncompressed: " << size << " bytes, compressed: "
+            << data.compressed_transfers_->size_in_bytes() << " bytes\n";
+}
@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include <random>
+#include <vector>
+
+#include "motis/tripbased/compressed_transfers.h"
+#include "motis/tripbased/data.h"
+
+#include "./random_transfers.h"
+
+using namespace motis;
+using namespace motis::tripbased;
+
+namespace {
+
+template <typename Transfers>
+void expect_transfers(Transfers const& expected,
+                      std::vector<tb_transfer> const& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (auto i = 0U; i < actual.size(); ++i) {
+    EXPECT_EQ(expected[i].to_trip_, actual[i].to_trip_);
+    EXPECT_EQ(expected[i].to_stop_idx_, actual[i].to_stop_idx_);
+  }
+}
+
+}  // namespace
+
+TEST(tripbased_compressed_transfers, round_trip) {
+  std::mt19937 rng{42};
+  tb_data data;
+  build_random_transfers(data, rng);
+  auto const ct = compress_transfers(data);
+
+  for (trip_id trip = 0U; trip < data.trip_count_; ++trip) {
+    for (stop_idx_t stop = 0U; stop < data.arrival_times_[trip].size();
+         ++stop) {
+      std::vector<tb_transfer> decoded;
+      ct.for_each(data.arrival_times_.index_[trip] + stop, trip,
+                  [&](tb_transfer const& t) { decoded.push_back(t); });
+      expect_transfers(data.transfers_.at(trip, stop), decoded);
+    }
+  }
+
+  auto const transfers = data.transfers_.data_;
+  auto const index = data.transfers_.index_;
+  use_compressed_transfers(data);
+  EXPECT_EQ(0U, data.transfers_.data_size());
+  EXPECT_EQ(ct.data_, data.compressed_transfers_->data_);
+
+  nested_fws_multimap<tb_transfer> decompressed{data.arrival_times_.index_};
+  decompress_transfers(data, decompressed);
+  EXPECT_EQ(index, decompressed.index_);
+  expect_transfers(transfers, std::vector<tb_transfer>(
+                                  begin(decompressed.data_),
+                                  end(decompressed.data_)));
+}
+
+TEST(tripbased_compressed_transfers, size) {
+  std::mt19937 rng{7};
+  tb_data data;
+  build_random_transfers(data, rng);
+
+  auto const size = data.transfers_.index_.size() * sizeof(uint64_t) +
+                    data.transfers_.data_.size() * sizeof(tb_transfer);
+  use_compressed_transfers(data);
+  EXPECT_LT(data.compressed_transfers_->size_in_bytes(), size / 2);
+}
+
+TEST(tripbased_compressed_transfers, overlay) {
+  std::mt19937 rng{3};
+  tb_data data;
+  build_random_transfers(data, rng);
+  auto const transfers_of = [&](trip_id const trip, stop_idx_t const stop) {
+    std::vector<tb_transfer> result;
+    data.for_each_transfer(trip, stop,
+                           [&](tb_transfer const& t) { result.push_back(t); });
+    return result;
+  };
+
+  // trips a and b (same stop count) swapped, new transfers of trip c
+  trip_id a = 0U, b = 1U;
+  while (data.arrival_times_[a].size() != data.arrival_times_[b].size()) {
+    ++b;
+  }
+  auto const c = b + 1U;
+  auto const swapped = [&](trip_id const t) {
+    return t == a ? b : t == b ? a : t;
+  };
+  std::vector<std::vector<tb_transfer>> expected_a;
+  for (stop_idx_t stop = 0U; stop < data.arrival_times_[b].size(); ++stop) {
+    auto& expected = expected_a.emplace_back();
+    for (auto t : data.transfers_.at(b, stop)) {
+      t.to_trip_ = swapped(t.to_trip_);
+      expected.push_back(t);
+    }
+  }
+  use_compressed_transfers(data);
+
+  auto& overlay = data.transfer_overlay_;
+  overlay.first_key_.resize(data.trip_count_, transfer_overlay::NO_KEY);
+  overlay.first_key_[c] = 0U;
+  for (stop_idx_t stop = 0U; stop < data.arrival_times_[c].size(); ++stop) {
+    overlay.index_.push_back(static_cast<uint32_t>(overlay.transfers_.size()));
+    overlay.transfers_.emplace_back(7U, stop);
+  }
+  overlay.index_.push_back(static_cast<uint32_t>(overlay.transfers_.size()));
+  overlay.to_compressed_trip_.resize(data.trip_count_);
+  for (trip_id t = 0U; t < data.trip_count_; ++t) {
+    overlay.to_compressed_trip_[t] = swapped(t);
+  }
+  overlay.to_current_trip_ = overlay.to_compressed_trip_;
+
+  for (stop_idx_t stop = 0U; stop < data.arrival_times_[a].size(); ++stop) {
+    expect_transfers(expected_a[stop], transfers_of(a, stop));
+  }
+  for (stop_idx_t stop = 0U; stop < data.arrival_times_[c].size(); ++stop) {
+    expect_transfers(std::vector<tb_transfer>{tb_transfer{7U, stop}},
+                     transfers_of(c, stop));
+  }
+
+  // merging keeps the transfers of all trips
+  auto const merged = compress_transfers(data);
+  for (trip_id trip = 0U; trip < data.trip_count_; ++trip) {
+    for (stop_idx_t stop = 0U; stop < data.arrival_times_[trip].size();
+         ++stop) {
+      std::vector<tb_transfer> decoded;
+      merged.for_each(data.arrival_times_.index_[trip] + stop, trip,
+                      [&](tb_transfer const& t) { decoded.push_back(t); });
+      expect_transfers(transfers_of(trip, stop), decoded);
+    }
+  }
+}
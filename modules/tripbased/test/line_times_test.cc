@@ -0,0 +1,27 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "motis/tripbased/data.h"
+
+using namespace motis;
+using namespace motis::tripbased;
+
+TEST(tripbased_line_times, count_times_before) {
+  std::mt19937 rng{42};
+  for (auto i = 0U; i < 10000U; ++i) {
+    std::vector<motis::time> times(rng() % 200);
+    for (auto& t : times) {
+      t = static_cast<motis::time>(rng() % 100);
+    }
+    std::sort(begin(times), end(times));
+    auto const t = static_cast<motis::time>(rng() % 110);
+
+    EXPECT_EQ(std::lower_bound(begin(times), end(times), t) - begin(times),
+              count_times_before<false>(times.data(), times.size(), t));
+    EXPECT_EQ(std::upper_bound(begin(times), end(times), t) - begin(times),
+              count_times_before<true>(times.data(), times.size(), t));
+  }
+}
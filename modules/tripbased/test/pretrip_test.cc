@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #include "motis/core/access/time_access.h"
 #include "motis/module/message.h"
@@ -17,11 +19,13 @@ using namespace motis::routing;
 using namespace motis::test;
 
 struct tripbased_pretrip : public motis_instance_test {
-  tripbased_pretrip()
+  explicit tripbased_pretrip(
+      std::vector<std::string> const& modules_cmdline_opt = {
+          "--tripbased.use_data_file=false"})
       : motis::test::motis_instance_test(
             loader::loader_options{
                 {"modules/tripbased/test_resources/schedule"}, "20151121"},
-            {"tripbased"}, {"--tripbased.use_data_file=false"}) {}
+            {"tripbased"}, modules_cmdline_opt) {}
 
   bool has_journey(std::vector<journey> const& journeys, int const departure,
                    int const arrival) {
@@ -33,47 +37,66 @@ struct tripbased_pretrip : public motis_instance_test {
              j.stops_.back().arrival_.schedule_timestamp_ == arr;
     });
   }
-};
 
-TEST_F(tripbased_pretrip, simple_fwd) {
-  message_creator fbb;
-  auto const interval = Interval(unix_time(1500), unix_time(1700));
-  fbb.create_and_finish(
-      MsgContent_RoutingRequest,
-      CreateRoutingRequest(
-          fbb, Start_PretripStart,
-          CreatePretripStart(
-              fbb,
-              CreateInputStation(fbb, fbb.CreateString("2000001"),
-                                 fbb.CreateString("")),
-              &interval, 0, false, false)
-              .Union(),
-          CreateInputStation(fbb, fbb.CreateString("1000001"),
-                             fbb.CreateString("")),
-          SearchType_Default, SearchDir_Forward,
-          fbb.CreateVector(std::vector<Offset<Via>>()),
-          fbb.CreateVector(std::vector<Offset<AdditionalEdgeWrapper>>()))
-          .Union(),
-      "/tripbased");
-  auto const msg = call(make_msg(fbb));
-  auto const res = motis_content(RoutingResponse, msg);
-  auto const journeys = message_to_journeys(res);
-  EXPECT_EQ(4, journeys.size());
-  for (auto const& j : journeys) {
-    EXPECT_EQ(3, j.stops_.size());
-    if (j.stops_.size() >= 3) {
-      EXPECT_EQ("2000001", j.stops_[0].eva_no_);
-      EXPECT_EQ("6000001", j.stops_[1].eva_no_);
-      EXPECT_EQ("1000001", j.stops_[2].eva_no_);
-    }
-    EXPECT_EQ(1, j.transports_.size());
-    if (!j.transports_.empty()) {
-      EXPECT_EQ("RE", j.transports_[0].category_name_);
-      EXPECT_EQ(2, j.transports_[0].train_nr_);
+  void simple_fwd() {
+    message_creator fbb;
+    auto const interval = Interval(unix_time(1500), unix_time(1700));
+    fbb.create_and_finish(
+        MsgContent_RoutingRequest,
+        CreateRoutingRequest(
+            fbb, Start_PretripStart,
+            CreatePretripStart(
+                fbb,
+                CreateInputStation(fbb, fbb.CreateString("2000001"),
+                                   fbb.CreateString("")),
+                &interval, 0, false, false)
+                .Union(),
+            CreateInputStation(fbb, fbb.CreateString("1000001"),
+                               fbb.CreateString("")),
+            SearchType_Default, SearchDir_Forward,
+            fbb.CreateVector(std::vector<Offset<Via>>()),
+            fbb.CreateVector(std::vector<Offset<AdditionalEdgeWrapper>>()))
+            .Union(),
+        "/tripbased");
+    auto const msg = call(make_msg(fbb));
+    auto const res = motis_content(RoutingResponse, msg);
+    auto const journeys = message_to_journeys(res);
+    EXPECT_EQ(4, journeys.size());
+    for (auto const& j : journeys) {
+      EXPECT_EQ(3, j.stops_.size());
+      if (j.stops_.size() >= 3) {
+        EXPECT_EQ("2000001", j.stops_[0].eva_no_);
+        EXPECT_EQ("6000001", j.stops_[1].eva_no_);
+        EXPECT_EQ("1000001", j.stops_[2].eva_no_);
+      }
+      EXPECT_EQ(1, j.transports_.size());
+      if (!j.transports_.empty()) {
+        EXPECT_EQ("RE", j.transports_[0].category_name_);
+        EXPECT_EQ(2, j.transports_[0].train_nr_);
+      }
     }
+    EXPECT_TRUE(has_journey(journeys, 1512, 1555));
+    EXPECT_TRUE(has_journey(journeys, 1542, 1625));
+    EXPECT_TRUE(has_journey(journeys, 1612, 1655));
+    EXPECT_TRUE(has_journey(journeys, 1642, 1725));
+  }
+};
+
+struct tripbased_pretrip_parallel : public tripbased_pretrip {
+  tripbased_pretrip_parallel()
+      : tripbased_pretrip(
+            {"--tripbased.use_data_file=false", "--tripbased.profile_jobs=4"}) {
   }
-  EXPECT_TRUE(has_journey(journeys, 1512, 1555));
-  EXPECT_TRUE(has_journey(journeys, 1542, 1625));
-  EXPECT_TRUE(has_journey(journeys, 1612, 1655));
-  EXPECT_TRUE(has_journey(journeys, 1642, 1725));
-}
+};
+
+struct tripbased_pretrip_compressed : public tripbased_pretrip {
+  tripbased_pretrip_compressed()
+      : tripbased_pretrip({"--tripbased.use_data_file=false",
+                           "--tripbased.compress_transfers=true"}) {}
+};
+
+TEST_F(tripbased_pretrip, simple_fwd) { simple_fwd(); }
+
+TEST_F(tripbased_pretrip_parallel, simple_fwd) { simple_fwd(); }
+
+TEST_F(tripbased_pretrip_compressed, simple_fwd) { simple_fwd(); }
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <random>
+
+#include "motis/tripbased/data.h"
+
+namespace motis::tripbased {
+
+// Transfers of 20000 trips with 2 to 31 stops and up to 7 transfers per stop
+// to nearby trips (only arrival_times_ and transfers_ are filled).
+inline void build_random_transfers(tb_data& data, std::mt19937& rng) {
+  constexpr auto const TRIP_COUNT = 20000U;
+  data.trip_count_ = TRIP_COUNT;
+  for (auto trip = 0U; trip < TRIP_COUNT; ++trip) {
+    auto const stop_count = 2U + rng() % 30U;
+    for (auto stop = 0U; stop < stop_count; ++stop) {
+      data.arrival_times_.push_back(static_cast<motis::time>(stop));
+      auto const transfer_count = rng() % 8U;
+      for (auto i = 0U; i < transfer_count; ++i) {
+        auto const to_trip = (trip + TRIP_COUNT - 1000U + rng() % 2000U) %
+                             TRIP_COUNT;
+        data.transfers_.push_back(
+            tb_transfer{static_cast<trip_id>(to_trip),
+                        static_cast<stop_idx_t>(rng() % 300U)});
+      }
+      data.transfers_.finish_nested_key();
+    }
+    data.arrival_times_.finish_key();
+    data.transfers_.finish_base_key();
+  }
+  data.arrival_times_.finish_map();
+  data.transfers_.finish_map();
+}
+
+}  // namespace motis::tripbased
@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include "motis/module/message.h"
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+
+#include "motis/tripbased/data.h"
+#include "motis/tripbased/tripbased.h"
+
+#include "motis/test/motis_instance_test.h"
+#include "motis/test/routing_util.h"
+#include "motis/test/schedule/simple_realtime.h"
+
+using namespace flatbuffers;
+using namespace motis;
+using namespace motis::module;
+using namespace motis::routing;
+using namespace motis::test;
+using motis::test::schedule::simple_realtime::dataset_opt;
+
+struct tripbased_rt_update : public motis_instance_test {
+  explicit tripbased_rt_update(
+      char const* rebuild_threshold = "--tripbased.rt_rebuild_threshold=1000",
+      char const* compress = "--tripbased.compress_transfers=false")
+      : motis::test::motis_instance_test(
+            dataset_opt, {"tripbased", "ris", "rt"},
+            {"--tripbased.use_data_file=false", rebuild_threshold, compress,
+             "--ris.input=test/schedule/simple_realtime/risml/delays.xml",
+             "--ris.init_time=2015-11-24T11:00:00"}) {}
+
+  // ICE 628 departs one minute late in Aschaffenburg
+  void expect_delayed_journey(RoutingResponse const* content) {
+    auto const journeys = message_to_journeys(content);
+    ASSERT_FALSE(journeys.empty());
+    auto const delayed = [&](journey const& j) {
+      return j.stops_.front().eva_no_ == "8000260" &&
+             j.stops_.back().eva_no_ == "8000208" &&
+             std::any_of(begin(j.stops_), end(j.stops_), [&](auto const& s) {
+               return s.departure_.schedule_timestamp_ == unix_time(1436) &&
+                      s.departure_.timestamp_ == unix_time(1437);
+             });
+    };
+    EXPECT_TRUE(std::any_of(begin(journeys), end(journeys), delayed));
+  }
+};
+
+struct tripbased_rt_rebuild : public tripbased_rt_update {
+  tripbased_rt_rebuild()
+      : tripbased_rt_update("--tripbased.rt_rebuild_threshold=0") {}
+};
+
+struct tripbased_rt_compressed : public tripbased_rt_update {
+  tripbased_rt_compressed()
+      : tripbased_rt_update("--tripbased.rt_rebuild_threshold=1000",
+                            "--tripbased.compress_transfers=true") {}
+};
+
+TEST_F(tripbased_rt_update, uses_realtime_times) {
+  auto const res = call(simple_realtime_request(*this, "/tripbased"));
+  auto const content = motis_content(RoutingResponse, res);
+  EXPECT_LE(1U, get_stat(content, "tripbased_rt", "update_count"));
+  EXPECT_EQ(0U, get_stat(content, "tripbased_rt", "full_rebuilds"));
+  expect_delayed_journey(content);
+}
+
+TEST_F(tripbased_rt_rebuild, uses_rebuilt_data) {
+  get_module<tripbased::tripbased>("tripbased").wait_for_rebuild();
+
+  auto const res = call(simple_realtime_request(*this, "/tripbased"));
+  auto const content = motis_content(RoutingResponse, res);
+  EXPECT_LE(1U, get_stat(content, "tripbased_rt", "full_rebuilds"));
+  EXPECT_EQ(0U, get_stat(content, "tripbased_rt", "pending_rebuilds"));
+  expect_delayed_journey(content);
+}
+
+TEST_F(tripbased_rt_compressed, compresses_updated_data) {
+  auto const res = call(simple_realtime_request(*this, "/tripbased"));
+  auto const content = motis_content(RoutingResponse, res);
+  EXPECT_LE(1U, get_stat(content, "tripbased_rt", "update_count"));
+  expect_delayed_journey(content);
+
+  auto const data = get_module<tripbased::tripbased>("tripbased").get_data();
+  ASSERT_NE(nullptr, data);
+  EXPECT_NE(nullptr, data->compressed_transfers_);
+  EXPECT_EQ(0U, data->transfers_.data_size());
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "utl/verify.h"
+
+#include "motis/loader/loader_options.h"
+
+#include "motis/test/schedule/simple_realtime.h"
+
+namespace motis::test {
+
+// Timetable of the benchmarks (motis-bench):
+//   MOTIS_BENCH_DATASET=<path> MOTIS_BENCH_SCHEDULE_BEGIN=<YYYYMMDD>
+// Without MOTIS_BENCH_DATASET the (tiny) simple_realtime schedule is used,
+// which only checks that the benchmarks run.
+inline loader::loader_options bench_dataset() {
+  auto opt = schedule::simple_realtime::dataset_opt;
+  if (auto const path = std::getenv("MOTIS_BENCH_DATASET"); path != nullptr) {
+    opt.dataset_ = {path};
+  }
+  if (auto const begin = std::getenv("MOTIS_BENCH_SCHEDULE_BEGIN");
+      begin != nullptr) {
+    opt.schedule_begin_ = begin;
+  }
+  return opt;
+}
+
+struct bench_query {
+  std::string from_, to_;
+  int departure_;  // HHMM on the first schedule day
+};
+
+// Fixed query set of the routing benchmarks. With MOTIS_BENCH_DATASET the
+// queries are read from MOTIS_BENCH_QUERY_FILE, one per line:
+//   <from station id> <to station id> <HHMM>
+// so that runs on different builds/layouts answer exactly the same queries.
+inline std::vector<bench_query> bench_queries() {
+  auto const file = std::getenv("MOTIS_BENCH_QUERY_FILE");
+  if (file == nullptr) {
+    utl::verify(std::getenv("MOTIS_BENCH_DATASET") == nullptr,
+                "MOTIS_BENCH_DATASET requires MOTIS_BENCH_QUERY_FILE");
+    return {{"8000096", "8000105", 1300}, {"8000096", "8000208", 1300},
+            {"8000261", "8000080", 1150}, {"8000260", "8000208", 1355},
+            {"8000156", "8000001", 1340}, {"8000284", "8000207", 1255},
+            {"8000031", "8000105", 1400}, {"8000046", "8000001", 1505}};
+  }
+
+  std::vector<bench_query> queries;
+  std::ifstream in{file};
+  utl::verify(in.is_open(), "cannot open MOTIS_BENCH_QUERY_FILE {}", file);
+  bench_query q;
+  while (in >> q.from_ >> q.to_ >> q.departure_) {
+    queries.emplace_back(q);
+  }
+  utl::verify(!queries.empty(), "no queries in {}", file);
+  return queries;
+}
+
+// Number of queries of the synthetic benchmarks: MOTIS_BENCH_QUERIES
+// (default 100).
+inline unsigned bench_query_count() {
+  auto const n = std::getenv("MOTIS_BENCH_QUERIES");
+  return n == nullptr ? 100U : static_cast<unsigned>(std::stoul(n));
+}
+
+}  // namespace motis::test
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "motis/core/journey/journey.h"
+#include "motis/core/journey/message_to_journeys.h"
+#include "motis/module/message.h"
+
+#include "motis/test/motis_instance_test.h"
+
+namespace motis::test {
+
+// (departure, arrival, number of trips) of each journey.
+using journey_set = std::set<std::tuple<std::time_t, std::time_t, unsigned>>;
+
+inline journey_set get_journeys(routing::RoutingResponse const* res) {
+  journey_set result;
+  for (auto const& j : message_to_journeys(res)) {
+    result.emplace(j.stops_.front().departure_.timestamp_,
+                   j.stops_.back().arrival_.timestamp_, j.trips_.size());
+  }
+  return result;
+}
+
+inline journey_set get_journeys(module::msg_ptr const& msg) {
+  using routing::RoutingResponse;
+  return get_journeys(motis_content(RoutingResponse, msg));
+}
+
+// Statistics entry of a routing response (0 if it does not exist).
+inline uint64_t get_stat(routing::RoutingResponse const* res,
+                         char const* category, char const* key) {
+  auto const stats = res->statistics()->LookupByKey(category);
+  if (stats == nullptr) {
+    return 0U;
+  }
+  auto const entry = stats->entries()->LookupByKey(key);
+  return entry == nullptr ? 0U : entry->value();
+}
+
+inline uint64_t get_stat(module::msg_ptr const& msg, char const* category,
+                         char const* key) {
+  using routing::RoutingResponse;
+  return get_stat(motis_content(RoutingResponse, msg), category, key);
+}
+
+// The interval is extended later until min_connection_count journeys are
+// found (no extension if 0).
+inline flatbuffers::Offset<routing::RoutingRequest> create_pretrip_request(
+    module::message_creator& fbb, std::string const& from,
+    std::string const& to, std::time_t const begin, std::time_t const end,
+    routing::SearchType const type = routing::SearchType_Default,
+    routing::SearchDir const dir = routing::SearchDir_Forward,
+    unsigned const min_connection_count = 0U) {
+  using namespace routing;
+  auto const interval = Interval{begin, end};
+  return CreateRoutingRequest(
+      fbb, Start_PretripStart,
+      CreatePretripStart(fbb,
+                         CreateInputStation(fbb, fbb.CreateString(from),
+                                            fbb.CreateString("")),
+                         &interval, min_connection_count, false,
+                         min_connection_count != 0U)
+          .Union(),
+      CreateInputStation(fbb, fbb.CreateString(to), fbb.CreateString("")),
+      type, dir, fbb.CreateVector(std::vector<flatbuffers::Offset<Via>>()),
+      fbb.CreateVector(
+          std::vector<flatbuffers::Offset<AdditionalEdgeWrapper>>()));
+}
+
+inline flatbuffers::Offset<routing::RoutingRequest> create_ontrip_request(
+    module::message_creator& fbb, std::string const& from,
+    std::string const& to, std::time_t const departure,
+    routing::SearchDir const dir = routing::SearchDir_Forward,
+    routing::SearchType const type = routing::SearchType_Default) {
+  using namespace routing;
+  return CreateRoutingRequest(
+      fbb, Start_OntripStationStart,
+      CreateOntripStationStart(fbb,
+                               CreateInputStation(fbb, fbb.CreateString(from),
+                                                  fbb.CreateString("")),
+                               departure)
+          .Union(),
+      CreateInputStation(fbb, fbb.CreateString(to), fbb.CreateString("")),
+      type, dir, fbb.CreateVector(std::vector<flatbuffers::Offset<Via>>()),
+      fbb.CreateVector(
+          std::vector<flatbuffers::Offset<AdditionalEdgeWrapper>>()));
+}
+
+inline module::msg_ptr make_routing_msg(
+    module::message_creator& fbb,
+    flatbuffers::Offset<routing::RoutingRequest> const req,
+    std::string const& target) {
+  fbb.create_and_finish(MsgContent_RoutingRequest, req.Union(), target);
+  return module::make_msg(fbb);
+}
+
+// simple_realtime schedule: 8000260 -> 8000208, departure 13:55. The only
+// (scheduled) connection arrives at 16:51.
+inline module::msg_ptr simple_realtime_request(
+    motis_instance_test const& t, std::string const& target,
+    routing::SearchType const type = routing::SearchType_Default) {
+  module::message_creator fbb;
+  return make_routing_msg(
+      fbb,
+      create_pretrip_request(fbb, "8000260", "8000208", t.unix_time(1355),
+                             t.unix_time(1355), type),
+      target);
+}
+
+}  // namespace motis::test